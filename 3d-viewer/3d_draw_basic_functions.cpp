@@ -201,13 +201,13 @@ void Draw3D_SolidHorizontalPolyPolygons( const SHAPE_POLY_SET& aPolysList,
 
                 for( int ipt = 0; ipt < curr_poly.PointCount(); ipt++ )
                 {
-                    v_data[0]   = curr_poly.Point( ipt ).x * aBiuTo3DUnits;
-                    v_data[1]   = -curr_poly.Point( ipt ).y * aBiuTo3DUnits;
+                    v_data[0]   = curr_poly.CPoint( ipt ).x * aBiuTo3DUnits;
+                    v_data[1]   = -curr_poly.CPoint( ipt ).y * aBiuTo3DUnits;
                     // gluTessVertex store pointers on data, not data, so do not store
                     // different corners values in a temporary variable
                     // but send pointer on each CPolyPt value in polylist
                     // before calling gluDeleteTess
-                    gluTessVertex( tess, v_data, &curr_poly.Point( ipt ) );
+                    gluTessVertex( tess, v_data, (void*) &curr_poly.CPoint( ipt ) );
                 }
 
                 gluTessEndContour( tess );
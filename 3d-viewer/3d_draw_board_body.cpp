@@ -198,6 +198,13 @@ void EDA_3D_CANVAS::buildBoard3DView( GLuint aBoardList, GLuint aBodyOnlyList,
         }
     }
 
+    // These polygons are only displayed: their large operations may be split in groups
+    // of polygons, run on several threads
+    bufferPolys.SetSplitOperations( true );
+    bufferPcbOutlines.SetSplitOperations( true );
+    currLayerHoles.SetSplitOperations( true );
+    allLayerHoles.SetSplitOperations( true );
+
     // Build board holes, with optimization of large holes shape.
     buildBoardThroughHolesPolygonList( allLayerHoles, segcountLowQuality, true );
 
@@ -474,6 +481,12 @@ void EDA_3D_CANVAS::buildTechLayers3DView( REPORTER* aErrorMessages, REPORTER* a
         }
     }
 
+    // These polygons are only displayed: their large operations may be split in groups
+    // of polygons, run on several threads
+    bufferPolys.SetSplitOperations( true );
+    bufferPcbOutlines.SetSplitOperations( true );
+    allLayerHoles.SetSplitOperations( true );
+
     // Build board holes, with no optimization of large holes shape.
     buildBoardThroughHolesPolygonList( allLayerHoles, segcountLowQuality, false );
 
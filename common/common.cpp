@@ -72,6 +72,11 @@ int LOCALE_IO::m_c_count = 0;
 
 LOCALE_IO::LOCALE_IO()
 {
+    m_thread_locale = THREAD_C_LOCALE::IsActive();
+
+    if( m_thread_locale )
+        return;
+
     wxASSERT_MSG( m_c_count >= 0, wxT( "LOCALE_IO::m_c_count mismanaged." ) );
 
     // use thread safe, atomic operation
@@ -86,6 +91,9 @@ LOCALE_IO::LOCALE_IO()
 
 LOCALE_IO::~LOCALE_IO()
 {
+    if( m_thread_locale )
+        return;
+
     // use thread safe, atomic operation
     if( __sync_sub_and_fetch( &m_c_count, 1 ) == 0 )
     {
@@ -97,6 +105,54 @@ LOCALE_IO::~LOCALE_IO()
 }
 
 
+#if defined( __WINDOWS__ )
+
+THREAD_C_LOCALE::THREAD_C_LOCALE()
+{
+    // setlocale() only changes the locale of the calling thread after this call
+    _configthreadlocale( _ENABLE_PER_THREAD_LOCALE );
+
+    m_previous = setlocale( LC_ALL, 0 );
+    setlocale( LC_ALL, "C" );
+}
+
+
+THREAD_C_LOCALE::~THREAD_C_LOCALE()
+{
+    setlocale( LC_ALL, m_previous.c_str() );
+    _configthreadlocale( _DISABLE_PER_THREAD_LOCALE );
+}
+
+
+bool THREAD_C_LOCALE::IsActive()
+{
+    return _configthreadlocale( 0 ) == _ENABLE_PER_THREAD_LOCALE;
+}
+
+#else
+
+THREAD_C_LOCALE::THREAD_C_LOCALE()
+{
+    m_locale   = newlocale( LC_ALL_MASK, "C", (locale_t) 0 );
+    m_previous = uselocale( m_locale );
+}
+
+
+THREAD_C_LOCALE::~THREAD_C_LOCALE()
+{
+    uselocale( m_previous );
+    freelocale( m_locale );
+}
+
+
+bool THREAD_C_LOCALE::IsActive()
+{
+    return uselocale( (locale_t) 0 ) != LC_GLOBAL_LOCALE;
+}
+
+#endif
+
+
 wxSize GetTextSize( const wxString& aSingleLine, wxWindow* aWindow )
 {
     wxCoord width;
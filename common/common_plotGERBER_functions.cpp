@@ -40,10 +40,13 @@
 #include <build_version.h>
 
 
+/// Initial size of the memory buffer holding the plot, to avoid most reallocations
+#define GERBER_BODY_RESERVE     ( 256 * 1024 )
+
+
 GERBER_PLOTTER::GERBER_PLOTTER()
 {
-    workFile  = 0;
-    finalFile = 0;
+    m_apertureListPos = 0;
     currentAperture = apertures.end();
 
     // number of digits after the point (number of digits of the mantissa
@@ -95,8 +98,8 @@ void GERBER_PLOTTER::SetGerberCoordinatesFormat( int aResolution, bool aUseInche
 void GERBER_PLOTTER::emitDcode( const DPOINT& pt, int dcode )
 {
 
-    fprintf( outputFile, "X%dY%dD%02d*\n",
-	    KiROUND( pt.x ), KiROUND( pt.y ), dcode );
+    StrPrintf( &m_body, "X%dY%dD%02d*\n",
+               KiROUND( pt.x ), KiROUND( pt.y ), dcode );
 }
 
 
@@ -104,22 +107,15 @@ bool GERBER_PLOTTER::StartPlot()
 {
     wxASSERT( outputFile );
 
-    finalFile = outputFile;     // the actual gerber file will be created later
-
-    // Create a temporary filename to store gerber file
-    // note tmpfile() does not work under Vista and W7 in user mode
-    m_workFilename = filename + wxT(".tmp");
-    workFile   = wxFopen( m_workFilename, wxT( "wt" ));
-    outputFile = workFile;
-    wxASSERT( outputFile );
-
-    if( outputFile == NULL )
-        return false;
+    // The plot is built in m_body, and written to outputFile by EndPlot(),
+    // once the aperture list, which must be written before the plot, is known
+    m_body.clear();
+    m_body.reserve( GERBER_BODY_RESERVE );
 
     for( unsigned ii = 0; ii < m_headerExtraLines.GetCount(); ii++ )
     {
         if( ! m_headerExtraLines[ii].IsEmpty() )
-            fprintf( outputFile, "%s\n", TO_UTF8( m_headerExtraLines[ii] ) );
+            StrPrintf( &m_body, "%s\n", TO_UTF8( m_headerExtraLines[ii] ) );
     }
 
     // Set coordinate format to 3.6 or 4.5 absolute, leading zero omitted
@@ -128,31 +124,33 @@ bool GERBER_PLOTTER::StartPlot()
     // It is fixed here to 3 (inch) or 4 (mm), but is not actually used
     int leadingDigitCount = m_gerberUnitInch ? 3 : 4;
 
-    fprintf( outputFile, "%%FSLAX%d%dY%d%d*%%\n",
-             leadingDigitCount, m_gerberUnitFmt,
-             leadingDigitCount, m_gerberUnitFmt );
-    fprintf( outputFile,
-             "G04 Gerber Fmt %d.%d, Leading zero omitted, Abs format (unit %s)*\n",
-             leadingDigitCount, m_gerberUnitFmt,
-             m_gerberUnitInch ? "inch" : "mm" );
+    StrPrintf( &m_body, "%%FSLAX%d%dY%d%d*%%\n",
+               leadingDigitCount, m_gerberUnitFmt,
+               leadingDigitCount, m_gerberUnitFmt );
+    StrPrintf( &m_body,
+               "G04 Gerber Fmt %d.%d, Leading zero omitted, Abs format (unit %s)*\n",
+               leadingDigitCount, m_gerberUnitFmt,
+               m_gerberUnitInch ? "inch" : "mm" );
 
     wxString Title = creator + wxT( " " ) + GetBuildVersion();
-    fprintf( outputFile, "G04 Created by KiCad (%s) date %s*\n",
-             TO_UTF8( Title ), TO_UTF8( DateAndTime() ) );
+    StrPrintf( &m_body, "G04 Created by KiCad (%s) date %s*\n",
+               TO_UTF8( Title ), TO_UTF8( DateAndTime() ) );
 
     /* Mass parameter: unit = INCHES/MM */
     if( m_gerberUnitInch )
-        fputs( "%MOIN*%\n", outputFile );
+        m_body += "%MOIN*%\n";
     else
-        fputs( "%MOMM*%\n", outputFile );
+        m_body += "%MOMM*%\n";
 
     // Be sure the usual dark polarity is selected:
-    fputs( "%LPD*%\n", outputFile );
+    m_body += "%LPD*%\n";
 
     // Specify linear interpol (G01):
-    fputs( "G01*\n", outputFile );
+    m_body += "G01*\n";
+
+    m_body += "G04 APERTURE LIST*\n";
+    m_apertureListPos = m_body.size();
 
-    fputs( "G04 APERTURE LIST*\n", outputFile );
     /* Select the default aperture */
     SetCurrentLineWidth( -1 );
 
@@ -162,38 +160,33 @@ bool GERBER_PLOTTER::StartPlot()
 
 bool GERBER_PLOTTER::EndPlot()
 {
-    char     line[1024];
-    wxString msg;
-
     wxASSERT( outputFile );
 
-    /* Outfile is actually a temporary file i.e. workFile */
-    fputs( "M02*\n", outputFile );
-    fflush( outputFile );
+    m_body += "M02*\n";
 
-    fclose( workFile );
-    workFile   = wxFopen( m_workFilename, wxT( "rt" ));
-    wxASSERT( workFile );
-    outputFile = finalFile;
+    // Placement of apertures in RS274X: the aperture list is inserted
+    // after the "G04 APERTURE LIST*" line, and the file is written at once
+    std::string apertureList;
 
-    // Placement of apertures in RS274X
-    while( fgets( line, 1024, workFile ) )
-    {
-        fputs( line, outputFile );
+    writeApertureList( &apertureList );
+    apertureList += "G04 APERTURE END LIST*\n";
 
-        if( strcmp( strtok( line, "\n\r" ), "G04 APERTURE LIST*" ) == 0 )
-        {
-            writeApertureList();
-            fputs( "G04 APERTURE END LIST*\n", outputFile );
-        }
-    }
+    fwrite( m_body.data(), 1, m_apertureListPos, outputFile );
+    fwrite( apertureList.data(), 1, apertureList.size(), outputFile );
+    fwrite( m_body.data() + m_apertureListPos, 1, m_body.size() - m_apertureListPos,
+            outputFile );
+
+    bool ok = !ferror( outputFile );
+
+    if( fclose( outputFile ) )
+        ok = false;
 
-    fclose( workFile );
-    fclose( finalFile );
-    ::wxRemoveFile( m_workFilename );
     outputFile = 0;
 
-    return true;
+    // Release the memory now: the plotter can be kept a while
+    std::string().swap( m_body );
+
+    return ok;
 }
 
 
@@ -221,27 +214,24 @@ void GERBER_PLOTTER::SetCurrentLineWidth( int width )
 std::vector<APERTURE>::iterator GERBER_PLOTTER::getAperture( const wxSize&           size,
                                                              APERTURE::APERTURE_TYPE type )
 {
-    int last_D_code = 9;
+    APERTURE_KEY key;
+    key.m_size = size;
+    key.m_type = type;
 
     // Search an existing aperture
-    std::vector<APERTURE>::iterator tool = apertures.begin();
-
-    while( tool != apertures.end() )
-    {
-        last_D_code = tool->DCode;
-
-        if( (tool->Type == type) && (tool->Size == size) )
-            return tool;
+    APERTURE_INDEX::const_iterator it = m_apertureIndex.find( key );
 
-        tool++;
-    }
+    if( it != m_apertureIndex.end() )
+        return apertures.begin() + it->second;
 
     // Allocate a new aperture
     APERTURE new_tool;
     new_tool.Size  = size;
     new_tool.Type  = type;
-    new_tool.DCode = last_D_code + 1;
+    new_tool.DCode = apertures.empty() ? 10 : apertures.back().DCode + 1;
     apertures.push_back( new_tool );
+    m_apertureIndex[key] = apertures.size() - 1;
+
     return apertures.end() - 1;
 }
 
@@ -249,22 +239,19 @@ std::vector<APERTURE>::iterator GERBER_PLOTTER::getAperture( const wxSize&
 void GERBER_PLOTTER::selectAperture( const wxSize&           size,
                                      APERTURE::APERTURE_TYPE type )
 {
-    wxASSERT( outputFile );
-
     if( ( currentAperture == apertures.end() )
        || ( currentAperture->Type != type )
        || ( currentAperture->Size != size ) )
     {
         // Pick an existing aperture or create a new one
         currentAperture = getAperture( size, type );
-        fprintf( outputFile, "D%d*\n", currentAperture->DCode );
+        StrPrintf( &m_body, "D%d*\n", currentAperture->DCode );
     }
 }
 
 
-void GERBER_PLOTTER::writeApertureList()
+void GERBER_PLOTTER::writeApertureList( std::string* aText )
 {
-    wxASSERT( outputFile );
     char cbuf[1024];
 
     // Init
@@ -310,7 +297,7 @@ void GERBER_PLOTTER::writeApertureList()
             break;
         }
 
-        fputs( cbuf, outputFile );
+        *aText += cbuf;
     }
 }
 
@@ -363,7 +350,6 @@ void GERBER_PLOTTER::Circle( const wxPoint& aCenter, int aDiameter, FILL_T aFill
 void GERBER_PLOTTER::Arc( const wxPoint& aCenter, double aStAngle, double aEndAngle,
                           int aRadius, FILL_T aFill, int aWidth )
 {
-    wxASSERT( outputFile );
     wxPoint start, end;
     start.x = aCenter.x + KiROUND( cosdecideg( aRadius, aStAngle ) );
     start.y = aCenter.y - KiROUND( sindecideg( aRadius, aStAngle ) );
@@ -374,17 +360,17 @@ void GERBER_PLOTTER::Arc( const wxPoint& aCenter, double aStAngle, double aEndAn
     DPOINT devEnd = userToDeviceCoordinates( end );
     DPOINT devCenter = userToDeviceCoordinates( aCenter ) - userToDeviceCoordinates( start );
 
-    fprintf( outputFile, "G75*\n" ); // Multiquadrant mode
+    m_body += "G75*\n"; // Multiquadrant mode
 
     if( aStAngle < aEndAngle )
-        fprintf( outputFile, "G03" );
+        m_body += "G03";
     else
-        fprintf( outputFile, "G02" );
+        m_body += "G02";
 
-    fprintf( outputFile, "X%dY%dI%dJ%dD01*\n",
-             KiROUND( devEnd.x ), KiROUND( devEnd.y ),
-             KiROUND( devCenter.x ), KiROUND( devCenter.y ) );
-    fprintf( outputFile, "G01*\n" ); // Back to linear interp.
+    StrPrintf( &m_body, "X%dY%dI%dJ%dD01*\n",
+               KiROUND( devEnd.x ), KiROUND( devEnd.y ),
+               KiROUND( devCenter.x ), KiROUND( devCenter.y ) );
+    m_body += "G01*\n"; // Back to linear interp.
 }
 
 
@@ -402,7 +388,7 @@ void GERBER_PLOTTER:: PlotPoly( const std::vector< wxPoint >& aCornerList,
 
     if( aFill )
     {
-        fputs( "G36*\n", outputFile );
+        m_body += "G36*\n";
 
         MoveTo( aCornerList[0] );
 
@@ -410,7 +396,7 @@ void GERBER_PLOTTER:: PlotPoly( const std::vector< wxPoint >& aCornerList,
             LineTo( aCornerList[ii] );
 
         FinishTo( aCornerList[0] );
-        fputs( "G37*\n", outputFile );
+        m_body += "G37*\n";
     }
 
     if( aWidth > 0 )
@@ -588,7 +574,7 @@ void GERBER_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos,  const wxPoint* aCo
 void GERBER_PLOTTER::SetLayerPolarity( bool aPositive )
 {
     if( aPositive )
-        fprintf( outputFile, "%%LPD*%%\n" );
+        m_body += "%LPD*%\n";
     else
-        fprintf( outputFile, "%%LPC*%%\n" );
+        m_body += "%LPC*%\n";
 }
@@ -141,9 +141,8 @@ void PSLIKE_PLOTTER::FlashPadCircle( const wxPoint& aPadPos, int aDiameter,
 void PSLIKE_PLOTTER::FlashPadRect( const wxPoint& aPadPos, const wxSize& aSize,
                                    double aPadOrient, EDA_DRAW_MODE_T aTraceMode )
 {
-    static std::vector< wxPoint > cornerList;
+    std::vector< wxPoint > cornerList;  // not static: several plotters can run at the same time
     wxSize size( aSize );
-    cornerList.clear();
 
     if( aTraceMode == FILLED )
         SetCurrentLineWidth( 0 );
@@ -191,8 +190,7 @@ void PSLIKE_PLOTTER::FlashPadRect( const wxPoint& aPadPos, const wxSize& aSize,
 void PSLIKE_PLOTTER::FlashPadTrapez( const wxPoint& aPadPos, const wxPoint *aCorners,
                                      double aPadOrient, EDA_DRAW_MODE_T aTraceMode )
 {
-    static std::vector< wxPoint > cornerList;
-    cornerList.clear();
+    std::vector< wxPoint > cornerList;  // not static: several plotters can run at the same time
 
     for( int ii = 0; ii < 4; ii++ )
         cornerList.push_back( aCorners[ii] );
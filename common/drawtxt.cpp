@@ -143,27 +143,106 @@ int NegableTextLength( const wxString& aText )
 }
 
 
-/* Function GetHersheyShapeDescription
- * return a pointer to the shape corresponding to unicode value AsciiCode
- * Note we use the same font for Bold and Normal texts
- * because KiCad handles a variable pen size to do that
- * that gives better results in XOR draw mode.
+/**
+ * Class HERSHEY_FONT
+ * is the newstroke font, decoded once from its Hershey shape descriptions instead of
+ * for each char of each text.  Each glyph is a set of strokes (polylines), and the
+ * points of all the strokes of all the glyphs are stored in a single array, in font
+ * units, relative to the glyph start and aligned on the midpoint.
+ *
+ * The only instance is built when the library is loaded, and is never modified later,
+ * so texts can be drawn or plotted by several threads.
  */
-static const char* GetHersheyShapeDescription( int AsciiCode )
+class HERSHEY_FONT
 {
-    // calculate font length
-    int font_length_max = newstroke_font_bufsize;
+public:
+    struct GLYPH
+    {
+        int      m_advance;         ///< Advance width, in font units
+        unsigned m_firstStroke;     ///< Index of the first stroke in m_strokeEnds
+        unsigned m_endStroke;       ///< Index after the last stroke in m_strokeEnds
+    };
 
-    if( AsciiCode >= (32 + font_length_max) )
-        AsciiCode = '?';
+    HERSHEY_FONT()
+    {
+        m_glyphs.resize( newstroke_font_bufsize );
 
-    if( AsciiCode < 32 )
-        AsciiCode = 32; // Clamp control chars
+        for( int ii = 0; ii < newstroke_font_bufsize; ii++ )
+        {
+            const char* ptcar = newstroke_font[ii];
+            GLYPH&      glyph = m_glyphs[ii];
 
-    AsciiCode -= 32;
+            // Get metrics
+            int xsta = *ptcar++ - 'R';
+            int xsto = *ptcar++ - 'R';
 
-    return newstroke_font[AsciiCode];
-}
+            glyph.m_advance     = xsto - xsta;
+            glyph.m_firstStroke = m_strokeEnds.size();
+
+            // Coordinates values are coded as <value> + 'R', a pen up is " R"
+            for( ; ptcar[0] && ptcar[1]; ptcar += 2 )
+            {
+                if( ptcar[0] == ' ' && ptcar[1] == 'R' )
+                    endStroke();
+                else
+                    m_points.push_back( wxPoint( ptcar[0] - 'R' - xsta, ptcar[1] - 'R' - 10 ) );
+            }
+
+            // End of character, insert a synthetic pen up
+            endStroke();
+
+            glyph.m_endStroke = m_strokeEnds.size();
+        }
+    }
+
+    /**
+     * Function GetGlyph
+     * @return the glyph of unicode value aCode, '?' for the values not in the font.
+     */
+    const GLYPH& GetGlyph( int aCode ) const
+    {
+        if( aCode >= 32 + (int) m_glyphs.size() )
+            aCode = '?';
+
+        if( aCode < 32 )
+            aCode = 32; // Clamp control chars
+
+        return m_glyphs[aCode - 32];
+    }
+
+    /// @return the first point of stroke aStroke in GetPoints()
+    unsigned GetStrokeStart( unsigned aStroke ) const
+    {
+        return aStroke ? m_strokeEnds[aStroke - 1] : 0;
+    }
+
+    /// @return the point after the last point of stroke aStroke in GetPoints()
+    unsigned GetStrokeEnd( unsigned aStroke ) const
+    {
+        return m_strokeEnds[aStroke];
+    }
+
+    const wxPoint* GetPoints() const
+    {
+        return &m_points[0];
+    }
+
+private:
+    void endStroke()
+    {
+        unsigned start = m_strokeEnds.empty() ? 0 : m_strokeEnds.back();
+
+        if( m_points.size() > start )
+            m_strokeEnds.push_back( m_points.size() );
+    }
+
+    std::vector<GLYPH>      m_glyphs;
+    std::vector<unsigned>   m_strokeEnds;
+    std::vector<wxPoint>    m_points;
+};
+
+
+static const HERSHEY_FONT s_hersheyFont;
 
 
 int GraphicTextWidth( const wxString& aText, int aXSize, bool aItalic, bool aWidth )
@@ -185,11 +264,8 @@ int GraphicTextWidth( const wxString& aText, int aXSize, bool aItalic, bool aWid
                 continue;
         }
 
-        const char* shape_ptr = GetHersheyShapeDescription( asciiCode );
-        // Get metrics
-        int         xsta    = *shape_ptr++ - 'R';
-        int         xsto    = *shape_ptr++ - 'R';
-        tally += KiROUND( aXSize * (xsto - xsta) * STROKE_FONT::STROKE_FONT_SCALE );
+        int advance = s_hersheyFont.GetGlyph( asciiCode ).m_advance;
+        tally += KiROUND( aXSize * advance * STROKE_FONT::STROKE_FONT_SCALE );
     }
 
     // For italic correction, add 1/8 size
@@ -210,7 +286,7 @@ static void DrawGraphicTextPline( EDA_RECT* aClipBox,
                                   bool aSketchMode,
                                   int point_count,
                                   wxPoint* coord,
-                                  void (* aCallback)( int x0, int y0, int xf, int yf ),
+                                  const TEXT_SEGMENT_CALLBACK& aCallback,
                                   PLOTTER* aPlotter )
 {
     if( aPlotter )
@@ -281,7 +357,7 @@ void DrawGraphicText( EDA_RECT* aClipBox,
                       int aWidth,
                       bool aItalic,
                       bool aBold,
-                      void (* aCallback)( int x0, int y0, int xf, int yf ),
+                      const TEXT_SEGMENT_CALLBACK& aCallback,
                       PLOTTER* aPlotter )
 {
     int         AsciiCode;
@@ -476,56 +552,19 @@ void DrawGraphicText( EDA_RECT* aClipBox,
 
         AsciiCode = aText.GetChar( ptr + overbars );
 
-        const char* ptcar = GetHersheyShapeDescription( AsciiCode );
-        // Get metrics
-        int         xsta    = *ptcar++ - 'R';
-        int         xsto    = *ptcar++ - 'R';
-        int         point_count = 0;
-        bool        endcar = false;
+        const HERSHEY_FONT::GLYPH& glyph = s_hersheyFont.GetGlyph( AsciiCode );
+        const wxPoint*             points = s_hersheyFont.GetPoints();
 
-        while( !endcar )
+        for( unsigned stroke = glyph.m_firstStroke; stroke < glyph.m_endStroke; stroke++ )
         {
-            int hc1, hc2;
-            hc1 = *ptcar++;
-
-            if( hc1 )
-            {
-                hc2 = *ptcar++;
-            }
-            else
-            {
-                // End of character, insert a synthetic pen up:
-                hc1    = ' ';
-                hc2    = 'R';
-                endcar = true;
-            }
+            int      point_count = 0;
+            unsigned end = s_hersheyFont.GetStrokeEnd( stroke );
 
-            // Do the Hershey decode thing:
-            // coordinates values are coded as <value> + 'R'
-            hc1 -= 'R';
-            hc2 -= 'R';
-
-            // Pen up request
-            if( hc1 == -50 && hc2 == 0 )
-            {
-                if( point_count )
-                {
-                    if( aWidth <= 1 )
-                        aWidth = 0;
-
-                    DrawGraphicTextPline( aClipBox, aDC, aColor, aWidth,
-                                          sketch_mode, point_count, coord,
-                                          aCallback, aPlotter );
-                }
-
-                point_count = 0;
-            }
-            else
+            for( unsigned ii = s_hersheyFont.GetStrokeStart( stroke ); ii < end; ii++ )
             {
                 wxPoint currpoint;
-                hc1 -= xsta; hc2 -= 10;    // Align the midpoint
-                hc1  = KiROUND( hc1 * size_h * STROKE_FONT::STROKE_FONT_SCALE );
-                hc2  = KiROUND( hc2 * size_v * STROKE_FONT::STROKE_FONT_SCALE );
+                int hc1  = KiROUND( points[ii].x * size_h * STROKE_FONT::STROKE_FONT_SCALE );
+                int hc2  = KiROUND( points[ii].y * size_v * STROKE_FONT::STROKE_FONT_SCALE );
 
                 // To simulate an italic font,
                 // add a x offset depending on the y offset
@@ -542,12 +581,19 @@ void DrawGraphicText( EDA_RECT* aClipBox,
                 if( point_count < BUF_SIZE - 1 )
                     point_count++;
             }
+
+            if( aWidth <= 1 )
+                aWidth = 0;
+
+            DrawGraphicTextPline( aClipBox, aDC, aColor, aWidth,
+                                  sketch_mode, point_count, coord,
+                                  aCallback, aPlotter );
         }    // end draw 1 char
 
         ptr++;
 
         // Apply the advance width
-        current_char_pos.x += KiROUND( size_h * (xsto - xsta) * STROKE_FONT::STROKE_FONT_SCALE );
+        current_char_pos.x += KiROUND( size_h * glyph.m_advance * STROKE_FONT::STROKE_FONT_SCALE );
     }
 
     if( overbars % 2 )
@@ -576,7 +622,7 @@ void DrawGraphicHaloText( EDA_RECT* aClipBox, wxDC * aDC,
                           enum EDA_TEXT_HJUSTIFY_T aH_justify,
                           enum EDA_TEXT_VJUSTIFY_T aV_justify,
                           int aWidth, bool aItalic, bool aBold,
-                          void (*aCallback)( int x0, int y0, int xf, int yf ),
+                          const TEXT_SEGMENT_CALLBACK& aCallback,
                           PLOTTER * aPlotter )
 {
     // Swap color if contrast would be better
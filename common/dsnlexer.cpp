@@ -29,8 +29,11 @@
 #include <cstdlib>         // bsearch()
 #include <cctype>
 
+#include <map>
+
 #include <macros.h>
 #include <fctsys.h>
+#include <ki_mutex.h>
 #include <dsnlexer.h>
 
 
@@ -39,6 +42,50 @@
 #define FMT_CLIPBOARD       _( "clipboard" )
 
 
+/// The keyword hashtables, one per keyword table, each shared by all the lexers
+/// using this table.  Filling a hashtable for each lexer is costly when many small
+/// files are parsed, e.g. all the footprints of a library.  Once filled, a hashtable
+/// is never modified, so it can be read without locking.
+typedef std::map<const KEYWORD*, KEYWORD_MAP>   KEYWORD_MAPS;
+
+static KEYWORD_MAPS keywordMaps;
+static MUTEX        keywordMapsLock;
+
+
+/**
+ * Function getKeywordMap
+ * @return the hashtable of the keyword table aKeywords, filled on first use.
+ */
+static const KEYWORD_MAP* getKeywordMap( const KEYWORD* aKeywords, unsigned aKeywordCount )
+{
+    MUTLOCK lock( keywordMapsLock );
+
+    KEYWORD_MAPS::iterator it = keywordMaps.find( aKeywords );
+
+    if( it != keywordMaps.end() )
+        return &it->second;
+
+    KEYWORD_MAP& keyword_hash = keywordMaps[aKeywords];
+
+    if( aKeywordCount > 11 )
+    {
+        // resize the hashtable bucket count
+        keyword_hash.reserve( aKeywordCount );
+    }
+
+    // fill the specialized "C string" hashtable from keywords[]
+    const KEYWORD*  kw  = aKeywords;
+    const KEYWORD*  end = kw + aKeywordCount;
+
+    for( ; kw < end; ++kw )
+    {
+        keyword_hash[kw->name] = kw->token;
+    }
+
+    return &keyword_hash;
+}
+
+
 //-----<DSNLEXER>-------------------------------------------------------------
 
 void DSNLEXER::init()
@@ -54,22 +101,7 @@ void DSNLEXER::init()
 
     curOffset = 0;
 
-#if 1
-    if( keywordCount > 11 )
-    {
-        // resize the hashtable bucket count
-        keyword_hash.reserve( keywordCount );
-    }
-
-    // fill the specialized "C string" hashtable from keywords[]
-    const KEYWORD*  it  = keywords;
-    const KEYWORD*  end = it + keywordCount;
-
-    for( ; it < end; ++it )
-    {
-        keyword_hash[it->name] = it->token;
-    }
-#endif
+    keyword_hash = getKeywordMap( keywords, keywordCount );
 }
 
 
@@ -260,8 +292,8 @@ int DSNLEXER::findToken( const std::string& tok )
 
 inline int DSNLEXER::findToken( const std::string& tok )
 {
-    KEYWORD_MAP::const_iterator it = keyword_hash.find( tok.c_str() );
-    if( it != keyword_hash.end() )
+    KEYWORD_MAP::const_iterator it = keyword_hash->find( tok.c_str() );
+    if( it != keyword_hash->end() )
         return it->second;
 
     return DSN_SYMBOL;      // not a keyword, some arbitrary symbol.
@@ -701,7 +733,15 @@ L_read:
                 }
 
                 else
-                    curText += *head++;
+                {
+                    // copy the run of plain characters up to the next special one at once
+                    const char* run = head;
+
+                    while( head<limit && *head!='\\' && *head!='"' )
+                        ++head;
+
+                    curText.append( run, head );
+                }
 
             }   // while
 
@@ -781,11 +821,11 @@ L_read:
     }           // specctraMode
 
     // non-quoted token, read it into curText.
-    curText.clear();
-
     head = cur;
     while( head<limit && !isSep( *head ) )
-        curText += *head++;
+        ++head;
+
+    curText.assign( cur, head );
 
     if( isNumber( curText.c_str(), curText.c_str() + curText.size() ) )
     {
@@ -27,6 +27,8 @@
  * @brief Implementation of base KiCad text object.
  */
 
+#include <boost/bind.hpp>
+
 #include <eda_text.h>
 #include <drawtxt.h>
 #include <macros.h>
@@ -468,14 +470,13 @@ void EDA_TEXT::Format( OUTPUTFORMATTER* aFormatter, int aNestLevel, int aControl
 // Convert the text shape to a list of segment
 // each segment is stored as 2 wxPoints: its starting point and its ending point
 // we are using DrawGraphicText to create the segments.
-// and therefore a call-back function is needed
-static std::vector<wxPoint>* s_cornerBuffer;
-
-// This is a call back function, used by DrawGraphicText to put each segment in buffer
-static void addTextSegmToBuffer( int x0, int y0, int xf, int yf )
+// and therefore a call-back function is needed, bound to the buffer of the caller:
+// the DRC converts texts on several threads.
+static void addTextSegmToBuffer( std::vector<wxPoint>* aCornerBuffer,
+                                 int x0, int y0, int xf, int yf )
 {
-    s_cornerBuffer->push_back( wxPoint( x0, y0 ) );
-    s_cornerBuffer->push_back( wxPoint( xf, yf ) );
+    aCornerBuffer->push_back( wxPoint( x0, y0 ) );
+    aCornerBuffer->push_back( wxPoint( xf, yf ) );
 }
 
 void EDA_TEXT::TransformTextShapeToSegmentList( std::vector<wxPoint>& aCornerBuffer ) const
@@ -485,7 +486,8 @@ void EDA_TEXT::TransformTextShapeToSegmentList( std::vector<wxPoint>& aCornerBuf
     if( IsMirrored() )
         size.x = -size.x;
 
-    s_cornerBuffer = &aCornerBuffer;
+    TEXT_SEGMENT_CALLBACK callback = boost::bind( addTextSegmToBuffer, &aCornerBuffer,
+                                                  _1, _2, _3, _4 );
     EDA_COLOR_T color = BLACK;  // not actually used, but needed by DrawGraphicText
 
     if( IsMultilineAllowed() )
@@ -503,7 +505,7 @@ void EDA_TEXT::TransformTextShapeToSegmentList( std::vector<wxPoint>& aCornerBuf
                              txt, GetOrientation(), size,
                              GetHorizJustify(), GetVertJustify(),
                              GetThickness(), IsItalic(),
-                             true, addTextSegmToBuffer );
+                             true, callback );
         }
     }
     else
@@ -512,6 +514,6 @@ void EDA_TEXT::TransformTextShapeToSegmentList( std::vector<wxPoint>& aCornerBuf
                          GetText(), GetOrientation(), size,
                          GetHorizJustify(), GetVertJustify(),
                          GetThickness(), IsItalic(),
-                         true, addTextSegmToBuffer );
+                         true, callback );
     }
 }
@@ -28,13 +28,6 @@
  */
 
 
-/**
-    No. concurrent threads doing "http(s) GET". More than 6 is not significantly
-    faster, less than 6 is likely slower. Main thread is in this count, so if
-    set to 1 then no temp threads are created.
-*/
-#define READER_THREADS      6
-
 /*
  * Functions to read footprint libraries and fill m_footprints by available footprints names
  * and their documentation (comments and keywords)
@@ -50,8 +43,393 @@
 #include <fp_lib_table.h>
 #include <fpid.h>
 #include <class_module.h>
-#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <html_messagebox.h>
+#include <job_scheduler.h>
+#include <richio.h>
+#include <dsnlexer.h>
+
+#include <map>
+#include <stdlib.h>
+#include <wx/dir.h>
+#include <wx/filename.h>
+
+
+/// Name of the footprint info index file, in the user configuration directory
+#define FP_INFO_INDEX_FILENAME  wxT( "fp-info-cache" )
+
+/// Version of the index file format, to be incremented when it changes
+#define FP_INFO_INDEX_VERSION   2
+
+
+/**
+ * Class FOOTPRINT_INFO_INDEX
+ * is the on-disk index of the footprint libraries, which stores the FOOTPRINT_INFO
+ * data of the footprints of each library, in order to not parse all the footprints
+ * each time the footprint list is built.
+ * Libraries are keyed by their type, URI and options, and the data of a library is
+ * used only if the hash of the names, modification times and sizes of its files did
+ * not change, so a changed library is parsed again.  Libraries which do not exist
+ * anymore are removed from the index when it is saved.
+ * Find() and Store() can be called from several threads.
+ */
+class FOOTPRINT_INFO_INDEX
+{
+public:
+    struct ENTRY
+    {
+        wxString    m_name;
+        wxString    m_doc;
+        wxString    m_keywords;
+        int         m_padCount;
+        int         m_uniquePadCount;
+    };
+
+    struct LIB
+    {
+        LIB() : m_hash( 0 ) {}
+
+        wxString            m_path;         ///< the library file or directory
+        unsigned long long  m_hash;         ///< see LibraryKey()
+        std::vector<ENTRY>  m_footprints;
+    };
+
+    FOOTPRINT_INFO_INDEX() :
+        m_modified( false )
+    {
+    }
+
+    /**
+     * Function Load
+     * reads the index file, in one read.  A missing or unreadable file gives
+     * an empty index.
+     */
+    void Load( const wxString& aFileName );
+
+    /**
+     * Function Save
+     * removes the libraries which do not exist anymore, and writes the index file if
+     * the index was modified since it was loaded.  The index is written to a temporary
+     * file renamed at the end, so another process never reads a partial index.
+     */
+    void Save( const wxString& aFileName );
+
+    /**
+     * Function Find
+     * copies to aLib the index data of the library aKey, if its hash is aHash.
+     * @return true if the library data is valid.
+     */
+    bool Find( const wxString& aKey, unsigned long long aHash, LIB& aLib )
+    {
+        MUTLOCK lock( m_lock );
+
+        LIBS::const_iterator it = m_libs.find( aKey );
+
+        if( it == m_libs.end() || it->second.m_hash != aHash )
+            return false;
+
+        aLib = it->second;
+        return true;
+    }
+
+    void Store( const wxString& aKey, const LIB& aLib )
+    {
+        MUTLOCK lock( m_lock );
+
+        m_libs[aKey] = aLib;
+        m_modified = true;
+    }
+
+    /**
+     * Function LibraryKey
+     * gives the index key, the path, the hash and the size in bytes of the library
+     * aNickname of aTable.  The hash covers the name, the modification time and the
+     * size of each file of the library.
+     * @return false if the library is not a local file or directory, which cannot
+     *  be indexed, and whose size is unknown.
+     */
+    static bool LibraryKey( FP_LIB_TABLE* aTable, const wxString& aNickname,
+                            wxString& aKey, wxString& aPath, unsigned long long& aHash,
+                            long long& aSize );
+
+private:
+    void parse( DSNLEXER& aLexer );
+
+    typedef std::map<wxString, LIB> LIBS;
+
+    LIBS    m_libs;
+    bool    m_modified;
+    MUTEX   m_lock;
+};
+
+
+void FOOTPRINT_INFO_INDEX::Load( const wxString& aFileName )
+{
+    m_libs.clear();
+    m_modified = false;
+
+    FILE* fp = wxFopen( aFileName, wxT( "rb" ) );
+
+    if( !fp )
+        return;
+
+    std::string content;
+
+    fseek( fp, 0, SEEK_END );
+    long size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+
+    if( size > 0 )
+    {
+        content.resize( size );
+
+        if( fread( &content[0], 1, size, fp ) != (size_t) size )
+            content.clear();
+    }
+
+    fclose( fp );
+
+    try
+    {
+        DSNLEXER lexer( content, aFileName );
+
+        parse( lexer );
+    }
+    catch( const IO_ERROR& )
+    {
+        // A broken index is rebuilt from the libraries
+        m_libs.clear();
+        m_modified = true;
+    }
+}
+
+
+void FOOTPRINT_INFO_INDEX::parse( DSNLEXER& aLexer )
+{
+    // (fp_info_index (version 2)
+    //   (lib "key" "path" hash
+    //     (fp "name" pad_count unique_pad_count "doc" "keywords")
+    //     ...)
+    //   ...)
+    if( aLexer.NextTok() == DSN_EOF )
+        return;
+
+    if( aLexer.CurTok() != DSN_LEFT )
+        aLexer.Expecting( DSN_LEFT );
+
+    aLexer.NeedSYMBOL();
+    aLexer.NeedLEFT();
+    aLexer.NeedSYMBOL();
+    aLexer.NeedNUMBER( "version" );
+
+    // An index written by another version is ignored, and rebuilt
+    if( atoi( aLexer.CurText() ) != FP_INFO_INDEX_VERSION )
+        return;
+
+    aLexer.NeedRIGHT();
+
+    while( aLexer.NextTok() == DSN_LEFT )
+    {
+        LIB lib;
+
+        aLexer.NeedSYMBOL();
+        aLexer.NeedSYMBOLorNUMBER();
+        wxString key = aLexer.FromUTF8();
+
+        aLexer.NeedSYMBOLorNUMBER();
+        lib.m_path = aLexer.FromUTF8();
+
+        aLexer.NeedNUMBER( "hash" );
+        lib.m_hash = strtoull( aLexer.CurText(), NULL, 10 );
+
+        while( aLexer.NextTok() == DSN_LEFT )
+        {
+            ENTRY entry;
+
+            aLexer.NeedSYMBOL();
+            aLexer.NeedSYMBOLorNUMBER();
+            entry.m_name = aLexer.FromUTF8();
+
+            aLexer.NeedNUMBER( "pad count" );
+            entry.m_padCount = atoi( aLexer.CurText() );
+
+            aLexer.NeedNUMBER( "unique pad count" );
+            entry.m_uniquePadCount = atoi( aLexer.CurText() );
+
+            aLexer.NeedSYMBOLorNUMBER();
+            entry.m_doc = aLexer.FromUTF8();
+
+            aLexer.NeedSYMBOLorNUMBER();
+            entry.m_keywords = aLexer.FromUTF8();
+
+            aLexer.NeedRIGHT();
+
+            lib.m_footprints.push_back( entry );
+        }
+
+        if( aLexer.CurTok() != DSN_RIGHT )
+            aLexer.Expecting( DSN_RIGHT );
+
+        m_libs[key] = lib;
+    }
+
+    if( aLexer.CurTok() != DSN_RIGHT )
+        aLexer.Expecting( DSN_RIGHT );
+}
+
+
+void FOOTPRINT_INFO_INDEX::Save( const wxString& aFileName )
+{
+    for( LIBS::iterator it = m_libs.begin(); it != m_libs.end(); )
+    {
+        const wxString& path = it->second.m_path;
+
+        if( wxFileName::FileExists( path ) || wxFileName::DirExists( path ) )
+        {
+            ++it;
+            continue;
+        }
+
+        m_libs.erase( it++ );
+        m_modified = true;
+    }
+
+    if( !m_modified )
+        return;
+
+    wxLogNull   noLog;      // the index is only a cache, it is not an error to not write it
+    wxString    tempName = wxFileName::CreateTempFileName( aFileName );
+
+    if( tempName.IsEmpty() )
+        return;
+
+    try
+    {
+        // a block {} scope to close the file before renaming it
+        {
+            FILE_OUTPUTFORMATTER out( tempName );
+
+            out.Print( 0, "(fp_info_index (version %d)\n", FP_INFO_INDEX_VERSION );
+
+            for( LIBS::const_iterator it = m_libs.begin(); it != m_libs.end(); ++it )
+            {
+                const LIB& lib = it->second;
+
+                out.Print( 1, "(lib %s %s %llu\n", out.Quotew( it->first ).c_str(),
+                           out.Quotew( lib.m_path ).c_str(), lib.m_hash );
+
+                for( unsigned ii = 0; ii < lib.m_footprints.size(); ++ii )
+                {
+                    const ENTRY& entry = lib.m_footprints[ii];
+
+                    out.Print( 2, "(fp %s %d %d %s %s)\n",
+                               out.Quotew( entry.m_name ).c_str(),
+                               entry.m_padCount, entry.m_uniquePadCount,
+                               out.Quotew( entry.m_doc ).c_str(),
+                               out.Quotew( entry.m_keywords ).c_str() );
+                }
+
+                out.Print( 1, ")\n" );
+            }
+
+            out.Print( 0, ")\n" );
+        }
+
+        if( wxRenameFile( tempName, aFileName, true ) )
+            m_modified = false;
+        else
+            wxRemoveFile( tempName );
+    }
+    catch( const IO_ERROR& )
+    {
+        // The libraries will be parsed again next time
+        wxRemoveFile( tempName );
+    }
+}
+
+
+/// Adds aSize bytes at aData to the 64 bits FNV-1a hash aHash.
+static void hashBytes( unsigned long long& aHash, const void* aData, size_t aSize )
+{
+    const unsigned char* bytes = (const unsigned char*) aData;
+
+    for( size_t ii = 0; ii < aSize; ++ii )
+    {
+        aHash ^= bytes[ii];
+        aHash *= 1099511628211ULL;
+    }
+}
+
+
+/// Adds the name, the modification time and the size of aFile to aHash.
+static void hashFile( unsigned long long& aHash, const wxFileName& aFile, long long& aSize )
+{
+    std::string name = TO_UTF8( aFile.GetFullName() );
+    long long   mtime = aFile.GetModificationTime().GetValue().GetValue();
+    long long   size = aFile.IsDir() ? 0 : aFile.GetSize().GetValue();
+
+    // The terminating null separates the name from the next values
+    hashBytes( aHash, name.c_str(), name.size() + 1 );
+    hashBytes( aHash, &mtime, sizeof( mtime ) );
+    hashBytes( aHash, &size, sizeof( size ) );
+
+    aSize += size;
+}
+
+
+bool FOOTPRINT_INFO_INDEX::LibraryKey( FP_LIB_TABLE* aTable, const wxString& aNickname,
+                                       wxString& aKey, wxString& aPath,
+                                       unsigned long long& aHash, long long& aSize )
+{
+    const FP_LIB_TABLE::ROW* row = aTable->FindRow( aNickname );
+
+    aPath = row->GetFullURI( true );
+    aKey = row->GetType() + wxT( " " ) + aPath + wxT( " " ) + row->GetOptions();
+    aHash = 14695981039346656037ULL;
+    aSize = 0;
+
+    // Any change in a library directory changes its modification time, or the one of
+    // the file which was changed.  Libraries which are not local (e.g. Github ones)
+    // are not indexed.
+    if( wxDir::Exists( aPath ) )
+    {
+        wxFileName dirName;
+
+        dirName.AssignDir( aPath );
+
+        // The modification time of the directory, for added and removed files
+        long long mtime = dirName.GetModificationTime().GetValue().GetValue();
+        hashBytes( aHash, &mtime, sizeof( mtime ) );
+
+        // The directory order is not specified: hash the files in name order
+        wxDir           dir( aPath );
+        wxArrayString   fileNames;
+        wxString        fileName;
+
+        for( bool cont = dir.GetFirst( &fileName, wxEmptyString, wxDIR_FILES );
+             cont; cont = dir.GetNext( &fileName ) )
+        {
+            fileNames.Add( fileName );
+        }
+
+        fileNames.Sort();
+
+        for( unsigned ii = 0; ii < fileNames.GetCount(); ++ii )
+            hashFile( aHash, wxFileName( aPath, fileNames[ii] ), aSize );
+
+        return true;
+    }
+
+    wxFileName fn( aPath );
+
+    if( fn.FileExists() )
+    {
+        hashFile( aHash, fn, aSize );
+        return true;
+    }
+
+    return false;
+}
 
 
 /*
@@ -107,17 +485,23 @@ void FOOTPRINT_INFO::load()
 
     std::auto_ptr<MODULE> m( fptable->FootprintLoad( m_nickname, m_fpname ) );
 
-    if( m.get() == NULL )    // Should happen only with malformed/broken libraries
+    setData( m.get() );
+}
+
+
+void FOOTPRINT_INFO::setData( const MODULE* aModule )
+{
+    if( aModule == NULL )    // Should happen only with malformed/broken libraries
     {
         m_pad_count = 0;
         m_unique_pad_count = 0;
     }
     else
     {
-        m_pad_count = m->GetPadCount( DO_NOT_INCLUDE_NPTH );
-        m_unique_pad_count = m->GetUniquePadCount( DO_NOT_INCLUDE_NPTH );
-        m_keywords  = m->GetKeywords();
-        m_doc       = m->GetDescription();
+        m_pad_count = aModule->GetPadCount( DO_NOT_INCLUDE_NPTH );
+        m_unique_pad_count = aModule->GetUniquePadCount( DO_NOT_INCLUDE_NPTH );
+        m_keywords  = aModule->GetKeywords();
+        m_doc       = aModule->GetDescription();
 
         // tell ensure_loaded() I'm loaded.
         m_loaded = true;
@@ -125,58 +509,251 @@ void FOOTPRINT_INFO::load()
 }
 
 
-void FOOTPRINT_LIST::loader_job( const wxString* aNicknameList, int aJobZ )
+/// A library to read by FOOTPRINT_LIST::ReadFootprintFiles()
+struct FOOTPRINT_LIST::LIB_JOB
 {
-    for( int i=0; i<aJobZ; ++i )
+    LIB_JOB( const wxString& aNickname ) :
+        m_nickname( aNickname ),
+        m_indexed( false ),
+        m_hash( 0 ),
+        m_size( 0 ),
+        m_failed( false ),
+        m_type( IO_MGR::KICAD ),
+        m_properties( NULL ),
+        m_perFootprint( false )
     {
-        const wxString& nickname = aNicknameList[i];
+    }
 
-        try
-        {
-            wxArrayString fpnames = m_lib_table->FootprintEnumerate( nickname );
+    /// Reading order of the libraries: biggest first, so no thread is left alone with
+    /// a big library at the end.  The size of remote libraries is unknown, and their
+    /// download is slow: they come first.
+    bool operator<( const LIB_JOB& aOther ) const
+    {
+        if( m_indexed != aOther.m_indexed )
+            return !m_indexed;
 
-            for( unsigned ni=0;  ni<fpnames.GetCount();  ++ni )
+        return m_size > aOther.m_size;
+    }
+
+    wxString    m_nickname;
+    wxString    m_key;              ///< index key, valid if m_indexed
+    wxString    m_path;             ///< library file or directory, valid if m_indexed
+    bool        m_indexed;          ///< false for libraries which cannot be indexed
+    unsigned long long m_hash;      ///< see FOOTPRINT_INFO_INDEX::LibraryKey()
+    long long   m_size;             ///< in bytes, unknown for libraries not indexed
+    bool        m_failed;           ///< the library was not found
+    IO_MGR::PCB_FILE_T m_type;      ///< the PLUGIN type of the library
+    const PROPERTIES* m_properties; ///< the options of the library
+    bool        m_perFootprint;     ///< the footprints are loaded by footprint_job()
+    FPILIST     m_footprints;       ///< the footprints read, in library order
+};
+
+
+/// A footprint of a library to load by FOOTPRINT_LIST::footprint_job()
+struct FOOTPRINT_LIST::FP_JOB
+{
+    FP_JOB( const LIB_JOB* aLib, FOOTPRINT_INFO* aFootprint ) :
+        m_lib( aLib ),
+        m_footprint( aFootprint )
+    {
+    }
+
+    const LIB_JOB*  m_lib;
+    FOOTPRINT_INFO* m_footprint;
+};
+
+
+/**
+ * The PLUGIN of a thread loading footprints, for the library it loaded a footprint from
+ * last.  The PLUGIN of a library in the FP_LIB_TABLE is not thread safe, so each thread
+ * has its own, which caches the library by itself.
+ */
+struct FOOTPRINT_LIST::FP_WORKER
+{
+    FP_WORKER() :
+        m_lib( NULL )
+    {
+    }
+
+    PLUGIN::RELEASER    m_plugin;
+    const LIB_JOB*      m_lib;      ///< the library of m_plugin
+};
+
+
+/// Adds a copy of aError to aErrors, mapping the unexpected into the expected.
+static void addError( boost::ptr_vector< IO_ERROR >& aErrors, const std::exception& aError )
+{
+    // This is a round about way to do this, but who knows what THROW_IO_ERROR()
+    // may be tricked out to do someday, keep it in the game.
+    try
+    {
+        THROW_IO_ERROR( aError.what() );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        aErrors.push_back( new IO_ERROR( ioe ) );
+    }
+}
+
+
+void FOOTPRINT_LIST::index_job( LIB_JOBS* aJobs, boost::ptr_vector< ERRLIST >* aErrors,
+                                int aJob, int aThread )
+{
+    LIB_JOB& job = (*aJobs)[aJob];
+
+    // Each thread has its own error list, which needs no lock.
+    ERRLIST& errors = (*aErrors)[aThread];
+
+    try
+    {
+        job.m_indexed = FOOTPRINT_INFO_INDEX::LibraryKey( m_lib_table, job.m_nickname,
+                                                          job.m_key, job.m_path, job.m_hash,
+                                                          job.m_size );
+
+        const FP_LIB_TABLE::ROW* row = m_lib_table->FindRow( job.m_nickname );
+
+        job.m_type = IO_MGR::EnumFromStr( row->GetType() );
+        job.m_properties = row->GetProperties();
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        job.m_failed = true;
+        errors.push_back( new IO_ERROR( ioe ) );
+    }
+    catch( const std::exception& se )
+    {
+        job.m_failed = true;
+        addError( errors, se );
+    }
+}
+
+
+void FOOTPRINT_LIST::loader_job( LIB_JOBS* aJobs, boost::ptr_vector< ERRLIST >* aErrors,
+                                 int aJob, int aThread )
+{
+    LIB_JOB& job = (*aJobs)[aJob];
+    ERRLIST& errors = (*aErrors)[aThread];
+
+    if( job.m_failed )
+        return;
+
+    try
+    {
+        bool indexed = m_index && job.m_indexed;
+
+        FOOTPRINT_INFO_INDEX::LIB lib;
+
+        if( indexed && m_index->Find( job.m_key, job.m_hash, lib ) )
+        {
+            for( unsigned ni = 0; ni < lib.m_footprints.size(); ++ni )
             {
-                FOOTPRINT_INFO* fpinfo = new FOOTPRINT_INFO( this, nickname, fpnames[ni] );
+                const FOOTPRINT_INFO_INDEX::ENTRY& entry = lib.m_footprints[ni];
 
-                addItem( fpinfo );
+                job.m_footprints.push_back( new FOOTPRINT_INFO( this, job.m_nickname, entry.m_name,
+                                                                entry.m_doc, entry.m_keywords,
+                                                                entry.m_padCount,
+                                                                entry.m_uniquePadCount ) );
             }
-        }
-        catch( const PARSE_ERROR& pe )
-        {
-            // m_errors.push_back is not thread safe, lock its MUTEX.
-            MUTLOCK lock( m_errors_lock );
 
-            ++m_error_count;        // modify only under lock
-            m_errors.push_back( new IO_ERROR( pe ) );
+            return;
         }
-        catch( const IO_ERROR& ioe )
+
+        wxArrayString fpnames = m_lib_table->FootprintEnumerate( job.m_nickname );
+
+        // A .pretty library parses each footprint file only when it is loaded: its
+        // footprints are loaded by footprint_job(), one job per footprint, so a big
+        // library is not loaded by a single thread.  The other PLUGINs read a whole
+        // library at once, and load it here.
+        if( job.m_type == IO_MGR::KICAD )
         {
-            MUTLOCK lock( m_errors_lock );
+            job.m_perFootprint = true;
+
+            for( unsigned ni=0;  ni<fpnames.GetCount();  ++ni )
+                job.m_footprints.push_back( new FOOTPRINT_INFO( this, job.m_nickname,
+                                                                fpnames[ni], false ) );
 
-            ++m_error_count;
-            m_errors.push_back( new IO_ERROR( ioe ) );
+            return;
         }
 
-        // Catch anything unexpected and map it into the expected.
-        // Likely even more important since this function runs on GUI-less
-        // worker threads.
-        catch( const std::exception& se )
+        lib.m_path = job.m_path;
+        lib.m_hash = job.m_hash;
+
+        for( unsigned ni=0;  ni<fpnames.GetCount();  ++ni )
         {
-            // This is a round about way to do this, but who knows what THROW_IO_ERROR()
-            // may be tricked out to do someday, keep it in the game.
-            try
-            {
-                THROW_IO_ERROR( se.what() );
-            }
-            catch( const IO_ERROR& ioe )
+            FOOTPRINT_INFO* fpinfo = new FOOTPRINT_INFO( this, job.m_nickname, fpnames[ni] );
+
+            job.m_footprints.push_back( fpinfo );
+
+            // A footprint which cannot be loaded will be tried again next time
+            if( !fpinfo->IsLoaded() )
+                indexed = false;
+
+            if( indexed )
             {
-                MUTLOCK lock( m_errors_lock );
+                FOOTPRINT_INFO_INDEX::ENTRY entry;
+
+                entry.m_name = fpinfo->GetFootprintName();
+                entry.m_doc = fpinfo->GetDoc();
+                entry.m_keywords = fpinfo->GetKeywords();
+                entry.m_padCount = fpinfo->GetPadCount();
+                entry.m_uniquePadCount = fpinfo->GetUniquePadCount();
 
-                ++m_error_count;
-                m_errors.push_back( new IO_ERROR( ioe ) );
+                lib.m_footprints.push_back( entry );
             }
         }
+
+        if( indexed )
+            m_index->Store( job.m_key, lib );
+    }
+    catch( const IO_ERROR& ioe )    // PARSE_ERRORs also
+    {
+        errors.push_back( new IO_ERROR( ioe ) );
+    }
+
+    // Catch anything unexpected and map it into the expected.
+    // Likely even more important since this function runs on GUI-less
+    // worker threads.
+    catch( const std::exception& se )
+    {
+        addError( errors, se );
+    }
+}
+
+
+void FOOTPRINT_LIST::footprint_job( FP_JOBS* aJobs, boost::ptr_vector< FP_WORKER >* aWorkers,
+                                    boost::ptr_vector< ERRLIST >* aErrors, int aJob, int aThread )
+{
+    FP_JOB&         job = (*aJobs)[aJob];
+    const LIB_JOB&  lib = *job.m_lib;
+    FP_WORKER&      worker = (*aWorkers)[aThread];
+    ERRLIST&        errors = (*aErrors)[aThread];
+
+    try
+    {
+        // The jobs of a library follow each other, so a thread mostly loads
+        // footprints of the same library with the same PLUGIN.
+        if( worker.m_lib != job.m_lib )
+        {
+            worker.m_plugin.set( IO_MGR::PluginFind( lib.m_type ) );
+            worker.m_lib = job.m_lib;
+        }
+
+        if( !(PLUGIN*) worker.m_plugin )
+            return;
+
+        std::auto_ptr<MODULE> m( worker.m_plugin->FootprintLoad( lib.m_path,
+                                                                 job.m_footprint->GetFootprintName(),
+                                                                 lib.m_properties ) );
+
+        job.m_footprint->setData( m.get() );
+    }
+    catch( const IO_ERROR& ioe )    // PARSE_ERRORs also
+    {
+        errors.push_back( new IO_ERROR( ioe ) );
+    }
+    catch( const std::exception& se )
+    {
+        addError( errors, se );
     }
 }
 
@@ -192,16 +769,34 @@ bool FOOTPRINT_LIST::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxString* a
     m_errors.clear();
     m_list.clear();
 
+    FOOTPRINT_INFO_INDEX index;
+    wxFileName indexFileName( GetKicadConfigPath(), FP_INFO_INDEX_FILENAME );
+
+    index.Load( indexFileName.GetFullPath() );
+    m_index = &index;
+
+    std::vector< wxString > nicknames;
+
     if( aNickname )
         // single footprint
-        loader_job( aNickname, 1 );
+        nicknames.push_back( *aNickname );
     else
-    {
-        std::vector< wxString > nicknames;
-
         // do all of them
         nicknames = aTable->GetLogicalLibs();
 
+    LIB_JOBS jobs;
+
+    for( unsigned i=0; i<nicknames.size(); ++i )
+        jobs.push_back( new LIB_JOB( nicknames[i] ) );
+
+    // Each thread adds its errors to its own list, without locking, the lists
+    // are merged once all the threads are done.
+    boost::ptr_vector< ERRLIST > errors;
+
+    for( int i=0; i<JOB_SCHEDULER::GetThreadCount( jobs.size() ); ++i )
+        errors.push_back( new ERRLIST );
+
+    {
         // Even though the PLUGIN API implementation is the place for the
         // locale toggling, in order to keep LOCAL_IO::C_count at 1 or greater
         // for the duration of all helper threads, we increment by one here via instantiation.
@@ -212,46 +807,95 @@ bool FOOTPRINT_LIST::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxString* a
         // none of them.
         LOCALE_IO   top_most_nesting;
 
-        // Something which will not invoke a thread copy constructor, one of many ways obviously:
-        typedef boost::ptr_vector< boost::thread >  MYTHREADS;
+        JOB_SCHEDULER::Run( jobs.size(),
+                            boost::bind( &FOOTPRINT_LIST::index_job, this, &jobs, &errors, _1, _2 ) );
 
-        MYTHREADS threads;
+        jobs.sort();
 
-        unsigned jobz = (nicknames.size() + READER_THREADS - 1) / READER_THREADS;
+        // The footprints are listed one library per job: the PLUGIN of a library in the
+        // FP_LIB_TABLE is not thread safe.
+        JOB_SCHEDULER::Run( jobs.size(),
+                            boost::bind( &FOOTPRINT_LIST::loader_job, this, &jobs, &errors, _1, _2 ) );
 
-        // Give each thread JOBZ nicknames to process.  The last portion of, or if the entire
-        // size() is small, I'll do myself.
-        for( unsigned i=0; i<nicknames.size();  )
-        {
-            if( i + jobz >= nicknames.size() )  // on the last iteration of this for(;;)
-            {
-                jobz = nicknames.size() - i;
+        // Then the footprints of the .pretty libraries are loaded one footprint per job,
+        // biggest libraries first, each thread with its own PLUGIN.
+        FP_JOBS fpJobs;
 
-                // Only a little bit to do, I'll do it myself on current thread.
-                // I am part of the READER_THREADS count.
-                loader_job( &nicknames[i], jobz );
-            }
-            else
-            {
-                // Delegate the job to a temporary thread created here.
-                threads.push_back( new boost::thread( &FOOTPRINT_LIST::loader_job,
-                        this, &nicknames[i], jobz ) );
-            }
+        for( unsigned i=0; i<jobs.size(); ++i )
+        {
+            if( !jobs[i].m_perFootprint )
+                continue;
 
-            i += jobz;
+            for( unsigned ni=0; ni<jobs[i].m_footprints.size(); ++ni )
+                fpJobs.push_back( FP_JOB( &jobs[i], &jobs[i].m_footprints[ni] ) );
         }
 
-        // Wait for all the worker threads to complete, it does not matter in what order
-        // we wait for them as long as a full sweep is made.  Think of the great race,
-        // everyone must finish.
-        for( unsigned i=0;  i<threads.size();  ++i )
+        boost::ptr_vector< FP_WORKER > workers;
+
+        for( int i=0; i<JOB_SCHEDULER::GetThreadCount( fpJobs.size() ); ++i )
+            workers.push_back( new FP_WORKER );
+
+        // There can be more footprint jobs than library jobs, and more threads
+        for( int i=errors.size(); i<JOB_SCHEDULER::GetThreadCount( fpJobs.size() ); ++i )
+            errors.push_back( new ERRLIST );
+
+        JOB_SCHEDULER::Run( fpJobs.size(),
+                            boost::bind( &FOOTPRINT_LIST::footprint_job, this, &fpJobs, &workers,
+                                         &errors, _1, _2 ) );
+    }
+
+    // A library is indexed only if all its footprints could be loaded, else they
+    // will be tried again next time
+    for( unsigned i=0; i<jobs.size(); ++i )
+    {
+        const LIB_JOB& job = jobs[i];
+
+        if( !job.m_perFootprint || !job.m_indexed )
+            continue;
+
+        FOOTPRINT_INFO_INDEX::LIB lib;
+
+        lib.m_path = job.m_path;
+        lib.m_hash = job.m_hash;
+
+        unsigned ni;
+
+        for( ni=0; ni<job.m_footprints.size(); ++ni )
         {
-            threads[i].join();
+            const FOOTPRINT_INFO& fpinfo = job.m_footprints[ni];
+
+            if( !fpinfo.m_loaded )
+                break;
+
+            FOOTPRINT_INFO_INDEX::ENTRY entry;
+
+            entry.m_name = fpinfo.m_fpname;
+            entry.m_doc = fpinfo.m_doc;
+            entry.m_keywords = fpinfo.m_keywords;
+            entry.m_padCount = fpinfo.m_pad_count;
+            entry.m_uniquePadCount = fpinfo.m_unique_pad_count;
+
+            lib.m_footprints.push_back( entry );
         }
 
-        m_list.sort();
+        if( ni == job.m_footprints.size() )
+            index.Store( job.m_key, lib );
     }
 
+    for( unsigned i=0; i<jobs.size(); ++i )
+        m_list.transfer( m_list.end(), jobs[i].m_footprints );
+
+    for( unsigned i=0; i<errors.size(); ++i )
+        m_errors.transfer( m_errors.end(), errors[i] );
+
+    m_error_count = m_errors.size();
+
+    if( !aNickname )
+        m_list.sort();
+
+    index.Save( indexFileName.GetFullPath() );
+    m_index = NULL;
+
     // The result of this function can be a blend of successes and failures, whose
     // mix is given by the Count()s of the two lists.  The return value indicates whether
     // an abort occurred, even true does not necessarily mean full success, although
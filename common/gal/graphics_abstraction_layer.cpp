@@ -85,6 +85,28 @@ void GAL::SetTextAttributes( const EDA_TEXT* aText )
 }
 
 
+void GAL::CopyAttributes( const GAL& aGal )
+{
+    screenSize        = aGal.screenSize;
+    worldUnitLength   = aGal.worldUnitLength;
+    screenDPI         = aGal.screenDPI;
+    lookAtPoint       = aGal.lookAtPoint;
+    zoomFactor        = aGal.zoomFactor;
+    worldScreenMatrix = aGal.worldScreenMatrix;
+    screenWorldMatrix = aGal.screenWorldMatrix;
+    worldScale        = aGal.worldScale;
+    flipX             = aGal.flipX;
+    flipY             = aGal.flipY;
+    lineWidth         = aGal.lineWidth;
+    isFillEnabled     = aGal.isFillEnabled;
+    isStrokeEnabled   = aGal.isStrokeEnabled;
+    fillColor         = aGal.fillColor;
+    strokeColor       = aGal.strokeColor;
+    layerDepth        = aGal.layerDepth;
+    depthRange        = aGal.depthRange;
+}
+
+
 void GAL::ComputeWorldScreenMatrix()
 {
     ComputeWorldScale();
@@ -0,0 +1,349 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <gal/recording_gal.h>
+
+using namespace KIGFX;
+
+
+RECORDING_GAL::RECORDING_GAL()
+{
+}
+
+
+RECORDING_GAL::~RECORDING_GAL()
+{
+}
+
+
+void RECORDING_GAL::DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+{
+    addCommand( CMD_LINE );
+    m_points.push_back( aStartPoint );
+    m_points.push_back( aEndPoint );
+}
+
+
+void RECORDING_GAL::DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint,
+                                 double aWidth )
+{
+    addCommand( CMD_SEGMENT );
+    m_points.push_back( aStartPoint );
+    m_points.push_back( aEndPoint );
+    m_values.push_back( aWidth );
+}
+
+
+void RECORDING_GAL::DrawPolyline( const std::deque<VECTOR2D>& aPointList )
+{
+    addCommand( CMD_POLYLINE, aPointList.size() );
+    m_points.insert( m_points.end(), aPointList.begin(), aPointList.end() );
+}
+
+
+void RECORDING_GAL::DrawPolyline( const VECTOR2D aPointList[], int aListSize )
+{
+    addCommand( CMD_POLYLINE, aListSize );
+    m_points.insert( m_points.end(), aPointList, aPointList + aListSize );
+}
+
+
+void RECORDING_GAL::DrawCircle( const VECTOR2D& aCenterPoint, double aRadius )
+{
+    addCommand( CMD_CIRCLE );
+    m_points.push_back( aCenterPoint );
+    m_values.push_back( aRadius );
+}
+
+
+void RECORDING_GAL::DrawArc( const VECTOR2D& aCenterPoint, double aRadius,
+                             double aStartAngle, double aEndAngle )
+{
+    addCommand( CMD_ARC );
+    m_points.push_back( aCenterPoint );
+    m_values.push_back( aRadius );
+    m_values.push_back( aStartAngle );
+    m_values.push_back( aEndAngle );
+}
+
+
+void RECORDING_GAL::DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+{
+    addCommand( CMD_RECTANGLE );
+    m_points.push_back( aStartPoint );
+    m_points.push_back( aEndPoint );
+}
+
+
+void RECORDING_GAL::DrawPolygon( const std::deque<VECTOR2D>& aPointList )
+{
+    addCommand( CMD_POLYGON, aPointList.size() );
+    m_points.insert( m_points.end(), aPointList.begin(), aPointList.end() );
+}
+
+
+void RECORDING_GAL::DrawPolygon( const VECTOR2D aPointList[], int aListSize )
+{
+    addCommand( CMD_POLYGON, aListSize );
+    m_points.insert( m_points.end(), aPointList, aPointList + aListSize );
+}
+
+
+void RECORDING_GAL::DrawCurve( const VECTOR2D& aStartPoint,    const VECTOR2D& aControlPointA,
+                               const VECTOR2D& aControlPointB, const VECTOR2D& aEndPoint )
+{
+    addCommand( CMD_CURVE );
+    m_points.push_back( aStartPoint );
+    m_points.push_back( aControlPointA );
+    m_points.push_back( aControlPointB );
+    m_points.push_back( aEndPoint );
+}
+
+
+void RECORDING_GAL::SetIsFill( bool aIsFillEnabled )
+{
+    GAL::SetIsFill( aIsFillEnabled );
+    addCommand( CMD_IS_FILL, aIsFillEnabled );
+}
+
+
+void RECORDING_GAL::SetIsStroke( bool aIsStrokeEnabled )
+{
+    GAL::SetIsStroke( aIsStrokeEnabled );
+    addCommand( CMD_IS_STROKE, aIsStrokeEnabled );
+}
+
+
+void RECORDING_GAL::SetFillColor( const COLOR4D& aColor )
+{
+    GAL::SetFillColor( aColor );
+    addCommand( CMD_FILL_COLOR );
+    m_values.push_back( aColor.r );
+    m_values.push_back( aColor.g );
+    m_values.push_back( aColor.b );
+    m_values.push_back( aColor.a );
+}
+
+
+void RECORDING_GAL::SetStrokeColor( const COLOR4D& aColor )
+{
+    GAL::SetStrokeColor( aColor );
+    addCommand( CMD_STROKE_COLOR );
+    m_values.push_back( aColor.r );
+    m_values.push_back( aColor.g );
+    m_values.push_back( aColor.b );
+    m_values.push_back( aColor.a );
+}
+
+
+void RECORDING_GAL::SetLineWidth( double aLineWidth )
+{
+    GAL::SetLineWidth( aLineWidth );
+    addCommand( CMD_LINE_WIDTH );
+    m_values.push_back( aLineWidth );
+}
+
+
+void RECORDING_GAL::SetLayerDepth( double aLayerDepth )
+{
+    GAL::SetLayerDepth( aLayerDepth );
+    addCommand( CMD_LAYER_DEPTH );
+    m_values.push_back( aLayerDepth );
+}
+
+
+void RECORDING_GAL::Transform( const MATRIX3x3D& aTransformation )
+{
+    addCommand( CMD_TRANSFORM );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        for( int j = 0; j < 3; ++j )
+            m_values.push_back( aTransformation.m_data[i][j] );
+    }
+}
+
+
+void RECORDING_GAL::Rotate( double aAngle )
+{
+    addCommand( CMD_ROTATE );
+    m_values.push_back( aAngle );
+}
+
+
+void RECORDING_GAL::Translate( const VECTOR2D& aTranslation )
+{
+    addCommand( CMD_TRANSLATE );
+    m_points.push_back( aTranslation );
+}
+
+
+void RECORDING_GAL::Scale( const VECTOR2D& aScale )
+{
+    addCommand( CMD_SCALE );
+    m_points.push_back( aScale );
+}
+
+
+void RECORDING_GAL::Save()
+{
+    addCommand( CMD_SAVE );
+}
+
+
+void RECORDING_GAL::Restore()
+{
+    addCommand( CMD_RESTORE );
+}
+
+
+void RECORDING_GAL::Replay( GAL* aGal, int aFirst, int aEnd ) const
+{
+    for( int i = aFirst; i < aEnd; ++i )
+    {
+        const COMMAND&  cmd = m_commands[i];
+        const VECTOR2D* p = cmd.m_point < m_points.size() ? &m_points[cmd.m_point] : NULL;
+        const double*   v = cmd.m_value < m_values.size() ? &m_values[cmd.m_value] : NULL;
+
+        switch( cmd.m_type )
+        {
+        case CMD_LINE:
+            aGal->DrawLine( p[0], p[1] );
+            break;
+
+        case CMD_SEGMENT:
+            aGal->DrawSegment( p[0], p[1], v[0] );
+            break;
+
+        case CMD_POLYLINE:
+            aGal->DrawPolyline( p, cmd.m_count );
+            break;
+
+        case CMD_CIRCLE:
+            aGal->DrawCircle( p[0], v[0] );
+            break;
+
+        case CMD_ARC:
+            aGal->DrawArc( p[0], v[0], v[1], v[2] );
+            break;
+
+        case CMD_RECTANGLE:
+            aGal->DrawRectangle( p[0], p[1] );
+            break;
+
+        case CMD_POLYGON:
+            aGal->DrawPolygon( p, cmd.m_count );
+            break;
+
+        case CMD_CURVE:
+            aGal->DrawCurve( p[0], p[1], p[2], p[3] );
+            break;
+
+        case CMD_IS_FILL:
+            aGal->SetIsFill( cmd.m_count );
+            break;
+
+        case CMD_IS_STROKE:
+            aGal->SetIsStroke( cmd.m_count );
+            break;
+
+        case CMD_FILL_COLOR:
+            aGal->SetFillColor( COLOR4D( v[0], v[1], v[2], v[3] ) );
+            break;
+
+        case CMD_STROKE_COLOR:
+            aGal->SetStrokeColor( COLOR4D( v[0], v[1], v[2], v[3] ) );
+            break;
+
+        case CMD_LINE_WIDTH:
+            aGal->SetLineWidth( v[0] );
+            break;
+
+        case CMD_LAYER_DEPTH:
+            aGal->SetLayerDepth( v[0] );
+            break;
+
+        case CMD_TRANSFORM:
+        {
+            MATRIX3x3D matrix;
+
+            for( int row = 0; row < 3; ++row )
+            {
+                for( int col = 0; col < 3; ++col )
+                    matrix.m_data[row][col] = v[row * 3 + col];
+            }
+
+            aGal->Transform( matrix );
+            break;
+        }
+
+        case CMD_ROTATE:
+            aGal->Rotate( v[0] );
+            break;
+
+        case CMD_TRANSLATE:
+            aGal->Translate( p[0] );
+            break;
+
+        case CMD_SCALE:
+            aGal->Scale( p[0] );
+            break;
+
+        case CMD_SAVE:
+            aGal->Save();
+            break;
+
+        case CMD_RESTORE:
+            aGal->Restore();
+            break;
+        }
+    }
+}
+
+
+void RECORDING_GAL::Clear()
+{
+    m_commands.clear();
+    m_points.clear();
+    m_values.clear();
+}
+
+
+bool RECORDING_GAL::IsSameRecording( const RECORDING_GAL& aOther ) const
+{
+    if( m_commands.size() != aOther.m_commands.size() || m_points != aOther.m_points
+        || m_values != aOther.m_values )
+        return false;
+
+    for( unsigned int i = 0; i < m_commands.size(); ++i )
+    {
+        const COMMAND& cmd = m_commands[i];
+        const COMMAND& other = aOther.m_commands[i];
+
+        if( cmd.m_type != other.m_type || cmd.m_count != other.m_count
+            || cmd.m_point != other.m_point || cmd.m_value != other.m_value )
+            return false;
+    }
+
+    return true;
+}
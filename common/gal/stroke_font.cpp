@@ -26,6 +26,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
+
 #include <gal/stroke_font.h>
 #include <gal/graphics_abstraction_layer.h>
 #include <wx/string.h>
@@ -38,12 +40,30 @@ const double STROKE_FONT::BOLD_FACTOR = 1.3;
 const double STROKE_FONT::STROKE_FONT_SCALE = 1.0 / 21.0;
 const double STROKE_FONT::ITALIC_TILT = 1.0 / 8;
 
+/// Maximal number of laid out lines of text kept in the cache
+const unsigned LAYOUT_CACHE_SIZE = 8192;
+
+/// Maximal length of a period while the layout cache churns, in cache sizes
+const unsigned MAX_BYPASS_PERIODS = 64;
+
+
+/// @return the start of the stroke being read in aGlyph, i.e. the end of the previous one
+static unsigned strokeStart( const GLYPH& aGlyph )
+{
+    return aGlyph.m_strokeEnds.empty() ? 0 : aGlyph.m_strokeEnds.back();
+}
+
 STROKE_FONT::STROKE_FONT( GAL* aGal ) :
     m_gal( aGal ),
     m_bold( false ),
     m_italic( false ),
     m_mirrored( false ),
-    m_overbar( false )
+    m_layoutCacheSize( LAYOUT_CACHE_SIZE ),
+    m_layoutCacheAdmits( true ),
+    m_layoutBypassPeriods( 1 ),
+    m_layoutLookups( 0 ),
+    m_layoutHits( 0 ),
+    m_layoutWasted( 0 )
 {
     // Default values
     m_glyphSize = VECTOR2D( 10.0, 10.0 );
@@ -56,18 +76,17 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
 {
     m_glyphs.clear();
     m_glyphBoundingBoxes.clear();
+    clearLayoutCache();
     m_glyphs.resize( aNewStrokeFontSize );
     m_glyphBoundingBoxes.resize( aNewStrokeFontSize );
 
     for( int j = 0; j < aNewStrokeFontSize; j++ )
     {
-        GLYPH    glyph;
+        GLYPH&   glyph = m_glyphs[j];
         double   glyphStartX = 0.0;
         double   glyphEndX = 0.0;
         VECTOR2D glyphBoundingX;
 
-        std::deque<VECTOR2D> pointList;
-
         int i = 0;
 
         while( aNewStrokeFont[j][i] )
@@ -90,10 +109,8 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
             else if( ( coordinate[0] == ' ' ) && ( coordinate[1] == 'R' ) )
             {
                 // Raise pen
-                if( pointList.size() > 0 )
-                    glyph.push_back( pointList );
-
-                pointList.clear();
+                if( glyph.m_points.size() > strokeStart( glyph ) )
+                    glyph.m_strokeEnds.push_back( glyph.m_points.size() );
             }
             else
             {
@@ -102,16 +119,14 @@ bool STROKE_FONT::LoadNewStrokeFont( const char* const aNewStrokeFont[], int aNe
                 point.x = (double) ( coordinate[0] - 'R' ) * STROKE_FONT_SCALE - glyphStartX;
 				// -10 is here to keep GAL rendering consistent with the legacy gfx stuff
                 point.y = (double) ( coordinate[1] - 'R' - 10) * STROKE_FONT_SCALE;
-                pointList.push_back( point );
+                glyph.m_points.push_back( point );
             }
 
             i += 2;
         }
 
-        if( pointList.size() > 0 )
-            glyph.push_back( pointList );
-
-        m_glyphs[j] = glyph;
+        if( glyph.m_points.size() > strokeStart( glyph ) )
+            glyph.m_strokeEnds.push_back( glyph.m_points.size() );
 
         // Compute the bounding box of the glyph
         m_glyphBoundingBoxes[j] = computeBoundingBox( glyph, glyphBoundingX );
@@ -136,13 +151,10 @@ BOX2D STROKE_FONT::computeBoundingBox( const GLYPH& aGLYPH, const VECTOR2D& aGLY
     boundingPoints.push_back( VECTOR2D( aGLYPHBoundingX.x, 0 ) );
     boundingPoints.push_back( VECTOR2D( aGLYPHBoundingX.y, 0 ) );
 
-    for( GLYPH::const_iterator pointListIt = aGLYPH.begin(); pointListIt != aGLYPH.end(); ++pointListIt )
+    for( std::vector<VECTOR2D>::const_iterator pointIt = aGLYPH.m_points.begin();
+            pointIt != aGLYPH.m_points.end(); ++pointIt )
     {
-        for( std::deque<VECTOR2D>::const_iterator pointIt = pointListIt->begin();
-                pointIt != pointListIt->end(); ++pointIt )
-        {
-            boundingPoints.push_back( VECTOR2D( aGLYPHBoundingX.x, pointIt->y ) );
-        }
+        boundingPoints.push_back( VECTOR2D( aGLYPHBoundingX.x, pointIt->y ) );
     }
 
     boundingBox.Compute( boundingPoints );
@@ -232,9 +244,53 @@ void STROKE_FONT::Draw( const UTF8& aText, const VECTOR2D& aPosition, double aRo
 
 void STROKE_FONT::drawSingleLineText( const UTF8& aText )
 {
-    // By default the overbar is turned off
-    m_overbar = false;
+    const LINE_LAYOUT& layout = layoutSingleLineText( aText );
+
+    for( unsigned i = 0; i + 1 < layout.m_overbars.size(); i += 2 )
+        m_gal->DrawLine( layout.m_overbars[i], layout.m_overbars[i + 1] );
+
+    const GLYPH& strokes = layout.m_strokes;
+    int start = 0;
+
+    for( unsigned i = 0; i < strokes.m_strokeEnds.size(); ++i )
+    {
+        int end = strokes.m_strokeEnds[i];
+
+        m_gal->DrawPolyline( &strokes.m_points[start], end - start );
+        start = end;
+    }
+}
+
+
+const STROKE_FONT::LINE_LAYOUT& STROKE_FONT::layoutSingleLineText( const UTF8& aText )
+{
+    LAYOUT_KEY key;
 
+    key.m_text              = aText;
+    key.m_glyphSize         = m_glyphSize;
+    key.m_horizontalJustify = m_horizontalJustify;
+    key.m_italic            = m_italic;
+    key.m_mirrored          = m_mirrored;
+
+    LAYOUT_CACHE::iterator cached = m_layoutCache.find( key );
+
+    countLayoutLookup( cached != m_layoutCache.end() );
+
+    if( cached != m_layoutCache.end() )
+    {
+        LAYOUT_ENTRY& entry = cached->second;
+
+        entry.m_used = true;
+        m_layoutLru.splice( m_layoutLru.begin(), m_layoutLru, entry.m_lruPos );
+
+        return entry.m_layout;
+    }
+
+    LINE_LAYOUT& layout = newLayout( key );
+    GLYPH&       strokes = layout.m_strokes;
+
+    // By default the overbar is turned off
+    bool        overbar = false;
     double      xOffset;
     VECTOR2D    glyphSize( m_glyphSize );
     double      overbar_italic_comp = 0.0;
@@ -242,23 +298,23 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
     // Compute the text size
     VECTOR2D textSize = computeTextSize( aText );
 
-    m_gal->Save();
-
     // Adjust the text position to the given alignment
+    double justifyOffset = 0.0;
+
     switch( m_horizontalJustify )
     {
     case GR_TEXT_HJUSTIFY_CENTER:
-        m_gal->Translate( VECTOR2D( -textSize.x / 2.0, 0 ) );
+        justifyOffset = -textSize.x / 2.0;
         break;
 
     case GR_TEXT_HJUSTIFY_RIGHT:
         if( !m_mirrored )
-            m_gal->Translate( VECTOR2D( -textSize.x, 0 ) );
+            justifyOffset = -textSize.x;
         break;
 
     case GR_TEXT_HJUSTIFY_LEFT:
         if( m_mirrored )
-            m_gal->Translate( VECTOR2D( -textSize.x, 0 ) );
+            justifyOffset = -textSize.x;
         break;
 
     default:
@@ -278,6 +334,13 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
         xOffset = 0.0;
     }
 
+    // FIXME italic should be done other way - referring to the lowest Y value of point
+    // because now italic fonts are translated a bit
+    double italicTilt = 0.0;
+
+    if( m_italic )
+        italicTilt = m_mirrored ? -0.1 : 0.1;
+
     // The overbar is indented inward at the beginning of an italicized section, but
     // must not be indented on subsequent letters to ensure that the bar segments
     // overlap.
@@ -292,7 +355,7 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
                 break;
 
             if( *chIt != '~' )      // It was a single tilda, it toggles overbar
-                m_overbar = !m_overbar;
+                overbar = !overbar;
 
             // If it is a double tilda, just process the second one
         }
@@ -302,10 +365,10 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
         if( dd >= (int) m_glyphBoundingBoxes.size() || dd < 0 )
             dd = '?' - ' ';
 
-        GLYPH& glyph = m_glyphs[dd];
-        BOX2D& bbox  = m_glyphBoundingBoxes[dd];
+        const GLYPH& glyph = m_glyphs[dd];
+        const BOX2D& bbox  = m_glyphBoundingBoxes[dd];
 
-        if( m_overbar && m_italic )
+        if( overbar && m_italic )
         {
             if( m_mirrored )
             {
@@ -317,7 +380,7 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
             }
         }
 
-        if( m_overbar )
+        if( overbar )
         {
             double overbar_start_x = xOffset;
             double overbar_start_y = -m_glyphSize.y * OVERBAR_HEIGHT;
@@ -330,46 +393,137 @@ void STROKE_FONT::drawSingleLineText( const UTF8& aText )
                 last_had_overbar = true;
             }
 
-            VECTOR2D startOverbar( overbar_start_x, overbar_start_y );
-            VECTOR2D endOverbar( overbar_end_x, overbar_end_y );
-
-            m_gal->DrawLine( startOverbar, endOverbar );
+            layout.m_overbars.push_back( VECTOR2D( overbar_start_x + justifyOffset,
+                                                   overbar_start_y ) );
+            layout.m_overbars.push_back( VECTOR2D( overbar_end_x + justifyOffset,
+                                                   overbar_end_y ) );
         }
         else
         {
             last_had_overbar = false;
         }
 
-        for( GLYPH::iterator pointListIt = glyph.begin(); pointListIt != glyph.end();
-             ++pointListIt )
-        {
-            std::deque<VECTOR2D> pointListScaled;
+        // Scale and move the points of the glyph to their place in the line, in a single
+        // loop without branches over the contiguous points
+        int first = strokes.m_points.size();
+        int count = glyph.m_points.size();
+        double x0 = xOffset + justifyOffset;
 
-            for( std::deque<VECTOR2D>::iterator pointIt = pointListIt->begin();
-                 pointIt != pointListIt->end(); ++pointIt )
-            {
-                VECTOR2D pointPos( pointIt->x * glyphSize.x + xOffset, pointIt->y * glyphSize.y );
-
-                if( m_italic )
-                {
-                    // FIXME should be done other way - referring to the lowest Y value of point
-                    // because now italic fonts are translated a bit
-                    if( m_mirrored )
-                        pointPos.x += pointPos.y * 0.1;
-                    else
-                        pointPos.x -= pointPos.y * 0.1;
-                }
-
-                pointListScaled.push_back( pointPos );
-            }
+        strokes.m_points.resize( first + count );
+
+        const VECTOR2D* src = count ? &glyph.m_points[0] : NULL;
+        VECTOR2D*       dst = count ? &strokes.m_points[first] : NULL;
 
-            m_gal->DrawPolyline( pointListScaled );
+        for( int i = 0; i < count; ++i )
+        {
+            double y = src[i].y * glyphSize.y;
+
+            dst[i].x = src[i].x * glyphSize.x + x0 - y * italicTilt;
+            dst[i].y = y;
         }
 
+        for( unsigned i = 0; i < glyph.m_strokeEnds.size(); ++i )
+            strokes.m_strokeEnds.push_back( first + glyph.m_strokeEnds[i] );
+
         xOffset += glyphSize.x * bbox.GetEnd().x;
     }
 
-    m_gal->Restore();
+    return layout;
+}
+
+
+void STROKE_FONT::SetLayoutCacheSize( unsigned aSize )
+{
+    m_layoutCacheSize = aSize;
+    clearLayoutCache();
+}
+
+
+void STROKE_FONT::clearLayoutCache()
+{
+    m_layoutCache.clear();
+    m_layoutLru.clear();
+    m_layoutCacheAdmits = true;
+    m_layoutBypassPeriods = 1;
+    m_layoutLookups = 0;
+    m_layoutHits = 0;
+    m_layoutWasted = 0;
+}
+
+
+void STROKE_FONT::countLayoutLookup( bool aHit )
+{
+    ++m_layoutLookups;
+
+    if( aHit )
+        ++m_layoutHits;
+
+    unsigned period = m_layoutCacheSize;
+
+    if( !m_layoutCacheAdmits )
+        period *= m_layoutBypassPeriods;
+
+    if( m_layoutLookups < period )
+        return;
+
+    if( m_layoutCacheAdmits )
+    {
+        // Most of the evicted layouts were never found: the texts drawn do not fit,
+        // so keep the cached ones instead of replacing them.  The churn periods get
+        // longer each time the cache churns again, so that they cover a whole redraw.
+        if( m_layoutWasted > m_layoutLookups / 2 )
+        {
+            m_layoutCacheAdmits = false;
+            m_layoutBypassPeriods = std::min( 2 * m_layoutBypassPeriods, MAX_BYPASS_PERIODS );
+        }
+        else
+        {
+            m_layoutBypassPeriods = 1;
+        }
+    }
+    else
+    {
+        // The cached layouts are not the texts drawn anymore (e.g. the view was zoomed)
+        if( m_layoutHits < m_layoutLookups / 8 )
+            m_layoutCacheAdmits = true;
+    }
+
+    m_layoutLookups = 0;
+    m_layoutHits = 0;
+    m_layoutWasted = 0;
+}
+
+
+STROKE_FONT::LINE_LAYOUT& STROKE_FONT::newLayout( const LAYOUT_KEY& aKey )
+{
+    if( !m_layoutCacheAdmits || m_layoutCacheSize == 0 )
+    {
+        m_uncachedLayout.m_strokes.m_points.clear();
+        m_uncachedLayout.m_strokes.m_strokeEnds.clear();
+        m_uncachedLayout.m_overbars.clear();
+
+        return m_uncachedLayout;
+    }
+
+    if( m_layoutCache.size() >= m_layoutCacheSize )
+    {
+        LAYOUT_CACHE::iterator oldest = m_layoutCache.find( *m_layoutLru.back() );
+
+        if( !oldest->second.m_used )
+            ++m_layoutWasted;
+
+        m_layoutLru.pop_back();
+        m_layoutCache.erase( oldest );
+    }
+
+    LAYOUT_CACHE::iterator entry = m_layoutCache.insert(
+            std::make_pair( aKey, LAYOUT_ENTRY() ) ).first;
+
+    m_layoutLru.push_front( &entry->first );
+    entry->second.m_lruPos = m_layoutLru.begin();
+    entry->second.m_used = false;
+
+    return entry->second.m_layout;
 }
 
 
@@ -27,6 +27,9 @@
 
 using boost::optional;
 
+boost::atomic<uint64_t> SHAPE_LINE_CHAIN::s_stampChanges( 0 );
+
+
 bool SHAPE_LINE_CHAIN::Collide( const VECTOR2I& aP, int aClearance ) const
 {
     // fixme: ugly!
@@ -88,6 +91,8 @@ void SHAPE_LINE_CHAIN::Replace( int aStartIndex, int aEndIndex, const VECTOR2I&
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateStamp();
+
     if( aStartIndex == aEndIndex )
         m_points[aStartIndex] = aP;
     else
@@ -106,6 +111,7 @@ void SHAPE_LINE_CHAIN::Replace( int aStartIndex, int aEndIndex, const SHAPE_LINE
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateStamp();
     m_points.erase( m_points.begin() + aStartIndex, m_points.begin() + aEndIndex + 1 );
     m_points.insert( m_points.begin() + aStartIndex, aLine.m_points.begin(), aLine.m_points.end() );
 }
@@ -119,6 +125,7 @@ void SHAPE_LINE_CHAIN::Remove( int aStartIndex, int aEndIndex )
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateStamp();
     m_points.erase( m_points.begin() + aStartIndex, m_points.begin() + aEndIndex + 1 );
 }
 
@@ -167,6 +174,7 @@ int SHAPE_LINE_CHAIN::Split( const VECTOR2I& aP )
     if( ii >= 0 )
     {
         m_points.insert( m_points.begin() + ii + 1, aP );
+        invalidateStamp();
 
         return ii + 1;
     }
@@ -414,6 +422,8 @@ SHAPE_LINE_CHAIN& SHAPE_LINE_CHAIN::Simplify()
 {
     std::vector<VECTOR2I> pts_unique;
 
+    invalidateStamp();
+
     if( PointCount() < 2 )
     {
         return *this;
@@ -565,6 +575,7 @@ bool SHAPE_LINE_CHAIN::Parse( std::stringstream& aStream )
     int n_pts;
 
     m_points.clear();
+    invalidateStamp();
     aStream >> n_pts;
     aStream >> m_closed;
 
@@ -31,17 +31,27 @@
 #include <set>
 #include <list>
 #include <algorithm>
+#include <cmath>
 
 #include <boost/foreach.hpp>
 
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
+#include <geometry/rtree.h>
+#include <ki_mutex.h>
+
+#include <boost/atomic.hpp>
 
 using namespace ClipperLib;
 
 SHAPE_POLY_SET::SHAPE_POLY_SET() :
-    SHAPE( SH_POLY_SET )
+    SHAPE( SH_POLY_SET ),
+    m_splitOperations( false ),
+    m_gridColumns( 0 ),
+    m_gridRows( 0 ),
+    m_cellWidth( 1 ),
+    m_cellHeight( 1 )
 {
 
 }
@@ -54,6 +64,8 @@ SHAPE_POLY_SET::~SHAPE_POLY_SET()
 
 int SHAPE_POLY_SET::NewOutline()
 {
+    invalidateEdgeIndex();
+
     SHAPE_LINE_CHAIN empty_path;
     POLYGON poly;
     poly.push_back( empty_path );
@@ -64,6 +76,8 @@ int SHAPE_POLY_SET::NewOutline()
 
 int SHAPE_POLY_SET::NewHole( int aOutline )
 {
+    invalidateEdgeIndex();
+
     m_polys.back().push_back( SHAPE_LINE_CHAIN() );
 
     return m_polys.back().size() - 2;
@@ -72,6 +86,8 @@ int SHAPE_POLY_SET::NewHole( int aOutline )
 
 int SHAPE_POLY_SET::Append( int x, int y, int aOutline, int aHole )
 {
+    invalidateEdgeIndex();
+
     if( aOutline < 0 )
         aOutline += m_polys.size();
 
@@ -150,6 +166,8 @@ VECTOR2I& SHAPE_POLY_SET::Vertex( int index, int aOutline , int aHole )
 
 int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 {
+    invalidateEdgeIndex();
+
     assert( aOutline.IsClosed() );
 
     POLYGON poly;
@@ -164,6 +182,8 @@ int SHAPE_POLY_SET::AddOutline( const SHAPE_LINE_CHAIN& aOutline )
 
 int SHAPE_POLY_SET::AddHole( const SHAPE_LINE_CHAIN& aHole, int aOutline )
 {
+    invalidateEdgeIndex();
+
     assert ( m_polys.size() );
 
     if( aOutline < 0 )
@@ -206,31 +226,287 @@ const SHAPE_LINE_CHAIN SHAPE_POLY_SET::convertFromClipper( const Path& aPath )
     return lc;
 }
 
-void SHAPE_POLY_SET::booleanOp( ClipType aType, const SHAPE_POLY_SET& aOtherShape,
-                                bool aFastMode )
+///> Operations on smaller sets are run in a single Clipper pass: splitting them is not worth it
+static const int SPLIT_MIN_VERTICES = 4096;
+
+
+///> A set of polygons which does not interact with the polygons of other groups
+struct POLYGON_GROUP
+{
+    BOX2I m_bbox;
+    std::vector<const SHAPE_POLY_SET::POLYGON*> m_subject;
+    std::vector<const SHAPE_POLY_SET::POLYGON*> m_clip;
+};
+
+
+struct BOX_LEFT_COMPARATOR
+{
+    BOX_LEFT_COMPARATOR( const std::vector<BOX2I>& aBoxes ) : m_boxes( aBoxes ) {}
+
+    bool operator()( int aFirst, int aSecond ) const
+    {
+        return m_boxes[aFirst].GetX() < m_boxes[aSecond].GetX();
+    }
+
+    const std::vector<BOX2I>& m_boxes;
+};
+
+
+static int findGroupRoot( std::vector<int>& aParent, int aIdx )
+{
+    while( aParent[aIdx] != aIdx )
+    {
+        aParent[aIdx] = aParent[aParent[aIdx]];
+        aIdx = aParent[aIdx];
+    }
+
+    return aIdx;
+}
+
+
+/**
+ * Function groupOverlappingBoxes
+ * puts boxes which overlap (directly or through other boxes) in the same group.
+ * Touching boxes count as overlapping. Groups are numbered in the order of their
+ * first box, so the grouping only depends on the input.
+ * @param aBoxes is the list of (normalized) boxes
+ * @param aGroups receives the group number of each box
+ * @return the number of groups
+ */
+static int groupOverlappingBoxes( const std::vector<BOX2I>& aBoxes, std::vector<int>& aGroups )
+{
+    int count = aBoxes.size();
+    std::vector<int> parent( count );
+    std::vector<int> order( count );
+
+    for( int i = 0; i < count; i++ )
+        parent[i] = order[i] = i;
+
+    // Sweep the boxes from left to right, keeping the ones which span the sweep line
+    std::sort( order.begin(), order.end(), BOX_LEFT_COMPARATOR( aBoxes ) );
+
+    std::vector<int> active;
+
+    for( int i = 0; i < count; i++ )
+    {
+        const BOX2I& box = aBoxes[order[i]];
+        unsigned int kept = 0;
+
+        for( unsigned int j = 0; j < active.size(); j++ )
+        {
+            const BOX2I& other = aBoxes[active[j]];
+
+            if( other.GetRight() < box.GetX() )
+                continue;
+
+            active[kept++] = active[j];
+
+            if( other.GetY() <= box.GetBottom() && box.GetY() <= other.GetBottom() )
+            {
+                int r1 = findGroupRoot( parent, order[i] );
+                int r2 = findGroupRoot( parent, active[j] );
+
+                if( r1 != r2 )
+                    parent[std::max( r1, r2 )] = std::min( r1, r2 );
+            }
+        }
+
+        active.resize( kept );
+        active.push_back( order[i] );
+    }
+
+    std::vector<int> label( count, -1 );
+    int groupCount = 0;
+
+    aGroups.resize( count );
+
+    for( int i = 0; i < count; i++ )
+    {
+        int root = findGroupRoot( parent, i );
+
+        if( label[root] < 0 )
+            label[root] = groupCount++;
+
+        aGroups[i] = label[root];
+    }
+
+    return groupCount;
+}
+
+
+static bool polygonBBox( const SHAPE_POLY_SET::POLYGON& aPoly, int aClearance, BOX2I& aBBox )
+{
+    bool valid = false;
+
+    for( unsigned int i = 0; i < aPoly.size(); i++ )
+    {
+        if( aPoly[i].PointCount() == 0 )
+            continue;
+
+        if( valid )
+            aBBox.Merge( aPoly[i].BBox( aClearance ) );
+        else
+            aBBox = aPoly[i].BBox( aClearance );
+
+        valid = true;
+    }
+
+    return valid;
+}
+
+
+struct GROUP_CLIP_ADDER
+{
+    GROUP_CLIP_ADDER( const SHAPE_POLY_SET::POLYGON* aClip ) : m_clip( aClip ) {}
+
+    bool operator()( POLYGON_GROUP* aGroup )
+    {
+        aGroup->m_clip.push_back( m_clip );
+        return true;
+    }
+
+    const SHAPE_POLY_SET::POLYGON* m_clip;
+};
+
+
+/**
+ * Function splitInGroups
+ * splits the operands of a boolean operation in groups of polygons which can be
+ * processed independently.
+ * For unions, subject and clip polygons are grouped together. For differences and
+ * intersections, only the subject polygons are grouped, and each clip polygon is added
+ * to every group it may touch (clip polygons touching no group cannot change the result).
+ * @param aClearance inflates the polygon bounding boxes, for offset operations
+ * @return false if the operation is better run in a single pass
+ */
+static bool splitInGroups( ClipType aType,
+                           const std::vector<SHAPE_POLY_SET::POLYGON>& aSubject,
+                           const std::vector<SHAPE_POLY_SET::POLYGON>& aClip,
+                           int aClearance, std::vector<POLYGON_GROUP>& aGroups )
+{
+    if( aType == ctXor )
+        return false;
+
+    int vertices = 0;
+
+    for( unsigned int i = 0; i < aSubject.size(); i++ )
+        for( unsigned int j = 0; j < aSubject[i].size(); j++ )
+            vertices += aSubject[i][j].PointCount();
+
+    for( unsigned int i = 0; i < aClip.size(); i++ )
+        for( unsigned int j = 0; j < aClip[i].size(); j++ )
+            vertices += aClip[i][j].PointCount();
+
+    if( vertices < SPLIT_MIN_VERTICES )
+        return false;
+
+    bool groupClip = ( aType == ctUnion );
+    unsigned int count = aSubject.size() + ( groupClip ? aClip.size() : 0 );
+    std::vector<BOX2I> boxes( count );
+
+    for( unsigned int i = 0; i < count; i++ )
+    {
+        const SHAPE_POLY_SET::POLYGON& poly = i < aSubject.size() ?
+                                              aSubject[i] : aClip[i - aSubject.size()];
+
+        // Empty outlines have no meaningful bounding box; they are rare enough to
+        // simply run the operation in one pass
+        if( !polygonBBox( poly, aClearance, boxes[i] ) )
+            return false;
+
+        boxes[i].Normalize();
+    }
+
+    std::vector<int> groupOf;
+    int groupCount = groupOverlappingBoxes( boxes, groupOf );
+
+    if( groupCount < 2 )
+        return false;
+
+    aGroups.clear();
+    aGroups.resize( groupCount );
+
+    for( unsigned int i = 0; i < count; i++ )
+    {
+        POLYGON_GROUP& group = aGroups[groupOf[i]];
+
+        if( group.m_subject.empty() && group.m_clip.empty() )
+            group.m_bbox = boxes[i];
+        else
+            group.m_bbox.Merge( boxes[i] );
+
+        if( i < aSubject.size() )
+            group.m_subject.push_back( &aSubject[i] );
+        else
+            group.m_clip.push_back( &aClip[i - aSubject.size()] );
+    }
+
+    if( !groupClip )
+    {
+        RTree<POLYGON_GROUP*, int, 2, float> index;
+
+        for( int i = 0; i < groupCount; i++ )
+        {
+            const BOX2I& bbox = aGroups[i].m_bbox;
+            int mmin[2] = { bbox.GetX(), bbox.GetY() };
+            int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+            index.Insert( mmin, mmax, &aGroups[i] );
+        }
+
+        for( unsigned int i = 0; i < aClip.size(); i++ )
+        {
+            BOX2I bbox;
+
+            if( !polygonBBox( aClip[i], aClearance, bbox ) )
+                continue;
+
+            bbox.Normalize();
+
+            int mmin[2] = { bbox.GetX(), bbox.GetY() };
+            int mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+            GROUP_CLIP_ADDER adder( &aClip[i] );
+
+            index.Search( mmin, mmax, adder );
+        }
+    }
+
+    return true;
+}
+
+
+void SHAPE_POLY_SET::booleanOpGroup( ClipType aType, const POLYGON_REFS& aSubject,
+                                     const POLYGON_REFS& aClip, bool aFastMode, Polyset& aResult )
 {
     Clipper c;
 
     if( !aFastMode )
         c.StrictlySimple( true );
 
-    BOOST_FOREACH( const POLYGON& poly, m_polys )
+    BOOST_FOREACH( const POLYGON* poly, aSubject )
     {
-        for( unsigned int i = 0; i < poly.size(); i++ )
-            c.AddPath( convertToClipper( poly[i], i > 0 ? false : true ), ptSubject, true );
+        for( unsigned int i = 0; i < poly->size(); i++ )
+            c.AddPath( convertToClipper( (*poly)[i], i > 0 ? false : true ), ptSubject, true );
     }
 
-    BOOST_FOREACH( const POLYGON& poly, aOtherShape.m_polys )
+    BOOST_FOREACH( const POLYGON* poly, aClip )
     {
-        for( unsigned int i = 0; i < poly.size(); i++ )
-            c.AddPath( convertToClipper( poly[i], i > 0 ? false : true ), ptClip, true );
+        for( unsigned int i = 0; i < poly->size(); i++ )
+            c.AddPath( convertToClipper( (*poly)[i], i > 0 ? false : true ), ptClip, true );
     }
 
     PolyTree solution;
 
     c.Execute( aType, solution, pftNonZero, pftNonZero );
 
-    importTree( &solution );
+    importTree( &solution, aResult );
+}
+
+
+void SHAPE_POLY_SET::booleanOp( ClipType aType, const SHAPE_POLY_SET& aOtherShape,
+                                bool aFastMode )
+{
+    booleanOp( aType, *this, aOtherShape, aFastMode );
 }
 
 
@@ -239,28 +515,34 @@ void SHAPE_POLY_SET::booleanOp( ClipperLib::ClipType aType,
                                 const SHAPE_POLY_SET& aOtherShape,
                                 bool aFastMode )
 {
-    Clipper c;
-
-    if( !aFastMode )
-        c.StrictlySimple( true );
+    std::vector<POLYGON_GROUP> groups;
 
-    BOOST_FOREACH( const POLYGON& poly, aShape.m_polys )
+    if( !m_splitOperations
+        || !splitInGroups( aType, aShape.m_polys, aOtherShape.m_polys, 0, groups ) )
     {
-        for( unsigned int i = 0; i < poly.size(); i++ )
-            c.AddPath( convertToClipper( poly[i], i > 0 ? false : true ), ptSubject, true );
-    }
+        groups.resize( 1 );
 
-    BOOST_FOREACH( const POLYGON& poly, aOtherShape.m_polys )
-    {
-        for( unsigned int i = 0; i < poly.size(); i++ )
-            c.AddPath( convertToClipper( poly[i], i > 0 ? false : true ), ptClip, true );
+        BOOST_FOREACH( const POLYGON& poly, aShape.m_polys )
+            groups[0].m_subject.push_back( &poly );
+
+        BOOST_FOREACH( const POLYGON& poly, aOtherShape.m_polys )
+            groups[0].m_clip.push_back( &poly );
     }
 
-    PolyTree solution;
+    std::vector<Polyset> results( groups.size() );
 
-    c.Execute( aType, solution, pftNonZero, pftNonZero );
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if( groups.size() > 1 )
+#endif /* USE_OPENMP */
+    for( int i = 0; i < (int) groups.size(); i++ )
+        booleanOpGroup( aType, groups[i].m_subject, groups[i].m_clip, aFastMode, results[i] );
+
+    // aShape or aOtherShape may be this set: replace its contents only now
+    invalidateEdgeIndex();
+    m_polys.clear();
 
-    importTree( &solution );
+    for( unsigned int i = 0; i < results.size(); i++ )
+        m_polys.insert( m_polys.end(), results[i].begin(), results[i].end() );
 }
 
 
@@ -300,14 +582,15 @@ void SHAPE_POLY_SET::BooleanIntersection( const SHAPE_POLY_SET& a, const SHAPE_P
 }
 
 
-void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
+void SHAPE_POLY_SET::inflateGroup( const POLYGON_REFS& aPolys, int aFactor,
+                                   int aCircleSegmentsCount, Polyset& aResult )
 {
     ClipperOffset c;
 
-    BOOST_FOREACH( const POLYGON& poly, m_polys )
+    BOOST_FOREACH( const POLYGON* poly, aPolys )
     {
-        for( unsigned int i = 0; i < poly.size(); i++ )
-            c.AddPath( convertToClipper( poly[i], i > 0 ? false : true ), jtRound, etClosedPolygon );
+        for( unsigned int i = 0; i < poly->size(); i++ )
+            c.AddPath( convertToClipper( (*poly)[i], i > 0 ? false : true ), jtRound, etClosedPolygon );
     }
 
     PolyTree solution;
@@ -316,14 +599,45 @@ void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
 
     c.Execute( solution, aFactor );
 
-    importTree( &solution );
+    importTree( &solution, aResult );
 }
 
 
-void SHAPE_POLY_SET::importTree( PolyTree* tree)
+void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
 {
+    std::vector<POLYGON_GROUP> groups;
+    Polyset empty;
+
+    // Polygons grow by aFactor (plus rounding), so they may touch up to that distance
+    if( !m_splitOperations
+        || !splitInGroups( ctUnion, m_polys, empty, std::max( aFactor, 0 ) + 1, groups ) )
+    {
+        groups.resize( 1 );
+
+        BOOST_FOREACH( const POLYGON& poly, m_polys )
+            groups[0].m_subject.push_back( &poly );
+    }
+
+    std::vector<Polyset> results( groups.size() );
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if( groups.size() > 1 )
+#endif /* USE_OPENMP */
+    for( int i = 0; i < (int) groups.size(); i++ )
+        inflateGroup( groups[i].m_subject, aFactor, aCircleSegmentsCount, results[i] );
+
+    invalidateEdgeIndex();
     m_polys.clear();
 
+    for( unsigned int i = 0; i < results.size(); i++ )
+        m_polys.insert( m_polys.end(), results[i].begin(), results[i].end() );
+}
+
+
+void SHAPE_POLY_SET::importTree( PolyTree* tree, Polyset& aResult )
+{
+    aResult.clear();
+
     for( PolyNode* n = tree->GetFirst(); n; n = n->GetNext() )
     {
         if( !n->IsHole() )
@@ -334,7 +648,7 @@ void SHAPE_POLY_SET::importTree( PolyTree* tree)
             for( unsigned int i = 0; i < n->Childs.size(); i++ )
                 paths.push_back( convertFromClipper( n->Childs[i]->Contour ) );
 
-            m_polys.push_back(paths);
+            aResult.push_back(paths);
         }
     }
 }
@@ -553,11 +867,14 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 void SHAPE_POLY_SET::Fracture( bool aFastMode )
 {
     Simplify( aFastMode ); // remove overlapping holes/degeneracy
-
-    BOOST_FOREACH( POLYGON& paths, m_polys )
-    {
-        fractureSingle( paths );
-    }
+    invalidateEdgeIndex();
+
+    // Each polygon is fractured on its own, so the work can be shared between threads
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if( m_polys.size() > 1 )
+#endif /* USE_OPENMP */
+    for( int i = 0; i < (int) m_polys.size(); i++ )
+        fractureSingle( m_polys[i] );
 }
 
 
@@ -593,6 +910,8 @@ const std::string SHAPE_POLY_SET::Format() const
 
 bool SHAPE_POLY_SET::Parse( std::stringstream& aStream )
 {
+    invalidateEdgeIndex();
+
     std::string tmp;
 
     aStream >> tmp;
@@ -667,18 +986,24 @@ const BOX2I SHAPE_POLY_SET::BBox( int aClearance ) const
 
 void SHAPE_POLY_SET::RemoveAllContours()
 {
+    invalidateEdgeIndex();
+
     m_polys.clear();
 }
 
 
 void SHAPE_POLY_SET::DeletePolygon( int aIdx )
 {
+    invalidateEdgeIndex();
+
     m_polys.erase( m_polys.begin() + aIdx );
 }
 
 
 void SHAPE_POLY_SET::Append( const SHAPE_POLY_SET& aSet )
 {
+    invalidateEdgeIndex();
+
     m_polys.insert( m_polys.end(), aSet.m_polys.begin(), aSet.m_polys.end() );
 }
 
@@ -689,87 +1014,458 @@ void SHAPE_POLY_SET::Append( const VECTOR2I& aP, int aOutline, int aHole )
 }
 
 
-bool SHAPE_POLY_SET::Contains( const VECTOR2I& aP, int aSubpolyIndex ) const
-{
-    // fixme: support holes!
+///> Outlines with fewer vertices are tested edge by edge, without an index
+static const int EDGE_INDEX_MIN_VERTICES = 32;
 
-    if( m_polys.size() == 0 ) // empty set?
-        return false;
+///> Average number of edges in each bucket of the edge index
+static const int EDGE_INDEX_BUCKET_SIZE = 4;
 
-    if( aSubpolyIndex >= 0 )
-        return pointInPolygon( aP, m_polys[aSubpolyIndex][0] );
+///> Outlines touching more cells of the outline grid are tested by every query
+static const int OUTLINE_GRID_MAX_CELLS = 16;
+
+
+/**
+ * Function edgeCrossing
+ * is the per-edge step of the point in polygon test.
+ * @return 1 if the horizontal ray going right from aP crosses the edge ip-ipNext, 0 if it
+ * does not, -1 if aP lies on the edge.
+ */
+static inline int edgeCrossing( const VECTOR2I& aP, const VECTOR2I& ip, const VECTOR2I& ipNext )
+{
+    if( ipNext.y == aP.y )
+    {
+        if( ( ipNext.x == aP.x ) || ( ip.y == aP.y &&
+            ( ( ipNext.x > aP.x ) == ( ip.x < aP.x ) ) ) )
+            return -1;
+    }
 
-    BOOST_FOREACH ( const POLYGON& polys, m_polys )
+    if( ( ip.y < aP.y ) != ( ipNext.y < aP.y ) )
     {
-        if( polys.size() == 0 )
-            continue;
+        if( ip.x >= aP.x )
+        {
+            if( ipNext.x > aP.x )
+                return 1;
 
-        if( pointInPolygon( aP, polys[0] ) )
-            return true;
+            int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
+                        (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+
+            if( !d )
+                return -1;
+
+            if( ( d > 0 ) == ( ipNext.y > ip.y ) )
+                return 1;
+        }
+        else
+        {
+            if( ipNext.x > aP.x )
+            {
+                int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
+                            (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+
+                if( !d )
+                    return -1;
+
+                if( ( d > 0 ) == ( ipNext.y > ip.y ) )
+                    return 1;
+            }
+        }
     }
 
-    return false;
+    return 0;
 }
 
 
-bool SHAPE_POLY_SET::pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const
+/// Last stamp given to an indexed outline.  Shared by all the sets, whose indexes are
+/// built concurrently under their own locks
+static boost::atomic<uint64_t> s_edgeIndexStamp( 0 );
+
+
+/// @return true if aP is inside aBox (normalized) or closer than aClearance to it
+static inline bool boxNear( const BOX2I& aBox, const VECTOR2I& aP, int aClearance )
 {
-    int result = 0;
-    int cnt = aPath.PointCount();
+    return aP.x >= aBox.GetX() - aClearance && aP.x <= aBox.GetRight() + aClearance
+           && aP.y >= aBox.GetY() - aClearance && aP.y <= aBox.GetBottom() + aClearance;
+}
 
-    if ( !aPath.BBox().Contains( aP ) ) // test with bounding box first
-        return false;
 
-    if( cnt < 3 )
-        return false;
+void SHAPE_POLY_SET::BuildEdgeIndex() const
+{
+    // Contains() and Collide() are const, and are called concurrently on shared sets
+    // (e.g. by the OpenMP DRC, ratsnest and zone filling).  The key is read with a
+    // barrier, so the index is complete when it is seen as valid
+    uint64_t key = SHAPE_LINE_CHAIN::StampChanges() + 1;
 
-    VECTOR2I ip = aPath.CPoint( 0 );
+    if( m_edgeIndexKey.m_value.load( boost::memory_order_acquire ) == key )
+        return;
 
-    for( int i = 1; i <= cnt; ++i )
+    // Only the threads querying this set wait for its index
+    MUTLOCK lock( m_edgeIndexLock.m_mutex );
+
+    uint64_t lastKey = m_edgeIndexKey.m_value.load( boost::memory_order_relaxed );
+
+    if( lastKey == key )
+        return;
+
+    bool changed = lastKey == 0 || m_edgeIndex.size() != m_polys.size();
+
+    m_edgeIndex.resize( m_polys.size() );
+
+    for( unsigned int ii = 0; ii < m_polys.size(); ii++ )
     {
-        VECTOR2I ipNext = ( i == cnt ? aPath.CPoint( 0 ) : aPath.CPoint( i ) );
+        EDGE_INDEX& index = m_edgeIndex[ii];
 
-        if( ipNext.y == aP.y )
+        // Empty polygons have no outline to index, and are skipped by the queries
+        if( m_polys[ii].empty() )
         {
-            if( ( ipNext.x == aP.x ) || ( ip.y == aP.y &&
-                ( ( ipNext.x > aP.x ) == ( ip.x < aP.x ) ) ) )
-                return true;
+            if( index.m_stamp )
+            {
+                index = EDGE_INDEX();
+                changed = true;
+            }
+
+            continue;
         }
 
-        if( ( ip.y < aP.y ) != ( ipNext.y < aP.y ) )
+        // The outlines which were not modified keep their index
+        if( !index.m_stamp || index.m_stamp != m_polys[ii][0].GetStamp() )
         {
-            if( ip.x >= aP.x )
+            indexOutline( ii );
+            changed = true;
+        }
+    }
+
+    if( changed )
+        buildOutlineGrid();
+
+    // Publish the index only once it is written
+    m_edgeIndexKey.m_value.store( key, boost::memory_order_release );
+}
+
+
+void SHAPE_POLY_SET::indexOutline( int aIndex ) const
+{
+    const SHAPE_LINE_CHAIN& path = m_polys[aIndex][0];
+    EDGE_INDEX& index = m_edgeIndex[aIndex];
+    int cnt = path.PointCount();
+
+    index.m_bbox = path.BBox();
+    index.m_bucketStart.clear();
+    index.m_edges.clear();
+
+    // Small outlines are tested edge by edge, once their bounding box matches
+    if( cnt >= EDGE_INDEX_MIN_VERTICES )
+    {
+        int bucketCount = cnt / EDGE_INDEX_BUCKET_SIZE;
+        int64_t height = (int64_t) index.m_bbox.GetHeight() / bucketCount + 1;
+
+        index.m_bucketHeight = (int) height;
+        bucketCount = index.m_bbox.GetHeight() / index.m_bucketHeight + 1;
+
+        // Two passes: count the edges of each bucket, then fill them in place
+        index.m_bucketStart.assign( bucketCount + 1, 0 );
+
+        for( int pass = 0; pass < 2; pass++ )
+        {
+            std::vector<int> fill;
+
+            if( pass == 1 )
             {
-                if( ipNext.x > aP.x )
-                    result = 1 - result;
-                else
-                {
-                    int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
-                                (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+                for( int i = 0; i < bucketCount; i++ )
+                    index.m_bucketStart[i + 1] += index.m_bucketStart[i];
+
+                index.m_edges.resize( index.m_bucketStart[bucketCount] );
+                fill.assign( index.m_bucketStart.begin(), index.m_bucketStart.end() - 1 );
+            }
 
-                    if( !d )
-                        return true;
+            for( int i = 0; i < cnt; i++ )
+            {
+                const VECTOR2I& p1 = path.CPoint( i );
+                const VECTOR2I& p2 = path.CPoint( i + 1 == cnt ? 0 : i + 1 );
+                int first = ( std::min( p1.y, p2.y ) - index.m_bbox.GetY() ) / index.m_bucketHeight;
+                int last = ( std::max( p1.y, p2.y ) - index.m_bbox.GetY() ) / index.m_bucketHeight;
 
-                    if( ( d > 0 ) == ( ipNext.y > ip.y ) )
-                        result = 1 - result;
+                for( int bucket = first; bucket <= last; bucket++ )
+                {
+                    if( pass == 0 )
+                        index.m_bucketStart[bucket + 1]++;
+                    else
+                        index.m_edges[fill[bucket]++] = i;
                 }
             }
-            else
+        }
+    }
+
+    index.m_stamp = s_edgeIndexStamp.fetch_add( 1 ) + 1;
+    path.SetStamp( index.m_stamp );
+}
+
+
+void SHAPE_POLY_SET::buildOutlineGrid() const
+{
+    bool empty = true;
+
+    m_gridStart.clear();
+    m_gridOutlines.clear();
+    m_wideOutlines.clear();
+
+    for( unsigned int ii = 0; ii < m_polys.size(); ii++ )
+    {
+        if( m_polys[ii].empty() || m_polys[ii][0].PointCount() == 0 )
+            continue;
+
+        if( empty )
+            m_gridBox = m_edgeIndex[ii].m_bbox;
+        else
+            m_gridBox.Merge( m_edgeIndex[ii].m_bbox );
+
+        empty = false;
+    }
+
+    if( empty )
+    {
+        m_gridColumns = m_gridRows = 0;
+        return;
+    }
+
+    // About one cell per outline, as square as the bounding box of the set allows
+    int64_t width = (int64_t) m_gridBox.GetWidth() + 1;
+    int64_t height = (int64_t) m_gridBox.GetHeight() + 1;
+    double cells = m_polys.size();
+
+    m_gridColumns = std::max( 1, std::min( (int) m_polys.size(),
+                                           (int) ( sqrt( cells * width / height ) + 0.5 ) ) );
+    m_gridRows = std::max( 1, std::min( (int) m_polys.size(), (int) ( cells / m_gridColumns ) ) );
+    m_cellWidth = (int) ( ( width - 1 ) / m_gridColumns + 1 );
+    m_cellHeight = (int) ( ( height - 1 ) / m_gridRows + 1 );
+
+    // Two passes, as for the edge index: count the outlines of each cell, then fill them
+    int cellCount = m_gridColumns * m_gridRows;
+    std::vector<int> fill;
+
+    m_gridStart.assign( cellCount + 1, 0 );
+
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        if( pass == 1 )
+        {
+            for( int i = 0; i < cellCount; i++ )
+                m_gridStart[i + 1] += m_gridStart[i];
+
+            m_gridOutlines.resize( m_gridStart[cellCount] );
+            fill.assign( m_gridStart.begin(), m_gridStart.end() - 1 );
+        }
+
+        for( unsigned int ii = 0; ii < m_polys.size(); ii++ )
+        {
+            if( m_polys[ii].empty() || m_polys[ii][0].PointCount() == 0 )
+                continue;
+
+            const BOX2I& bbox = m_edgeIndex[ii].m_bbox;
+            int col0 = ( bbox.GetX() - m_gridBox.GetX() ) / m_cellWidth;
+            int col1 = ( bbox.GetRight() - m_gridBox.GetX() ) / m_cellWidth;
+            int row0 = ( bbox.GetY() - m_gridBox.GetY() ) / m_cellHeight;
+            int row1 = ( bbox.GetBottom() - m_gridBox.GetY() ) / m_cellHeight;
+
+            if( ( col1 - col0 + 1 ) * ( row1 - row0 + 1 ) > OUTLINE_GRID_MAX_CELLS )
             {
-                if( ipNext.x > aP.x )
-                {
-                    int64_t d = (int64_t)( ip.x - aP.x ) * (int64_t)( ipNext.y - aP.y ) -
-                                (int64_t)( ipNext.x - aP.x ) * (int64_t)( ip.y - aP.y );
+                if( pass == 0 )
+                    m_wideOutlines.push_back( ii );
 
-                if( !d )
-                    return true;
+                continue;
+            }
 
-                if( ( d > 0 ) == ( ipNext.y > ip.y ) )
-                    result = 1 - result;
+            for( int row = row0; row <= row1; row++ )
+            {
+                for( int col = col0; col <= col1; col++ )
+                {
+                    int cell = row * m_gridColumns + col;
+
+                    if( pass == 0 )
+                        m_gridStart[cell + 1]++;
+                    else
+                        m_gridOutlines[fill[cell]++] = ii;
                 }
             }
         }
+    }
+}
+
+
+bool SHAPE_POLY_SET::pointInIndexedPolygon( const VECTOR2I& aP, int aSubpolyIndex ) const
+{
+    if( m_polys[aSubpolyIndex].size() == 0 )
+        return false;
+
+    const SHAPE_LINE_CHAIN& path = m_polys[aSubpolyIndex][0];
+    const EDGE_INDEX& index = m_edgeIndex[aSubpolyIndex];
+
+    if( path.PointCount() == 0 || !boxNear( index.m_bbox, aP, 0 ) )
+        return false;
+
+    if( index.m_edges.empty() )
+        return pointInPolygon( aP, path );
+
+    int cnt = path.PointCount();
+    int bucket = ( aP.y - index.m_bbox.GetY() ) / index.m_bucketHeight;
+    int result = 0;
+
+    // Only the edges spanning aP.y matter, and they are all in the bucket of aP.y
+    for( int i = index.m_bucketStart[bucket]; i < index.m_bucketStart[bucket + 1]; i++ )
+    {
+        int edge = index.m_edges[i];
+        int crossing = edgeCrossing( aP, path.CPoint( edge ),
+                                     path.CPoint( edge + 1 == cnt ? 0 : edge + 1 ) );
+
+        if( crossing < 0 )
+            return true;
+
+        result ^= crossing;
+    }
+
+    return result ? true : false;
+}
+
+
+bool SHAPE_POLY_SET::collideIndexedOutline( const VECTOR2I& aP, int aIndex, int aClearance ) const
+{
+    if( m_polys[aIndex].empty() )
+        return false;
+
+    const SHAPE_LINE_CHAIN& path = m_polys[aIndex][0];
+    const EDGE_INDEX& index = m_edgeIndex[aIndex];
+    int cnt = path.PointCount();
+
+    if( cnt == 0 || !boxNear( index.m_bbox, aP, aClearance ) )
+        return false;
+
+    if( pointInIndexedPolygon( aP, aIndex ) )
+        return true;
+
+    if( aClearance <= 0 )
+        return false;
+
+    if( index.m_edges.empty() )
+    {
+        for( int i = 0; i < cnt; i++ )
+        {
+            SEG seg( path.CPoint( i ), path.CPoint( i + 1 == cnt ? 0 : i + 1 ) );
+
+            if( seg.Distance( aP ) <= aClearance )
+                return true;
+        }
+
+        return false;
+    }
+
+    // The edges closer than aClearance span a y within aClearance of aP.y
+    int first = std::max( aP.y - aClearance - index.m_bbox.GetY(), 0 ) / index.m_bucketHeight;
+    int last = std::min( aP.y + aClearance - index.m_bbox.GetY(), index.m_bbox.GetHeight() )
+               / index.m_bucketHeight;
+
+    for( int bucket = first; bucket <= last; bucket++ )
+    {
+        for( int i = index.m_bucketStart[bucket]; i < index.m_bucketStart[bucket + 1]; i++ )
+        {
+            int edge = index.m_edges[i];
+            SEG seg( path.CPoint( edge ), path.CPoint( edge + 1 == cnt ? 0 : edge + 1 ) );
+
+            if( seg.Distance( aP ) <= aClearance )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool SHAPE_POLY_SET::collideIndexed( const VECTOR2I& aP, int aClearance ) const
+{
+    if( !m_gridColumns || !boxNear( m_gridBox, aP, aClearance ) )
+        return false;
+
+    for( unsigned int i = 0; i < m_wideOutlines.size(); i++ )
+    {
+        if( collideIndexedOutline( aP, m_wideOutlines[i], aClearance ) )
+            return true;
+    }
+
+    // An outline touching several cells may be tested more than once, which is harmless
+    int col0 = std::max( aP.x - aClearance - m_gridBox.GetX(), 0 ) / m_cellWidth;
+    int col1 = std::min( aP.x + aClearance - m_gridBox.GetX(), m_gridBox.GetWidth() )
+               / m_cellWidth;
+    int row0 = std::max( aP.y - aClearance - m_gridBox.GetY(), 0 ) / m_cellHeight;
+    int row1 = std::min( aP.y + aClearance - m_gridBox.GetY(), m_gridBox.GetHeight() )
+               / m_cellHeight;
+
+    col1 = std::min( col1, m_gridColumns - 1 );
+    row1 = std::min( row1, m_gridRows - 1 );
+
+    for( int row = row0; row <= row1; row++ )
+    {
+        for( int col = col0; col <= col1; col++ )
+        {
+            int cell = row * m_gridColumns + col;
+
+            for( int i = m_gridStart[cell]; i < m_gridStart[cell + 1]; i++ )
+            {
+                if( collideIndexedOutline( aP, m_gridOutlines[i], aClearance ) )
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+bool SHAPE_POLY_SET::Contains( const VECTOR2I& aP, int aSubpolyIndex ) const
+{
+    // fixme: support holes!
+
+    if( m_polys.size() == 0 ) // empty set?
+        return false;
+
+    BuildEdgeIndex();
+
+    if( aSubpolyIndex >= 0 )
+        return pointInIndexedPolygon( aP, aSubpolyIndex );
+
+    return collideIndexed( aP, 0 );
+}
+
 
+bool SHAPE_POLY_SET::Collide( const VECTOR2I& aP, int aClearance ) const
+{
+    if( m_polys.size() == 0 )
+        return false;
+
+    BuildEdgeIndex();
+
+    // A single pass: inside an outline, or close to one of its edges
+    return collideIndexed( aP, std::max( aClearance, 0 ) );
+}
+
+
+bool SHAPE_POLY_SET::pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const
+{
+    // The bounding box of aPath is tested by the caller
+    int result = 0;
+    int cnt = aPath.PointCount();
+
+    if( cnt < 3 )
+        return false;
+
+    VECTOR2I ip = aPath.CPoint( 0 );
+
+    for( int i = 1; i <= cnt; ++i )
+    {
+        VECTOR2I ipNext = ( i == cnt ? aPath.CPoint( 0 ) : aPath.CPoint( i ) );
+        int crossing = edgeCrossing( aP, ip, ipNext );
+
+        if( crossing < 0 )
+            return true;
+
+        result ^= crossing;
         ip = ipNext;
     }
 
@@ -779,6 +1475,8 @@ bool SHAPE_POLY_SET::pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN&
 
 void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 {
+    invalidateEdgeIndex();
+
     BOOST_FOREACH( POLYGON &poly, m_polys )
     {
         BOOST_FOREACH( SHAPE_LINE_CHAIN &path, poly )
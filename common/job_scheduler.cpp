@@ -0,0 +1,95 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file job_scheduler.cpp
+ */
+
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <job_scheduler.h>
+
+
+/// The job queue shared by the threads of a JOB_SCHEDULER::Run() call
+class JOB_QUEUE
+{
+public:
+    JOB_QUEUE( int aJobCount, const JOB_SCHEDULER::JOB& aJob ) :
+        m_job( aJob ),
+        m_jobCount( aJobCount ),
+        m_next( 0 )
+    {
+    }
+
+    /// Runs the jobs until the queue is empty
+    void Work( int aThread )
+    {
+        for( int job = next(); job >= 0; job = next() )
+            m_job( job, aThread );
+    }
+
+private:
+    /// @return the next job to run, or -1 if all the jobs were taken.
+    int next()
+    {
+        // each thread overshoots the counter once
+        int job = m_next.fetch_add( 1 );
+
+        return job < m_jobCount ? job : -1;
+    }
+
+    const JOB_SCHEDULER::JOB& m_job;
+    int                 m_jobCount;
+    boost::atomic<int>  m_next;
+};
+
+
+int JOB_SCHEDULER::GetThreadCount( int aJobCount )
+{
+    // hardware_concurrency() gives 0 when the information is not available
+    int count = std::max<int>( boost::thread::hardware_concurrency(), 1 );
+
+    return std::max( std::min( count, aJobCount ), 1 );
+}
+
+
+void JOB_SCHEDULER::Run( int aJobCount, const JOB& aJob )
+{
+    JOB_QUEUE queue( aJobCount, aJob );
+    int threadCount = GetThreadCount( aJobCount );
+
+    // Something which will not invoke a thread copy constructor
+    boost::ptr_vector<boost::thread> threads;
+
+    for( int ii = 1; ii < threadCount; ++ii )
+        threads.push_back( new boost::thread( &JOB_QUEUE::Work, &queue, ii ) );
+
+    queue.Work( 0 );
+
+    for( unsigned ii = 0; ii < threads.size(); ++ii )
+        threads[ii].join();
+}
@@ -25,6 +25,7 @@
 #include <kicad_curl/kicad_curl_easy.h>
 
 #include <cstddef>
+#include <cctype>
 #include <exception>
 #include <stdarg.h>
 #include <sstream>
@@ -61,6 +62,45 @@ KICAD_CURL_EASY::KICAD_CURL_EASY() :
 
     curl_easy_setopt( m_CURL, CURLOPT_WRITEFUNCTION, write_callback );
     curl_easy_setopt( m_CURL, CURLOPT_WRITEDATA, (void*) &m_buffer );
+    curl_easy_setopt( m_CURL, CURLOPT_HEADERFUNCTION, header_callback );
+    curl_easy_setopt( m_CURL, CURLOPT_HEADERDATA, (void*) &m_responseHeaders );
+}
+
+
+size_t KICAD_CURL_EASY::header_callback( char* aBuffer, size_t aSize, size_t aCount,
+                                         void* aUserp )
+{
+    size_t      realsize = aSize * aCount;
+    HEADER_MAP* headers = (HEADER_MAP*) aUserp;
+    std::string line( aBuffer, realsize );
+
+    // Each response starts with its status line, only keep the headers of the
+    // last one when redirects are followed.
+    if( line.compare( 0, 5, "HTTP/" ) == 0 )
+    {
+        headers->clear();
+        return realsize;
+    }
+
+    std::string::size_type colon = line.find( ':' );
+
+    if( colon == std::string::npos )
+        return realsize;
+
+    std::string name = line.substr( 0, colon );
+
+    for( std::string::iterator it = name.begin();  it != name.end();  ++it )
+        *it = (char) tolower( (unsigned char) *it );
+
+    std::string::size_type first = line.find_first_not_of( " \t", colon + 1 );
+    std::string::size_type last  = line.find_last_not_of( " \t\r\n" );
+
+    if( first == std::string::npos || last < first )
+        (*headers)[name] = std::string();
+    else
+        (*headers)[name] = line.substr( first, last - first + 1 );
+
+    return realsize;
 }
 
 
@@ -82,6 +122,7 @@ void KICAD_CURL_EASY::Perform()
 
     // bonus: retain worst case memory allocation, should re-use occur
     m_buffer.clear();
+    m_responseHeaders.clear();
 
     CURLcode res = curl_easy_perform( m_CURL );
 
@@ -92,3 +133,26 @@ void KICAD_CURL_EASY::Perform()
         THROW_IO_ERROR( msg );
     }
 }
+
+
+long KICAD_CURL_EASY::GetResponseCode()
+{
+    long code = 0;
+
+    curl_easy_getinfo( m_CURL, CURLINFO_RESPONSE_CODE, &code );
+
+    return code;
+}
+
+
+std::string KICAD_CURL_EASY::GetResponseHeader( const std::string& aName ) const
+{
+    std::string name = aName;
+
+    for( std::string::iterator it = name.begin();  it != name.end();  ++it )
+        *it = (char) tolower( (unsigned char) *it );
+
+    HEADER_MAP::const_iterator it = m_responseHeaders.find( name );
+
+    return it != m_responseHeaders.end() ? it->second : std::string();
+}
@@ -24,9 +24,19 @@
 
 
 #include <cstdarg>
+#include <cstring>
+#include <algorithm>
 
 #include <richio.h>
 
+#ifdef __WINDOWS__
+#include <wx/msw/wrapwin.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -258,6 +268,163 @@ char* FILE_LINE_READER::ReadLine() throw( IO_ERROR )
 }
 
 
+MMAP_LINE_READER::MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber,
+            unsigned aMaxLineLength ) throw( IO_ERROR ) :
+    FILE_LINE_READER( aFileName, aStartingLineNumber, aMaxLineLength ),
+    m_map( NULL ),
+    m_mapSize( 0 ),
+    m_offset( 0 )
+{
+    mapFile();
+}
+
+
+MMAP_LINE_READER::MMAP_LINE_READER( FILE* aFile, const wxString& aFileName,
+                    bool doOwn,
+                    unsigned aStartingLineNumber,
+                    unsigned aMaxLineLength ) :
+    FILE_LINE_READER( aFile, aFileName, doOwn, aStartingLineNumber, aMaxLineLength ),
+    m_map( NULL ),
+    m_mapSize( 0 ),
+    m_offset( 0 )
+{
+    mapFile();
+}
+
+
+void MMAP_LINE_READER::mapFile()
+{
+#ifdef __WINDOWS__
+    m_mapHandle = NULL;
+#endif
+
+    // Only a file which was not read from yet can be read from its mapping
+    if( ftell( fp ) != 0L )
+        return;
+
+#ifdef __WINDOWS__
+    HANDLE          file = (HANDLE) _get_osfhandle( _fileno( fp ) );
+    LARGE_INTEGER   size;
+
+    if( file == INVALID_HANDLE_VALUE || !GetFileSizeEx( file, &size ) || size.QuadPart <= 0
+        || (unsigned long long) size.QuadPart > (size_t) -1 )
+        return;
+
+    HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+    if( !mapping )
+        return;
+
+    void* map = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+
+    if( !map )
+    {
+        CloseHandle( mapping );
+        return;
+    }
+
+    m_mapHandle = mapping;
+    m_map       = (const char*) map;
+    m_mapSize   = (size_t) size.QuadPart;
+#else
+    struct stat st;
+
+    if( fstat( fileno( fp ), &st ) || !S_ISREG( st.st_mode ) || st.st_size <= 0
+        || (unsigned long long) st.st_size > (size_t) -1 )
+        return;
+
+    void* map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno( fp ), 0 );
+
+    if( map == MAP_FAILED )
+        return;
+
+#ifdef MADV_SEQUENTIAL
+    madvise( map, st.st_size, MADV_SEQUENTIAL );
+#endif
+
+    m_map       = (const char*) map;
+    m_mapSize   = st.st_size;
+#endif
+}
+
+
+MMAP_LINE_READER::~MMAP_LINE_READER()
+{
+    if( m_map )
+    {
+#ifdef __WINDOWS__
+        UnmapViewOfFile( m_map );
+        CloseHandle( (HANDLE) m_mapHandle );
+#else
+        munmap( (void*) m_map, m_mapSize );
+#endif
+    }
+}
+
+
+void MMAP_LINE_READER::readMappedLine() throw( IO_ERROR )
+{
+    const char* begin = m_map + m_offset;
+    const char* end   = m_map + m_mapSize;
+    const char* eol   = (const char*) memchr( begin, '\n', end - begin );
+    unsigned    len   = ( eol ? eol + 1 : end ) - begin;
+
+    // lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++lineNum;
+
+    // same limit as FILE_LINE_READER::ReadLine()
+    if( len >= maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    length = 0;     // nothing to keep in expandCapacity()
+
+    if( len + 1 > capacity )
+        expandCapacity( len + 1 );
+
+    memcpy( line, begin, len );
+
+    length = len;
+    line[length] = 0;
+    m_offset += len;
+}
+
+
+char* MMAP_LINE_READER::ReadLine() throw( IO_ERROR )
+{
+    if( m_map )
+        readMappedLine();
+    else
+        FILE_LINE_READER::ReadLine();
+
+    // "\r\n" is read as "\n" whether the file is mapped or not, so both give the
+    // same lines on all platforms
+    if( length >= 2 && line[length - 2] == '\r' && line[length - 1] == '\n' )
+    {
+        line[length - 2] = '\n';
+        line[--length] = 0;
+    }
+
+    return length ? line : NULL;
+}
+
+
+void MMAP_LINE_READER::Rewind()
+{
+    if( !m_map )
+    {
+        FILE_LINE_READER::Rewind();
+        return;
+    }
+
+    line[0]  = 0;
+    length   = 0;
+    m_offset = 0;
+    lineNum  = 0;
+}
+
+
 STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ) :
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     lines( aString ),
@@ -401,6 +568,17 @@ const char* OUTPUTFORMATTER::GetQuoteChar( const char* wrapee )
 
 int OUTPUTFORMATTER::vprint( const char* fmt,  va_list ap )  throw( IO_ERROR )
 {
+    // Many formats have no conversion, e.g. ")\n", they need no vsnprintf()
+    if( !strchr( fmt, '%' ) )
+    {
+        int len = strlen( fmt );
+
+        if( len > 0 )
+            write( fmt, len );
+
+        return len;
+    }
+
     // This function can call vsnprintf twice.
     // But internally, vsnprintf retrieves arguments from the va_list identified by arg as if
     // va_arg was used on it, and thus the state of the va_list is likely to be altered by the call.
@@ -448,10 +626,14 @@ int OUTPUTFORMATTER::Print( int nestLevel, const char* fmt, ... ) throw( IO_ERRO
     int result = 0;
     int total  = 0;
 
-    for( int i=0; i<nestLevel;  ++i )
+    static const char spaces[] = "                                ";
+    const int maxWidth = sizeof( spaces ) - 1;
+
+    // no error checking needed, an exception indicates an error.
+    for( int width = nestLevel * NESTWIDTH;  width > 0;  width -= maxWidth )
     {
-        // no error checking needed, an exception indicates an error.
-        result = sprint( "%*c", NESTWIDTH, ' ' );
+        result = std::min( width, maxWidth );
+        write( spaces, result );
 
         total += result;
     }
@@ -550,6 +732,8 @@ void STRING_FORMATTER::StripUseless()
 
 //-----<FILE_OUTPUTFORMATTER>----------------------------------------
 
+#define FILE_OUTPUTFMTBUFZ  ( 256 * 1024 )  ///< size of the FILE buffer of a FILE_OUTPUTFORMATTER
+
 FILE_OUTPUTFORMATTER::FILE_OUTPUTFORMATTER( const wxString& aFileName,
         const wxChar* aMode,  char aQuoteChar ) throw( IO_ERROR ) :
     OUTPUTFORMATTER( OUTPUTFMTBUFZ, aQuoteChar ),
@@ -564,6 +748,9 @@ FILE_OUTPUTFORMATTER::FILE_OUTPUTFORMATTER( const wxString& aFileName,
                             m_filename.GetData() );
         THROW_IO_ERROR( msg );
     }
+
+    // Boards and libraries are written in many small pieces
+    setvbuf( m_fp, NULL, _IOFBF, FILE_OUTPUTFMTBUFZ );
 }
 
 
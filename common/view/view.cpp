@@ -22,7 +22,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 
 #include <base_struct.h>
 #include <layers_id_colors_and_visibility.h>
@@ -32,7 +34,9 @@
 #include <view/view_rtree.h>
 #include <gal/definitions.h>
 #include <gal/graphics_abstraction_layer.h>
+#include <gal/recording_gal.h>
 #include <painter.h>
+#include <job_scheduler.h>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -40,13 +44,17 @@
 
 using namespace KIGFX;
 
+/// Number of items drawn by each job when recaching items on several threads
+static const int RECACHE_CHUNK_SIZE = 256;
+
 VIEW::VIEW( bool aIsDynamic ) :
     m_enableOrderModifier( true ),
     m_scale( 4.0 ),
     m_minScale( 4.0 ), m_maxScale( 15000 ),
     m_painter( NULL ),
     m_gal( NULL ),
-    m_dynamic( aIsDynamic )
+    m_dynamic( aIsDynamic ),
+    m_useThreads( false )
 {
     m_boundary.SetMaximum();
     m_needsUpdate.reserve( 32768 );
@@ -67,6 +75,9 @@ VIEW::~VIEW()
 {
     BOOST_FOREACH( LAYER_MAP::value_type& l, m_layers )
         delete l.second.items;
+
+    BOOST_FOREACH( RECORDING_GAL* recorder, m_recorders )
+        delete recorder;
 }
 
 
@@ -688,31 +699,28 @@ struct VIEW::unlinkItem
 
 struct VIEW::recacheItem
 {
-    recacheItem( VIEW* aView, GAL* aGal, int aLayer, bool aImmediately ) :
-        view( aView ), gal( aGal ), layer( aLayer ), immediately( aImmediately )
+    recacheItem( GAL* aGal, int aLayer, bool aImmediately, RECACHE_LIST& aRecache ) :
+        gal( aGal ), layer( aLayer ), immediately( aImmediately ), recache( aRecache )
     {
     }
 
     bool operator()( VIEW_ITEM* aItem )
     {
-        // Remove previously cached group
-        int group = aItem->getGroup( layer );
-
-        if( group >= 0 )
-            gal->DeleteGroup( group );
-
         if( immediately )
         {
-            group = gal->BeginGroup();
-            aItem->setGroup( layer, group );
+            // The item is drawn later, with the others, by VIEW::recacheItems()
+            RECACHE_ENTRY entry = { aItem, layer, -1, 0, 0 };
 
-            if( !view->m_painter->Draw( aItem, layer ) )
-                aItem->ViewDraw( layer, gal ); // Alternative drawing method
-
-            gal->EndGroup();
+            recache.push_back( entry );
         }
         else
         {
+            // Remove previously cached group
+            int group = aItem->getGroup( layer );
+
+            if( group >= 0 )
+                gal->DeleteGroup( group );
+
             aItem->ViewUpdate( VIEW_ITEM::ALL );
             aItem->setGroup( layer, -1 );
         }
@@ -720,10 +728,10 @@ struct VIEW::recacheItem
         return true;
     }
 
-    VIEW* view;
     GAL* gal;
     int layer;
     bool immediately;
+    RECACHE_LIST& recache;
 };
 
 
@@ -838,7 +846,7 @@ void VIEW::clearGroupCache()
 }
 
 
-void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
+void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags, RECACHE_LIST& aRecache )
 {
     // updateLayers updates geometry too, so we do not have to update both of them at the same time
     if( aUpdateFlags & VIEW_ITEM::LAYERS )
@@ -857,7 +865,11 @@ void VIEW::invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags )
         if( IsCached( layerId ) )
         {
             if( aUpdateFlags & ( VIEW_ITEM::GEOMETRY | VIEW_ITEM::LAYERS ) )
-                updateItemGeometry( aItem, layerId );
+            {
+                RECACHE_ENTRY entry = { aItem, layerId, -1, 0, 0 };
+
+                aRecache.push_back( entry );
+            }
             else if( aUpdateFlags & VIEW_ITEM::COLOR )
                 updateItemColor( aItem, layerId );
         }
@@ -900,29 +912,113 @@ void VIEW::updateItemColor( VIEW_ITEM* aItem, int aLayer )
 }
 
 
-void VIEW::updateItemGeometry( VIEW_ITEM* aItem, int aLayer )
+void VIEW::recacheItems( RECACHE_LIST& aItems )
 {
-    wxASSERT( (unsigned) aLayer < m_layers.size() );
-    wxASSERT( IsCached( aLayer ) );
+    int chunkCount  = ( aItems.size() + RECACHE_CHUNK_SIZE - 1 ) / RECACHE_CHUNK_SIZE;
+    int threadCount = m_useThreads ? JOB_SCHEDULER::GetThreadCount( chunkCount ) : 1;
+    std::vector<PAINTER*> painters;
 
-    VIEW_LAYER& l = m_layers.at( aLayer );
+#ifdef PROFILE
+    prof_counter recordTime, replayTime;
+    prof_start( &recordTime );
+#endif /* PROFILE */
 
-    m_gal->SetTarget( l.target );
-    m_gal->SetLayerDepth( l.renderingOrder );
+    // Draw the items on several threads, each one with its own painter recording the
+    // commands in its own GAL.  The GAL is not thread safe, so the commands are replayed
+    // on it afterwards, by this thread.
+    if( threadCount > 1 )
+    {
+        while( (int) m_recorders.size() < threadCount )
+            m_recorders.push_back( new RECORDING_GAL );
 
-    // Redraw the item from scratch
-    int group = aItem->getGroup( aLayer );
+        for( int i = 0; i < threadCount; ++i )
+        {
+            PAINTER* painter = m_painter->Clone( m_recorders[i] );
 
-    if( group >= 0 )
-        m_gal->DeleteGroup( group );
+            if( !painter )
+                break;      // the painter has to draw on this thread
+
+            m_recorders[i]->CopyAttributes( *m_gal );
+            painters.push_back( painter );
+        }
+
+        if( (int) painters.size() == threadCount )
+        {
+            JOB_SCHEDULER::Run( chunkCount, boost::bind( &VIEW::recordItems, this, &aItems,
+                                                         &painters, _1, _2 ) );
+        }
+    }
+
+#ifdef PROFILE
+    prof_end( &recordTime );
+    prof_start( &replayTime );
+#endif /* PROFILE */
+
+    // The OpenGL tessellation and the vertex manager updates happen here, on this thread
+    BOOST_FOREACH( RECACHE_ENTRY& entry, aItems )
+    {
+        wxASSERT( (unsigned) entry.layer < m_layers.size() );
+        wxASSERT( IsCached( entry.layer ) );
+
+        VIEW_LAYER& l = m_layers.at( entry.layer );
+
+        m_gal->SetTarget( l.target );
+        m_gal->SetLayerDepth( l.renderingOrder );
+
+        // Redraw the item from scratch
+        int group = entry.item->getGroup( entry.layer );
+
+        if( group >= 0 )
+            m_gal->DeleteGroup( group );
 
-    group = m_gal->BeginGroup();
-    aItem->setGroup( aLayer, group );
+        group = m_gal->BeginGroup();
+        entry.item->setGroup( entry.layer, group );
+
+        if( entry.recorder >= 0 )
+            m_recorders[entry.recorder]->Replay( m_gal, entry.first, entry.end );
+        else if( !m_painter->Draw( entry.item, entry.layer ) )
+            entry.item->ViewDraw( entry.layer, m_gal ); // Alternative drawing method
+
+        m_gal->EndGroup();
+    }
+
+#ifdef PROFILE
+    prof_end( &replayTime );
+
+    wxLogDebug( wxT( "recacheItems: %u items, %u threads, record %.1f ms, replay %.1f ms" ),
+                (unsigned) aItems.size(), (unsigned) painters.size(), recordTime.msecs(),
+                replayTime.msecs() );
+#endif /* PROFILE */
 
-    if( !m_painter->Draw( static_cast<EDA_ITEM*>( aItem ), aLayer ) )
-        aItem->ViewDraw( aLayer, m_gal ); // Alternative drawing method
+    BOOST_FOREACH( PAINTER* painter, painters )
+        delete painter;
 
-    m_gal->EndGroup();
+    BOOST_FOREACH( RECORDING_GAL* recorder, m_recorders )
+        recorder->Clear();
+}
+
+
+void VIEW::recordItems( RECACHE_LIST* aItems, const std::vector<PAINTER*>* aPainters,
+                        int aChunk, int aThread )
+{
+    RECORDING_GAL* recorder = m_recorders[aThread];
+    PAINTER*       painter = ( *aPainters )[aThread];
+    unsigned int   end = std::min<unsigned int>( aItems->size(),
+                                                 ( aChunk + 1 ) * RECACHE_CHUNK_SIZE );
+
+    for( unsigned int i = aChunk * RECACHE_CHUNK_SIZE; i < end; ++i )
+    {
+        RECACHE_ENTRY& entry = ( *aItems )[i];
+
+        entry.first = recorder->GetCommandCount();
+
+        // Items unknown to the painter are drawn by themselves, on the GAL thread
+        if( painter->Draw( entry.item, entry.layer ) )
+        {
+            entry.recorder = aThread;
+            entry.end = recorder->GetCommandCount();
+        }
+    }
 }
 
 
@@ -1002,6 +1098,7 @@ bool VIEW::areRequiredLayersEnabled( int aLayerId ) const
 void VIEW::RecacheAllItems( bool aImmediately )
 {
     BOX2I r;
+    RECACHE_LIST recache;
 
     r.SetMaximum();
 
@@ -1018,12 +1115,14 @@ void VIEW::RecacheAllItems( bool aImmediately )
         {
             m_gal->SetTarget( l->target );
             m_gal->SetLayerDepth( l->renderingOrder );
-            recacheItem visitor( this, m_gal, l->id, aImmediately );
+            recacheItem visitor( m_gal, l->id, aImmediately, recache );
             l->items->Query( r, visitor );
             MarkTargetDirty( l->target );
         }
     }
 
+    recacheItems( recache );
+
 #ifdef PROFILE
     prof_end( &totalRealTime );
 
@@ -1035,15 +1134,19 @@ void VIEW::RecacheAllItems( bool aImmediately )
 
 void VIEW::UpdateItems()
 {
-    // Update items that need this
+    RECACHE_LIST recache;
+
+    // Update items that need this, and draw those with a new geometry all together
     BOOST_FOREACH( VIEW_ITEM* item, m_needsUpdate )
     {
         assert( item->viewRequiredUpdate() != VIEW_ITEM::NONE );
 
-        invalidateItem( item, item->viewRequiredUpdate() );
+        invalidateItem( item, item->viewRequiredUpdate(), recache );
     }
 
     m_needsUpdate.clear();
+
+    recacheItems( recache );
 }
 
 
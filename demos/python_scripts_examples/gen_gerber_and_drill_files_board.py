@@ -69,12 +69,11 @@ plot_plan = [
 ]
 
 
+# The plot files are queued, then plotted at the same time by RunQueue()
 for layer_info in plot_plan:
     pctl.SetLayer(layer_info[1])
-    pctl.OpenPlotfile(layer_info[0], PLOT_FORMAT_GERBER, layer_info[2])
-    print 'plot %s' % pctl.GetPlotFileName()
-    if pctl.PlotLayer() == False:
-        print "plot error"
+    if pctl.QueuePlotfile(layer_info[0], PLOT_FORMAT_GERBER, layer_info[2]) == False:
+        print "cannot create %s" % pctl.GetPlotFileName()
 
 #generate internal copper layers, if any
 lyrcnt = board.GetCopperLayerCount();
@@ -82,15 +81,8 @@ lyrcnt = board.GetCopperLayerCount();
 for innerlyr in range ( 1, lyrcnt-1 ):
     pctl.SetLayer(innerlyr)
     lyrname = 'inner%s' % innerlyr
-    pctl.OpenPlotfile(lyrname, PLOT_FORMAT_GERBER, "inner")
-    print 'plot %s' % pctl.GetPlotFileName()
-    if pctl.PlotLayer() == False:
-        print "plot error"
-
-
-# At the end you have to close the last plot, otherwise you don't know when
-# the object will be recycled!
-pctl.ClosePlot()
+    if pctl.QueuePlotfile(lyrname, PLOT_FORMAT_GERBER, "inner") == False:
+        print "cannot create %s" % pctl.GetPlotFileName()
 
 # Fabricators need drill files.
 # sometimes a drill map file is asked (for verification purpose)
@@ -111,7 +103,12 @@ drlwriter.SetFormat( metricFmt )
 genDrl = True
 genMap = True
 print 'create drill and map files in %s' % pctl.GetPlotDirName()
-drlwriter.CreateDrillandMapFilesSet( pctl.GetPlotDirName(), genDrl, genMap );
+pctl.QueueDrillFiles( drlwriter, pctl.GetPlotDirName(), genDrl, genMap )
+
+# Plot the layers and create the drill files, on several threads
+print 'plot the queued files'
+if pctl.RunQueue() == False:
+    print "plot error"
 
 # One can create a text file to report drill statistics
 rptfn = pctl.GetPlotDirName() + 'drill_report.rpt'
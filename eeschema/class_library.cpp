@@ -39,11 +39,13 @@
 #include <config_params.h>
 #include <wildcards_and_files_ext.h>
 #include <project_rescue.h>
+#include <job_scheduler.h>
 
 #include <general.h>
 #include <class_library.h>
 
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 
 #include <wx/tokenzr.h>
 #include <wx/regex.h>
@@ -455,11 +457,10 @@ LIB_ALIAS* PART_LIB::GetPreviousEntry( const wxString& aName )
 }
 
 
-bool PART_LIB::Load( wxString& aErrorMsg )
+bool PART_LIB::Load( wxString& aErrorMsg, std::vector<PART_TEXT>* aPartTexts )
 {
     FILE*          file;
     char*          line;
-    wxString       msg;
 
     if( fileName.GetFullPath().IsEmpty() )
     {
@@ -475,7 +476,7 @@ bool PART_LIB::Load( wxString& aErrorMsg )
         return false;
     }
 
-    FILE_LINE_READER reader( file, fileName.GetFullPath() );
+    MMAP_LINE_READER reader( file, fileName.GetFullPath() );
 
     if( !reader.ReadLine() )
     {
@@ -561,31 +562,35 @@ bool PART_LIB::Load( wxString& aErrorMsg )
 
         if( strnicmp( line, "DEF", 3 ) == 0 )
         {
-            // Read one DEF/ENDDEF part entry from library:
-            LIB_PART* part = new LIB_PART( wxEmptyString, this );
-
-            if( part->Load( reader, msg ) )
+            if( !aPartTexts )
             {
-                // Check for duplicate entry names and warn the user about
-                // the potential conflict.
-                if( FindEntry( part->GetName() ) != NULL )
-                {
-                    wxString msg = duplicate_name_msg;
+                // Read one DEF/ENDDEF part entry from library:
+                LIB_PART* part = loadPart( reader );
 
-                    wxLogWarning( msg,
-                                  GetChars( fileName.GetName() ),
-                                  GetChars( part->GetName() ) );
-                }
+                if( part )
+                    addLoadedPart( part );
 
-                LoadAliases( part );
+                continue;
             }
-            else
+
+            // Only keep the lines of the part, up to the first one starting with ENDDEF
+            aPartTexts->push_back( PART_TEXT() );
+
+            PART_TEXT& text = aPartTexts->back();
+
+            text.m_lineNumber = reader.LineNumber();
+            text.m_text = line;
+
+            while( reader.ReadLine() )
             {
-                wxLogWarning( _( "Library '%s' component load error %s." ),
-                              GetChars( fileName.GetName() ),
-                              GetChars( msg ) );
-                msg.Clear();
-                delete part;
+                line = reader.Line();
+                text.m_text += line;
+
+                char* p = line + strspn( line, " \t" );
+
+                if( strnicmp( p, "ENDDEF", 6 ) == 0
+                    && ( !p[6] || isspace( (unsigned char) p[6] ) ) )
+                    break;
             }
         }
     }
@@ -596,6 +601,90 @@ bool PART_LIB::Load( wxString& aErrorMsg )
 }
 
 
+LIB_PART* PART_LIB::loadPart( LINE_READER& aLineReader )
+{
+    LIB_PART* part = new LIB_PART( wxEmptyString, this );
+    wxString  msg;
+
+    if( !part->Load( aLineReader, msg ) )
+    {
+        wxLogWarning( _( "Library '%s' component load error %s." ),
+                      GetChars( fileName.GetName() ),
+                      GetChars( msg ) );
+        delete part;
+        return NULL;
+    }
+
+    return part;
+}
+
+
+void PART_LIB::addLoadedPart( LIB_PART* aPart )
+{
+    // Check for duplicate entry names and warn the user about
+    // the potential conflict.
+    if( FindEntry( aPart->GetName() ) != NULL )
+    {
+        wxString msg = duplicate_name_msg;
+
+        wxLogWarning( msg,
+                      GetChars( fileName.GetName() ),
+                      GetChars( aPart->GetName() ) );
+    }
+
+    LoadAliases( aPart );
+}
+
+
+/**
+ * Class PART_TEXT_READER
+ * reads the text of a part kept by PART_LIB::Load(), with the line numbers of the
+ * library file.
+ */
+class PART_TEXT_READER : public STRING_LINE_READER
+{
+public:
+    PART_TEXT_READER( const PART_LIB::PART_TEXT& aText, const wxString& aSource ) :
+        STRING_LINE_READER( aText.m_text, aSource )
+    {
+        lineNum = aText.m_lineNumber - 1;
+    }
+};
+
+
+LIB_PART* PART_LIB::ParsePart( const PART_TEXT& aText )
+{
+    PART_TEXT_READER reader( aText, fileName.GetFullPath() );
+
+    // LIB_PART::Load() starts at the DEF line
+    if( !reader.ReadLine() )
+        return NULL;
+
+    return loadPart( reader );
+}
+
+
+void PART_LIB::EndLoad( const std::vector<LIB_PART*>& aParts )
+{
+    for( unsigned i = 0; i < aParts.size();  ++i )
+    {
+        if( aParts[i] )
+            addLoadedPart( aParts[i] );
+    }
+
+    if( aParts.size() )
+        ++m_mod_hash;
+
+    if( USE_OLD_DOC_FILE_FORMAT( versionMajor, versionMinor ) )
+    {
+        wxString errorMsg;
+
+        // not fatal if error here.
+        LoadDocs( errorMsg );
+    }
+}
+
+
 void PART_LIB::LoadAliases( LIB_PART* aPart )
 {
     wxCHECK_RET( aPart, wxT( "Cannot load aliases of NULL part.  Bad programmer!" ) );
@@ -620,13 +709,14 @@ void PART_LIB::LoadAliases( LIB_PART* aPart )
 bool PART_LIB::LoadHeader( LINE_READER& aLineReader )
 {
     char* line, * text, * data;
+    char* saveptr;
 
     while( aLineReader.ReadLine() )
     {
         line = (char*) aLineReader;
 
-        text = strtok( line, " \t\r\n" );
-        data = strtok( NULL, " \t\r\n" );
+        text = strtok_r( line, " \t\r\n", &saveptr );
+        data = strtok_r( NULL, " \t\r\n", &saveptr );
 
         if( stricmp( text, "TimeStamp" ) == 0 )
             timeStamp = atol( data );
@@ -643,6 +733,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
 {
     int        lineNumber = 0;
     char       line[8000], * name, * text;
+    char*      saveptr;
     LIB_ALIAS* entry;
     FILE*      file;
     wxFileName fn = fileName;
@@ -684,7 +775,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
         }
 
         // Read one $CMP/$ENDCMP part entry from library:
-        name = strtok( line + 5, "\n\r" );
+        name = strtok_r( line + 5, "\n\r", &saveptr );
 
         wxString cmpname = FROM_UTF8( name );
 
@@ -695,7 +786,7 @@ bool PART_LIB::LoadDocs( wxString& aErrorMsg )
             if( strncmp( line, "$ENDCMP", 7 ) == 0 )
                 break;
 
-            text = strtok( line + 2, "\n\r" );
+            text = strtok_r( line + 2, "\n\r", &saveptr );
 
             if( entry )
             {
@@ -800,25 +891,22 @@ bool PART_LIB::SaveHeader( OUTPUTFORMATTER& aFormatter )
 
 PART_LIB* PART_LIB::LoadLibrary( const wxString& aFileName ) throw( IO_ERROR, boost::bad_pointer )
 {
-    std::auto_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
-
     wxBusyCursor ShowWait;
 
+    return ReadLibrary( aFileName );
+}
+
+
+PART_LIB* PART_LIB::ReadLibrary( const wxString& aFileName ) throw( IO_ERROR, boost::bad_pointer )
+{
+    std::auto_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, aFileName ) );
+
     wxString errorMsg;
 
     if( !lib->Load( errorMsg ) )
         THROW_IO_ERROR( errorMsg );
 
-    if( USE_OLD_DOC_FILE_FORMAT( lib->versionMajor, lib->versionMinor ) )
-    {
-#if 1
-        // not fatal if error here.
-        lib->LoadDocs( errorMsg );
-#else
-        if( !lib->LoadDocs( errorMsg ) )
-            THROW_IO_ERROR( errorMsg );
-#endif
-    }
+    lib->EndLoad( std::vector<LIB_PART*>() );
 
     PART_LIB* ret = lib.release();
 
@@ -1102,6 +1190,92 @@ const wxString PART_LIBS::CacheName( const wxString& aFullProjectFilename )
 }
 
 
+/// A library to read by PART_LIBS::LoadAllLibraries()
+struct LIB_LOAD_JOB
+{
+    LIB_LOAD_JOB( const wxString& aFileName ) :
+        m_fileName( aFileName ),
+        m_isCache( false ),
+        m_lib( NULL )
+    {
+    }
+
+    wxString    m_fileName;
+    bool        m_isCache;
+    PART_LIB*   m_lib;          ///< the library read, NULL if it failed to load
+    wxString    m_error;        ///< why the library failed to load
+
+    std::vector<PART_LIB::PART_TEXT>    m_partTexts;    ///< the parts read, not parsed yet
+    std::vector<LIB_PART*>              m_parts;        ///< the parts parsed from m_partTexts
+};
+
+
+/// Reads the library of job (*aOrder)[aJob] and splits it in parts, on a worker thread.
+static void readLibraryJob( std::vector<LIB_LOAD_JOB>* aJobs, const std::vector<int>* aOrder,
+                            int aJob )
+{
+    LIB_LOAD_JOB& job = (*aJobs)[ (*aOrder)[aJob] ];
+
+    try
+    {
+        std::auto_ptr<PART_LIB> lib( new PART_LIB( LIBRARY_TYPE_EESCHEMA, job.m_fileName ) );
+        wxString errorMsg;
+
+        // As PART_LIB::ReadLibrary(), without the parts and the docs, see endLoadJob()
+        if( !lib->Load( errorMsg, &job.m_partTexts ) )
+            THROW_IO_ERROR( errorMsg );
+
+        job.m_parts.resize( job.m_partTexts.size(), NULL );
+        job.m_lib = lib.release();
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        job.m_error = ioe.errorText;
+    }
+    catch( const std::exception& se )
+    {
+        job.m_error = FROM_UTF8( se.what() );
+    }
+}
+
+
+/// Parses the part (*aParts)[aJob], a (job, part) pair, on a worker thread.
+static void parsePartJob( std::vector<LIB_LOAD_JOB>* aJobs,
+                          const std::vector< std::pair<int, int> >* aParts, int aJob )
+{
+    LIB_LOAD_JOB& job = (*aJobs)[ (*aParts)[aJob].first ];
+    int           part = (*aParts)[aJob].second;
+
+    try
+    {
+        job.m_parts[part] = job.m_lib->ParsePart( job.m_partTexts[part] );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogWarning( _( "Library '%s' component load error %s." ),
+                      GetChars( job.m_fileName ), GetChars( ioe.errorText ) );
+    }
+    catch( const std::exception& se )
+    {
+        wxLogWarning( _( "Library '%s' component load error %s." ),
+                      GetChars( job.m_fileName ), GetChars( FROM_UTF8( se.what() ) ) );
+    }
+}
+
+
+/// Adds the parsed parts to the library of job aJob, on a worker thread.
+static void endLoadJob( std::vector<LIB_LOAD_JOB>* aJobs, int aJob )
+{
+    LIB_LOAD_JOB& job = (*aJobs)[aJob];
+
+    if( !job.m_lib )
+        return;
+
+    job.m_lib->EndLoad( job.m_parts );
+    job.m_partTexts.clear();
+}
+
+
 void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR, boost::bad_pointer )
 {
     wxFileName      fn;
@@ -1123,6 +1297,8 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR, boost::ba
 
     wxASSERT( !size() );    // expect to load into "this" empty container.
 
+    std::vector<LIB_LOAD_JOB> jobs;
+
     for( unsigned i = 0; i < lib_names.GetCount();  ++i )
     {
         fn.Clear();
@@ -1149,47 +1325,103 @@ void PART_LIBS::LoadAllLibraries( PROJECT* aProject ) throw( IO_ERROR, boost::ba
             filename = fn.GetFullPath();
         }
 
-        try
+        jobs.push_back( LIB_LOAD_JOB( filename ) );
+    }
+
+    // add the special cache library, last.
+    wxString cache_name = CacheName( aProject->GetProjectFullName() );
+
+    if( !!cache_name )
+    {
+        jobs.push_back( LIB_LOAD_JOB( cache_name ) );
+        jobs.back().m_isCache = true;
+    }
+
+    // Read the libraries in parallel, the biggest files first.
+    std::vector< std::pair<wxULongLong, int> > bySize;
+
+    for( unsigned i = 0; i < jobs.size();  ++i )
+        bySize.push_back( std::make_pair( wxFileName::GetSize( jobs[i].m_fileName ), (int) i ) );
+
+    std::sort( bySize.rbegin(), bySize.rend() );
+
+    std::vector<int> order;
+
+    for( unsigned i = 0; i < bySize.size();  ++i )
+        order.push_back( bySize[i].second );
+
+    {
+        // The jobs have no user interface, show it here, on the main thread.
+        wxBusyCursor ShowWait;
+
+        // The libraries are read in parallel, but most of the time goes to parsing
+        // their parts: they are parsed apart, so a big library is not left to one
+        // thread.  Then the parts are added to their library in the file order.
+        JOB_SCHEDULER::Run( jobs.size(), boost::bind( &readLibraryJob, &jobs, &order, _1 ) );
+
+        std::vector< std::pair<int, int> > parts;
+
+        for( unsigned i = 0; i < jobs.size();  ++i )
         {
-            AddLibrary( filename );
+            for( unsigned j = 0; j < jobs[i].m_partTexts.size();  ++j )
+                parts.push_back( std::make_pair( (int) i, (int) j ) );
         }
-        catch( const IO_ERROR& ioe )
-        {
-            wxString msg = wxString::Format( _(
-                    "Part library '%s' failed to load. Error:\n"
-                    "%s" ),
-                    GetChars( filename ),
-                    GetChars( ioe.errorText )
-                    );
 
-            THROW_IO_ERROR( msg );
-        }
+        JOB_SCHEDULER::Run( parts.size(), boost::bind( &parsePartJob, &jobs, &parts, _1 ) );
+        JOB_SCHEDULER::Run( jobs.size(), boost::bind( &endLoadJob, &jobs, _1 ) );
     }
 
-    // add the special cache library.
-    wxString cache_name = CacheName( aProject->GetProjectFullName() );
-    PART_LIB* cache_lib;
+    // Add them in the library list order, up to the first one which failed to load.
+    wxString errorMsg;
 
-    if( !!cache_name )
+    for( unsigned i = 0; i < jobs.size();  ++i )
     {
-        try
+        LIB_LOAD_JOB& job = jobs[i];
+
+        if( !errorMsg.IsEmpty() )
         {
-            cache_lib = AddLibrary( cache_name );
-            if( cache_lib )
-                cache_lib->SetCache();
+            delete job.m_lib;
+            continue;
         }
-        catch( const IO_ERROR& ioe )
+
+        // Don't add the library if it is already loaded.
+        wxFileName libFn( job.m_fileName );
+        PART_LIB*  lib = FindLibrary( libFn.GetName() );
+
+        if( lib )
         {
-            wxString msg = wxString::Format( _(
+            delete job.m_lib;
+        }
+        else if( job.m_lib )
+        {
+            lib = job.m_lib;
+            push_back( lib );
+        }
+        else if( job.m_isCache )
+        {
+            errorMsg = wxString::Format( _(
                     "Part library '%s' failed to load.\nError: %s" ),
-                    GetChars( cache_name ),
-                    GetChars( ioe.errorText )
+                    GetChars( job.m_fileName ),
+                    GetChars( job.m_error )
+                    );
+        }
+        else
+        {
+            errorMsg = wxString::Format( _(
+                    "Part library '%s' failed to load. Error:\n"
+                    "%s" ),
+                    GetChars( job.m_fileName ),
+                    GetChars( job.m_error )
                     );
-
-            THROW_IO_ERROR( msg );
         }
+
+        if( lib && job.m_isCache )
+            lib->SetCache();
     }
 
+    if( !errorMsg.IsEmpty() )
+        THROW_IO_ERROR( errorMsg );
+
     // Print the libraries not found
     if( !!libs_not_found )
     {
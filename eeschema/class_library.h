@@ -363,6 +363,13 @@ public:
     PART_LIB( int aType, const wxString& aFileName );
     ~PART_LIB();
 
+    /// The text of a part (its lines from DEF to ENDDEF), read by Load() and parsed later
+    struct PART_TEXT
+    {
+        std::string m_text;
+        unsigned    m_lineNumber;   ///< line number of DEF in the library file
+    };
+
     /**
      * Function Save
      * writes library to \a aFormatter.
@@ -385,9 +392,30 @@ public:
      * Load library from file.
      *
      * @param aErrorMsg - Error message if load fails.
+     * @param aPartTexts - if not NULL, receives the text of the parts instead of loading
+     *   them, so they can be parsed by ParsePart() on several threads, then added by
+     *   EndLoad().
      * @return True if load was successful otherwise false.
      */
-    bool Load( wxString& aErrorMsg );
+    bool Load( wxString& aErrorMsg, std::vector<PART_TEXT>* aPartTexts = NULL );
+
+    /**
+     * Function ParsePart
+     * parses a part read by Load() into a new part of this library, without adding it.
+     * It does not modify the library, so the parts can be parsed by several threads.
+     *
+     * @return the part, owned by the caller, or NULL (after a warning) if it is invalid.
+     */
+    LIB_PART* ParsePart( const PART_TEXT& aText );
+
+    /**
+     * Function EndLoad
+     * adds the parts whose parsing was deferred by Load(), in the file order, and loads
+     * the document file of old libraries.
+     *
+     * @param aParts - the parts returned by ParsePart(), NULL for the invalid ones.
+     */
+    void EndLoad( const std::vector<LIB_PART*>& aParts );
 
     bool LoadDocs( wxString& aErrorMsg );
 
@@ -397,6 +425,12 @@ private:
     bool LoadHeader( LINE_READER& aLineReader );
     void LoadAliases( LIB_PART* aPart );
 
+    /// Reads the part at the current line of aLineReader, NULL if it is invalid
+    LIB_PART* loadPart( LINE_READER& aLineReader );
+
+    /// Adds a part read from the library file
+    void addLoadedPart( LIB_PART* aPart );
+
 public:
     /**
      * Get library entry status.
@@ -652,6 +686,18 @@ public:
      */
     static PART_LIB* LoadLibrary( const wxString& aFileName ) throw( IO_ERROR, boost::bad_pointer );
 
+    /**
+     * Function ReadLibrary
+     * is LoadLibrary() without any user interface, so it can be called from a
+     * worker thread.
+     *
+     * @param aFileName - File name of the part library to load.
+     * @return PART_LIB* - the allocated and loaded PART_LIB, which is owned by
+     *   the caller.
+     * @throw IO_ERROR if there's any problem loading the library.
+     */
+    static PART_LIB* ReadLibrary( const wxString& aFileName ) throw( IO_ERROR, boost::bad_pointer );
+
     /**
      * Function HasPowerParts
      * @return true if at least one power part is found in lib
@@ -28,6 +28,7 @@
 #include <fctsys.h>
 #include <gr_basic.h>
 #include <macros.h>
+#include <kicad_string.h>
 #include <class_drawpanel.h>
 #include <plot_common.h>
 #include <trigo.h>
@@ -72,6 +73,7 @@ bool LIB_BEZIER::Save( OUTPUTFORMATTER& aFormatter )
 bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 {
     char*   p;
+    char*   saveptr;
     int     i, ccount = 0;
     wxPoint pt;
     char*   line = (char*) aLineReader;
@@ -90,14 +92,14 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         return false;
     }
 
-    strtok( line + 2, " \t\n" );     // Skip field
-    strtok( NULL, " \t\n" );         // Skip field
-    strtok( NULL, " \t\n" );         // Skip field
-    strtok( NULL, " \t\n" );
+    strtok_r( line + 2, " \t\n", &saveptr );     // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );         // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );         // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );
 
     for( i = 0; i < ccount; i++ )
     {
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( sscanf( p, "%d", &pt.x ) != 1 )
         {
@@ -105,7 +107,7 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
             return false;
         }
 
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( sscanf( p, "%d", &pt.y ) != 1 )
         {
@@ -118,7 +120,7 @@ bool LIB_BEZIER::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 
     m_Fill = NO_FILL;
 
-    if( ( p = strtok( NULL, " \t\n" ) ) != NULL )
+    if( ( p = strtok_r( NULL, " \t\n", &saveptr ) ) != NULL )
     {
         if( p[0] == 'F' )
             m_Fill = FILLED_SHAPE;
@@ -29,6 +29,7 @@
 #include <fctsys.h>
 #include <gr_basic.h>
 #include <macros.h>
+#include <kicad_string.h>
 #include <class_drawpanel.h>
 #include <plot_common.h>
 #include <trigo.h>
@@ -75,6 +76,7 @@ bool LIB_POLYLINE::Save( OUTPUTFORMATTER& aFormatter )
 bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
 {
     char*   p;
+    char*   saveptr;
     int     i, ccount = 0;
     wxPoint pt;
     char*   line = (char*) aLineReader;
@@ -95,14 +97,14 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         return false;
     }
 
-    strtok( line + 2, " \t\n" );     // Skip field
-    strtok( NULL, " \t\n" );         // Skip field
-    strtok( NULL, " \t\n" );         // Skip field
-    strtok( NULL, " \t\n" );
+    strtok_r( line + 2, " \t\n", &saveptr );     // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );         // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );         // Skip field
+    strtok_r( NULL, " \t\n", &saveptr );
 
     for( i = 0; i < ccount; i++ )
     {
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( p == NULL || sscanf( p, "%d", &pt.x ) != 1 )
         {
@@ -110,7 +112,7 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
             return false;
         }
 
-        p = strtok( NULL, " \t\n" );
+        p = strtok_r( NULL, " \t\n", &saveptr );
 
         if( p == NULL || sscanf( p, "%d", &pt.y ) != 1 )
         {
@@ -121,7 +123,7 @@ bool LIB_POLYLINE::Load( LINE_READER& aLineReader, wxString& aErrorMsg )
         AddPoint( pt );
     }
 
-    if( ( p = strtok( NULL, " \t\n" ) ) != NULL )
+    if( ( p = strtok_r( NULL, " \t\n", &saveptr ) ) != NULL )
     {
         if( p[0] == 'F' )
             m_Fill = FILLED_SHAPE;
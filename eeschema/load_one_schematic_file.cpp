@@ -97,7 +97,7 @@ bool SCH_EDIT_FRAME::LoadOneEEFile( SCH_SCREEN* aScreen, const wxString& aFullFi
     }
 
     // reader now owns the open FILE.
-    FILE_LINE_READER    reader( f, aFullFileName );
+    MMAP_LINE_READER    reader( f, aFullFileName );
 
     msgDiag.Printf( _( "Loading '%s'" ), GetChars( aScreen->GetFileName() ) );
     PrintMsg( msgDiag );
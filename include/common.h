@@ -33,11 +33,16 @@
 #define INCLUDE__COMMON_H_
 
 #include <vector>
+#include <locale.h>
 
 #include <wx/wx.h>
 #include <wx/confbase.h>
 #include <wx/fileconf.h>
 
+#if defined( __WXMAC__ )
+#include <xlocale.h>
+#endif
+
 #include <richio.h>
 #include <colors.h>
 
@@ -199,6 +204,39 @@ private:
     // The locale in use before switching to the "C" locale
     // (the locale can be set by user, and is not always the system locale)
     std::string m_user_locale;
+
+    // true when the thread has its own locale (see THREAD_C_LOCALE): the global
+    // locale is then left alone
+    bool        m_thread_locale;
+};
+
+
+/**
+ * Class THREAD_C_LOCALE
+ * switches the calling thread, and only this thread, to the "C" locale for the
+ * lifetime of the object.  LOCALE_IO does nothing on a thread which has its own
+ * locale, so a worker thread can read or write files while the GUI thread keeps
+ * the user locale.  Instantiate it at the top of the thread function.
+ */
+class THREAD_C_LOCALE
+{
+public:
+    THREAD_C_LOCALE();
+    ~THREAD_C_LOCALE();
+
+    /**
+     * Function IsActive
+     * @return true if the calling thread uses its own locale instead of the global one.
+     */
+    static bool IsActive();
+
+private:
+#if defined( __WINDOWS__ )
+    std::string m_previous;     ///< the locale of the thread before the switch
+#else
+    locale_t    m_locale;       ///< the "C" locale used by the thread
+    locale_t    m_previous;     ///< the locale of the thread before the switch
+#endif
 };
 
 
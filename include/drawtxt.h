@@ -31,6 +31,8 @@
 #ifndef __INCLUDE__DRAWTXT_H__
 #define __INCLUDE__DRAWTXT_H__ 1
 
+#include <boost/function.hpp>
+
 #include <base_struct.h>
 #include <eda_text.h>               // EDA_TEXT_HJUSTIFY_T and EDA_TEXT_VJUSTIFY_T
 
@@ -51,6 +53,13 @@
 class EDA_DRAW_PANEL;
 class PLOTTER;
 
+/**
+ * Called by DrawGraphicText() for each segment of a text.  It can be bound to an
+ * object holding the state of the caller, so texts can be converted on several
+ * threads at the same time.
+ */
+typedef boost::function<void ( int x0, int y0, int xf, int yf )> TEXT_SEGMENT_CALLBACK;
+
 /**
  * Function  Clamp_Text_PenSize
  *As a rule, pen width should not be >1/4em, otherwise the character
@@ -125,7 +134,7 @@ void DrawGraphicText( EDA_RECT* aClipBox,
                       int aWidth,
                       bool aItalic,
                       bool aBold,
-                      void (*aCallback)( int x0, int y0, int xf, int yf ) = NULL,
+                      const TEXT_SEGMENT_CALLBACK& aCallback = NULL,
                       PLOTTER * aPlotter = NULL );
 
 
@@ -149,7 +158,7 @@ void DrawGraphicHaloText( EDA_RECT* aClipBox,
                           int aWidth,
                           bool aItalic,
                           bool aBold,
-                          void (*aCallback)( int x0, int y0, int xf, int yf ) = NULL,
+                          const TEXT_SEGMENT_CALLBACK& aCallback = NULL,
                           PLOTTER * aPlotter = NULL );
 
 #endif /* __INCLUDE__DRAWTXT_H__ */
@@ -110,7 +110,8 @@ protected:
 
     const KEYWORD*      keywords;               ///< table sorted by CMake for bsearch()
     unsigned            keywordCount;           ///< count of keywords table
-    KEYWORD_MAP         keyword_hash;           ///< fast, specialized "C string" hashtable
+    const KEYWORD_MAP*  keyword_hash;           ///< fast, specialized "C string" hashtable,
+                                                ///< shared by the lexers using keywords
 
     void init();
 
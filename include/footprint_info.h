@@ -42,6 +42,8 @@
 
 class FP_LIB_TABLE;
 class FOOTPRINT_LIST;
+class MODULE;
+class FOOTPRINT_INFO_INDEX;
 class wxTopLevelWindow;
 
 
@@ -53,6 +55,7 @@ class wxTopLevelWindow;
 class FOOTPRINT_INFO
 {
     friend bool operator<( const FOOTPRINT_INFO& item1, const FOOTPRINT_INFO& item2 );
+    friend class FOOTPRINT_LIST;    // loads the footprints on worker threads
 
 public:
 
@@ -62,7 +65,13 @@ public:
     const wxString& GetFootprintName() const            { return m_fpname; }
     const wxString& GetNickname() const                 { return m_nickname; }
 
-    FOOTPRINT_INFO( FOOTPRINT_LIST* aOwner, const wxString& aNickname, const wxString& aFootprintName ) :
+    /**
+     * Constructor FOOTPRINT_INFO
+     * @param aLoad tells to load the footprint now, else it is loaded when its data is
+     *  first needed, or by FOOTPRINT_LIST::ReadFootprintFiles().
+     */
+    FOOTPRINT_INFO( FOOTPRINT_LIST* aOwner, const wxString& aNickname, const wxString& aFootprintName,
+                    bool aLoad = !USE_FPI_LAZY ) :
         m_owner( aOwner ),
         m_loaded( false ),
         m_nickname( aNickname ),
@@ -71,11 +80,29 @@ public:
         m_pad_count( 0 ),
         m_unique_pad_count( 0 )
     {
-#if !USE_FPI_LAZY
-        load();
-#endif
+        if( aLoad )
+            load();
     }
 
+    /// Constructor for an item whose data is already known, e.g. read from the
+    /// footprint info index: the footprint is not loaded.
+    FOOTPRINT_INFO( FOOTPRINT_LIST* aOwner, const wxString& aNickname, const wxString& aFootprintName,
+                    const wxString& aDoc, const wxString& aKeywords,
+                    int aPadCount, int aUniquePadCount ) :
+        m_owner( aOwner ),
+        m_loaded( true ),
+        m_nickname( aNickname ),
+        m_fpname( aFootprintName ),
+        m_num( 0 ),
+        m_pad_count( aPadCount ),
+        m_unique_pad_count( aUniquePadCount ),
+        m_doc( aDoc ),
+        m_keywords( aKeywords )
+    {
+    }
+
+    bool IsLoaded() const                               { return m_loaded; }
+
     const wxString& GetDoc()
     {
         ensure_loaded();
@@ -128,6 +155,9 @@ private:
     /// lazily load stuff not filled in by constructor.  This may throw IO_ERRORS.
     void load();
 
+    /// fills in the data of the footprint from aModule, the loaded footprint or NULL
+    void setData( const MODULE* aModule );
+
     FOOTPRINT_LIST* m_owner;            ///< provides access to FP_LIB_TABLE
 
     bool        m_loaded;
@@ -170,34 +200,55 @@ class FOOTPRINT_LIST
     FPILIST m_list;
     ERRLIST m_errors;                   ///< some can be PARSE_ERRORs also
 
-    MUTEX   m_errors_lock;
-    MUTEX   m_list_lock;
+    FOOTPRINT_INFO_INDEX* m_index;      ///< on-disk index, used by ReadFootprintFiles() only
+
+    struct LIB_JOB;                     ///< a library to read, see footprint_info.cpp
+    struct FP_JOB;                      ///< a footprint to load, see footprint_info.cpp
+    struct FP_WORKER;                   ///< the PLUGIN of a thread, see footprint_info.cpp
+
+    typedef boost::ptr_vector< LIB_JOB >                LIB_JOBS;
+    typedef std::vector< FP_JOB >                       FP_JOBS;
 
     /**
-     * Function loader_job
-     * loads footprints from @a aNicknameList and calls AddItem() on to help fill
-     * m_list.
+     * Function index_job
+     * finds the index key, the timestamp and the size of the library of job aJob.
+     * Called from worker threads, by a JOB_SCHEDULER.
      *
-     * @param aNicknameList is a wxString[] holding libraries to load all footprints from.
-     * @param aJobZ is the size of the job, i.e. the count of nicknames.
+     * @param aJobs are the libraries to read.
+     * @param aErrors receive the errors, one list per thread.
      */
-    void loader_job( const wxString* aNicknameList, int aJobZ );
-
-    void addItem( FOOTPRINT_INFO* aItem )
-    {
-        // m_list is not thread safe, and this function is called from
-        // worker threads, lock m_list.
-        MUTLOCK lock( m_list_lock );
+    void index_job( LIB_JOBS* aJobs, boost::ptr_vector< ERRLIST >* aErrors, int aJob, int aThread );
 
-        m_list.push_back( aItem );
-    }
+    /**
+     * Function loader_job
+     * lists the footprints of the library of job aJob, with their data from the index
+     * if the library is indexed.  Otherwise the footprints of a .pretty library are left
+     * to footprint_job(), and the ones of other libraries, which are read at once, are
+     * loaded here.  Called from worker threads, by a JOB_SCHEDULER.
+     *
+     * @param aJobs are the libraries to read.
+     * @param aErrors receive the errors, one list per thread.
+     */
+    void loader_job( LIB_JOBS* aJobs, boost::ptr_vector< ERRLIST >* aErrors, int aJob, int aThread );
 
+    /**
+     * Function footprint_job
+     * loads the footprint of job aJob, with the PLUGIN of the thread.  Called from worker
+     * threads, by a JOB_SCHEDULER.
+     *
+     * @param aJobs are the footprints to load.
+     * @param aWorkers are the PLUGINs, one per thread.
+     * @param aErrors receive the errors, one list per thread.
+     */
+    void footprint_job( FP_JOBS* aJobs, boost::ptr_vector< FP_WORKER >* aWorkers,
+                        boost::ptr_vector< ERRLIST >* aErrors, int aJob, int aThread );
 
 public:
 
     FOOTPRINT_LIST() :
         m_lib_table( 0 ),
-        m_error_count( 0 )
+        m_error_count( 0 ),
+        m_index( 0 )
     {
     }
 
@@ -238,6 +289,9 @@ public:
     /**
      * Function ReadFootprintFiles
      * reads all the footprints provided by the combination of aTable and aNickname.
+     * The footprint data of the libraries which did not change since they were last
+     * read is taken from an index file in the user configuration directory, instead
+     * of parsing every footprint.
      *
      * @param aTable defines all the libraries.
      * @param aNickname is the library to read from, or if NULL means read all
@@ -579,6 +579,17 @@ public:
             flipY = 1.0;    // regular
     }
 
+    /**
+     * @brief Copies the view and the drawing attributes of another GAL.
+     *
+     * The world <-> screen transformation, the colors, the line width and the depth are
+     * copied, so items drawn with this GAL look as if drawn with aGal.  The grid, cursor
+     * and text settings are not copied.
+     *
+     * @param aGal is the GAL whose attributes are copied.
+     */
+    void CopyAttributes( const GAL& aGal );
+
     // ---------------------------
     // Buffer manipulation methods
     // ---------------------------
@@ -0,0 +1,217 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file recording_gal.h
+ * @brief GAL recording the drawing commands to replay them on another GAL.
+ */
+
+#ifndef RECORDING_GAL_H_
+#define RECORDING_GAL_H_
+
+#include <vector>
+
+#include <gal/graphics_abstraction_layer.h>
+
+namespace KIGFX
+{
+/**
+ * @brief Class RECORDING_GAL records the drawing commands, to replay them later on another GAL.
+ *
+ * It lets painters run on worker threads: each thread draws with its own RECORDING_GAL,
+ * then the thread owning the real GAL replays the recorded commands, e.g. inside a group.
+ * Texts are recorded as the lines and polylines of their strokes.  Groups, targets and
+ * screen methods are not recorded.
+ *
+ * Call CopyAttributes() before drawing, so the painters see the world scale, the colors
+ * and the line width of the real GAL.
+ */
+class RECORDING_GAL : public GAL
+{
+public:
+    RECORDING_GAL();
+    ~RECORDING_GAL();
+
+    // ---------------
+    // Drawing methods
+    // ---------------
+
+    /// @copydoc GAL::DrawLine()
+    virtual void DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint );
+
+    /// @copydoc GAL::DrawSegment()
+    virtual void DrawSegment( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint, double aWidth );
+
+    /// @copydoc GAL::DrawPolyline()
+    virtual void DrawPolyline( const std::deque<VECTOR2D>& aPointList );
+    virtual void DrawPolyline( const VECTOR2D aPointList[], int aListSize );
+
+    /// @copydoc GAL::DrawCircle()
+    virtual void DrawCircle( const VECTOR2D& aCenterPoint, double aRadius );
+
+    /// @copydoc GAL::DrawArc()
+    virtual void DrawArc( const VECTOR2D& aCenterPoint, double aRadius,
+                          double aStartAngle, double aEndAngle );
+
+    /// @copydoc GAL::DrawRectangle()
+    virtual void DrawRectangle( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint );
+
+    /// @copydoc GAL::DrawPolygon()
+    virtual void DrawPolygon( const std::deque<VECTOR2D>& aPointList );
+    virtual void DrawPolygon( const VECTOR2D aPointList[], int aListSize );
+
+    /// @copydoc GAL::DrawCurve()
+    virtual void DrawCurve( const VECTOR2D& startPoint,    const VECTOR2D& controlPointA,
+                            const VECTOR2D& controlPointB, const VECTOR2D& endPoint );
+
+    // -----------------
+    // Attribute setting
+    // -----------------
+
+    /// @copydoc GAL::SetIsFill()
+    virtual void SetIsFill( bool aIsFillEnabled );
+
+    /// @copydoc GAL::SetIsStroke()
+    virtual void SetIsStroke( bool aIsStrokeEnabled );
+
+    /// @copydoc GAL::SetFillColor()
+    virtual void SetFillColor( const COLOR4D& aColor );
+
+    /// @copydoc GAL::SetStrokeColor()
+    virtual void SetStrokeColor( const COLOR4D& aColor );
+
+    /// @copydoc GAL::SetLineWidth()
+    virtual void SetLineWidth( double aLineWidth );
+
+    /// @copydoc GAL::SetLayerDepth()
+    virtual void SetLayerDepth( double aLayerDepth );
+
+    // --------------
+    // Transformation
+    // --------------
+
+    /// @copydoc GAL::Transform()
+    virtual void Transform( const MATRIX3x3D& aTransformation );
+
+    /// @copydoc GAL::Rotate()
+    virtual void Rotate( double aAngle );
+
+    /// @copydoc GAL::Translate()
+    virtual void Translate( const VECTOR2D& aTranslation );
+
+    /// @copydoc GAL::Scale()
+    virtual void Scale( const VECTOR2D& aScale );
+
+    /// @copydoc GAL::Save()
+    virtual void Save();
+
+    /// @copydoc GAL::Restore()
+    virtual void Restore();
+
+    // ---------
+    // Recording
+    // ---------
+
+    /**
+     * @brief Returns the number of recorded commands.
+     *
+     * It is the index of the next command, use it to mark the start and the end of the
+     * commands of an item.
+     */
+    inline int GetCommandCount() const
+    {
+        return m_commands.size();
+    }
+
+    /**
+     * @brief Replays recorded commands on another GAL.
+     *
+     * @param aGal is the GAL to draw with.
+     * @param aFirst is the index of the first command to replay.
+     * @param aEnd is the index following the last command to replay.
+     */
+    void Replay( GAL* aGal, int aFirst, int aEnd ) const;
+
+    /// @brief Drops the recorded commands, keeping the memory for the next recording.
+    void Clear();
+
+    /**
+     * @brief Tells if another recorder holds the same commands with the same arguments,
+     * e.g. to check that two ways of drawing items give the same result.
+     *
+     * @param aOther is the other recorder.
+     * @return true if the recordings are identical.
+     */
+    bool IsSameRecording( const RECORDING_GAL& aOther ) const;
+
+private:
+    /// Recorded command types
+    enum COMMAND_TYPE
+    {
+        CMD_LINE,               ///< 2 points
+        CMD_SEGMENT,            ///< 2 points, the width
+        CMD_POLYLINE,           ///< m_count points
+        CMD_CIRCLE,             ///< the center point, the radius
+        CMD_ARC,                ///< the center point, the radius and the angles
+        CMD_RECTANGLE,          ///< 2 points
+        CMD_POLYGON,            ///< m_count points
+        CMD_CURVE,              ///< 4 points
+        CMD_IS_FILL,            ///< m_count is the flag
+        CMD_IS_STROKE,          ///< m_count is the flag
+        CMD_FILL_COLOR,         ///< 4 values: r, g, b, a
+        CMD_STROKE_COLOR,       ///< 4 values: r, g, b, a
+        CMD_LINE_WIDTH,         ///< the width
+        CMD_LAYER_DEPTH,        ///< the depth
+        CMD_TRANSFORM,          ///< the 9 values of the matrix, row by row
+        CMD_ROTATE,             ///< the angle
+        CMD_TRANSLATE,          ///< 1 point
+        CMD_SCALE,              ///< 1 point
+        CMD_SAVE,
+        CMD_RESTORE
+    };
+
+    /// A recorded command, whose arguments are stored in m_points and m_values
+    struct COMMAND
+    {
+        COMMAND_TYPE    m_type;
+        int             m_count;        ///< Point count or flag, depending on the type
+        unsigned int    m_point;        ///< Index of the first point in m_points
+        unsigned int    m_value;        ///< Index of the first value in m_values
+    };
+
+    /// Appends a command of type aType, whose arguments are pushed next.
+    inline void addCommand( COMMAND_TYPE aType, int aCount = 0 )
+    {
+        COMMAND cmd = { aType, aCount, (unsigned int) m_points.size(),
+                        (unsigned int) m_values.size() };
+
+        m_commands.push_back( cmd );
+    }
+
+    std::vector<COMMAND>    m_commands;     ///< Recorded commands
+    std::vector<VECTOR2D>   m_points;       ///< Point arguments of the commands
+    std::vector<double>     m_values;       ///< Scalar arguments of the commands
+};
+}    // namespace KIGFX
+
+#endif  // RECORDING_GAL_H_
@@ -30,18 +30,32 @@
 #define STROKE_FONT_H_
 
 #include <deque>
+#include <list>
 #include <utf8.h>
 
 #include <eda_text.h>
 
 #include <math/box2.h>
 
+#include <boost/unordered_map.hpp>
+
 namespace KIGFX
 {
 class GAL;
 
-typedef std::deque< std::deque<VECTOR2D> > GLYPH;
-typedef std::vector<GLYPH>                 GLYPH_LIST;
+/**
+ * @brief Strokes of a glyph, or of a line of text.
+ *
+ * The polylines are stored one after another in a single array, so they are transformed
+ * and drawn without being copied.
+ */
+struct GLYPH
+{
+    std::vector<VECTOR2D>   m_points;       ///< Points of all the strokes
+    std::vector<int>        m_strokeEnds;   ///< End of each stroke in m_points
+};
+
+typedef std::vector<GLYPH> GLYPH_LIST;
 
 /**
  * @brief Class STROKE_FONT implements stroke font drawing.
@@ -142,14 +156,126 @@ public:
         m_gal = aGal;
     }
 
+    /**
+     * Function SetLayoutCacheSize
+     * sets the maximal number of laid out lines of text kept in the cache, and empties it.
+     * @param aSize is the number of lines, 0 to lay out each line each time it is drawn.
+     */
+    void SetLayoutCacheSize( unsigned aSize );
+
 private:
+    /// A line of text laid out: the strokes of its glyphs, and its overbars as
+    /// (start, end) pairs
+    struct LINE_LAYOUT
+    {
+        GLYPH                   m_strokes;
+        std::vector<VECTOR2D>   m_overbars;
+    };
+
+    /// Key of the layout cache: a line of text and the properties changing its layout
+    struct LAYOUT_KEY
+    {
+        std::string         m_text;
+        VECTOR2D            m_glyphSize;
+        EDA_TEXT_HJUSTIFY_T m_horizontalJustify;
+        bool                m_italic;
+        bool                m_mirrored;
+
+        bool operator==( const LAYOUT_KEY& aOther ) const
+        {
+            return m_text == aOther.m_text && m_glyphSize == aOther.m_glyphSize
+                   && m_horizontalJustify == aOther.m_horizontalJustify
+                   && m_italic == aOther.m_italic && m_mirrored == aOther.m_mirrored;
+        }
+    };
+
+    struct LAYOUT_KEY_HASH : std::unary_function<LAYOUT_KEY, std::size_t>
+    {
+        std::size_t operator()( const LAYOUT_KEY& aKey ) const
+        {
+            std::size_t seed = boost::hash_value( aKey.m_text );
+            boost::hash_combine( seed, aKey.m_glyphSize.x );
+            boost::hash_combine( seed, aKey.m_glyphSize.y );
+            boost::hash_combine( seed, (int) aKey.m_horizontalJustify );
+            boost::hash_combine( seed, aKey.m_italic );
+            boost::hash_combine( seed, aKey.m_mirrored );
+
+            return seed;
+        }
+    };
+
+    /// The keys of the cached layouts, from the most to the least recently used.  The keys
+    /// are stored in the cache, whose elements do not move when it is rehashed.
+    typedef std::list<const LAYOUT_KEY*> LAYOUT_LRU;
+
+    /// A cached layout
+    struct LAYOUT_ENTRY
+    {
+        LINE_LAYOUT             m_layout;
+        LAYOUT_LRU::iterator    m_lruPos;   ///< Position of the key in m_layoutLru
+        bool                    m_used;     ///< The layout was found since it was cached
+    };
+
+    typedef boost::unordered_map<LAYOUT_KEY, LAYOUT_ENTRY, LAYOUT_KEY_HASH> LAYOUT_CACHE;
+
     GAL*                m_gal;                                    ///< Pointer to the GAL
     GLYPH_LIST          m_glyphs;                                 ///< Glyph list
     std::vector<BOX2D>  m_glyphBoundingBoxes;                     ///< Bounding boxes of the glyphs
     VECTOR2D            m_glyphSize;                              ///< Size of the glyphs
     EDA_TEXT_HJUSTIFY_T m_horizontalJustify;                      ///< Horizontal justification
     EDA_TEXT_VJUSTIFY_T m_verticalJustify;                        ///< Vertical justification
-    bool                m_bold, m_italic, m_mirrored, m_overbar;  ///< Properties of text
+    bool                m_bold, m_italic, m_mirrored;             ///< Properties of text
+    LAYOUT_CACHE        m_layoutCache;                            ///< Laid out lines of text
+    LAYOUT_LRU          m_layoutLru;                              ///< Least recently used order
+    LINE_LAYOUT         m_uncachedLayout;                         ///< Layout not kept in the cache
+    unsigned            m_layoutCacheSize;                        ///< Maximal number of layouts
+
+    /// False while the cache churns: the new layouts are not cached, and the cached ones
+    /// are kept.  The texts of a view are usually drawn in the same order at each redraw,
+    /// so when they do not fit, a least recently used cache would only evict layouts before
+    /// they are drawn again.
+    bool                m_layoutCacheAdmits;
+    unsigned            m_layoutBypassPeriods;                    ///< Length of a churn period
+    unsigned            m_layoutLookups;                          ///< Lookups of the current period
+    unsigned            m_layoutHits;                             ///< Hits of the current period
+    unsigned            m_layoutWasted;                           ///< Layouts evicted without a hit
+
+    /**
+     * @brief Empties the layout cache.
+     */
+    void clearLayoutCache();
+
+    /**
+     * @brief Updates the statistics of the layout cache with a lookup.  At the end of each
+     * period, the cache switches between its two states:
+     *
+     * - admitting (m_layoutCacheAdmits is true): a miss caches the new layout, evicting the
+     *   least recently used one when the cache is full.  A period is m_layoutCacheSize
+     *   lookups.  When more than half of them evicted a layout which was never found
+     *   (m_layoutWasted), the texts drawn do not fit in the cache: it switches to bypassing,
+     *   and m_layoutBypassPeriods doubles, up to MAX_BYPASS_PERIODS.  Otherwise
+     *   m_layoutBypassPeriods goes back to 1.
+     * - bypassing: a miss lays the text out in m_uncachedLayout, and the cached layouts
+     *   are kept, so they are still found.  A period is m_layoutBypassPeriods times
+     *   m_layoutCacheSize lookups, so that it spans a redraw.  When less than one lookup
+     *   in eight hits (m_layoutHits), the texts drawn changed, e.g. after a zoom: the cache
+     *   switches to admitting.
+     *
+     * The lookup, hit and wasted counters are reset at the end of each period, and
+     * clearLayoutCache() resets the cache to admitting.
+     *
+     * @param aHit is true if the layout was found in the cache.
+     */
+    void countLayoutLookup( bool aHit );
+
+    /**
+     * @brief Returns an empty layout for aKey, in the cache if it admits new layouts,
+     * evicting the least recently used one if the cache is full.
+     *
+     * @param aKey is the key of the layout.
+     * @return is the layout to fill.
+     */
+    LINE_LAYOUT& newLayout( const LAYOUT_KEY& aKey );
 
     /**
      * @brief Returns a single line height using current settings.
@@ -175,6 +301,15 @@ private:
      */
     void drawSingleLineText( const UTF8& aText );
 
+    /**
+     * @brief Lays out a single line of text with the current settings, relatively to the
+     * text position.
+     *
+     * @param aText is the text to be laid out.
+     * @return is the layout, from the cache if the text was already laid out.
+     */
+    const LINE_LAYOUT& layoutSingleLineText( const UTF8& aText );
+
     /**
      * @brief Compute the size of a given text.
      *
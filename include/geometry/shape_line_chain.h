@@ -25,10 +25,12 @@
 #ifndef __SHAPE_LINE_CHAIN
 #define __SHAPE_LINE_CHAIN
 
+#include <stdint.h>
 #include <vector>
 #include <sstream>
 
 #include <boost/optional.hpp>
+#include <boost/atomic.hpp>
 
 #include <math/vector2d.h>
 #include <geometry/shape.h>
@@ -72,22 +74,37 @@ public:
      * Initializes an empty line chain.
      */
     SHAPE_LINE_CHAIN() :
-        SHAPE( SH_LINE_CHAIN ), m_closed( false )
+        SHAPE( SH_LINE_CHAIN ), m_closed( false ), m_stamp( 0 )
     {}
 
     /**
      * Copy Constructor
      */
     SHAPE_LINE_CHAIN( const SHAPE_LINE_CHAIN& aShape ) :
-        SHAPE( SH_LINE_CHAIN ), m_points( aShape.m_points ), m_closed( aShape.m_closed )
+        SHAPE( SH_LINE_CHAIN ), m_points( aShape.m_points ), m_closed( aShape.m_closed ),
+        m_stamp( aShape.m_stamp )
     {}
 
+    SHAPE_LINE_CHAIN& operator=( const SHAPE_LINE_CHAIN& aShape )
+    {
+        // The chain may be an indexed outline replaced in place
+        if( m_stamp != aShape.m_stamp )
+            invalidateStamp();
+
+        m_points = aShape.m_points;
+        m_closed = aShape.m_closed;
+        m_bbox = aShape.m_bbox;
+        m_stamp = aShape.m_stamp;
+
+        return *this;
+    }
+
     /**
      * Constructor
      * Initializes a 2-point line chain (a single segment)
      */
     SHAPE_LINE_CHAIN( const VECTOR2I& aA, const VECTOR2I& aB ) :
-        SHAPE( SH_LINE_CHAIN ), m_closed( false )
+        SHAPE( SH_LINE_CHAIN ), m_closed( false ), m_stamp( 0 )
     {
         m_points.resize( 2 );
         m_points[0] = aA;
@@ -95,7 +112,7 @@ public:
     }
 
     SHAPE_LINE_CHAIN( const VECTOR2I& aA, const VECTOR2I& aB, const VECTOR2I& aC ) :
-        SHAPE( SH_LINE_CHAIN ), m_closed( false )
+        SHAPE( SH_LINE_CHAIN ), m_closed( false ), m_stamp( 0 )
     {
         m_points.resize( 3 );
         m_points[0] = aA;
@@ -104,7 +121,7 @@ public:
     }
 
     SHAPE_LINE_CHAIN( const VECTOR2I& aA, const VECTOR2I& aB, const VECTOR2I& aC, const VECTOR2I& aD ) :
-        SHAPE( SH_LINE_CHAIN ), m_closed( false )
+        SHAPE( SH_LINE_CHAIN ), m_closed( false ), m_stamp( 0 )
     {
         m_points.resize( 4 );
         m_points[0] = aA;
@@ -116,7 +133,8 @@ public:
 
     SHAPE_LINE_CHAIN( const VECTOR2I* aV, int aCount ) :
         SHAPE( SH_LINE_CHAIN ),
-        m_closed( false )
+        m_closed( false ),
+        m_stamp( 0 )
     {
         m_points.resize( aCount );
 
@@ -137,6 +155,7 @@ public:
     {
         m_points.clear();
         m_closed = false;
+        invalidateStamp();
     }
 
     /**
@@ -149,6 +168,7 @@ public:
     void SetClosed( bool aClosed )
     {
         m_closed = aClosed;
+        invalidateStamp();
     }
 
     /**
@@ -231,7 +251,9 @@ public:
     /**
      * Function Point()
      *
-     * Returns a reference to a given point in the line chain.
+     * Returns a reference to a given point in the line chain.  The point may be modified
+     * through the reference, so the line chain loses its stamp (see GetStamp()): use
+     * CPoint() to read a point and SetPoint() to move it.
      * @param aIndex index of the point
      * @return reference to the point
      */
@@ -240,9 +262,30 @@ public:
         if( aIndex < 0 )
             aIndex += PointCount();
 
+        invalidateStamp();
         return m_points[aIndex];
     }
 
+    /**
+     * Function SetPoint()
+     *
+     * Moves a given point of the line chain.  The line chain keeps its stamp if the point
+     * does not actually move.
+     * @param aIndex index of the point (negative values count from the end)
+     * @param aPos new position of the point
+     */
+    void SetPoint( int aIndex, const VECTOR2I& aPos )
+    {
+        if( aIndex < 0 )
+            aIndex += PointCount();
+
+        if( m_points[aIndex] != aPos )
+        {
+            m_points[aIndex] = aPos;
+            invalidateStamp();
+        }
+    }
+
     /**
      * Function CPoint()
      *
@@ -338,6 +381,8 @@ public:
      */
     void Append( const VECTOR2I& aP, bool aAllowDuplication = false )
     {
+        invalidateStamp();
+
         if( m_points.size() == 0 )
             m_bbox = BOX2I( aP, VECTOR2I( 0, 0 ) );
 
@@ -359,7 +404,9 @@ public:
         if( aOtherLine.PointCount() == 0 )
             return;
 
-        else if( PointCount() == 0 || aOtherLine.CPoint( 0 ) != CPoint( -1 ) )
+        invalidateStamp();
+
+        if( PointCount() == 0 || aOtherLine.CPoint( 0 ) != CPoint( -1 ) )
         {
             const VECTOR2I p = aOtherLine.CPoint( 0 );
             m_points.push_back( p );
@@ -377,6 +424,7 @@ public:
     void Insert( int aVertex, const VECTOR2I& aP )
     {
         m_points.insert( m_points.begin() + aVertex, aP );
+        invalidateStamp();
     }
 
     /**
@@ -577,6 +625,43 @@ public:
     {
         for( std::vector<VECTOR2I>::iterator i = m_points.begin(); i != m_points.end(); ++i )
             (*i) += aVector;
+
+        invalidateStamp();
+    }
+
+    /**
+     * Function GetStamp()
+     *
+     * Returns the stamp given to the current points by SetStamp(), or 0 if the line chain
+     * was modified since.  Data computed from the points (e.g. the edge index of
+     * SHAPE_POLY_SET) stay valid as long as the stamp is the same; a copy has the stamp of
+     * the original.
+     */
+    uint64_t GetStamp() const
+    {
+        return m_stamp;
+    }
+
+    /**
+     * Function SetStamp()
+     *
+     * Gives a stamp to the current points.  The stamp must be unique, e.g. taken from a
+     * counter, and not 0.
+     */
+    void SetStamp( uint64_t aStamp ) const
+    {
+        m_stamp = aStamp;
+    }
+
+    /**
+     * Function StampChanges()
+     *
+     * Returns the number of times a line chain having a stamp was modified, in the whole
+     * program: the data depending on stamps must be checked again when it changes.
+     */
+    static uint64_t StampChanges()
+    {
+        return s_stampChanges.load( boost::memory_order_acquire );
     }
 
     bool IsSolid() const
@@ -593,6 +678,22 @@ private:
 
     /// cached bounding box
     BOX2I m_bbox;
+
+    /// stamp of the points (see GetStamp()), reset by every modification
+    mutable uint64_t m_stamp;
+
+    /// see StampChanges()
+    static boost::atomic<uint64_t> s_stampChanges;
+
+    void invalidateStamp()
+    {
+        // Only the first modification after SetStamp() is counted
+        if( m_stamp )
+        {
+            m_stamp = 0;
+            s_stampChanges.fetch_add( 1, boost::memory_order_acq_rel );
+        }
+    }
 };
 
 #endif // __SHAPE_LINE_CHAIN
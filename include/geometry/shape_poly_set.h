@@ -30,6 +30,10 @@
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 
+#include <ki_mutex.h>
+
+#include <boost/atomic.hpp>
+
 #include "clipper.hpp"
 
 
@@ -39,7 +43,21 @@
  * Represents a set of closed polygons. Polygons may be nonconvex, self-intersecting
  * and have holes. Provides boolean operations (using Clipper library as the backend).
  *
- * TODO: add convex partitioning & spatial index
+ * Fracturing processes each polygon separately, in parallel when built with OpenMP.
+ *
+ * Large boolean operations and inflation may be split in groups of polygons which cannot
+ * interact (their bounding boxes do not overlap), see SetSplitOperations().  Each group is
+ * then processed separately, in parallel when built with OpenMP, and the results are
+ * concatenated in the order of the input polygons, so the output does not depend on the
+ * thread count.  Compared to a single pass, intersection points may be rounded differently
+ * by 1 unit and the polygons come in another order, so the split is opt-in.
+ *
+ * Point containment queries only test the outlines found in a grid of their bounding
+ * boxes and, on large outlines, use an edge index (y-sorted buckets of edges).  They are
+ * built on the first query, and rebuilt for the outlines modified since, which are found
+ * by their stamp (see SHAPE_LINE_CHAIN::GetStamp()).
+ *
+ * TODO: add convex partitioning
  */
 class SHAPE_POLY_SET : public SHAPE
 {
@@ -96,7 +114,7 @@ class SHAPE_POLY_SET : public SHAPE
 
             T& Get()
             {
-                return m_poly->Polygon( m_currentOutline )[0].Point( m_currentVertex );
+                return vertex( (T*) NULL );
             }
 
             T& operator*()
@@ -113,6 +131,17 @@ class SHAPE_POLY_SET : public SHAPE
         private:
             friend class SHAPE_POLY_SET;
 
+            // Only ITERATOR gives a mutable vertex, which marks its outline as modified
+            VECTOR2I& vertex( VECTOR2I* )
+            {
+                return m_poly->Polygon( m_currentOutline )[0].Point( m_currentVertex );
+            }
+
+            const VECTOR2I& vertex( const VECTOR2I* )
+            {
+                return m_poly->CPolygon( m_currentOutline )[0].CPoint( m_currentVertex );
+            }
+
             SHAPE_POLY_SET* m_poly;
             int m_currentOutline;
             int m_lastOutline;
@@ -250,6 +279,19 @@ class SHAPE_POLY_SET : public SHAPE
         }
 
 
+        /**
+         * Function SetSplitOperations
+         * allows the large boolean operations and inflations of this set (including the
+         * Simplify() of Fracture()) to be split in independent groups of polygons, run in
+         * parallel.  The results cover the same area as a single Clipper pass, but are not
+         * identical to it: keep it disabled (the default) where the polygons are stored or
+         * compared, e.g. for zone filling.  Copying a set copies this option.
+         */
+        void SetSplitOperations( bool aSplit )
+        {
+            m_splitOperations = aSplit;
+        }
+
         ///> Performs boolean polyset union
         ///> For aFastMode meaning, see function booleanOp
         void BooleanAdd( const SHAPE_POLY_SET& b, bool aFastMode = false );
@@ -309,8 +351,11 @@ class SHAPE_POLY_SET : public SHAPE
 
         const BOX2I BBox( int aClearance = 0 ) const;
 
+        ///> Returns true if aP is inside an outline of the set, or closer than aClearance
+        ///> to one. Holes are not supported (as in Contains())
+        bool Collide( const VECTOR2I& aP, int aClearance = 0 ) const;
+
         // fixme: add collision support
-        bool Collide( const VECTOR2I& aP, int aClearance = 0 ) const { return false; }
         bool Collide( const SEG& aSeg, int aClearance = 0 ) const { return false; }
 
 
@@ -318,6 +363,17 @@ class SHAPE_POLY_SET : public SHAPE
         ///> checks all polygons in the set
         bool Contains( const VECTOR2I& aP, int aSubpolyIndex = -1 ) const;
 
+        /**
+         * Function BuildEdgeIndex
+         * builds the outline bounding boxes, the outline grid and the edge index used by
+         * Contains() and Collide(), for the outlines modified since they were last built.
+         * When no indexed line chain was modified anywhere since, it only compares a counter
+         * (see SHAPE_LINE_CHAIN::StampChanges()).  Contains() and Collide() call it, so a
+         * set can be queried from several threads at once: the index is built by the first
+         * one, under the lock of the set.
+         */
+        void BuildEdgeIndex() const;
+
         ///> Returns true if the set is empty (no polygons at all)
         bool IsEmpty() const
         {
@@ -335,13 +391,73 @@ class SHAPE_POLY_SET : public SHAPE
 
     private:
 
+        ///> Bounding box of an outline and, for large outlines, its edges stored by y buckets:
+        ///> the edges spanning a given y are all in the bucket of this y
+        struct EDGE_INDEX
+        {
+            EDGE_INDEX() : m_stamp( 0 ), m_bucketHeight( 1 ) {}
+
+            uint64_t m_stamp;                   ///> stamp of the outline when indexed, or 0
+            BOX2I m_bbox;
+            int m_bucketHeight;
+            std::vector<int> m_bucketStart;     ///> first entry of each bucket in m_edges
+            std::vector<int> m_edges;           ///> edges (by start vertex) of all buckets,
+                                                ///> empty for small outlines
+        };
+
+        ///> Key of the edge index of a set (see m_edgeIndexKey), read without the lock of the
+        ///> set.  A copied set gets the key of the index it copies
+        struct EDGE_INDEX_KEY
+        {
+            EDGE_INDEX_KEY() : m_value( 0 ) {}
+            EDGE_INDEX_KEY( const EDGE_INDEX_KEY& aKey ) : m_value( aKey.m_value.load() ) {}
+
+            EDGE_INDEX_KEY& operator=( const EDGE_INDEX_KEY& aKey )
+            {
+                m_value.store( aKey.m_value.load() );
+                return *this;
+            }
+
+            boost::atomic<uint64_t> m_value;
+        };
+
+        ///> Lock of the edge index builds of a set.  A copied set gets a lock of its own,
+        ///> since it gets a copy of the index and not the index itself
+        struct EDGE_INDEX_LOCK
+        {
+            EDGE_INDEX_LOCK() {}
+            EDGE_INDEX_LOCK( const EDGE_INDEX_LOCK& ) {}
+            EDGE_INDEX_LOCK& operator=( const EDGE_INDEX_LOCK& ) { return *this; }
+
+            MUTEX m_mutex;
+        };
+
+        void invalidateEdgeIndex()
+        {
+            m_edgeIndexKey.m_value.store( 0 );
+        }
+
+        void indexOutline( int aIndex ) const;
+        void buildOutlineGrid() const;
+
+        bool pointInIndexedPolygon( const VECTOR2I& aP, int aSubpolyIndex ) const;
+
+        ///> Returns true if aP is inside the aIndex-th outline or closer than aClearance to it
+        bool collideIndexedOutline( const VECTOR2I& aP, int aIndex, int aClearance ) const;
+
+        ///> Runs collideIndexedOutline() on the outlines near aP, found in the outline grid
+        bool collideIndexed( const VECTOR2I& aP, int aClearance ) const;
+
         SHAPE_LINE_CHAIN& getContourForCorner( int aCornerId, int& aIndexWithinContour );
         VECTOR2I& vertex( int aCornerId );
         const VECTOR2I& cvertex( int aCornerId ) const;
 
 
+        typedef std::vector<POLYGON> Polyset;
+        typedef std::vector<const POLYGON*> POLYGON_REFS;
+
         void fractureSingle( POLYGON& paths );
-        void importTree( ClipperLib::PolyTree* tree );
+        static void importTree( ClipperLib::PolyTree* tree, Polyset& aResult );
 
         /** Function booleanOp
          * this is the engine to execute all polygon boolean transforms
@@ -361,14 +477,56 @@ class SHAPE_POLY_SET : public SHAPE
                         const SHAPE_POLY_SET& aShape,
                         const SHAPE_POLY_SET& aOtherShape, bool aFastMode = false );
 
-        bool pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const;
+        /**
+         * Function booleanOpGroup
+         * runs a single Clipper boolean operation on a group of polygons.
+         * Thread safe: it touches nothing but its arguments.
+         * @param aResult receives the resulting polygons
+         */
+        static void booleanOpGroup( ClipperLib::ClipType aType, const POLYGON_REFS& aSubject,
+                                    const POLYGON_REFS& aClip, bool aFastMode, Polyset& aResult );
 
-        const ClipperLib::Path convertToClipper( const SHAPE_LINE_CHAIN& aPath, bool aRequiredOrientation );
-        const SHAPE_LINE_CHAIN convertFromClipper( const ClipperLib::Path& aPath );
+        /**
+         * Function inflateGroup
+         * runs a single Clipper offset operation on a group of polygons (see Inflate()).
+         * Thread safe: it touches nothing but its arguments.
+         * @param aResult receives the resulting polygons
+         */
+        static void inflateGroup( const POLYGON_REFS& aPolys, int aFactor,
+                                  int aCircleSegmentsCount, Polyset& aResult );
 
-        typedef std::vector<POLYGON> Polyset;
+        bool pointInPolygon( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath ) const;
+
+        static const ClipperLib::Path convertToClipper( const SHAPE_LINE_CHAIN& aPath,
+                                                        bool aRequiredOrientation );
+        static const SHAPE_LINE_CHAIN convertFromClipper( const ClipperLib::Path& aPath );
 
         Polyset m_polys;
+
+        ///> see SetSplitOperations()
+        bool m_splitOperations;
+
+        ///> Bounding box and edge index of each outline
+        mutable std::vector<EDGE_INDEX> m_edgeIndex;
+
+        ///> Grid of cells over the outline bounding boxes: the outlines touching each cell
+        ///> are stored in m_gridOutlines, from m_gridStart[cell].  The outlines touching
+        ///> too many cells are in m_wideOutlines, and tested by every query
+        mutable BOX2I m_gridBox;
+        mutable int m_gridColumns;
+        mutable int m_gridRows;
+        mutable int m_cellWidth;
+        mutable int m_cellHeight;
+        mutable std::vector<int> m_gridStart;
+        mutable std::vector<int> m_gridOutlines;
+        mutable std::vector<int> m_wideOutlines;
+
+        ///> SHAPE_LINE_CHAIN::StampChanges() + 1 when the index was last checked against
+        ///> the outline stamps, or 0 when outlines were added or removed since
+        mutable EDGE_INDEX_KEY m_edgeIndexKey;
+
+        ///> Serializes the builds of the edge index of this set (see BuildEdgeIndex())
+        mutable EDGE_INDEX_LOCK m_edgeIndexLock;
 };
 
 #endif
@@ -0,0 +1,72 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file job_scheduler.h
+ * @brief Runs independent jobs on a pool of threads.
+ */
+
+#ifndef JOB_SCHEDULER_H_
+#define JOB_SCHEDULER_H_
+
+#include <boost/function.hpp>
+
+
+/**
+ * Class JOB_SCHEDULER
+ * runs a set of independent jobs, numbered from 0 to N-1, on a pool of threads sized
+ * to the hardware concurrency.  The jobs are not split in fixed blocks: each thread
+ * takes the next job from a shared queue when it is done with the previous one, so
+ * a long job does not leave the other threads idle while jobs are left.  Queue the
+ * longest jobs first to get the best balance.
+ * <p>
+ * The queue is a single atomic counter rather than per thread queues with work
+ * stealing: the jobs are whole files or parsed items, so taking a job costs one atomic
+ * increment, which is negligible, and the jobs are taken in order.
+ *
+ * The calling thread runs jobs too, as thread number 0, and Run() returns when all
+ * the jobs are done.  The jobs are run on GUI-less threads: they must not use the
+ * GUI, and must not let exceptions escape.
+ */
+class JOB_SCHEDULER
+{
+public:
+    /// A job, called with the job number and the number of the thread running it
+    typedef boost::function<void ( int aJob, int aThread )> JOB;
+
+    /**
+     * Function GetThreadCount
+     * @return the number of threads used to run aJobCount jobs, i.e. the hardware
+     *  concurrency, but not more than aJobCount, and at least 1.  Use it to size
+     *  per thread data.
+     */
+    static int GetThreadCount( int aJobCount );
+
+    /**
+     * Function Run
+     * runs aJob for each job number in [0, aJobCount).
+     */
+    static void Run( int aJobCount, const JOB& aJob );
+};
+
+#endif  // JOB_SCHEDULER_H_
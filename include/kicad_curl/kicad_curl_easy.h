@@ -43,6 +43,7 @@
 
 
 #include <string>
+#include <map>
 #include <curl/curl.h>
 #include <kicad_curl/kicad_curl.h>
 
@@ -175,10 +176,32 @@ public:
         return m_buffer;
     }
 
+    /**
+     * Function GetResponseCode
+     * returns the HTTP status code of the last response received by Perform(),
+     * e.g. 200, 304 or 404.  When redirects are followed, this is the code of the
+     * final response.
+     */
+    long GetResponseCode();
+
+    /**
+     * Function GetResponseHeader
+     * returns the value of the header \a aName of the last response received by
+     * Perform(), or an empty string if there is no such header.
+     *
+     * @param aName is the header name without the colon, case insensitive, i.e. ETag
+     */
+    std::string GetResponseHeader( const std::string& aName ) const;
+
 private:
+    typedef std::map<std::string, std::string>  HEADER_MAP;
+
+    static size_t header_callback( char* aBuffer, size_t aSize, size_t aCount, void* aUserp );
+
     CURL*           m_CURL;
     curl_slist*     m_headers;
     std::string     m_buffer;
+    HEADER_MAP      m_responseHeaders;  ///< keyed by lower case header names
 };
 
 #endif // KICAD_CURL_EASY_H_
@@ -167,8 +167,13 @@ wxString GetIllegalFileNameWxChars();
 bool ReplaceIllegalFileNameChars( std::string* aName, int aReplaceChar = 0 );
 
 #ifndef HAVE_STRTOKR
+#if defined( _MSC_VER )
+// MSVC has the same function, named strtok_s
+#define strtok_r strtok_s
+#else
 // common/strtok_r.c optionally:
 extern "C" char* strtok_r( char* str, const char* delim, char** nextp );
 #endif
+#endif
 
 #endif  // KICAD_STRING_H_
@@ -301,6 +301,20 @@ public:
      */
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) = 0;
 
+    /**
+     * Function Clone
+     * Creates a painter drawing like this one, with the same settings, on another GAL.
+     * Clones are used to draw items on worker threads, so their Draw() must only read the
+     * items and must not use the GUI.
+     * @param aGal is the GAL used by the clone.
+     * @return The new painter, owned by the caller, or NULL if the painter does not support
+     * drawing on worker threads.
+     */
+    virtual PAINTER* Clone( GAL* aGal ) const
+    {
+        return NULL;
+    }
+
 protected:
     /// Instance of graphic abstraction layer that gives an interface to call
     /// commands used to draw (eg. DrawLine, DrawCircle, etc.)
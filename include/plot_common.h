@@ -33,6 +33,7 @@
 #define PLOT_COMMON_H_
 
 #include <vector>
+#include <boost/unordered_map.hpp>
 #include <math/box2.h>
 #include <drawtxt.h>
 #include <class_page_info.h>
@@ -985,16 +986,44 @@ protected:
     std::vector<APERTURE>::iterator
     getAperture( const wxSize& size, APERTURE::APERTURE_TYPE type );
 
-    FILE* workFile;
-    FILE* finalFile;
-    wxString m_workFilename;
-
     /**
-     * Generate the table of D codes
+     * Generate the table of D codes, appended to \a aText
      */
-    void writeApertureList();
+    void writeApertureList( std::string* aText );
+
+    std::string m_body;             ///< the plot, written to the file by EndPlot()
+    size_t      m_apertureListPos;  ///< where the aperture list goes in m_body
+
+    /// Key of the aperture index: the type and the size of an aperture
+    struct APERTURE_KEY
+    {
+        wxSize                  m_size;
+        APERTURE::APERTURE_TYPE m_type;
+
+        bool operator==( const APERTURE_KEY& aOther ) const
+        {
+            return m_type == aOther.m_type && m_size == aOther.m_size;
+        }
+    };
+
+    struct APERTURE_KEY_HASH : std::unary_function<APERTURE_KEY, std::size_t>
+    {
+        std::size_t operator()( const APERTURE_KEY& aKey ) const
+        {
+            std::size_t seed = 0;
+            boost::hash_combine( seed, aKey.m_size.x );
+            boost::hash_combine( seed, aKey.m_size.y );
+            boost::hash_combine( seed, (int) aKey.m_type );
+
+            return seed;
+        }
+    };
+
+    /// Map an aperture type and size to its position in the apertures list
+    typedef boost::unordered_map<APERTURE_KEY, int, APERTURE_KEY_HASH> APERTURE_INDEX;
 
-    std::vector<APERTURE>           apertures;
+    std::vector<APERTURE>           apertures;      ///< in D code order
+    APERTURE_INDEX                  m_apertureIndex;
     std::vector<APERTURE>::iterator currentAperture;
 
     bool     m_gerberUnitInch;  // true if the gerber units are inches, false for mm
@@ -405,7 +405,7 @@ public:
      * rewinds the file and resets the line number back to zero.  Line number
      * will go to 1 on first ReadLine().
      */
-    void Rewind()
+    virtual void Rewind()
     {
         rewind( fp );
         lineNum = 0;
@@ -413,6 +413,70 @@ public:
 };
 
 
+/**
+ * Class MMAP_LINE_READER
+ * is a FILE_LINE_READER which maps the whole file read only in memory.  ReadLine()
+ * copies the line it returns from the mapping to the line buffer with one memcpy(),
+ * instead of reading the file byte by byte.  The line is copied because users of a
+ * LINE_READER may modify it, e.g. with strtok().
+ * <p>
+ * Files which cannot be mapped, e.g. empty files or pipes, are read as
+ * FILE_LINE_READER does.  Either way, lines ending with "\r\n" are returned ending
+ * with "\n" on all platforms, as from a file opened in text mode on Windows.
+ */
+class MMAP_LINE_READER : public FILE_LINE_READER
+{
+protected:
+    const char* m_map;          ///< the mapped file, or NULL if it is read with FILE_LINE_READER
+    size_t      m_mapSize;
+    size_t      m_offset;       ///< offset of the next line in m_map
+
+#ifdef __WINDOWS__
+    void*       m_mapHandle;
+#endif
+
+    void mapFile();
+
+    /**
+     * Function readMappedLine
+     * copies the next line of the mapping to the line buffer, as ReadLine() does.
+     * @throw IO_ERROR when the line is too long.
+     */
+    void readMappedLine() throw( IO_ERROR );
+
+public:
+
+    /**
+     * Constructor MMAP_LINE_READER
+     * opens and maps @a aFileName, see FILE_LINE_READER for the parameters.
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened.
+     */
+    MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX ) throw( IO_ERROR );
+
+    /**
+     * Constructor MMAP_LINE_READER
+     * maps the open file @a aFile, see FILE_LINE_READER for the parameters.  The file
+     * is mapped only if it was not read from yet.
+     */
+    MMAP_LINE_READER( FILE* aFile, const wxString& aFileName, bool doOwn = true,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX );
+
+    ~MMAP_LINE_READER();
+
+    char* ReadLine() throw( IO_ERROR );   // see LINE_READER::ReadLine() description
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the file and resets the line number back to zero.
+     */
+    void Rewind();      // override FILE_LINE_READER::Rewind()
+};
+
+
 /**
  * Class STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
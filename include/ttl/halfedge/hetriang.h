@@ -183,6 +183,12 @@ public:
         return m_parents.size();
     }
 
+    /// Returns the board items that share this node
+    inline const std::list<const BOARD_CONNECTED_ITEM*>& GetParents() const
+    {
+        return m_parents;
+    }
+
     inline void AddParent( const BOARD_CONNECTED_ITEM* aParent )
     {
         m_parents.push_back( aParent );
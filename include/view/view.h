@@ -39,6 +39,7 @@ class GAL;
 class VIEW_ITEM;
 class VIEW_GROUP;
 class VIEW_RTREE;
+class RECORDING_GAL;
 
 /**
  * Class VIEW.
@@ -154,6 +155,20 @@ public:
         return m_painter;
     }
 
+    /**
+     * Function SetUseThreads()
+     * Enables or disables drawing the items on several threads when they are recached (see
+     * RecacheAllItems() and UpdateItems()).  Threads are used only if the painter can be
+     * cloned, see PAINTER::Clone().  They are disabled by default, until the threaded recache
+     * has been checked and timed with both the Cairo and the OpenGL GALs (see
+     * tools/view_recache_bench).
+     * @param aEnable tells if the items may be drawn on several threads.
+     */
+    inline void SetUseThreads( bool aEnable )
+    {
+        m_useThreads = aEnable;
+    }
+
     /**
      * Function SetViewport()
      * Sets the visible area of the VIEW.
@@ -462,7 +477,8 @@ public:
 
     /**
      * Function RecacheAllItems()
-     * Rebuilds GAL display lists.
+     * Rebuilds GAL display lists.  When instantly recached, the items are drawn on several
+     * threads if possible, see SetUseThreads().
      * @param aForceNow decides if every item should be instantly recached. Otherwise items are
      * going to be recached when they become visible.
      */
@@ -576,11 +592,23 @@ private:
         std::set<int>           requiredLayers;  ///< layers that have to be enabled to show the layer
     };
 
+    /// An item to be drawn again on one of its cached layers
+    struct RECACHE_ENTRY
+    {
+        VIEW_ITEM*              item;            ///< the item to be drawn
+        int                     layer;           ///< the layer to draw it on
+        int                     recorder;        ///< index of the recorder holding its commands,
+                                                 ///< or -1 if it has to be drawn by the VIEW
+        int                     first;           ///< index of its first recorded command
+        int                     end;             ///< index following its last recorded command
+    };
+
     // Convenience typedefs
     typedef boost::unordered_map<int, VIEW_LAYER>   LAYER_MAP;
     typedef LAYER_MAP::iterator                     LAYER_MAP_ITER;
     typedef std::vector<VIEW_LAYER*>                LAYER_ORDER;
     typedef std::vector<VIEW_LAYER*>::iterator      LAYER_ORDER_ITER;
+    typedef std::vector<RECACHE_ENTRY>              RECACHE_LIST;
 
     // Function objects that need to access VIEW/VIEW_ITEM private/protected members
     struct clearLayerCache;
@@ -646,14 +674,29 @@ private:
      * Manages dirty flags & redraw queueing when updating an item.
      * @param aItem is the item to be updated.
      * @param aUpdateFlags determines the way an item is refreshed.
+     * @param aRecache receives the layers on which the item has to be drawn again.
      */
-    void invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags );
+    void invalidateItem( VIEW_ITEM* aItem, int aUpdateFlags, RECACHE_LIST& aRecache );
 
     /// Updates colors that are used for an item to be drawn
     void updateItemColor( VIEW_ITEM* aItem, int aLayer );
 
-    /// Updates all informations needed to draw an item
-    void updateItemGeometry( VIEW_ITEM* aItem, int aLayer );
+    /**
+     * Function recacheItems()
+     * Draws items again in new cached groups, replacing their previous groups.  The items are
+     * drawn on several threads with clones of the painter when possible, then their groups
+     * are built in the list order.
+     * @param aItems are the items to draw, with the layers to draw them on.
+     */
+    void recacheItems( RECACHE_LIST& aItems );
+
+    /**
+     * Function recordItems()
+     * Draws a chunk of aItems with the recorder and the painter of aThread.  This is a
+     * JOB_SCHEDULER job of recacheItems().
+     */
+    void recordItems( RECACHE_LIST* aItems, const std::vector<PAINTER*>* aPainters,
+                      int aChunk, int aThread );
 
     /// Updates bounding box of an item
     void updateBbox( VIEW_ITEM* aItem );
@@ -715,6 +758,12 @@ private:
 
     /// Items to be updated
     std::vector<VIEW_ITEM*> m_needsUpdate;
+
+    /// Whether to draw the recached items on several threads
+    bool m_useThreads;
+
+    /// GALs recording the items drawn by each thread when recaching, created when needed
+    std::vector<RECORDING_GAL*> m_recorders;
 };
 } // namespace KIGFX
 
@@ -51,6 +51,7 @@ class PCB_TARGET;
 class DIMENSION;
 class EDGE_MODULE;
 class DRC;
+class BACKGROUND_BOARD_SAVER;
 class ZONE_CONTAINER;
 class DRAWSEGMENT;
 class GENERAL_COLLECTOR;
@@ -107,6 +108,8 @@ protected:
 
     DRC* m_drc;                                 ///< the DRC controller, see drc.cpp
 
+    BACKGROUND_BOARD_SAVER* m_autoSaver;        ///< writes the auto save files
+
     PARAM_CFG_ARRAY   m_configSettings;         ///< List of Pcbnew configuration settings.
 
     wxString          m_lastNetListRead;        ///< Last net list read with relative path.
@@ -186,6 +189,21 @@ protected:
      */
     virtual bool doAutoSave();
 
+    /**
+     * Function autoSaveCompleted
+     * is called from the worker thread of the auto save when the file is written, and
+     * reports to the GUI thread with onAutoSaveDone().
+     */
+    void autoSaveCompleted( const wxString& aFileName, const wxString& aError );
+
+    /**
+     * Function onAutoSaveDone
+     * is called on the GUI thread when an auto save is done.
+     * @param aFileName is the auto save file name.
+     * @param aError is the error message, empty if the file was written.
+     */
+    void onAutoSaveDone( const wxString& aFileName, const wxString& aError );
+
     /**
      * Function isautoSaveRequired
      * returns true if the board has been modified.
@@ -1419,7 +1437,9 @@ public:
      * The old fillings are removed
      * @param aActiveWindow = the current active window, if a progress bar is shown
      *                      = NULL to do not display a progress bar
-     * @param aVerbose = true to show error messages
+     * @param aVerbose = true to fill all the zones even if one cannot be filled,
+     *                  false to stop at the first zone which cannot be filled
+     * @return error level (0 = no error, 1 = aborted by the user or a zone not filled)
      */
     int Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose = true );
 
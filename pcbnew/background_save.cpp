@@ -0,0 +1,127 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+/**
+ * @file background_save.cpp
+ */
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <fctsys.h>
+#include <common.h>
+#include <macros.h>
+#include <class_board.h>
+#include <io_mgr.h>
+#include <background_save.h>
+
+
+BACKGROUND_BOARD_SAVER::BACKGROUND_BOARD_SAVER() :
+    m_thread( NULL ),
+    m_running( false )
+{
+}
+
+
+BACKGROUND_BOARD_SAVER::~BACKGROUND_BOARD_SAVER()
+{
+    Wait();
+}
+
+
+bool BACKGROUND_BOARD_SAVER::Start( const BOARD* aBoard, const wxString& aFileName,
+                                    const COMPLETION& aCompletion )
+{
+    if( IsRunning() )
+        return false;
+
+    // Release the thread of the previous save, which is done
+    Wait();
+
+    BOARD* snapshot = aBoard->Snapshot();
+
+    {
+        MUTLOCK lock( m_lock );
+        m_running = true;
+    }
+
+    m_thread = new boost::thread( boost::bind( &BACKGROUND_BOARD_SAVER::run, this,
+                                               snapshot, aFileName, aCompletion ) );
+
+    return true;
+}
+
+
+bool BACKGROUND_BOARD_SAVER::IsRunning() const
+{
+    MUTLOCK lock( m_lock );
+
+    return m_running;
+}
+
+
+void BACKGROUND_BOARD_SAVER::Wait()
+{
+    if( m_thread )
+    {
+        m_thread->join();
+        delete m_thread;
+        m_thread = NULL;
+    }
+}
+
+
+void BACKGROUND_BOARD_SAVER::run( BOARD* aSnapshot, const wxString& aFileName,
+                                  const COMPLETION& aCompletion )
+{
+    wxString error;
+
+    {
+        // The LOCALE_IO of the plugin then leaves the locale of the GUI thread alone
+        THREAD_C_LOCALE cLocale;
+
+        try
+        {
+            PLUGIN::RELEASER pi( IO_MGR::PluginFind( IO_MGR::KICAD ) );
+
+            pi->Save( aFileName, aSnapshot, NULL );
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            error = ioe.errorText;
+        }
+        catch( const std::exception& e )
+        {
+            error = FROM_UTF8( e.what() );
+        }
+    }
+
+    delete aSnapshot;
+
+    if( aCompletion )
+        aCompletion( aFileName, error );
+
+    MUTLOCK lock( m_lock );
+    m_running = false;
+}
@@ -0,0 +1,94 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+/**
+ * @file background_save.h
+ * @brief Saves a snapshot of a board on a worker thread.
+ */
+
+#ifndef BACKGROUND_SAVE_H_
+#define BACKGROUND_SAVE_H_
+
+#include <boost/function.hpp>
+#include <wx/string.h>
+
+#include <ki_mutex.h>
+
+class BOARD;
+
+namespace boost { class thread; }
+
+
+/**
+ * Class BACKGROUND_BOARD_SAVER
+ * writes a BOARD to a file in the KiCad s-expression format on a worker thread, so the
+ * GUI is not blocked while the file is formatted and written.  Start() takes a
+ * BOARD::Snapshot() of the board, which is cheap compared to the formatting, and the
+ * worker thread saves this copy with the same PCB_IO::Save() as a foreground save, so
+ * the files are identical.  Only one save runs at a time.
+ */
+class BACKGROUND_BOARD_SAVER
+{
+public:
+    /**
+     * Called on the worker thread when the save is done, with the file name and the
+     * error message, empty on success.  It must not use the GUI: use CallAfter() to
+     * report to the GUI thread.
+     */
+    typedef boost::function<void ( const wxString& aFileName, const wxString& aError )> COMPLETION;
+
+    BACKGROUND_BOARD_SAVER();
+
+    /// Waits for a running save
+    ~BACKGROUND_BOARD_SAVER();
+
+    /**
+     * Function Start
+     * takes a snapshot of \a aBoard and starts writing it to \a aFileName.
+     * @return false if a save is already running, and nothing is started.
+     */
+    bool Start( const BOARD* aBoard, const wxString& aFileName, const COMPLETION& aCompletion );
+
+    /**
+     * Function IsRunning
+     * @return true if a save is running.
+     */
+    bool IsRunning() const;
+
+    /**
+     * Function Wait
+     * returns when the running save, if any, is done.  Its completion has been called.
+     */
+    void Wait();
+
+private:
+    /// The worker thread function, which owns aSnapshot
+    void run( BOARD* aSnapshot, const wxString& aFileName, const COMPLETION& aCompletion );
+
+    boost::thread*  m_thread;
+    bool            m_running;
+    mutable MUTEX   m_lock;         ///< protects m_running
+};
+
+#endif  // BACKGROUND_SAVE_H_
@@ -31,6 +31,7 @@
  * Used to fill zones areas and in 3D viewer
  */
 #include <vector>
+#include <boost/bind.hpp>
 
 #include <fctsys.h>
 #include <drawtxt.h>
@@ -47,20 +48,37 @@
 #include <class_edge_mod.h>
 #include <convert_basic_shapes_to_polygon.h>
 
-// These variables are parameters used in addTextSegmToPoly.
-// But addTextSegmToPoly is a call-back function,
-// so we cannot send them as arguments.
-static int s_textWidth;
-static int s_textCircle2SegmentCount;
-static SHAPE_POLY_SET* s_cornerBuffer;
-
-// This is a call back function, used by DrawGraphicText to draw the 3D text shape:
-static void addTextSegmToPoly( int x0, int y0, int xf, int yf )
+/**
+ * Struct TEXT_SHAPE_BUILDER
+ * holds the parameters of the segments of a text drawn by DrawGraphicText(), which
+ * calls AddSegment() for each one.  They are local to the caller, not static, because
+ * texts are converted on several threads at the same time, e.g. by parallel plots.
+ */
+struct TEXT_SHAPE_BUILDER
 {
-    TransformRoundedEndsSegmentToPolygon( *s_cornerBuffer,
-                                           wxPoint( x0, y0), wxPoint( xf, yf ),
-                                           s_textCircle2SegmentCount, s_textWidth );
-}
+    SHAPE_POLY_SET& m_cornerBuffer;
+    int             m_circleToSegmentsCount;
+    int             m_width;
+
+    TEXT_SHAPE_BUILDER( SHAPE_POLY_SET& aCornerBuffer, int aCircleToSegmentsCount ) :
+        m_cornerBuffer( aCornerBuffer ),
+        m_circleToSegmentsCount( aCircleToSegmentsCount ),
+        m_width( 0 )
+    {
+    }
+
+    void AddSegment( int x0, int y0, int xf, int yf )
+    {
+        TransformRoundedEndsSegmentToPolygon( m_cornerBuffer,
+                                              wxPoint( x0, y0 ), wxPoint( xf, yf ),
+                                              m_circleToSegmentsCount, m_width );
+    }
+
+    TEXT_SEGMENT_CALLBACK Callback()
+    {
+        return boost::bind( &TEXT_SHAPE_BUILDER::AddSegment, this, _1, _2, _3, _4 );
+    }
+};
 
 
 void BOARD::ConvertBrdLayerToPolygonalContours( LAYER_ID aLayer, SHAPE_POLY_SET& aOutlines )
@@ -249,18 +267,16 @@ void MODULE::TransformGraphicShapesWithClearanceToPolygonSet(
     if( Value().GetLayer() == aLayer && Value().IsVisible() )
         texts.push_back( &Value() );
 
-    s_cornerBuffer = &aCornerBuffer;
-
     // To allow optimization of circles approximated by segments,
     // aCircleToSegmentsCountForTexts, when not 0, is used.
     // if 0 (default value) the aCircleToSegmentsCount is used
-    s_textCircle2SegmentCount = aCircleToSegmentsCountForTexts ?
-                                aCircleToSegmentsCountForTexts : aCircleToSegmentsCount;
+    TEXT_SHAPE_BUILDER builder( aCornerBuffer, aCircleToSegmentsCountForTexts ?
+                                aCircleToSegmentsCountForTexts : aCircleToSegmentsCount );
 
     for( unsigned ii = 0; ii < texts.size(); ii++ )
     {
         TEXTE_MODULE *textmod = texts[ii];
-        s_textWidth  = textmod->GetThickness() + ( 2 * aInflateValue );
+        builder.m_width = textmod->GetThickness() + ( 2 * aInflateValue );
         wxSize size = textmod->GetSize();
 
         if( textmod->IsMirrored() )
@@ -270,7 +286,7 @@ void MODULE::TransformGraphicShapesWithClearanceToPolygonSet(
                          textmod->GetShownText(), textmod->GetDrawRotation(), size,
                          textmod->GetHorizJustify(), textmod->GetVertJustify(),
                          textmod->GetThickness(), textmod->IsItalic(),
-                         true, addTextSegmToPoly );
+                         true, builder.Callback() );
     }
 
 }
@@ -375,9 +391,8 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
     if( IsMirrored() )
         size.x = -size.x;
 
-    s_cornerBuffer = &aCornerBuffer;
-    s_textWidth  = GetThickness() + ( 2 * aClearanceValue );
-    s_textCircle2SegmentCount = aCircleToSegmentsCount;
+    TEXT_SHAPE_BUILDER builder( aCornerBuffer, aCircleToSegmentsCount );
+    builder.m_width = GetThickness() + ( 2 * aClearanceValue );
     EDA_COLOR_T color = BLACK;  // not actually used, but needed by DrawGraphicText
 
     if( IsMultilineAllowed() )
@@ -395,7 +410,7 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
                              txt, GetOrientation(), size,
                              GetHorizJustify(), GetVertJustify(),
                              GetThickness(), IsItalic(),
-                             true, addTextSegmToPoly );
+                             true, builder.Callback() );
         }
     }
     else
@@ -404,7 +419,7 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
                          GetShownText(), GetOrientation(), size,
                          GetHorizJustify(), GetVertJustify(),
                          GetThickness(), IsItalic(),
-                         true, addTextSegmToPoly );
+                         true, builder.Callback() );
     }
 }
 
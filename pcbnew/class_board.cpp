@@ -32,6 +32,9 @@
 
 #include <limits.h>
 #include <algorithm>
+#include <map>
+
+#include <boost/make_shared.hpp>
 
 #include <fctsys.h>
 #include <common.h>
@@ -112,11 +115,12 @@ BOARD::BOARD() :
 
 BOARD::~BOARD()
 {
-    while( m_ZoneDescriptorList.size() )
-    {
-        ZONE_CONTAINER* area_to_remove = m_ZoneDescriptorList[0];
-        Delete( area_to_remove );
-    }
+    // The ratsnest is deleted below: the zones are not removed from it, as
+    // the zones of a Snapshot() were never added to it.
+    for( unsigned ii = 0; ii < m_ZoneDescriptorList.size(); ii++ )
+        delete m_ZoneDescriptorList[ii];
+
+    m_ZoneDescriptorList.clear();
 
     delete m_ratsnest;
 
@@ -858,6 +862,14 @@ unsigned BOARD::GetNodesCount() const
 
 
 EDA_RECT BOARD::ComputeBoundingBox( bool aBoardEdgesOnly )
+{
+    m_BoundingBox = computeBoundingBox( aBoardEdgesOnly );  // save for BOARD::GetBoundingBox()
+
+    return m_BoundingBox;
+}
+
+
+EDA_RECT BOARD::computeBoundingBox( bool aBoardEdgesOnly ) const
 {
     bool hasItems = false;
     EDA_RECT area;
@@ -926,8 +938,6 @@ EDA_RECT BOARD::ComputeBoundingBox( bool aBoardEdgesOnly )
         }
     }
 
-    m_BoundingBox = area;   // save for BOARD::GetBoundingBox()
-
     return area;
 }
 
@@ -1471,6 +1481,50 @@ int BOARD::SetAreasNetCodesFromNetNames()
 }
 
 
+void BOARD::InvalidateZoneFills( const EDA_RECT& aArea )
+{
+    for( int ii = 0; ii < GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = GetArea( ii );
+
+        if( zone->IsOnCopperLayer() && !zone->GetIsKeepout() )
+            zone->InvalidateFilledArea( aArea );
+    }
+}
+
+
+void BOARD::InvalidateZoneFills( BOARD_ITEM* aItem )
+{
+    // The clearance holes of an item extend beyond its shape
+    EDA_RECT area = aItem->GetBoundingBox();
+    area.Inflate( GetDesignSettings().GetBiggestClearanceValue() );
+
+    InvalidateZoneFills( area );
+}
+
+
+int BOARD::RefillDirtyZones( std::vector<ZONE_CONTAINER*>* aRefilledZones )
+{
+    int count = 0;
+
+    for( int ii = 0; ii < GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = GetArea( ii );
+
+        if( zone->IsFillDirty() )
+        {
+            zone->RefillDirtyArea( this );
+            count++;
+
+            if( aRefilledZones )
+                aRefilledZones->push_back( zone );
+        }
+    }
+
+    return count;
+}
+
+
 VIA* BOARD::GetViaByPosition( const wxPoint& aPosition, LAYER_ID aLayer) const
 {
     for( VIA *via = GetFirstVia( m_Track); via; via = GetFirstVia( via->Next() ) )
@@ -2711,6 +2765,168 @@ BOARD_ITEM* BOARD::DuplicateAndAddItem( const BOARD_ITEM* aItem,
 }
 
 
+/**
+ * Function snapshotItem
+ * copies \a aItem for BOARD::Snapshot().  The copy constructors give new time stamps
+ * to the copies: the time stamps of the item and of its children are restored, so the
+ * copy is saved as the item.  The copied pads are added to \a aPadCopies: their nets
+ * are set when the nets of the snapshot exist.
+ */
+static BOARD_ITEM* snapshotItem( const BOARD_ITEM* aItem, BOARD* aSnapshot,
+                                 std::map<const D_PAD*, D_PAD*>& aPadCopies )
+{
+    BOARD_ITEM* copy = static_cast<BOARD_ITEM*>( aItem->Clone() );
+
+    copy->SetParent( aSnapshot );
+    copy->SetTimeStamp( aItem->GetTimeStamp() );
+
+    switch( aItem->Type() )
+    {
+    case PCB_MODULE_T:
+    {
+        const MODULE* module = static_cast<const MODULE*>( aItem );
+        MODULE* moduleCopy = static_cast<MODULE*>( copy );
+
+        moduleCopy->Reference().SetTimeStamp( module->Reference().GetTimeStamp() );
+        moduleCopy->Value().SetTimeStamp( module->Value().GetTimeStamp() );
+
+        D_PAD* padCopy = moduleCopy->Pads();
+
+        for( const D_PAD* pad = module->Pads();  pad && padCopy;
+                pad = pad->Next(), padCopy = padCopy->Next() )
+        {
+            padCopy->SetTimeStamp( pad->GetTimeStamp() );
+            aPadCopies[pad] = padCopy;
+        }
+
+        BOARD_ITEM* drawingCopy = moduleCopy->GraphicalItems();
+
+        for( const BOARD_ITEM* drawing = module->GraphicalItems();  drawing && drawingCopy;
+                drawing = drawing->Next(), drawingCopy = drawingCopy->Next() )
+        {
+            drawingCopy->SetTimeStamp( drawing->GetTimeStamp() );
+        }
+
+        break;
+    }
+
+    case PCB_DIMENSION_T:
+    {
+        const DIMENSION* dimension = static_cast<const DIMENSION*>( aItem );
+        DIMENSION* dimensionCopy = static_cast<DIMENSION*>( copy );
+
+        // The text is a member: its copy still has the original dimension as parent
+        dimensionCopy->Text().SetParent( dimensionCopy );
+        dimensionCopy->Text().SetTimeStamp( dimension->Text().GetTimeStamp() );
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    // Use the net of the same code in the snapshot
+    if( copy->IsConnected() )
+    {
+        BOARD_CONNECTED_ITEM* connected = static_cast<BOARD_CONNECTED_ITEM*>( copy );
+
+        connected->SetNetCode( static_cast<const BOARD_CONNECTED_ITEM*>( aItem )->GetNetCode() );
+    }
+
+    return copy;
+}
+
+
+BOARD* BOARD::Snapshot() const
+{
+    BOARD* snapshot = new BOARD();
+
+    snapshot->m_fileName = m_fileName;
+    snapshot->m_fileFormatVersionAtLoad = m_fileFormatVersionAtLoad;
+    snapshot->m_Status_Pcb = m_Status_Pcb;
+
+    for( LAYER_NUM layer = 0; layer < LAYER_ID_COUNT; ++layer )
+        snapshot->m_Layer[layer] = m_Layer[layer];
+
+    snapshot->m_designSettings = m_designSettings;
+    snapshot->m_zoneSettings = m_zoneSettings;
+    snapshot->m_colorsSettings = m_colorsSettings;
+    snapshot->m_paper = m_paper;
+    snapshot->m_titles = m_titles;
+    snapshot->m_plotOptions = m_plotOptions;
+
+    // The assignment shares the net classes: give the snapshot its own copies
+    NETCLASSES& netClasses = snapshot->m_designSettings.m_NetClasses;
+
+    netClasses.Clear();
+    netClasses.Add( boost::make_shared<NETCLASS>( *m_designSettings.GetDefault() ) );
+
+    for( NETCLASSES::const_iterator it = m_designSettings.m_NetClasses.begin();
+         it != m_designSettings.m_NetClasses.end(); ++it )
+    {
+        netClasses.Add( boost::make_shared<NETCLASS>( *it->second ) );
+    }
+
+    // The bounding box and the counters are not recomputed: the file header
+    // reports the values of this BOARD
+    snapshot->m_BoundingBox = m_BoundingBox;
+    snapshot->m_nodeCount = m_nodeCount;
+    snapshot->m_unconnectedNetCount = m_unconnectedNetCount;
+
+    // The items are added without BOARD::Add(), which would feed the ratsnest
+    std::map<const D_PAD*, D_PAD*> padCopies;
+
+    for( const MODULE* module = m_Modules;  module;  module = module->Next() )
+    {
+        snapshot->m_Modules.PushBack(
+                static_cast<MODULE*>( snapshotItem( module, snapshot, padCopies ) ) );
+    }
+
+    for( const BOARD_ITEM* item = m_Drawings;  item;  item = item->Next() )
+        snapshot->m_Drawings.PushBack( snapshotItem( item, snapshot, padCopies ) );
+
+    // Nets are needed by the connected items which follow
+    snapshot->m_NetInfo.copyNets( m_NetInfo, padCopies );
+
+    for( std::map<const D_PAD*, D_PAD*>::iterator it = padCopies.begin();
+            it != padCopies.end(); ++it )
+    {
+        it->second->SetNetCode( it->first->GetNetCode() );
+    }
+
+    for( const TRACK* track = m_Track;  track;  track = track->Next() )
+    {
+        snapshot->m_Track.PushBack(
+                static_cast<TRACK*>( snapshotItem( track, snapshot, padCopies ) ) );
+    }
+
+    for( const SEGZONE* segzone = m_Zone;  segzone;  segzone = segzone->Next() )
+    {
+        snapshot->m_Zone.PushBack(
+                static_cast<SEGZONE*>( snapshotItem( segzone, snapshot, padCopies ) ) );
+    }
+
+    for( unsigned ii = 0; ii < m_ZoneDescriptorList.size(); ii++ )
+    {
+        snapshot->m_ZoneDescriptorList.push_back(
+                static_cast<ZONE_CONTAINER*>( snapshotItem( m_ZoneDescriptorList[ii], snapshot,
+                                                            padCopies ) ) );
+    }
+
+    // Only the rats count is saved, but keep the rats valid for the snapshot pads
+    for( unsigned ii = 0; ii < m_FullRatsnest.size(); ii++ )
+    {
+        RATSNEST_ITEM rat = m_FullRatsnest[ii];
+
+        rat.m_PadStart = padCopies[rat.m_PadStart];
+        rat.m_PadEnd = padCopies[rat.m_PadEnd];
+        snapshot->m_FullRatsnest.push_back( rat );
+    }
+
+    return snapshot;
+}
+
+
 wxString BOARD::GetNextModuleReferenceWithPrefix( const wxString& aPrefix,
                                                   bool aFillSequenceGaps )
 {
@@ -31,6 +31,8 @@
 #define CLASS_BOARD_H_
 
 
+#include <boost/function.hpp>
+
 #include <dlist.h>
 
 #include <common.h>                         // PAGE_INFO
@@ -216,6 +218,13 @@ private:
      */
     void chainMarkedSegments( wxPoint aPosition, const LSET& aLayerSet, TRACK_PTRS* aList );
 
+    /**
+     * Function computeBoundingBox
+     * @return EDA_RECT - the bounding box of all the board items, or of the board edge
+     * segments if \a aBoardEdgesOnly is true (see ComputeBoundingBox()).
+     */
+    EDA_RECT computeBoundingBox( bool aBoardEdgesOnly ) const;
+
 public:
     static inline bool ClassOf( const EDA_ITEM* aItem )
     {
@@ -297,6 +306,17 @@ public:
     BOARD_ITEM* DuplicateAndAddItem( const BOARD_ITEM* aItem,
                                      bool aIncrementReferences );
 
+    /**
+     * Function Snapshot
+     * makes a copy of this BOARD holding everything which is saved in a board file: the
+     * settings, the net classes, the nets with their codes, and the items with their time
+     * stamps.  The copy shares nothing with this BOARD, so it can be saved by another
+     * thread while this BOARD is edited, and the file is the one this BOARD would give.
+     * Markers are not copied, and the ratsnest of the copy is not computed.
+     * @return BOARD* - the copy, owned by the caller.
+     */
+    BOARD* Snapshot() const;
+
     /**
      * Function GetNextModuleReferenceWithPrefix
      * Get the next available module reference with this prefix
@@ -859,6 +879,18 @@ public:
      */
     EDA_RECT ComputeBoundingBox( bool aBoardEdgesOnly = false );
 
+    /**
+     * Function GetBoardEdgesBoundingBox
+     * calculates the bounding box of the board edge segments, as ComputeBoundingBox( true )
+     * does, but does not save it for GetBoundingBox(): the board is not modified, so it can
+     * be called from the jobs of a BOARD_PLOT_BATCH.
+     * @return EDA_RECT - the bounding box of the board edges
+     */
+    EDA_RECT GetBoardEdgesBoundingBox() const
+    {
+        return computeBoundingBox( true );
+    }
+
     /**
      * Function GetBoundingBox
      * may be called soon after ComputeBoundingBox() to return the same EDA_RECT,
@@ -1042,6 +1074,76 @@ public:
      */
     int SetAreasNetCodesFromNetNames( void );
 
+    /**
+     * Function InvalidateZoneFills
+     * tells the filled zones that board items were modified inside aArea, so that
+     * RefillDirtyZones() rebuilds only the clearance holes of the items inside aArea.
+     * @param aArea is the area covered by the modified items, including their clearance.
+     * For a moved item, it must be called for both the old and the new item position.
+     */
+    void InvalidateZoneFills( const EDA_RECT& aArea );
+
+    /**
+     * Function InvalidateZoneFills
+     * tells the filled zones that aItem, at its current position, is added, removed or
+     * modified: the area of the item inflated by the biggest clearance is invalidated.
+     * @param aItem is the item, to give before and after its modification.
+     */
+    void InvalidateZoneFills( BOARD_ITEM* aItem );
+
+    /**
+     * Function RefillDirtyZones
+     * rebuilds the filled areas of the zones which have invalidated areas.
+     * @param aRefilledZones, if not NULL, is filled with the refilled zones.
+     * @return the number of refilled zones.
+     */
+    int RefillDirtyZones( std::vector<ZONE_CONTAINER*>* aRefilledZones = NULL );
+
+    /**
+     * Function PrepareZonesFill
+     * prepares a fill of all the zones which can run on several threads (see FillZones()):
+     * removes the segment zones, calculates what the items read by the fill cache lazily,
+     * and rebuilds the corner-smoothed outlines of all the zones.
+     * @param aZonesToFill is filled with the zones to fill, i.e. all but the keepout areas.
+     */
+    void PrepareZonesFill( std::vector<ZONE_CONTAINER*>& aZonesToFill );
+
+    /**
+     * A ZONE_FILL_PROGRESS is called by FillZones() after a zone is filled, with the number
+     * of zones filled so far, the number of zones to fill and the filled zone.  It is only
+     * called from the thread which called FillZones(), and returns false to abort the fill.
+     */
+    typedef boost::function<bool ( int aFilledCount, int aZoneCount,
+                                   ZONE_CONTAINER* aZone )> ZONE_FILL_PROGRESS;
+
+    /**
+     * Function FillZones
+     * builds the filled areas of zones prepared by PrepareZonesFill(), concurrently, the
+     * biggest zones first.  Each fill only reads the board and writes the filled areas of
+     * its own zone, so the result does not depend on the number of threads.
+     * @param aZones are the zones to fill.
+     * @param aThreadCount is the number of threads, 0 to use the default (in OpenMP builds).
+     * @param aProgress, if not empty, reports the progress and can abort the fill.  The
+     *  zones not filled yet when it aborts keep their filled areas.
+     * @param aRefilledZones, if not NULL, is filled with the zones whose filled areas were
+     *  rebuilt, i.e. all of \a aZones unless the fill stopped early.
+     * @param aStopOnError is true to stop the fill after a zone whose filled areas cannot
+     *  be built (see ZONE_CONTAINER::BuildFilledSolidAreasPolygons()).
+     * @return false if the fill was aborted or a zone could not be filled.
+     */
+    bool FillZones( const std::vector<ZONE_CONTAINER*>& aZones, int aThreadCount = 0,
+                    const ZONE_FILL_PROGRESS& aProgress = ZONE_FILL_PROGRESS(),
+                    std::vector<ZONE_CONTAINER*>* aRefilledZones = NULL,
+                    bool aStopOnError = false );
+
+    /**
+     * Function FillAllZones
+     * fills all the zones of a board which is not shown in a frame, as
+     * PCB_EDIT_FRAME::Fill_All_Zones() does, using PrepareZonesFill() and FillZones().
+     * @param aThreadCount is the number of threads, 0 to use the default (in OpenMP builds).
+     */
+    void FillAllZones( int aThreadCount = 0 );
+
     /**
      * Function GetArea
      * returns the Area (Zone Container) at a given index.
@@ -1193,10 +1295,13 @@ public:
      * @param aArea_To_Examine: area to compare with other areas, or if NULL then
      *          all areas are compared to all others.
      * @param aCreate_Markers: if true create DRC markers. False: do not creates anything
+     * @param aMarkers: if not NULL, the created markers are stored in this list instead
+     *          of being added to the board.
      * @return errors count
      */
     int Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_Examine,
-                                                   bool            aCreate_Markers );
+                                                   bool            aCreate_Markers,
+                                                   std::vector<MARKER_PCB*>* aMarkers = NULL );
 
     /****** function relative to ratsnest calculations: */
 
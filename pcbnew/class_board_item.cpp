@@ -34,6 +34,7 @@
 
 #include <class_board.h>
 #include <string>
+#include <algorithm>
 
 wxString BOARD_ITEM::ShowShape( STROKE_T aShape )
 {
@@ -86,10 +87,81 @@ wxString BOARD_ITEM::GetLayerName() const
 }
 
 
+/// The number of decimals of a millimeter value in internal units, IU_PER_MM being
+/// a power of ten.
+static const int iuDecimals = KiROUND( log10( IU_PER_MM ) );
+
+
+/**
+ * Function formatFixedPoint
+ * writes \a aValue / 10^aDecimals into \a aBuf, as "%.10g" would write it, without
+ * the sprintf() overhead: no exponent, and no trailing zero after the decimal point.
+ * The value is an exact decimal number with at most 10 significant digits, so the
+ * result is the same as sprintf's.
+ * @return int - the length of the nul terminated text, not more than 13.
+ */
+static int formatFixedPoint( int aValue, int aDecimals, char* aBuf )
+{
+    char        digits[16];     // the digits of aValue, the lowest first
+    int         count = 0;
+    unsigned    value = aValue < 0 ? 0u - (unsigned) aValue : (unsigned) aValue;
+    char*       out = aBuf;
+
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while( value );
+
+    if( aValue < 0 )
+        *out++ = '-';
+
+    // Integer part
+    if( count > aDecimals )
+    {
+        for( int ii = count - 1;  ii >= aDecimals;  --ii )
+            *out++ = digits[ii];
+    }
+    else
+    {
+        *out++ = '0';
+    }
+
+    // Fractional part, without its trailing zeros
+    int fracDigits = std::min( count, aDecimals );
+    int last = 0;
+
+    while( last < fracDigits && digits[last] == '0' )
+        ++last;
+
+    if( last < fracDigits )
+    {
+        *out++ = '.';
+
+        for( int ii = aDecimals - 1;  ii >= last;  --ii )
+            *out++ = ii < count ? digits[ii] : '0';
+    }
+
+    *out = '\0';
+
+    return out - aBuf;
+}
+
+
 std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 {
 #if 1
 
+    char    buf[16];
+    int     len = formatFixedPoint( aValue, iuDecimals, buf );
+
+    return std::string( buf, len );
+
+#else
+
+    // The general purpose algorithm, which gives the same results than the
+    // above fixed point one.  Can be used to verify the latter.
+
     char    buf[50];
     int     len;
     double  mm = aValue / IU_PER_MM;
@@ -113,56 +185,6 @@ std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 
     return std::string( buf, len );
 
-#else
-
-    // Assume aValue is in nanometers, and that we want the result in millimeters,
-    // and that int is 32 bits wide.  Then perform an alternative algorithm.
-    // Can be used to verify that the above algorithm is correctly generating text.
-    // Convert aValue into an integer string, then insert a decimal point manually.
-    // Results are the same as above general purpose algorithm.
-
-    wxASSERT( sizeof(int) == 4 );
-
-    if( aValue == 0 )
-        return std::string( 1, '0' );
-    else
-    {
-        char    buf[50];
-        int     len = sprintf( buf, aValue > 0 ? "%06d" : "%07d", aValue );     // optionally pad w/leading zeros
-
-        std::string ret( buf, len );
-
-        std::string::iterator it = ret.end() - 1;           // last byte
-
-        // insert '.' at 6 positions from end, dividing by 10e6 (a million), nm => mm
-        std::string::iterator decpoint = ret.end() - 6;
-
-        // truncate trailing zeros, up to decimal point position
-        for(  ; *it=='0' && it >= decpoint;  --it )
-            ret.erase( it );    // does not invalidate iterators it or decpoint
-
-        if( it >= decpoint )
-        {
-            ret.insert( decpoint, '.' );
-
-            // decpoint is invalidated here, after insert()
-
-#if 1       // want a leading zero when decimal point is in first position?
-            if( ret[0] == '.' )
-            {
-                // insert leading zero ahead of decimal point.
-                ret.insert( ret.begin(), '0' );
-            }
-            else if( ret[0]=='-' && ret[1]=='.' )
-            {
-                ret.insert( ret.begin() + 1, '0' );
-            }
-#endif
-        }
-
-        return ret;
-    }
-
 #endif
 }
 
@@ -170,8 +192,16 @@ std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 std::string BOARD_ITEM::FormatAngle( double aAngle )
 {
     char temp[50];
+    int  len;
+
+    // Most angles are an integer number of tenths of degree.  A negative zero is
+    // left to snprintf(), which writes its sign.
+    bool negativeZero = aAngle == 0.0 && 1.0 / aAngle < 0.0;
 
-    int len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
+    if( fabs( aAngle ) < 1e9 && aAngle == (int) aAngle && !negativeZero )
+        len = formatFixedPoint( (int) aAngle, 1, temp );
+    else
+        len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
 
     return std::string( temp, len );
 }
@@ -179,13 +209,25 @@ std::string BOARD_ITEM::FormatAngle( double aAngle )
 
 std::string BOARD_ITEM::FormatInternalUnits( const wxPoint& aPoint )
 {
-    return FormatInternalUnits( aPoint.x ) + " " + FormatInternalUnits( aPoint.y );
+    char    buf[32];
+    int     len = formatFixedPoint( aPoint.x, iuDecimals, buf );
+
+    buf[len++] = ' ';
+    len += formatFixedPoint( aPoint.y, iuDecimals, buf + len );
+
+    return std::string( buf, len );
 }
 
 
 std::string BOARD_ITEM::FormatInternalUnits( const wxSize& aSize )
 {
-    return FormatInternalUnits( aSize.GetWidth() ) + " " + FormatInternalUnits( aSize.GetHeight() );
+    char    buf[32];
+    int     len = formatFixedPoint( aSize.GetWidth(), iuDecimals, buf );
+
+    buf[len++] = ' ';
+    len += formatFixedPoint( aSize.GetHeight(), iuDecimals, buf + len );
+
+    return std::string( buf, len );
 }
 
 
@@ -452,6 +452,14 @@ private:
      */
     int getFreeNetCode();
 
+    /**
+     * Function copyNets
+     * replaces the nets of this list by copies of the nets of \a aOther, with the same net
+     * codes, for a copy of the BOARD of \a aOther.  The pad lists are copied too, through
+     * \a aPadCopies which gives the pad of the copy for each pad of the original BOARD.
+     */
+    void copyNets( const NETINFO_LIST& aOther, const std::map<const D_PAD*, D_PAD*>& aPadCopies );
+
     BOARD* m_Parent;
 
     NETNAMES_MAP m_netNames;                    ///< map for a fast look up by net names
@@ -97,6 +97,49 @@ void NETINFO_LIST::AppendNet( NETINFO_ITEM* aNewElement )
 }
 
 
+void NETINFO_LIST::copyNets( const NETINFO_LIST& aOther,
+                             const std::map<const D_PAD*, D_PAD*>& aPadCopies )
+{
+    const NETCLASSES& netClasses = m_Parent->GetDesignSettings().m_NetClasses;
+
+    clear();
+
+    for( NETCODES_MAP::const_iterator it = aOther.m_netCodes.begin(), itEnd = aOther.m_netCodes.end();
+            it != itEnd; ++it )
+    {
+        const NETINFO_ITEM* net = it->second;
+        NETINFO_ITEM* copy = new NETINFO_ITEM( m_Parent, net->GetNetname(), net->GetNet() );
+
+        copy->SetClass( netClasses.Find( net->GetClassName() ) );
+
+        // The node counts are used to filter the net classes when saving the board
+        for( unsigned ii = 0; ii < net->m_PadInNetList.size(); ii++ )
+        {
+            std::map<const D_PAD*, D_PAD*>::const_iterator pad =
+                    aPadCopies.find( net->m_PadInNetList[ii] );
+
+            if( pad != aPadCopies.end() )
+                copy->m_PadInNetList.push_back( pad->second );
+        }
+
+        // Keep the net codes: AppendNet() would renumber them if they have gaps
+        m_netNames.insert( std::make_pair( copy->GetNetname(), copy ) );
+        m_netCodes.insert( std::make_pair( copy->GetNet(), copy ) );
+    }
+
+    for( unsigned ii = 0; ii < aOther.m_PadsFullList.size(); ii++ )
+    {
+        std::map<const D_PAD*, D_PAD*>::const_iterator pad =
+                aPadCopies.find( aOther.m_PadsFullList[ii] );
+
+        if( pad != aPadCopies.end() )
+            m_PadsFullList.push_back( pad->second );
+    }
+
+    m_newNetCode = aOther.m_newNetCode;
+}
+
+
 /* sort function, to sort pad list by netnames
  * this is a case sensitive sort.
  * DO NOT change it because NETINFO_ITEM* BOARD::FindNet( const wxString& aNetname )
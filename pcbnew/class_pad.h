@@ -323,6 +323,14 @@ public:
      */
     void BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue, double aRotation ) const;
 
+    /**
+     * Function BuildPadPolygon
+     * Same as above, for a pad of size \a aPadSize instead of the pad size (for instance
+     * the pad size plus its solder mask margin).  The pad itself is not modified.
+     */
+    void BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue, double aRotation,
+                          const wxSize& aPadSize ) const;
+
     /**
      * Function BuildPadShapePolygon
      * Build the Corner list of the polygonal shape,
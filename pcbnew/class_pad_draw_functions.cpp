@@ -620,12 +620,19 @@ int D_PAD::BuildSegmentFromOvalShape(wxPoint& aSegStart, wxPoint& aSegEnd,
 
 void D_PAD::BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue,
                              double aRotation ) const
+{
+    BuildPadPolygon( aCoord, aInflateValue, aRotation, m_Size );
+}
+
+
+void D_PAD::BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue,
+                             double aRotation, const wxSize& aPadSize ) const
 {
     wxSize delta;
     wxSize halfsize;
 
-    halfsize.x = m_Size.x >> 1;
-    halfsize.y = m_Size.y >> 1;
+    halfsize.x = aPadSize.x >> 1;
+    halfsize.y = aPadSize.y >> 1;
 
     switch( GetShape() )
     {
@@ -689,7 +696,7 @@ void D_PAD::BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue,
         if( delta.y )    // lower and upper segment is horizontal
         {
             // Calculate angle of left (or right) segment with vertical axis
-            angle = atan2( m_DeltaSize.y, m_Size.y );
+            angle = atan2( m_DeltaSize.y, aPadSize.y );
 
             // left and right sides are moved by aInflateValue.x in their perpendicular direction
             // We must calculate the corresponding displacement on the horizontal axis
@@ -705,7 +712,7 @@ void D_PAD::BuildPadPolygon( wxPoint aCoord[4], wxSize aInflateValue,
         else if( delta.x )          // left and right segment is vertical
         {
             // Calculate angle of lower (or upper) segment with horizontal axis
-            angle = atan2( m_DeltaSize.x, m_Size.x );
+            angle = atan2( m_DeltaSize.x, aPadSize.x );
 
             // lower and upper sides are moved by aInflateValue.x in their perpendicular direction
             // We must calculate the corresponding displacement on the vertical axis
@@ -66,6 +66,7 @@ ZONE_CONTAINER::ZONE_CONTAINER( BOARD* aBoard ) :
     m_cornerRadius = 0;
     SetLocalFlags( 0 );                         // flags tempoarry used in zone calculations
     m_Poly     = new CPolyLine();               // Outlines
+    m_isFillDirty = false;
     aBoard->GetZoneSettings().ExportSetting( *this );
 }
 
@@ -93,6 +94,14 @@ ZONE_CONTAINER::ZONE_CONTAINER( const ZONE_CONTAINER& aZone ) :
     m_FilledPolysList.Append( aZone.m_FilledPolysList );
     m_FillSegmList = aZone.m_FillSegmList;      // vector <> copy
 
+    // The copy can be refilled incrementally (the undo copies are swapped with the zone),
+    // but the areas invalidated in aZone are not invalidated in the copy
+    m_solidAreaOutline = aZone.m_solidAreaOutline;
+    m_featureHoles = aZone.m_featureHoles;
+    m_featureHolesMap = aZone.m_featureHolesMap;
+    m_fillCacheKey = aZone.m_fillCacheKey;
+    m_isFillDirty = false;
+
     m_isKeepout = aZone.m_isKeepout;
     m_doNotAllowCopperPour = aZone.m_doNotAllowCopperPour;
     m_doNotAllowVias = aZone.m_doNotAllowVias;
@@ -127,10 +136,69 @@ bool ZONE_CONTAINER::UnFill()
     m_FillSegmList.clear();
     m_IsFilled = false;
 
+    m_solidAreaOutline.RemoveAllContours();
+    m_featureHoles.RemoveAllContours();
+    m_featureHolesMap.clear();
+    m_fillCacheKey.clear();
+    m_isFillDirty = false;
+
     return change;
 }
 
 
+void ZONE_CONTAINER::InvalidateFilledArea( const EDA_RECT& aArea )
+{
+    // The holes of the items are inflated by the zone clearance (or the thermal gap
+    // for pads) and by half the min thickness, and the copper around them is rebuilt
+    // with the min thickness
+    EDA_RECT area = aArea;
+    area.Inflate( std::max( m_ZoneClearance, m_ThermalReliefGap ) + m_ZoneMinThickness );
+
+    // Items outside the zone do not change its filled areas
+    if( !m_IsFilled || !area.Intersects( GetBoundingBox() ) )
+        return;
+
+    if( m_isFillDirty )
+    {
+        m_dirtyArea.Merge( area );
+    }
+    else
+    {
+        m_dirtyArea = area;
+        m_isFillDirty = true;
+    }
+}
+
+
+void ZONE_CONTAINER::buildFillCacheKey( std::vector<int>& aKey ) const
+{
+    aKey.clear();
+
+    aKey.push_back( GetLayer() );
+    aKey.push_back( GetNetCode() );
+    aKey.push_back( GetClearance() );
+    aKey.push_back( m_ZoneClearance );
+    aKey.push_back( m_ZoneMinThickness );
+    aKey.push_back( m_ArcToSegmentsCount );
+    aKey.push_back( m_PadConnection );
+    aKey.push_back( m_ThermalReliefGap );
+    aKey.push_back( m_ThermalReliefCopperBridge );
+    aKey.push_back( m_cornerSmoothingType );
+    aKey.push_back( m_cornerRadius );
+    aKey.push_back( m_priority );
+    aKey.push_back( m_FillMode );
+
+    const std::vector<CPolyPt>& corners = m_Poly->m_CornersList.GetList();
+
+    for( unsigned ii = 0; ii < corners.size(); ii++ )
+    {
+        aKey.push_back( corners[ii].x );
+        aKey.push_back( corners[ii].y );
+        aKey.push_back( corners[ii].end_contour );
+    }
+}
+
+
 const wxPoint& ZONE_CONTAINER::GetPosition() const
 {
     static const wxPoint dummy;
@@ -775,6 +843,14 @@ void ZONE_CONTAINER::Copy( ZONE_CONTAINER* src )
     m_FilledPolysList.Append( src->m_FilledPolysList );
     m_FillSegmList.clear();
     m_FillSegmList = src->m_FillSegmList;
+    m_IsFilled = src->m_IsFilled;
+
+    // Keep the data of the incremental refill matching the filled areas
+    m_solidAreaOutline = src->m_solidAreaOutline;
+    m_featureHoles = src->m_featureHoles;
+    m_featureHolesMap = src->m_featureHolesMap;
+    m_fillCacheKey = src->m_fillCacheKey;
+    m_isFillDirty = false;
 }
 
 
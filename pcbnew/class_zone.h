@@ -33,6 +33,7 @@
 
 
 #include <vector>
+#include <map>
 #include <gr_basic.h>
 #include <class_board_item.h>
 #include <class_board_connected_item.h>
@@ -48,6 +49,7 @@ class PCB_EDIT_FRAME;
 class BOARD;
 class ZONE_CONTAINER;
 class MSG_PANEL_ITEM;
+class SHAPE_FILE_IO;
 
 
 /**
@@ -285,6 +287,42 @@ public:
      */
     bool BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer = NULL );
 
+    /**
+     * Function BuildSmoothedPoly
+     * rebuilds the corner-smoothed version of m_Poly returned by GetSmoothedPoly(),
+     * according to the current corner smoothing settings.
+     */
+    void BuildSmoothedPoly();
+
+    /**
+     * Function InvalidateFilledArea
+     * tells the zone that board items were added, removed or modified inside aArea
+     * since the zone was filled, so the next RefillDirtyArea() call will rebuild the
+     * clearance holes of the items inside aArea.
+     * @param aArea is the area covered by the changed items, including their clearance
+     * (for a moved item, both its old and its new position must be invalidated).
+     * The zone adds its own clearance, thermal gap and min thickness.
+     */
+    void InvalidateFilledArea( const EDA_RECT& aArea );
+
+    /**
+     * Function IsFillDirty
+     * @return true if some areas were invalidated since the zone was filled.
+     */
+    bool IsFillDirty() const { return m_isFillDirty; }
+
+    /**
+     * Function RefillDirtyArea
+     * updates the filled areas after a call to InvalidateFilledArea(): only the clearance
+     * holes of the items touching the invalidated areas are rebuilt, the holes of the other
+     * items are taken from the last fill.  The holes are then subtracted from the whole
+     * zone, so the filled areas are the same as with a full fill.
+     * A full BuildFilledSolidAreasPolygons() is made if the zone outline or settings
+     * were modified since the last fill, or if the zone was never filled.
+     * @param aPcb is the board.
+     */
+    void RefillDirtyArea( BOARD* aPcb );
+
     /**
      * Function AddClearanceAreasPolygonsToPolysList
      * Add non copper areas polygons (pads and tracks with clearance)
@@ -547,7 +585,80 @@ public:
 
 
 private:
-    void buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeatures );
+    /**
+     * Function buildFeatureHoleList
+     * builds the clearance holes (pads, tracks, other zones, thermal reliefs...)
+     * to remove from the zone solid area.
+     * @param aPcb is the board.
+     * The holes of each item are kept in m_featureHoles, for the next refill.
+     * @param aPcb is the board.
+     * @param aFeatures is the buffer to store the holes.
+     * @param aDirtyArea, if not NULL, is the area where items changed since the last fill:
+     * the holes of the items outside it are copied from the last fill instead of being
+     * rebuilt.  The holes are the same, in the same order, as when aDirtyArea is NULL.
+     */
+    void buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeatures,
+                               const EDA_RECT* aDirtyArea = NULL );
+
+    /// The kinds of holes an item can create in the zone (a pad has a clearance hole
+    /// or a thermal relief)
+    enum FEATURE_HOLE_KIND
+    {
+        HOLE_CLEARANCE,
+        HOLE_THERMAL
+    };
+
+    /// The holes of an item in m_featureHoles
+    struct FEATURE_HOLES
+    {
+        EDA_RECT m_itemBox;     ///< bounding box of the item when its holes were built
+        int      m_first;       ///< index of the first outline of the holes
+        int      m_count;       ///< number of outlines
+    };
+
+    typedef std::map< std::pair<const BOARD_ITEM*, int>, FEATURE_HOLES > FEATURE_HOLES_MAP;
+
+    /**
+     * Function reuseFeatureHoles
+     * appends to aFeatures the holes of an item kept from the last fill, if the item is
+     * outside aDirtyArea and has the same bounding box as then, and records them in aMap.
+     * @param aKind is a FEATURE_HOLE_KIND.
+     * @return true if the holes were appended, false if they must be rebuilt.
+     */
+    bool reuseFeatureHoles( const BOARD_ITEM* aItem, int aKind, const EDA_RECT& aItemBox,
+                            const EDA_RECT* aDirtyArea, SHAPE_POLY_SET& aFeatures,
+                            FEATURE_HOLES_MAP& aMap ) const;
+
+    /**
+     * Function recordFeatureHoles
+     * records in aMap the holes of an item, the outlines of aFeatures from aFirst.
+     */
+    static void recordFeatureHoles( const BOARD_ITEM* aItem, int aKind,
+                                    const EDA_RECT& aItemBox, int aFirst,
+                                    const SHAPE_POLY_SET& aFeatures, FEATURE_HOLES_MAP& aMap );
+
+    /**
+     * Function buildFilledAreas
+     * builds m_FilledPolysList from the zone solid area minus the clearance holes:
+     * fractures the areas, removes insulated islands and unconnected thermal stubs.
+     */
+    void buildFilledAreas( BOARD* aPcb, SHAPE_POLY_SET& aSolidAreas,
+                           double aCorrectionFactor, SHAPE_FILE_IO& aDumper );
+
+    /**
+     * Function buildFillCacheKey
+     * stores in aKey all the zone parameters the filled areas depend on (outline
+     * and fill settings), to know if the data kept for RefillDirtyArea() are still valid.
+     */
+    void buildFillCacheKey( std::vector<int>& aKey ) const;
+
+    /**
+     * Function createSmoothedPoly
+     * @return a new corner-smoothed copy of m_Poly, owned by the caller.
+     * It smoothes a copy of m_Poly and does not modify the zone, so the outlines
+     * of a zone can be read while other zones are filled by other threads.
+     */
+    CPolyLine* createSmoothedPoly() const;
 
     CPolyLine*            m_Poly;                ///< Outline of the zone.
     CPolyLine*            m_smoothedPoly;        // Corner-smoothed version of m_Poly
@@ -616,6 +727,18 @@ private:
      * described by m_Poly can have many filled areas
      */
     SHAPE_POLY_SET m_FilledPolysList;
+
+    /* Data kept from the last fill, to rebuild only the holes of the changed items:
+     * the zone outline shrunk by half the min thickness, the clearance holes (before
+     * merging them) and the items which created them, the zone parameters used to build
+     * them, and the area invalidated since the fill.
+     */
+    SHAPE_POLY_SET        m_solidAreaOutline;
+    SHAPE_POLY_SET        m_featureHoles;
+    FEATURE_HOLES_MAP     m_featureHolesMap;
+    std::vector<int>      m_fillCacheKey;
+    EDA_RECT              m_dirtyArea;
+    bool                  m_isFillDirty;
 };
 
 
@@ -38,6 +38,10 @@
 // Helper classes to handle connection points
 #include <connect.h>
 
+#include <algorithm>
+#include <set>
+#include <map>
+
 extern void Merge_SubNets_Connected_By_CopperAreas( BOARD* aPcb );
 extern void Merge_SubNets_Connected_By_CopperAreas( BOARD* aPcb, int aNetcode );
 
@@ -489,80 +493,44 @@ void CONNECTIONS::Build_CurrNet_SubNets_Connections( TRACK* aFirstTrack, TRACK*
 }
 
 
-/**
- * Change a subnet value to a new value, in m_sortedPads pad list
- * After that, 2 cluster (or subnets) are merged into only one.
- * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
+/*
+ * Subnets are handled as a disjoint-set forest (union-find): items are labelled with the
+ * subnet they were attached to when they were first reached, and merging two subnets only
+ * links their trees, instead of renumbering every item of the net.
+ * The root of a tree is always its smallest subnet value, so that the final subnet of
+ * an item is the smallest of the merged subnets, as if items had been renumbered.
  */
-int CONNECTIONS::Merge_PadsSubNets( int aOldSubNet, int aNewSubNet )
+int CONNECTIONS::newSubNet()
 {
-    int    change_count = 0;
+    int subnet = m_subNetParent.size();
+    m_subNetParent.push_back( subnet );
 
-    if( aOldSubNet == aNewSubNet )
-        return 0;
+    return subnet;
+}
 
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        std::swap( aOldSubNet, aNewSubNet );
 
-    // Examine connections between intersecting pads
-    for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
+int CONNECTIONS::findSubNet( int aSubNet )
+{
+    // Path halving: every visited subnet is linked to its grandparent
+    while( m_subNetParent[aSubNet] != aSubNet )
     {
-        D_PAD * curr_pad = m_sortedPads[ii];
-        if( curr_pad->GetSubNet() != aOldSubNet )
-            continue;
-
-        change_count++;
-        curr_pad->SetSubNet( aNewSubNet );
+        m_subNetParent[aSubNet] = m_subNetParent[m_subNetParent[aSubNet]];
+        aSubNet = m_subNetParent[aSubNet];
     }
 
-    return change_count;
+    return aSubNet;
 }
 
-/*
- * Change a subnet value to a new value, for tracks and pads which are connected to.
- * The result is merging 2 clusters (or subnets) into only one cluster.
- * Note: the resulting sub net value is the smallest between aOldSubNet et aNewSubNet
- */
-int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
-{
-    TRACK* curr_track;
-    int    change_count = 0;
-
-    if( aOldSubNet == aNewSubNet )
-        return 0;
-
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        std::swap( aOldSubNet, aNewSubNet );
-
-    curr_track = (TRACK*)m_firstTrack;
-
-    for( ; curr_track != NULL; curr_track = curr_track->Next() )
-    {
-        if( curr_track->GetSubNet() != aOldSubNet )
-        {
-            if( curr_track == m_lastTrack )
-                break;
-
-            continue;
-        }
 
-        change_count++;
-        curr_track->SetSubNet( aNewSubNet );
-
-        for( unsigned ii = 0; ii < curr_track->m_PadsConnected.size(); ii++ )
-        {
-            D_PAD * pad = curr_track->m_PadsConnected[ii];
-            if( pad->GetSubNet() == aOldSubNet )
-            {
-                pad->SetSubNet( curr_track->GetSubNet() );
-            }
-        }
-
-        if( curr_track == m_lastTrack )
-            break;
-    }
+void CONNECTIONS::mergeSubNets( int aSubNet1, int aSubNet2 )
+{
+    int root1 = findSubNet( aSubNet1 );
+    int root2 = findSubNet( aSubNet2 );
 
-    return change_count;
+    if( root1 < root2 )
+        m_subNetParent[root2] = root1;
+    else if( root2 < root1 )
+        m_subNetParent[root1] = root2;
 }
 
 
@@ -580,11 +548,15 @@ int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
  */
 void CONNECTIONS::Propagate_SubNets()
 {
-    int sub_netcode = 1;
+    // Subnet 0 stands for "not attached to a cluster"
+    m_subNetParent.clear();
+    m_subNetParent.push_back( 0 );
 
     TRACK* curr_track = (TRACK*)m_firstTrack;
+    int first_subnet = newSubNet();
+
     if( curr_track )
-        curr_track->SetSubNet( sub_netcode );
+        curr_track->SetSubNet( first_subnet );
 
     // Examine connections between tracks and pads
     for( ; curr_track != NULL; curr_track = curr_track->Next() )
@@ -599,7 +571,7 @@ void CONNECTIONS::Propagate_SubNets()
                 if( pad->GetSubNet() > 0 )
                 {
                     // The pad is already a cluster member, so we can merge the 2 clusters
-                    Merge_SubNets( pad->GetSubNet(), curr_track->GetSubNet() );
+                    mergeSubNets( pad->GetSubNet(), curr_track->GetSubNet() );
                 }
                 else
                 {
@@ -619,8 +591,7 @@ void CONNECTIONS::Propagate_SubNets()
                 {
                     /* it is connected to a pad not in a cluster, so we must create a new
                      * cluster (only with the 2 items: the track and the pad) */
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
+                    curr_track->SetSubNet( newSubNet() );
                     pad->SetSubNet( curr_track->GetSubNet() );
                 }
             }
@@ -636,7 +607,7 @@ void CONNECTIONS::Propagate_SubNets()
                 // The other track is already a cluster member, so we can merge the 2 clusters
                 if( track->GetSubNet() )
                 {
-                    Merge_SubNets( track->GetSubNet(), curr_track->GetSubNet() );
+                    mergeSubNets( track->GetSubNet(), curr_track->GetSubNet() );
                 }
                 else
                 {
@@ -657,8 +628,7 @@ void CONNECTIONS::Propagate_SubNets()
                 {
                     // it is connected to an other segment not in a cluster, so we must
                     // create a new cluster (only with the 2 track segments)
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
+                    curr_track->SetSubNet( newSubNet() );
                     track->SetSubNet( curr_track->GetSubNet() );
                 }
             }
@@ -683,15 +653,7 @@ void CONNECTIONS::Propagate_SubNets()
                 if( pad->GetSubNet() > 0 )
                 {
                     // The pad is already a cluster member, so we can merge the 2 clusters
-                    // Store the initial subnets, which will be modified by Merge_PadsSubNets
-                    int subnet1 = pad->GetSubNet();
-                    int subnet2 = curr_pad->GetSubNet();
-
-                    // merge subnets of pads only, even those not connected by tracks
-                    Merge_PadsSubNets( subnet1, subnet2 );
-
-                    // merge subnets of tracks (and pads, which are already merged)
-                    Merge_SubNets( subnet1, subnet2 );
+                    mergeSubNets( pad->GetSubNet(), curr_pad->GetSubNet() );
                 }
                 else
                 {
@@ -712,13 +674,24 @@ void CONNECTIONS::Propagate_SubNets()
                 {
                     // the connected pad is not in a cluster,
                     // so we must create a new cluster, with the 2 pads.
-                    sub_netcode++;
-                    curr_pad->SetSubNet( sub_netcode );
+                    curr_pad->SetSubNet( newSubNet() );
                     pad->SetSubNet( curr_pad->GetSubNet() );
                 }
             }
         }
     }
+
+    // Replace the subnet each item was attached to by the final subnet of its cluster
+    for( curr_track = (TRACK*)m_firstTrack; curr_track != NULL; curr_track = curr_track->Next() )
+    {
+        curr_track->SetSubNet( findSubNet( curr_track->GetSubNet() ) );
+
+        if( curr_track == m_lastTrack )
+            break;
+    }
+
+    for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
+        m_sortedPads[ii]->SetSubNet( findSubNet( m_sortedPads[ii]->GetSubNet() ) );
 }
 
 /*
@@ -728,27 +701,33 @@ void CONNECTIONS::Propagate_SubNets()
  * to update active/inactive ratsnest items status
  */
 void PCB_BASE_FRAME::TestConnections()
+{
+    ::TestConnections( m_Pcb );
+}
+
+
+void TestConnections( BOARD* aPcb )
 {
     // Clear the cluster identifier for all pads
-    for( unsigned i = 0;  i< m_Pcb->GetPadCount();  ++i )
+    for( unsigned i = 0;  i< aPcb->GetPadCount();  ++i )
     {
-        D_PAD* pad = m_Pcb->GetPad(i);
+        D_PAD* pad = aPcb->GetPad(i);
 
         pad->SetZoneSubNet( 0 );
         pad->SetSubNet( 0 );
     }
 
-    m_Pcb->Test_Connections_To_Copper_Areas();
+    aPcb->Test_Connections_To_Copper_Areas();
 
     // Test existing connections net by net
     // note some nets can have no tracks, and pads intersecting
     // so Build_CurrNet_SubNets_Connections must be called for each net
-    CONNECTIONS connections( m_Pcb );
+    CONNECTIONS connections( aPcb );
 
     int last_net_tested = 0;
     int current_net_code = 0;
 
-    for( TRACK* track = m_Pcb->m_Track; track; )
+    for( TRACK* track = aPcb->m_Track; track; )
     {
         // At this point, track is the first track of a given net
         current_net_code = track->GetNetCode();
@@ -770,13 +749,11 @@ void PCB_BASE_FRAME::TestConnections()
     }
 
     // Test last nets without tracks, if any
-    int netsCount = m_Pcb->GetNetCount();
+    int netsCount = aPcb->GetNetCount();
     for( int net = last_net_tested+1; net < netsCount; net++ )
         connections.Build_CurrNet_SubNets_Connections( NULL, NULL, net );
 
-    Merge_SubNets_Connected_By_CopperAreas( m_Pcb );
-
-    return;
+    Merge_SubNets_Connected_By_CopperAreas( aPcb );
 }
 
 
@@ -851,17 +828,55 @@ void PCB_BASE_FRAME::TestNetConnection( wxDC* aDC, int aNetCode )
 }
 
 
+/**
+ * Helper function scheduleNetcodeChange
+ * used by RecalculateAllTracksNetcode() when the net code of a track is changed,
+ * to examine again this track and the tracks connected to it: in the current pass
+ * if they are after the track being examined in list, in the next pass otherwise.
+ * @param aChanged = index of the track which has its net code changed
+ * @param aCurrent = index of the track being examined
+ * @param aDependents = for each track, the tracks having it in their connected tracks list
+ * @param aPass = tracks to examine in the current pass
+ * @param aNextPass = tracks to examine in the next pass
+ */
+static void scheduleNetcodeChange( int aChanged, int aCurrent,
+                                   const std::vector< std::vector<int> >& aDependents,
+                                   std::set<int>& aPass, std::set<int>& aNextPass )
+{
+    if( aChanged > aCurrent )
+        aPass.insert( aChanged );
+    else
+        aNextPass.insert( aChanged );
+
+    for( unsigned ii = 0; ii < aDependents[aChanged].size(); ii++ )
+    {
+        int index = aDependents[aChanged][ii];
+
+        if( index > aCurrent )
+            aPass.insert( index );
+        else
+            aNextPass.insert( index );
+    }
+}
+
+
 /* search connections between tracks and pads and propagate pad net codes to the track
  * segments.
  * Pads netcodes are assumed to be up to date.
  */
 void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
+{
+    ::RecalculateAllTracksNetcode( m_Pcb );
+}
+
+
+void RecalculateAllTracksNetcode( BOARD* aPcb )
 {
     // Build the net info list
-    GetBoard()->BuildListOfNets();
+    aPcb->BuildListOfNets();
 
     // Reset variables and flags used in computation
-    for( TRACK* t = m_Pcb->m_Track;  t;  t = t->Next() )
+    for( TRACK* t = aPcb->m_Track;  t;  t = t->Next() )
     {
         t->m_TracksConnected.clear();
         t->m_PadsConnected.clear();
@@ -873,41 +888,71 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
     }
 
     // If no pad, reset pointers and netcode, and do nothing else
-    if( m_Pcb->GetPadCount() == 0 )
+    if( aPcb->GetPadCount() == 0 )
         return;
 
-    CONNECTIONS connections( m_Pcb );
+    CONNECTIONS connections( aPcb );
     connections.BuildPadsList();
-    connections.BuildTracksCandidatesList(m_Pcb->m_Track);
+    connections.BuildTracksCandidatesList(aPcb->m_Track);
 
     // First pass: build connections between track segments and pads.
     connections.SearchTracksConnectedToPads();
 
     // For tracks connected to at least one pad,
     // set the track net code to the pad netcode
-    for( TRACK* t = m_Pcb->m_Track;  t;  t = t->Next() )
+    for( TRACK* t = aPcb->m_Track;  t;  t = t->Next() )
     {
         if( t->m_PadsConnected.size() )
             t->SetNetCode( t->m_PadsConnected[0]->GetNetCode() );
     }
 
     // Pass 2: build connections between track ends
-    for( TRACK* t = m_Pcb->m_Track;  t;  t = t->Next() )
+    for( TRACK* t = aPcb->m_Track;  t;  t = t->Next() )
     {
         connections.SearchConnectedTracks( t );
         connections.GetConnectedTracks( t );
     }
 
-    // Propagate net codes from a segment to other connected segments
-    bool new_pass_request = true;   // set to true if a track has its netcode changed from 0
-                                    // to a known netcode to re-evaluate netcodes
-                                    // of connected items
-    while( new_pass_request )
+    // Propagate net codes from a segment to other connected segments.
+    // Net codes are propagated by passes on the track list, until no net code is changed.
+    // A track can change only when its net code or the net code of one of its connected
+    // tracks was changed since it was last examined, so only these tracks are examined
+    // again: the result is the same as examining the whole list at each pass.
+    // Tracks are indexed by their position in list
+    std::vector<TRACK*> trackList;
+    std::map<const TRACK*, int> trackIndex;
+
+    for( TRACK* t = aPcb->m_Track;  t;  t = t->Next() )
     {
-        new_pass_request = false;
+        trackIndex[t] = trackList.size();
+        trackList.push_back( t );
+    }
+
+    // For each track, the list of tracks having it in their m_TracksConnected list
+    std::vector< std::vector<int> > dependents( trackList.size() );
+
+    for( unsigned ii = 0; ii < trackList.size(); ii++ )
+    {
+        TRACK* t = trackList[ii];
+
+        for( unsigned kk = 0; kk < t->m_TracksConnected.size(); kk++ )
+            dependents[ trackIndex[ t->m_TracksConnected[kk] ] ].push_back( ii );
+    }
 
-        for( TRACK* t = m_Pcb->m_Track;  t;  t = t->Next() )
+    std::set<int> pass;         // tracks to examine in the current pass
+    std::set<int> next_pass;    // tracks to examine in the next pass
+
+    for( unsigned ii = 0; ii < trackList.size(); ii++ )
+        pass.insert( pass.end(), ii );
+
+    while( !pass.empty() )
+    {
+        while( !pass.empty() )
         {
+            int index = *pass.begin();
+            pass.erase( pass.begin() );
+
+            TRACK* t = trackList[index];
             int netcode = t->GetNetCode();
 
             if( netcode == 0 )
@@ -918,9 +963,9 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
                     int altnetcode = t->m_TracksConnected[kk]->GetNetCode();
                     if( altnetcode )
                     {
-                        new_pass_request = true;
                         netcode = altnetcode;
                         t->SetNetCode(netcode);
+                        scheduleNetcodeChange( index, index, dependents, pass, next_pass );
                         break;
                     }
                 }
@@ -931,19 +976,23 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
                 // propagate this netcode to connected tracks having no netcode
                 for( unsigned kk = 0; kk < t->m_TracksConnected.size(); kk++ )
                 {
-                    int altnetcode = t->m_TracksConnected[kk]->GetNetCode();
-                    if( altnetcode == 0 )
+                    TRACK* other = t->m_TracksConnected[kk];
+
+                    if( other->GetNetCode() == 0 )
                     {
-                        t->m_TracksConnected[kk]->SetNetCode(netcode);
-                        new_pass_request = true;
+                        other->SetNetCode(netcode);
+                        scheduleNetcodeChange( trackIndex[other], index, dependents,
+                                               pass, next_pass );
                     }
                 }
             }
         }
+
+        pass.swap( next_pass );
     }
 
     // Sort the track list by net codes:
-    RebuildTrackChain( m_Pcb );
+    RebuildTrackChain( aPcb );
 }
 
 
@@ -954,10 +1003,6 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
  */
 static bool SortTracksByNetCode( const TRACK* const & ref, const TRACK* const & compare )
 {
-    // For items having the same Net, keep the order in list
-    if( ref->GetNetCode() == compare->GetNetCode())
-        return ref->m_Param < compare->m_Param;
-
     return ref->GetNetCode() < compare->GetNetCode();
 }
 
@@ -979,23 +1024,14 @@ static void RebuildTrackChain( BOARD* pcb )
     trackList.reserve( item_count );
 
     // Put track list in a temporary list to sort tracks by netcode
-    // We try to keep the initial order of track segments in list, when possible
-    // so we use m_Param (a member variable used for temporary storage)
-    // to temporary keep trace of the order of segments
-    // The sort function uses this variable to sort items that
-    // have the same net code.
-    // Without this, during sorting, the initial order is sometimes lost
-    // by the sort algorithm
     for( int ii = 0; ii < item_count; ++ii )
-    {
-        pcb->m_Track->m_Param = ii;
         trackList.push_back( pcb->m_Track.PopFront() );
-    }
 
     // the list is empty now
     wxASSERT( pcb->m_Track == NULL && pcb->m_Track.GetCount()==0 );
 
-    sort( trackList.begin(), trackList.end(), SortTracksByNetCode );
+    // A stable sort keeps the initial order of track segments having the same net code
+    std::stable_sort( trackList.begin(), trackList.end(), SortTracksByNetCode );
 
     // add them back to the list
     for( int i = 0; i < item_count;  ++i )
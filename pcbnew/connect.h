@@ -99,6 +99,8 @@ private:
     const TRACK * m_firstTrack;                 // The first track used to build m_Candidates
     const TRACK * m_lastTrack;                  // The last track used to build m_Candidates
     std::vector<D_PAD*> m_sortedPads;           // list of sorted pads by X (then Y) coordinate
+    std::vector<int> m_subNetParent;            // Subnets forest used by Propagate_SubNets:
+                                                // the parent subnet of each subnet
 
 public:
     CONNECTIONS( BOARD * aBrd );
@@ -236,28 +238,44 @@ private:
     int searchEntryPointInCandidatesList( const wxPoint & aPoint);
 
     /**
-     * Function Merge_SubNets
-     * Change a subnet old value to a new value, for tracks and pads which are connected to
-     * tracks from m_firstTrack to m_lastTrack and their connected pads.
-     * and modify the subnet parameter (change the old value to the new value).
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting sub net value is the smallest between aOldSubNet and aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
+     * Function newSubNet
+     * Creates a new subnet (a cluster containing no item yet)
+     * @return the new subnet value
      */
-    int Merge_SubNets( int aOldSubNet, int aNewSubNet );
+    int newSubNet();
 
     /**
-     * Function Merge_PadsSubNets
-     * Change a subnet value to a new value, in m_sortedPads pad list
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
+     * Function findSubNet
+     * @return the subnet value of the cluster aSubNet has been merged into,
+     * i.e. the smallest subnet value of the merged clusters
+     * @param aSubNet = the subnet value given to an item when it was added to a cluster
      */
-    int Merge_PadsSubNets( int aOldSubNet, int aNewSubNet );
+    int findSubNet( int aSubNet );
+
+    /**
+     * Function mergeSubNets
+     * Merges 2 clusters (or subnets) into only one.
+     * Items keep their subnet value until the end of Propagate_SubNets, which sets
+     * the final subnet value (given by findSubNet) of each item.
+     * @param aSubNet1 = subnet value of an item of the first cluster
+     * @param aSubNet2 = subnet value of an item of the second cluster
+     */
+    void mergeSubNets( int aSubNet1, int aSubNet2 );
 };
 
+
+/**
+ * Function TestConnections
+ * tests the connections of all the nets of \a aPcb, and updates the subnets of the pads
+ * and tracks (see PCB_BASE_FRAME::TestConnections()).
+ */
+void TestConnections( BOARD* aPcb );
+
+/**
+ * Function RecalculateAllTracksNetcode
+ * propagates the pad net codes of \a aPcb to the track segments connected to them, and
+ * sorts the track list by net codes (see PCB_BASE_FRAME::RecalculateAllTracksNetcode()).
+ */
+void RecalculateAllTracksNetcode( BOARD* aPcb );
+
 #endif      //  ifndef CONNECT_H
@@ -820,6 +820,12 @@ void DIALOG_PLOT::Plot( wxCommandEvent& event )
 
     wxBusyCursor dummy;
 
+    // The files are opened here, and the layers are plotted at the same time
+    BOARD*                  board = m_parent->GetBoard();
+    BOARD_PLOT_BATCH        batch( board );
+    std::vector<wxString>   plotFiles;
+    wxString                msg;
+
     for( LSEQ seq = m_plotOpts.GetLayerSelection().UIOrder();  seq;  ++seq )
     {
         LAYER_ID layer = *seq;
@@ -838,26 +844,30 @@ void DIALOG_PLOT::Plot( wxCommandEvent& event )
                            m_board->GetLayerName( layer ),
                            file_ext );
 
-        LOCALE_IO toggle;
-
-        BOARD*      board = m_parent->GetBoard();
-        PLOTTER*    plotter = StartPlotBoard( board, &m_plotOpts, layer, fn.GetFullPath(), wxEmptyString );
+        if( batch.AddLayer( layer, m_plotOpts, fn.GetFullPath(), wxEmptyString ) >= 0 )
+        {
+            plotFiles.push_back( fn.GetFullPath() );
+        }
+        else
+        {
+            msg.Printf( _( "Unable to create file '%s'." ), GetChars( fn.GetFullPath() ) );
+            reporter.Report( msg, REPORTER::RPT_ERROR );
+        }
+    }
 
-        // Print diags in messages box:
-        wxString msg;
+    batch.Run();
 
-        if( plotter )
+    // Print diags in messages box:
+    for( int ii = 0;  ii < batch.GetCount();  ++ii )
+    {
+        if( batch.Succeeded( ii ) )
         {
-            PlotOneBoardLayer( board, plotter, layer, m_plotOpts );
-            plotter->EndPlot();
-            delete plotter;
-
-            msg.Printf( _( "Plot file '%s' created." ), GetChars( fn.GetFullPath() ) );
+            msg.Printf( _( "Plot file '%s' created." ), GetChars( plotFiles[ii] ) );
             reporter.Report( msg, REPORTER::RPT_ACTION );
         }
         else
         {
-            msg.Printf( _( "Unable to create file '%s'." ), GetChars( fn.GetFullPath() ) );
+            msg.Printf( _( "Unable to write file '%s'." ), GetChars( plotFiles[ii] ) );
             reporter.Report( msg, REPORTER::RPT_ERROR );
         }
     }
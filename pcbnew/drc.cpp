@@ -42,6 +42,7 @@
 #include <class_draw_panel_gal.h>
 #include <view/view.h>
 #include <geometry/seg.h>
+#include <geometry/rtree.h>
 
 #include <tool/tool_manager.h>
 #include <tools/common_actions.h>
@@ -51,6 +52,190 @@
 
 #include <dialog_drc.h>
 #include <wx/progdlg.h>
+#include <ratsnest_data.h>
+#include <profile.h>
+
+#include <algorithm>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+
+/**
+ * Class DRC_CANDIDATE_INDEX
+ * is a spatial index of the board pads and tracks, used to find the items which can
+ * violate the clearance of a given track segment, via or pad, instead of testing it
+ * against every item of the board.
+ * Items are stored by their index in the pad and track lists given to Build(), so the
+ * candidates can be returned in list order, and tested in the same order as a linear
+ * scan of these lists would do.
+ * Each item is stored with its bounding box inflated by its own clearance: two items
+ * closer than the biggest of their clearances always have overlapping boxes.
+ */
+class DRC_CANDIDATE_INDEX
+{
+public:
+    DRC_CANDIDATE_INDEX()
+    {
+    }
+
+    /**
+     * Function Build
+     * fills the index.
+     * @param aPads is the list of pads, in test order.
+     * @param aTracks is the list of tracks and vias, in test order.
+     */
+    void Build( const std::vector<D_PAD*>& aPads, const std::vector<TRACK*>& aTracks )
+    {
+        for( unsigned ii = 0; ii < aPads.size(); ++ii )
+            insert( m_pads, padBBox( aPads[ii] ), ii );
+
+        for( unsigned ii = 0; ii < aTracks.size(); ++ii )
+        {
+            const TRACK* track = aTracks[ii];
+            EDA_RECT bbox = trackBBox( track );
+            LSEQ layers = track->GetLayerSet().CuStack();
+
+            for( ; layers; ++layers )
+                insert( m_tracks[*layers], bbox, ii );
+        }
+    }
+
+    /**
+     * Function QueryPads
+     * @return the indexes of the pads which can collide with aTrack, in ascending order.
+     */
+    void QueryPads( const TRACK* aTrack, std::vector<int>& aResult )
+    {
+        aResult.clear();
+
+        COLLECTOR collector( aResult, -1 );
+        query( m_pads, trackBBox( aTrack ), collector );
+
+        std::sort( aResult.begin(), aResult.end() );
+    }
+
+    /**
+     * Function QueryPads
+     * @return the indexes greater than aAfter of the pads which can collide with aPad
+     * (or with its hole), in ascending order.
+     */
+    void QueryPads( const D_PAD* aPad, int aAfter, std::vector<int>& aResult )
+    {
+        aResult.clear();
+
+        COLLECTOR collector( aResult, aAfter );
+        query( m_pads, padBBox( aPad ), collector );
+
+        std::sort( aResult.begin(), aResult.end() );
+    }
+
+    /**
+     * Function QueryTracks
+     * @return the indexes greater than aAfter of the tracks which can collide with aTrack,
+     * in ascending order.
+     */
+    void QueryTracks( const TRACK* aTrack, int aAfter, std::vector<int>& aResult )
+    {
+        aResult.clear();
+
+        COLLECTOR   collector( aResult, aAfter );
+        EDA_RECT    bbox = trackBBox( aTrack );
+        LSEQ        layers = aTrack->GetLayerSet().CuStack();
+
+        for( ; layers; ++layers )
+            query( m_tracks[*layers], bbox, collector );
+
+        // Vias are stored on each of their layers
+        std::sort( aResult.begin(), aResult.end() );
+        aResult.erase( std::unique( aResult.begin(), aResult.end() ), aResult.end() );
+    }
+
+private:
+    typedef RTree<int, int, 2, float> INDEX_TREE;
+
+    /// Margin added to the boxes, to absorb rounding errors of the clearance tests
+    static const int SLACK = 10;
+
+    struct COLLECTOR
+    {
+        COLLECTOR( std::vector<int>& aResult, int aAfter ) :
+            m_result( aResult ), m_after( aAfter )
+        {
+        }
+
+        bool operator()( int aIndex )
+        {
+            if( aIndex > m_after )
+                m_result.push_back( aIndex );
+
+            return true;
+        }
+
+        std::vector<int>&   m_result;
+        int                 m_after;
+    };
+
+    static EDA_RECT padBBox( const D_PAD* aPad )
+    {
+        // The pad shape, and its hole, which is tested even if the pad is not on
+        // the layer of the other item
+        EDA_RECT bbox( aPad->ShapePos(), wxSize( 0, 0 ) );
+        bbox.Inflate( aPad->GetBoundingRadius() + aPad->GetClearance() );
+
+        if( aPad->GetDrillSize().x )
+        {
+            EDA_RECT hole( aPad->GetPosition(), wxSize( 0, 0 ) );
+            hole.Inflate( std::max( aPad->GetDrillSize().x, aPad->GetDrillSize().y ) / 2 );
+            bbox.Merge( hole );
+        }
+
+        return bbox;
+    }
+
+    static EDA_RECT trackBBox( const TRACK* aTrack )
+    {
+        EDA_RECT bbox( aTrack->GetStart(), wxSize( 0, 0 ) );
+        bbox.SetEnd( aTrack->GetEnd() );
+        bbox.Normalize();
+        bbox.Inflate( aTrack->GetWidth() / 2 + aTrack->GetClearance() );
+
+        return bbox;
+    }
+
+    static void insert( INDEX_TREE& aTree, const EDA_RECT& aBBox, int aIndex )
+    {
+        const int mmin[2] = { aBBox.GetX() - SLACK, aBBox.GetY() - SLACK };
+        const int mmax[2] = { aBBox.GetRight() + SLACK, aBBox.GetBottom() + SLACK };
+
+        aTree.Insert( mmin, mmax, aIndex );
+    }
+
+    static void query( INDEX_TREE& aTree, const EDA_RECT& aBBox, COLLECTOR& aCollector )
+    {
+        const int mmin[2] = { aBBox.GetX() - SLACK, aBBox.GetY() - SLACK };
+        const int mmax[2] = { aBBox.GetRight() + SLACK, aBBox.GetBottom() + SLACK };
+
+        aTree.Search( mmin, mmax, aCollector );
+    }
+
+    INDEX_TREE m_pads;
+    INDEX_TREE m_tracks[LAYER_ID_COUNT];
+};
+
+
+/// The names of the test families, as reported by DRC::RunTestsHeadless()
+static const wxChar* const testFamilyNames[] =
+{
+    wxT( "netclasses" ),
+    wxT( "pad2pad" ),
+    wxT( "tracks" ),
+    wxT( "zones" ),
+    wxT( "unconnected" ),
+    wxT( "keepouts" ),
+    wxT( "texts" )
+};
 
 
 void DRC::ShowDialog()
@@ -92,6 +277,22 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_pcb = aPcbWindow->GetBoard();
     m_drcDialog  = NULL;
 
+    init();
+}
+
+
+DRC::DRC( BOARD* aBoard )
+{
+    m_mainWindow = NULL;
+    m_pcb = aBoard;
+    m_drcDialog  = NULL;
+
+    init();
+}
+
+
+void DRC::init()
+{
     // establish initial values for everything:
     m_doPad2PadTest     = true;     // enable pad to pad clearance tests
     m_doUnconnectedTest = true;     // enable unconnected tests
@@ -113,6 +314,10 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_ycliplo = 0;
     m_xcliphi = 0;
     m_ycliphi = 0;
+
+    m_collectMarkers = false;
+    m_deferTexts = false;
+    m_scanTracks = false;
 }
 
 
@@ -121,6 +326,9 @@ DRC::~DRC()
     // maybe someday look at pointainer.h  <- google for "pointainer.h"
     for( unsigned i = 0; i<m_unconnected.size();  ++i )
         delete m_unconnected[i];
+
+    for( unsigned i = 0; i < m_markers.size(); ++i )
+        delete m_markers[i];
 }
 
 
@@ -284,6 +492,166 @@ void DRC::RunTests( wxTextCtrl* aMessages )
 }
 
 
+void DRC::RunTestsHeadless( std::vector<DRC_TEST_RESULT>& aResults )
+{
+    prof_counter timer;
+
+    aResults.clear();
+
+    // Before testing, refill all zones and compute the ratsnest, as RunTests() does
+    aResults.push_back( DRC_TEST_RESULT( wxT( "fill_zones" ) ) );
+    prof_start( &timer );
+
+    m_pcb->FillAllZones();
+
+    prof_end( &timer );
+    aResults.back().m_msecs = timer.msecs();
+
+    aResults.push_back( DRC_TEST_RESULT( wxT( "ratsnest" ) ) );
+    prof_start( &timer );
+
+    m_pcb->GetRatsnest()->ProcessBoard();
+    m_pcb->GetRatsnest()->Recalculate();
+
+    prof_end( &timer );
+    aResults.back().m_msecs = timer.msecs();
+
+    // If the netclasses do not pass the BOARD_DESIGN_SETTINGS checks, every member
+    // of a net class would also fail: quit after reporting the netclass errors
+    std::vector<TEST_FAMILY> families( 1, TEST_NETCLASSES );
+
+    if( !runTestFamilies( families, aResults ) )
+        return;
+
+    families.clear();
+
+    if( m_doPad2PadTest )
+        families.push_back( TEST_PAD2PAD );
+
+    families.push_back( TEST_TRACKS );
+    families.push_back( TEST_ZONES );
+
+    if( m_doUnconnectedTest )
+        families.push_back( TEST_UNCONNECTED );
+
+    if( m_doKeepoutTest )
+        families.push_back( TEST_KEEPOUTS );
+
+    families.push_back( TEST_TEXTS );
+
+    runTestFamilies( families, aResults );
+}
+
+
+bool DRC::runTestFamilies( const std::vector<TEST_FAMILY>& aFamilies,
+                           std::vector<DRC_TEST_RESULT>& aResults )
+{
+    int familyCount = aFamilies.size();
+    std::vector<DRC*> workers( familyCount );
+    std::vector<double> msecs( familyCount );
+    std::vector<int> passed( familyCount );
+    int i;
+
+    // Tests store intermediate results in the DRC object: each family uses its own one,
+    // which collects its markers instead of adding them to the board.
+    // A single family (the netclass tests) runs on this thread, several ones run on
+    // worker threads, which only record the items to describe in their markers.
+#ifdef USE_OPENMP
+    bool concurrent = familyCount > 1 && omp_get_max_threads() > 1;
+#else
+    bool concurrent = false;
+#endif /* USE_OPENMP */
+
+    for( i = 0; i < familyCount; ++i )
+    {
+        workers[i] = new DRC( m_pcb );
+        workers[i]->m_collectMarkers = true;
+        workers[i]->m_deferTexts = concurrent;
+        workers[i]->m_scanTracks = m_scanTracks;
+    }
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) private(i) if(concurrent)
+#endif /* USE_OPENMP */
+    for( i = 0; i < familyCount; ++i )
+    {
+        prof_counter timer;
+
+        prof_start( &timer );
+        passed[i] = workers[i]->runTestFamily( aFamilies[i] );
+        prof_end( &timer );
+
+        msecs[i] = timer.msecs();
+    }
+
+    // Marker texts are built and markers are added to the board by the main thread,
+    // in family order
+    bool ok = true;
+
+    for( i = 0; i < familyCount; ++i )
+    {
+        DRC* worker = workers[i];
+        DRC_TEST_RESULT result( testFamilyNames[aFamilies[i]] );
+
+        worker->buildDeferredTexts();
+        worker->m_deferTexts = false;
+
+        // The zone outline test of testZones() creates its markers with their texts
+        if( aFamilies[i] == TEST_ZONES && concurrent )
+        {
+            prof_counter timer;
+
+            prof_start( &timer );
+            m_pcb->Test_Drc_Areas_Outlines_To_Areas_Outlines( NULL, true, &worker->m_markers );
+            prof_end( &timer );
+
+            msecs[i] += timer.msecs();
+        }
+
+        result.m_msecs = msecs[i];
+
+        for( unsigned jj = 0; jj < worker->m_markers.size(); ++jj )
+        {
+            result.m_items.push_back( worker->m_markers[jj]->GetReporter() );
+            addMarkerToPcb( worker->m_markers[jj] );
+        }
+
+        for( unsigned jj = 0; jj < worker->m_unconnected.size(); ++jj )
+        {
+            result.m_items.push_back( *worker->m_unconnected[jj] );
+            m_unconnected.push_back( worker->m_unconnected[jj] );
+        }
+
+        // The markers and the unconnected items now belong to the board and to this DRC
+        worker->m_markers.clear();
+        worker->m_unconnected.clear();
+        delete worker;
+
+        aResults.push_back( result );
+        ok = ok && passed[i];
+    }
+
+    return ok;
+}
+
+
+bool DRC::runTestFamily( TEST_FAMILY aFamily )
+{
+    switch( aFamily )
+    {
+    case TEST_NETCLASSES:   return testNetClasses();
+    case TEST_PAD2PAD:      testPad2Pad();              break;
+    case TEST_TRACKS:       testTracks( NULL, false );  break;
+    case TEST_ZONES:        testZones();                break;
+    case TEST_UNCONNECTED:  testUnconnected();          break;
+    case TEST_KEEPOUTS:     testKeepoutAreas();         break;
+    case TEST_TEXTS:        testTexts();                break;
+    }
+
+    return true;
+}
+
+
 void DRC::ListUnconnectedPads()
 {
     testUnconnected();
@@ -296,7 +664,9 @@ void DRC::ListUnconnectedPads()
 void DRC::updatePointers()
 {
     // update my pointers, m_mainWindow is the only unchangeable one
-    m_pcb = m_mainWindow->GetBoard();
+    // (without frame, the board cannot change)
+    if( m_mainWindow )
+        m_pcb = m_mainWindow->GetBoard();
 
     if( m_drcDialog )  // Use diag list boxes only in DRC dialog
     {
@@ -306,6 +676,21 @@ void DRC::updatePointers()
 }
 
 
+void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
+{
+    if( m_collectMarkers )
+    {
+        m_markers.push_back( aMarker );
+        return;
+    }
+
+    m_pcb->Add( aMarker );
+
+    if( m_mainWindow )
+        m_mainWindow->GetGalCanvas()->GetView()->Add( aMarker );
+}
+
+
 bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
 {
     bool ret = true;
@@ -324,8 +709,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_CLEARANCE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -340,8 +724,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_TRACKWIDTH, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -355,8 +738,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_VIASIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -370,8 +752,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_VIADRILLSIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -385,8 +766,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_uVIASIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -400,8 +780,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_uVIADRILLSIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -435,41 +814,72 @@ bool DRC::testNetClasses()
 
 void DRC::testPad2Pad()
 {
+#ifdef PROFILE
+    prof_counter totalTime;
+    prof_start( &totalTime );
+#endif
+
     std::vector<D_PAD*> sortedPads;
 
     m_pcb->GetSortedPadListByXthenYCoord( sortedPads );
 
-    // find the max size of the pads (used to stop the test)
-    int max_size = 0;
-
-    for( unsigned i = 0; i < sortedPads.size(); ++i )
+    // Each pad is tested against the following pads in list which are close enough to
+    // create a clearance issue, as the candidates are found in an index instead of
+    // sweeping the list up to the size of the biggest pad of the board.
+    // Building the index also calculates the bounding radius of every pad, so the
+    // tests below only read the pads.
+    DRC_CANDIDATE_INDEX index;
+    index.Build( sortedPads, std::vector<TRACK*>() );
+
+    int padCount = sortedPads.size();
+    std::vector<PAD_DRC_ERROR> errors( padCount );
+    int i;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel private(i)
+#endif /* USE_OPENMP */
     {
-        D_PAD* pad = sortedPads[i];
+        // Clearance tests store intermediate results in the DRC object: each thread
+        // uses its own one
+        DRC worker( m_pcb );
+        std::vector<int> candidates;
+        std::vector<D_PAD*> candidatePads;
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule(dynamic, 64)
+#endif /* USE_OPENMP */
+        for( i = 0; i < padCount; ++i )
+        {
+            index.QueryPads( sortedPads[i], i, candidates );
 
-        // GetBoundingRadius() is the radius of the minimum sized circle fully containing the pad
-        int radius = pad->GetBoundingRadius();
-        if( radius > max_size )
-            max_size = radius;
-    }
+            candidatePads.clear();
+
+            for( unsigned jj = 0; jj < candidates.size(); ++jj )
+                candidatePads.push_back( sortedPads[candidates[jj]] );
 
-    // Test the pads
-    D_PAD** listEnd = &sortedPads[ sortedPads.size() ];
+            worker.doPadToPadsDrc( sortedPads[i], candidatePads, errors[i] );
+        }
+    }
 
-    for( unsigned i = 0; i< sortedPads.size(); ++i )
+    // Markers are created by the main thread, in pad list order
+    for( i = 0; i < padCount; ++i )
     {
-        D_PAD* pad = sortedPads[i];
+        const PAD_DRC_ERROR& error = errors[i];
 
-        int    x_limit = max_size + pad->GetClearance() +
-                         pad->GetBoundingRadius() + pad->GetPosition().x;
+        if( !error.m_pad )
+            continue;
 
-        if( !doPadToPadsDrc( pad, &sortedPads[i], listEnd, x_limit ) )
-        {
-            wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-            m_currentMarker = 0;
-        }
+        m_currentMarker = fillMarker( error.m_pad, error.m_otherPad, error.m_errorCode,
+                                      m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
+        m_currentMarker = 0;
     }
+
+#ifdef PROFILE
+    prof_end( &totalTime );
+
+    wxLogDebug( wxT( "Pad clearances: %d pads, %.1f ms" ), padCount, totalTime.msecs() );
+#endif /* PROFILE */
 }
 
 
@@ -478,10 +888,28 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
     wxProgressDialog * progressDialog = NULL;
     const int delta = 500;  // This is the number of tests between 2 calls to the
                             // progress bar
-    int count = 0;
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
-        count++;
+    std::vector<D_PAD*> pads;
+    std::vector<TRACK*> tracks;
+
+    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+        tracks.push_back( segm );
+
+    // Each segment is tested only against the pads and the following tracks which are
+    // close enough to create a clearance issue, in list order, so the results are the
+    // same as testing it against the whole lists
+    DRC_CANDIDATE_INDEX index;
 
+    if( !m_scanTracks )
+    {
+        pads = m_pcb->GetPads();
+        index.Build( pads, tracks );
+    }
+
+    std::vector<int>    candidateIds;
+    std::vector<D_PAD*> candidatePads;
+    std::vector<TRACK*> candidateTracks;
+
+    int count = tracks.empty() ? 0 : tracks.size() - 1;
     int deltamax = count/delta;
 
     if( aShowProgressBar && deltamax > 3 )
@@ -496,8 +924,11 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
     int ii = 0;
     count = 0;
 
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
+    // The last segment is not tested: it was tested by all others
+    for( int jj = 0; jj < (int) tracks.size() - 1; ++jj )
     {
+        TRACK* segm = tracks[jj];
+
         if ( ii++ > delta )
         {
             ii = 0;
@@ -515,11 +946,33 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
             }
         }
 
-        if( !doTrackDrc( segm, segm->Next(), true ) )
+        bool ok;
+
+        if( m_scanTracks )
+        {
+            ok = doTrackDrc( segm, segm->Next(), true );
+        }
+        else
+        {
+            index.QueryPads( segm, candidateIds );
+            candidatePads.clear();
+
+            for( unsigned kk = 0; kk < candidateIds.size(); ++kk )
+                candidatePads.push_back( pads[candidateIds[kk]] );
+
+            index.QueryTracks( segm, jj, candidateIds );
+            candidateTracks.clear();
+
+            for( unsigned kk = 0; kk < candidateIds.size(); ++kk )
+                candidateTracks.push_back( tracks[candidateIds[kk]] );
+
+            ok = doTrackDrc( segm, candidatePads, candidateTracks );
+        }
+
+        if( !ok )
         {
             wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+            addMarkerToPcb( m_currentMarker );
             m_currentMarker = 0;
         }
     }
@@ -531,6 +984,12 @@ void DRC::testTracks( wxWindow *aActiveWindow, bool aShowProgressBar )
 
 void DRC::testUnconnected()
 {
+    if( !m_mainWindow )
+    {
+        testUnconnectedFromRatsnest();
+        return;
+    }
+
     if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
     {
         wxClientDC dc( m_mainWindow->GetCanvas() );
@@ -564,6 +1023,47 @@ void DRC::testUnconnected()
 }
 
 
+void DRC::testUnconnectedFromRatsnest()
+{
+    RN_DATA* ratsnest = m_pcb->GetRatsnest();
+    wxString msg;
+
+    for( int net = 1; net < ratsnest->GetNetCount(); ++net )
+    {
+        const std::vector<RN_EDGE_MST_PTR>* edges = ratsnest->GetNet( net ).GetUnconnected();
+
+        if( edges == NULL )
+            continue;
+
+        BOOST_FOREACH( const RN_EDGE_MST_PTR& edge, *edges )
+        {
+            const RN_NODE_PTR& sourceNode = edge->GetSourceNode();
+            const RN_NODE_PTR& targetNode = edge->GetTargetNode();
+
+            if( sourceNode->GetParents().empty() || targetNode->GetParents().empty() )
+                continue;
+
+            const BOARD_CONNECTED_ITEM* source = sourceNode->GetParents().front();
+            const BOARD_CONNECTED_ITEM* target = targetNode->GetParents().front();
+
+            if( m_deferTexts )
+                msg.Clear();
+            else
+                msg = source->GetSelectMenuText() + wxT( " net " ) + source->GetNetname();
+
+            DRC_ITEM* uncItem = new DRC_ITEM( DRCE_UNCONNECTED_PADS,
+                                              msg,
+                                              describeItem( target ),
+                                              wxPoint( sourceNode->GetX(), sourceNode->GetY() ),
+                                              wxPoint( targetNode->GetX(), targetNode->GetY() ) );
+
+            m_unconnected.push_back( uncItem );
+            deferTexts( NULL, uncItem, source, target );
+        }
+    }
+}
+
+
 void DRC::testZones()
 {
     // Test copper areas for valid netcodes
@@ -593,14 +1093,16 @@ void DRC::testZones()
         {
             m_currentMarker = fillMarker( test_area,
                                           DRCE_SUSPICIOUS_NET_FOR_ZONE_OUTLINE, m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+            addMarkerToPcb( m_currentMarker );
             m_currentMarker = NULL;
         }
     }
 
-    // Test copper areas outlines, and create markers when needed
-    m_pcb->Test_Drc_Areas_Outlines_To_Areas_Outlines( NULL, true );
+    // Test copper areas outlines, and create markers when needed.  With deferred texts,
+    // runTestFamilies() runs it on the main thread.
+    if( !m_deferTexts )
+        m_pcb->Test_Drc_Areas_Outlines_To_Areas_Outlines( NULL, true,
+                                                          m_collectMarkers ? &m_markers : NULL );
 }
 
 
@@ -629,8 +1131,7 @@ void DRC::testKeepoutAreas()
                 {
                     m_currentMarker = fillMarker( segm, NULL,
                                                   DRCE_TRACK_INSIDE_KEEPOUT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                    addMarkerToPcb( m_currentMarker );
                     m_currentMarker = 0;
                 }
             }
@@ -646,8 +1147,7 @@ void DRC::testKeepoutAreas()
                 {
                     m_currentMarker = fillMarker( segm, NULL,
                                                   DRCE_VIA_INSIDE_KEEPOUT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                    addMarkerToPcb( m_currentMarker );
                     m_currentMarker = 0;
                 }
             }
@@ -707,8 +1207,7 @@ void DRC::testTexts()
                         m_currentMarker = fillMarker( track, text,
                                                       DRCE_TRACK_INSIDE_TEXT,
                                                       m_currentMarker );
-                        m_pcb->Add( m_currentMarker );
-                        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                        addMarkerToPcb( m_currentMarker );
                         m_currentMarker = NULL;
                         break;
                     }
@@ -726,8 +1225,7 @@ void DRC::testTexts()
                     {
                         m_currentMarker = fillMarker( track, text,
                                                       DRCE_VIA_INSIDE_TEXT, m_currentMarker );
-                        m_pcb->Add( m_currentMarker );
-                        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                        addMarkerToPcb( m_currentMarker );
                         m_currentMarker = NULL;
                         break;
                     }
@@ -776,8 +1274,7 @@ void DRC::testTexts()
                 {
                     m_currentMarker = fillMarker( pad, text,
                                                   DRCE_PAD_INSIDE_TEXT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                    addMarkerToPcb( m_currentMarker );
                     m_currentMarker = NULL;
                     break;
                 }
@@ -834,7 +1331,8 @@ bool DRC::doTrackKeepoutDrc( TRACK* aRefSeg )
 }
 
 
-bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_limit )
+bool DRC::doPadToPadsDrc( D_PAD* aRefPad, const std::vector<D_PAD*>& aCandidates,
+                          PAD_DRC_ERROR& aError )
 {
     const static LSET all_cu = LSET::AllCuMask();
 
@@ -857,18 +1355,13 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
     // (a value = 0 means use netclass value)
     dummypad.SetLocalClearance( 1 );
 
-    for( D_PAD** pad_list = aStart;  pad_list<aEnd;  ++pad_list )
+    for( unsigned ii = 0; ii < aCandidates.size(); ++ii )
     {
-        D_PAD* pad = *pad_list;
+        D_PAD* pad = aCandidates[ii];
 
         if( pad == aRefPad )
             continue;
 
-        // We can stop the test when pad->GetPosition().x > x_limit
-        // because the list is sorted by X values
-        if( pad->GetPosition().x > x_limit )
-            break;
-
         // No problem if pads which are on copper layers are on different copper layers,
         // (pads can be only on a technical layer, to build complex pads)
         // but their hole (if any ) can create DRC error because they are on all
@@ -906,8 +1399,7 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
                 if( !checkClearancePadToPad( aRefPad, &dummypad ) )
                 {
                     // here we have a drc error on pad!
-                    m_currentMarker = fillMarker( pad, aRefPad,
-                                                  DRCE_HOLE_NEAR_PAD, m_currentMarker );
+                    aError = PAD_DRC_ERROR( pad, aRefPad, DRCE_HOLE_NEAR_PAD );
                     return false;
                 }
             }
@@ -923,8 +1415,7 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
                 if( !checkClearancePadToPad( pad, &dummypad ) )
                 {
                     // here we have a drc error on aRefPad!
-                    m_currentMarker = fillMarker( aRefPad, pad,
-                                                  DRCE_HOLE_NEAR_PAD, m_currentMarker );
+                    aError = PAD_DRC_ERROR( aRefPad, pad, DRCE_HOLE_NEAR_PAD );
                     return false;
                 }
             }
@@ -959,7 +1450,7 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
         if( !checkClearancePadToPad( aRefPad, pad ) )
         {
             // here we have a drc error!
-            m_currentMarker = fillMarker( aRefPad, pad, DRCE_PAD_NEAR_PAD1, m_currentMarker );
+            aError = PAD_DRC_ERROR( aRefPad, pad, DRCE_PAD_NEAR_PAD1 );
             return false;
         }
     }
@@ -49,7 +49,7 @@
 MARKER_PCB* DRC::fillMarker( const TRACK* aTrack, BOARD_ITEM* aItem, int aErrorCode,
                              MARKER_PCB* fillMe )
 {
-    wxString textA = aTrack->GetSelectMenuText();
+    wxString textA = describeItem( aTrack );
     wxString textB;
 
     wxPoint  position;
@@ -57,7 +57,7 @@ MARKER_PCB* DRC::fillMarker( const TRACK* aTrack, BOARD_ITEM* aItem, int aErrorC
 
     if( aItem )     // aItem might be NULL
     {
-        textB = aItem->GetSelectMenuText();
+        textB = describeItem( aItem );
 
         if( aItem->Type() == PCB_PAD_T )
         {
@@ -121,13 +121,15 @@ MARKER_PCB* DRC::fillMarker( const TRACK* aTrack, BOARD_ITEM* aItem, int aErrorC
         }
     }
 
+    deferTexts( fillMe, NULL, aTrack, aItem );
+
     return fillMe;
 }
 
 
 MARKER_PCB* DRC::fillMarker( D_PAD* aPad, BOARD_ITEM* aItem, int aErrorCode, MARKER_PCB* fillMe )
 {
-    wxString textA = aPad->GetSelectMenuText();
+    wxString textA = describeItem( aPad );
     wxString textB;
 
     wxPoint  posA = aPad->GetPosition();
@@ -135,7 +137,7 @@ MARKER_PCB* DRC::fillMarker( D_PAD* aPad, BOARD_ITEM* aItem, int aErrorCode, MAR
 
     if( aItem )
     {
-        textB = aItem->GetSelectMenuText();
+        textB = describeItem( aItem );
 
         switch( aItem->Type() )
         {
@@ -163,13 +165,15 @@ MARKER_PCB* DRC::fillMarker( D_PAD* aPad, BOARD_ITEM* aItem, int aErrorCode, MAR
         fillMe->SetItem( aPad );    // TODO it has to be checked
     }
 
+    deferTexts( fillMe, NULL, aPad, aItem );
+
     return fillMe;
 }
 
 
 MARKER_PCB* DRC::fillMarker( ZONE_CONTAINER* aArea, int aErrorCode, MARKER_PCB* fillMe )
 {
-    wxString textA = aArea->GetSelectMenuText();
+    wxString textA = describeItem( aArea );
 
     wxPoint  posA = aArea->GetPosition();
 
@@ -183,6 +187,8 @@ MARKER_PCB* DRC::fillMarker( ZONE_CONTAINER* aArea, int aErrorCode, MARKER_PCB*
         fillMe->SetItem( aArea );
     }
 
+    deferTexts( fillMe, NULL, aArea, NULL );
+
     return fillMe;
 }
 
@@ -192,7 +198,7 @@ MARKER_PCB* DRC::fillMarker( const ZONE_CONTAINER* aArea,
                              int                   aErrorCode,
                              MARKER_PCB*           fillMe )
 {
-    wxString textA = aArea->GetSelectMenuText();
+    wxString textA = describeItem( aArea );
 
     wxPoint  posA = aPos;
 
@@ -206,12 +212,17 @@ MARKER_PCB* DRC::fillMarker( const ZONE_CONTAINER* aArea,
         fillMe->SetItem( aArea );
     }
 
+    deferTexts( fillMe, NULL, aArea, NULL );
+
     return fillMe;
 }
 
 
 MARKER_PCB* DRC::fillMarker( int aErrorCode, const wxString& aMessage, MARKER_PCB* fillMe )
 {
+    // The message is already built: the netclass tests do not run on worker threads
+    wxASSERT( !m_deferTexts );
+
     wxPoint posA;   // not displayed
 
     if( fillMe )
@@ -224,3 +235,58 @@ MARKER_PCB* DRC::fillMarker( int aErrorCode, const wxString& aMessage, MARKER_PC
     return fillMe;
 }
 
+
+wxString DRC::describeItem( const BOARD_ITEM* aItem ) const
+{
+    return m_deferTexts ? wxString() : aItem->GetSelectMenuText();
+}
+
+
+void DRC::deferTexts( MARKER_PCB* aMarker, DRC_ITEM* aUnconnected,
+                      const BOARD_ITEM* aItemA, const BOARD_ITEM* aItemB )
+{
+    if( m_deferTexts )
+        m_deferredTexts.push_back( DEFERRED_TEXTS( aMarker, aUnconnected, aItemA, aItemB ) );
+}
+
+
+void DRC::buildDeferredTexts()
+{
+    // A marker can be filled several times: the last texts are kept
+    for( unsigned ii = 0; ii < m_deferredTexts.size(); ++ii )
+    {
+        const DEFERRED_TEXTS& deferred = m_deferredTexts[ii];
+        wxString textA = deferred.m_itemA->GetSelectMenuText();
+        wxString textB;
+
+        if( deferred.m_itemB )
+            textB = deferred.m_itemB->GetSelectMenuText();
+
+        if( deferred.m_unconnected )
+        {
+            // Same texts as testUnconnected()
+            DRC_ITEM*   item = deferred.m_unconnected;
+            wxPoint     posA = item->GetPointA();
+            wxPoint     posB = item->GetPointB();
+
+            textA << wxT( " net " )
+                  << static_cast<const BOARD_CONNECTED_ITEM*>( deferred.m_itemA )->GetNetname();
+            item->SetData( item->GetErrorCode(), textA, textB, posA, posB );
+            continue;
+        }
+
+        MARKER_PCB*     marker = deferred.m_marker;
+        const DRC_ITEM& item = marker->GetReporter();
+        int             errorCode = item.GetErrorCode();
+        wxPoint         position = marker->GetPos();
+        wxPoint         posA = item.GetPointA();
+        wxPoint         posB = item.GetPointB();
+
+        if( item.HasSecondItem() )
+            marker->SetData( errorCode, position, textA, posA, textB, posB );
+        else
+            marker->SetData( errorCode, position, textA, posA );
+    }
+
+    m_deferredTexts.clear();
+}
@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <boost/shared_ptr.hpp>
+#include <class_drc_item.h>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -140,6 +141,24 @@ public:
 typedef std::vector<DRC_ITEM*> DRC_LIST;
 
 
+/**
+ * Struct DRC_TEST_RESULT
+ * is the report of a family of tests (or of a preparation step, which reports no
+ * violation) run by DRC::RunTestsHeadless().
+ */
+struct DRC_TEST_RESULT
+{
+    DRC_TEST_RESULT( const wxString& aName = wxEmptyString ) :
+        m_name( aName ), m_msecs( 0.0 )
+    {
+    }
+
+    wxString                m_name;     ///< short name of the test family, e.g. "tracks"
+    double                  m_msecs;    ///< time spent running the tests
+    std::vector<DRC_ITEM>   m_items;    ///< the violations found, in board order
+};
+
+
 /**
  * Class DRC
  * is the Design Rule Checker, and performs all the DRC tests.  The output of
@@ -199,6 +218,66 @@ private:
 
     DRC_LIST            m_unconnected;  ///< list of unconnected pads, as DRC_ITEMs
 
+    /// When set, the markers are stored in m_markers instead of being added to the board,
+    /// so the tests can run in a worker thread (see RunTestsHeadless())
+    bool                     m_collectMarkers;
+    std::vector<MARKER_PCB*> m_markers;
+
+    /// The items described by a marker or an unconnected item whose texts are deferred
+    struct DEFERRED_TEXTS
+    {
+        DEFERRED_TEXTS( MARKER_PCB* aMarker, DRC_ITEM* aUnconnected,
+                        const BOARD_ITEM* aItemA, const BOARD_ITEM* aItemB ) :
+            m_marker( aMarker ), m_unconnected( aUnconnected ),
+            m_itemA( aItemA ), m_itemB( aItemB )
+        {
+        }
+
+        MARKER_PCB*         m_marker;       ///< the marker, or NULL for an unconnected item
+        DRC_ITEM*           m_unconnected;
+        const BOARD_ITEM*   m_itemA;
+        const BOARD_ITEM*   m_itemB;        ///< NULL if there is no second item
+    };
+
+    /// When set, the markers and the unconnected items are created without their texts,
+    /// which use translations and formatting that are not thread-safe: the tests only
+    /// record the items to describe in m_deferredTexts, and buildDeferredTexts() builds
+    /// the texts on the main thread (see runTestFamilies())
+    bool                        m_deferTexts;
+    std::vector<DEFERRED_TEXTS> m_deferredTexts;
+
+    /// When set, testTracks() tests each segment against all the pads and the following
+    /// tracks, as the online DRC does, instead of the candidates found in an index
+    bool                     m_scanTracks;
+
+    /// The test families run by RunTestsHeadless(), in report order
+    enum TEST_FAMILY
+    {
+        TEST_NETCLASSES,
+        TEST_PAD2PAD,
+        TEST_TRACKS,
+        TEST_ZONES,
+        TEST_UNCONNECTED,
+        TEST_KEEPOUTS,
+        TEST_TEXTS
+    };
+
+    /// A pad clearance error found by doPadToPadsDrc(), to be reported by a marker
+    struct PAD_DRC_ERROR
+    {
+        PAD_DRC_ERROR( D_PAD* aPad = NULL, D_PAD* aOtherPad = NULL, int aErrorCode = 0 ) :
+            m_pad( aPad ), m_otherPad( aOtherPad ), m_errorCode( aErrorCode )
+        {
+        }
+
+        D_PAD*  m_pad;          ///< the pad the marker is attached to, NULL if no error
+        D_PAD*  m_otherPad;
+        int     m_errorCode;
+    };
+
+
+    /// Sets the default settings, used by the constructors
+    void init();
 
     /**
      * Function updatePointers
@@ -207,6 +286,51 @@ private:
      */
     void updatePointers();
 
+    /**
+     * Function addMarkerToPcb
+     * adds a marker to the board and to its view, or to m_markers when the markers
+     * are collected.
+     */
+    void addMarkerToPcb( MARKER_PCB* aMarker );
+
+    /**
+     * Function runTestFamilies
+     * runs the given test families concurrently, each one with its own DRC object,
+     * then adds their markers to the board and their reports to aResults, in the order
+     * of aFamilies.
+     * @return false if the netclasses do not pass the global design rules
+     */
+    bool runTestFamilies( const std::vector<TEST_FAMILY>& aFamilies,
+                          std::vector<DRC_TEST_RESULT>& aResults );
+
+    /**
+     * Function runTestFamily
+     * runs one family of tests, as RunTests() does.
+     * @return false if the netclasses do not pass the global design rules
+     */
+    bool runTestFamily( TEST_FAMILY aFamily );
+
+    /**
+     * Function describeItem
+     * @return the text describing aItem in a marker, or an empty string when the texts
+     * are deferred (see m_deferTexts).
+     */
+    wxString describeItem( const BOARD_ITEM* aItem ) const;
+
+    /**
+     * Function deferTexts
+     * records the items described by aMarker or aUnconnected when the texts are deferred.
+     */
+    void deferTexts( MARKER_PCB* aMarker, DRC_ITEM* aUnconnected,
+                     const BOARD_ITEM* aItemA, const BOARD_ITEM* aItemB );
+
+    /**
+     * Function buildDeferredTexts
+     * builds the texts of the markers and of the unconnected items recorded by a test
+     * which ran with deferred texts.
+     */
+    void buildDeferredTexts();
+
 
     /**
      * Function fillMarker
@@ -281,6 +405,13 @@ private:
 
     void testUnconnected();
 
+    /**
+     * Function testUnconnectedFromRatsnest
+     * finds the unconnected items using the board ratsnest (RN_DATA), which must be
+     * up to date.  Used instead of testUnconnected() when there is no frame.
+     */
+    void testUnconnectedFromRatsnest();
+
     void testZones();
 
     void testKeepoutAreas();
@@ -294,13 +425,15 @@ private:
     /**
      * Function doPadToPadsDrc
      * tests the clearance between aRefPad and other pads.
-     * The pad list must be sorted by x coordinate.
+     * It does not create a marker, so it can be run by several threads, each one
+     * using its own DRC object.
      * @param aRefPad The pad to test
-     * @param aStart The start of the pad list to test against
-     * @param aEnd Marks the end of the list and is not included
-     * @param x_limit is used to stop the test (when the any pad's X coord exceeds this)
+     * @param aCandidates The pads to test against, in test order
+     * @param aError is set to the first error found
+     * @return false if an error was found
      */
-    bool doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_limit );
+    bool doPadToPadsDrc( D_PAD* aRefPad, const std::vector<D_PAD*>& aCandidates,
+                         PAD_DRC_ERROR& aError );
 
     /**
      * Function DoTrackDrc
@@ -313,6 +446,50 @@ private:
      */
     bool doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool doPads = true );
 
+    /**
+     * Function doTrackDrc
+     * tests the current segment against explicit lists of pads and tracks.
+     * The lists are tested in the given order, and the first problem found is reported,
+     * so giving the candidates in board order produces the same result as the list scan.
+     * @param aRefSeg The segment to test
+     * @param aPads The pads to test against (can be empty)
+     * @param aTracks The tracks and vias to test against
+     * @return bool - true if no poblems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool doTrackDrc( TRACK* aRefSeg, const std::vector<D_PAD*>& aPads,
+                     const std::vector<TRACK*>& aTracks );
+
+    /**
+     * Function startTrackDrc
+     * tests the width (and for vias the drill and layers) of a segment, and prepares
+     * m_segmEnd, m_segmAngle and m_segmLength for checkTrackToPad() and checkTrackToTrack().
+     * @param aRefSeg The segment to test
+     * @return bool - true if no problems, else false and m_currentMarker is filled in.
+     */
+    bool startTrackDrc( TRACK* aRefSeg );
+
+    /**
+     * Function checkTrackToPad
+     * tests the clearance between a segment and a pad, or the pad hole when the pad
+     * is not on the layers of the segment.  startTrackDrc() must have been called.
+     * @param aRefSeg The segment to test
+     * @param aPad The pad to test against
+     * @param aDummyPad A pad on all copper layers, used to test the hole
+     * @return bool - true if no problems, else false and m_currentMarker is filled in.
+     */
+    bool checkTrackToPad( TRACK* aRefSeg, D_PAD* aPad, D_PAD& aDummyPad );
+
+    /**
+     * Function checkTrackToTrack
+     * tests the clearance between a segment and another segment or via.
+     * startTrackDrc() must have been called.
+     * @param aRefSeg The segment to test
+     * @param aTrack The segment or via to test against
+     * @return bool - true if no problems, else false and m_currentMarker is filled in.
+     */
+    bool checkTrackToTrack( TRACK* aRefSeg, TRACK* aTrack );
+
     /**
      * Function doTrackKeepoutDrc
      * tests the current segment or via.
@@ -393,6 +570,13 @@ private:
 public:
     DRC( PCB_EDIT_FRAME* aPcbWindow );
 
+    /**
+     * Constructor
+     * creates a DRC working on a board which is not shown in a frame, to run the tests
+     * with RunTestsHeadless().
+     */
+    DRC( BOARD* aBoard );
+
     ~DRC();
 
     /**
@@ -484,6 +668,29 @@ public:
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
 
+    /**
+     * Function RunTestsHeadless
+     * runs the tests specified with a previous call to SetSettings() without any
+     * window: zones are refilled and the ratsnest is recomputed first, then the
+     * independent test families run concurrently.  The markers are added to the
+     * board in the same order whatever the number of threads.
+     * @param aResults is filled with the timings and the violations of each step.
+     */
+    void RunTestsHeadless( std::vector<DRC_TEST_RESULT>& aResults );
+
+    /**
+     * Function SetScanTracks
+     * selects how the track clearances are tested: by scanning the whole pad and track
+     * lists, or (the default) by testing only the candidates found in a spatial index.
+     * Both find the same problems: the scan is kept to check the index and to measure
+     * its benefit (see drc_bench).
+     * @param aScan true to scan the lists.
+     */
+    void SetScanTracks( bool aScan )
+    {
+        m_scanTracks = aScan;
+    }
+
     /**
      * Function ListUnconnectedPad
      * gathers a list of all the unconnected pads and shows them in the
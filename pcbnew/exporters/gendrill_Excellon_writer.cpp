@@ -78,7 +78,7 @@ EXCELLON_WRITER::EXCELLON_WRITER( BOARD* aPcb )
 }
 
 
-void EXCELLON_WRITER::CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
+bool EXCELLON_WRITER::CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
                                             bool aGenDrill, bool aGenMap,
                                             REPORTER * aReporter )
 {
@@ -119,7 +119,7 @@ void EXCELLON_WRITER::CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
                                           GetChars( fullFilename ) );
                         aReporter->Report( msg );
                     }
-                    break;
+                    return false;
                 }
                 else
                 {
@@ -149,7 +149,7 @@ void EXCELLON_WRITER::CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
                         aReporter->Report( msg );
                     }
 
-                    return;
+                    return false;
                 }
                 else
                 {
@@ -162,6 +162,8 @@ void EXCELLON_WRITER::CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
             }
         }
     }
+
+    return true;
 }
 
 
@@ -241,8 +241,11 @@ public:
      * @param aGenDrill = true to generate the EXCELLON drill file
      * @param aGenMap = true to generate a drill map file
      * @param aReporter = a REPORTER to return activity or any message (can be NULL)
+     * @return true if all the files were created
+     *
+     * With a NULL reporter, it can be run as a job of a BOARD_PLOT_BATCH.
      */
-    void CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
+    bool CreateDrillandMapFilesSet( const wxString& aPlotDirectory,
                                     bool aGenDrill, bool aGenMap,
                                     REPORTER * aReporter = NULL );
 
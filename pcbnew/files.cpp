@@ -52,9 +52,12 @@
 #include <build_version.h>      // LEGACY_BOARD_FILE_VERSION
 #include <module_editor_frame.h>
 #include <modview_frame.h>
+#include <background_save.h>
 
 #include <wx/stdpaths.h>
 
+#include <boost/bind.hpp>
+
 
 //#define     USE_INSTRUMENTATION     true
 #define     USE_INSTRUMENTATION     false
@@ -690,6 +693,9 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool aCreateBackupF
         return false;
     }
 
+    // The auto save file is deleted below: a running auto save must not write it again
+    m_autoSaver->Wait();
+
     wxString backupFileName;
 
     // aCreateBackupFile == false is mainly used to write autosave files
@@ -821,6 +827,10 @@ bool PCB_EDIT_FRAME::SavePcbCopy( const wxString& aFileName )
 
 bool PCB_EDIT_FRAME::doAutoSave()
 {
+    // The timer is started again when the auto save fails
+    if( m_autoSaver->IsRunning() )
+        return false;
+
     wxFileName tmpFileName;
 
     if( GetBoard()->GetFileName().IsEmpty() )
@@ -852,18 +862,53 @@ bool PCB_EDIT_FRAME::doAutoSave()
             return false;
     }
 
+    // As in SavePcbFile(): a legacy board is saved in the s-expression format
+    if( autoSaveFileName.GetExt() == LegacyPcbFileExtension )
+        autoSaveFileName.SetExt( KiCadPcbFileExtension );
+
+    if( !IsWritable( autoSaveFileName ) )
+        return false;
+
     wxLogTrace( traceAutoSave, "Creating auto save file <" + autoSaveFileName.GetFullPath() + ">" );
 
-    if( SavePcbFile( autoSaveFileName.GetFullPath(), NO_BACKUP_FILE ) )
+    // Prepare the board as SavePcbFile() does, then write a snapshot of it on a
+    // worker thread, so the auto save does not interrupt the user.
+    GetBoard()->m_Status_Pcb &= ~CONNEXION_OK;
+    GetBoard()->SynchronizeNetsAndNetClasses();
+    SetCurrentNetClass( NETCLASS::Default );
+
+    if( !m_autoSaver->Start( GetBoard(), autoSaveFileName.GetFullPath(),
+                             boost::bind( &PCB_EDIT_FRAME::autoSaveCompleted, this, _1, _2 ) ) )
+        return false;
+
+    UpdateTitle();
+    m_autoSaveState = false;
+    return true;
+}
+
+
+void PCB_EDIT_FRAME::autoSaveCompleted( const wxString& aFileName, const wxString& aError )
+{
+    CallAfter( boost::bind( &PCB_EDIT_FRAME::onAutoSaveDone, this, aFileName, aError ) );
+}
+
+
+void PCB_EDIT_FRAME::onAutoSaveDone( const wxString& aFileName, const wxString& aError )
+{
+    if( aError.IsEmpty() )
     {
-        GetScreen()->SetModify();
-        GetBoard()->SetFileName( tmpFileName.GetFullPath() );
-        UpdateTitle();
-        m_autoSaveState = false;
-        return true;
+        wxLogTrace( traceAutoSave, "Wrote auto save file <" + aFileName + ">" );
+        return;
     }
 
-    GetBoard()->SetFileName( tmpFileName.GetFullPath() );
+    wxString msg = wxString::Format( _(
+            "Error saving board file '%s'.\n%s" ),
+            GetChars( aFileName ),
+            GetChars( aError )
+            );
+    DisplayError( this, msg );
 
-    return false;
+    // Try again later, as when doAutoSave() fails
+    if( m_autoSaveInterval > 0 )
+        m_autoSaveTimer->Start( m_autoSaveInterval * 1000, wxTIMER_ONE_SHOT );
 }
@@ -70,9 +70,11 @@ Vary: Accept-Encoding
 
 #include <wx/zipstrm.h>
 #include <wx/mstream.h>
+#include <wx/wfstream.h>
 #include <wx/uri.h>
 
 #include <fctsys.h>
+#include <common.h>             // GetKicadConfigPath()
 
 #include <io_mgr.h>
 #include <richio.h>
@@ -89,6 +91,7 @@ using namespace std;
 
 
 static const char* PRETTY_DIR = "allow_pretty_writing_to_this_dir";
+static const char* CACHE_DIR  = "cache_github_zip_in_this_dir";
 
 
 typedef boost::ptr_map<string, wxZipEntry>  MODULE_MAP;
@@ -194,13 +197,10 @@ MODULE* GITHUB_PLUGIN::FootprintLoad( const wxString& aLibraryPath,
 
     if( it != m_gh_cache->end() )  // fp_name is present
     {
-        //std::string::data() ensures that the referenced data block is contiguous.
-        wxMemoryInputStream mis( m_zip_image.data(), m_zip_image.size() );
-
         // This decoder should always be UTF8, since it was saved that way by git.
         // That is, since pretty footprints are UTF8, and they were pushed to the
-        // github repo, they are still UTF8.
-        wxZipInputStream    zis( mis, wxConvUTF8 );
+        // github repo, they are still UTF8.  Only the requested entry is inflated.
+        wxZipInputStream    zis( openZip(), wxConvUTF8 );
         wxZipEntry*         entry = (wxZipEntry*) it->second;   // remove "const"-ness
 
         if( zis.OpenEntry( *entry ) )
@@ -349,12 +349,12 @@ void GITHUB_PLUGIN::FootprintLibOptions( PROPERTIES* aListToAppendTo ) const
         "format of the save is pretty.</p>"
         ));
 
-    /*
-    (*aListToAppendTo)["cache_github_zip_in_this_dir"] = UTF8( _(
+    (*aListToAppendTo)[ CACHE_DIR ] = UTF8( _(
         "Set this property to a directory where the github *.zip file will be cached. "
-        "This should speed up subsequent visits to this library."
+        "This speeds up subsequent visits to this library, and allows using it "
+        "without network access once cached.  The default is a directory in the "
+        "KiCad configuration directory."
         ));
-    */
 }
 
 
@@ -403,6 +403,8 @@ void GITHUB_PLUGIN::cacheLib( const wxString& aLibraryPath, const PROPERTIES* aP
             }
         }
 
+        setCacheDir( aProperties );
+
         // operator==( wxString, wxChar* ) does not exist, construct wxString once here.
         const wxString    kicad_mod( "kicad_mod" );
 
@@ -415,10 +417,9 @@ void GITHUB_PLUGIN::cacheLib( const wxString& aLibraryPath, const PROPERTIES* aP
 
         m_lib_path = aLibraryPath;
 
-        wxMemoryInputStream mis( &m_zip_image[0], m_zip_image.size() );
-
+        // The central directory is read, no footprint is inflated here.
         // @todo: generalize this name encoding from a PROPERTY (option) later
-        wxZipInputStream    zis( mis, wxConvUTF8 );
+        wxZipInputStream    zis( openZip(), wxConvUTF8 );
 
         wxZipEntry* entry;
 
@@ -512,6 +513,151 @@ bool GITHUB_PLUGIN::repoURL_zipURL( const wxString& aRepoURL, std::string* aZipU
 }
 
 
+void GITHUB_PLUGIN::setCacheDir( const PROPERTIES* aProperties )
+{
+    UTF8        cache_dir;
+    wxString    wx_cache_dir;
+
+    if( aProperties && aProperties->Value( CACHE_DIR, &cache_dir ) )
+    {
+        wx_cache_dir = cache_dir;
+        wx_cache_dir = FP_LIB_TABLE::ExpandSubstitutions( wx_cache_dir );
+    }
+    else
+    {
+        wxFileName fn;
+
+        fn.AssignDir( GetKicadConfigPath() );
+        fn.AppendDir( wxT( "github_cache" ) );
+        wx_cache_dir = fn.GetPath();
+    }
+
+    // A cache directory which cannot be created only costs the download each time.
+    // One which exists but is read only may still be a pre-populated offline cache.
+    if( !wxFileName::DirExists( wx_cache_dir ) &&
+        !wxFileName::Mkdir( wx_cache_dir, 0777, wxPATH_MKDIR_FULL ) )
+    {
+        wxLogDebug( wxT( "Cannot create github zip cache directory: " ) + wx_cache_dir );
+        m_cache_dir.clear();
+        return;
+    }
+
+    m_cache_dir = wx_cache_dir;
+}
+
+
+wxString GITHUB_PLUGIN::zipCacheName( const std::string& aZipURL ) const
+{
+    // FNV-1a hash of the URL, so the cache of each library has its own file name.
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+
+    for( unsigned i = 0;  i < aZipURL.size();  ++i )
+        hash = ( hash ^ (unsigned char) aZipURL[i] ) * 0x100000001B3ULL;
+
+    wxFileName fn( m_cache_dir, wxString::Format( wxT( "%08x%08x" ),
+                                                  unsigned( hash >> 32 ), unsigned( hash ) ),
+                   wxT( "zip" ) );
+
+    return fn.GetFullPath();
+}
+
+
+wxInputStream* GITHUB_PLUGIN::openZip() const
+{
+    if( m_zip_file.size() )
+    {
+        wxFFileInputStream* fis = new wxFFileInputStream( m_zip_file );
+
+        if( !fis->IsOk() )
+        {
+            delete fis;
+
+            wxString msg = wxString::Format( _( "Unable to open cached zip archive '%s'" ),
+                                             GetChars( m_zip_file ) );
+            THROW_IO_ERROR( msg );
+        }
+
+        return fis;
+    }
+
+    //std::string::data() ensures that the referenced data block is contiguous.
+    return new wxMemoryInputStream( m_zip_image.data(), m_zip_image.size() );
+}
+
+
+/**
+ * Function readETag
+ * returns the ETag stored with the cached zip archive \a aZipFile, or an empty string.
+ */
+static std::string readETag( const wxString& aZipFile )
+{
+    std::string etag;
+    FILE*       fp = wxFopen( aZipFile + wxT( ".etag" ), wxT( "rb" ) );
+
+    if( fp )
+    {
+        char    buf[512];
+        size_t  len = fread( buf, 1, sizeof( buf ), fp );
+
+        etag.assign( buf, len );
+        fclose( fp );
+    }
+
+    return etag;
+}
+
+
+/**
+ * Function writeCacheFile
+ * writes \a aData to \a aFileName through a temporary file, so an interrupted write
+ * never leaves a truncated file behind.
+ */
+static bool writeCacheFile( const wxString& aFileName, const std::string& aData )
+{
+    wxString    tempFileName = aFileName + wxT( ".tmp" );
+    FILE*       fp = wxFopen( tempFileName, wxT( "wb" ) );
+
+    if( !fp )
+        return false;
+
+    bool ok = fwrite( aData.data(), 1, aData.size(), fp ) == aData.size();
+
+    ok = ( fclose( fp ) == 0 ) && ok;
+    ok = ok && wxRenameFile( tempFileName, aFileName, true );
+
+    if( !ok )
+        wxRemoveFile( tempFileName );
+
+    return ok;
+}
+
+
+/**
+ * Function useCachedZip
+ * tells if the cached zip archive is used when the server answers with the HTTP status
+ * \a aCode.  "304 Not Modified" means the cached zip archive is current.  The server
+ * errors (5xx) and the client errors which only refuse the request for now, i.e. the
+ * Github rate limit (403 and 429) and a request timeout (408), leave the cached zip
+ * archive as the best there is.  The other client errors, e.g. 404 for a library
+ * removed from the server or 401 for a private one, are reported, because the library
+ * table needs a fix, and the cached zip archive is not used.
+ */
+static bool useCachedZip( long aCode )
+{
+    switch( aCode )
+    {
+    case 304:
+    case 403:
+    case 408:
+    case 429:
+        return true;
+
+    default:
+        return aCode >= 500;
+    }
+}
+
+
 void GITHUB_PLUGIN::remoteGetZip( const wxString& aRepoURL ) throw( IO_ERROR )
 {
     std::string  zip_url;
@@ -522,6 +668,22 @@ void GITHUB_PLUGIN::remoteGetZip( const wxString& aRepoURL ) throw( IO_ERROR )
         THROW_IO_ERROR( msg );
     }
 
+    m_zip_image.clear();
+    m_zip_file.clear();
+
+    wxString    cache_zip;
+    std::string etag;
+
+    if( m_cache_dir.size() )
+    {
+        cache_zip = zipCacheName( zip_url );
+
+        if( wxFileName::FileExists( cache_zip ) )
+            etag = readETag( cache_zip );
+        else
+            cache_zip.clear();
+    }
+
     wxLogDebug( wxT( "Attempting to download: " ) + zip_url );
 
     KICAD_CURL_EASY kcurl;      // this can THROW_IO_ERROR
@@ -531,13 +693,24 @@ void GITHUB_PLUGIN::remoteGetZip( const wxString& aRepoURL ) throw( IO_ERROR )
     kcurl.SetHeader( "Accept", "application/zip" );
     kcurl.SetFollowRedirects( true );
 
+    // The server answers "304 Not Modified" without a body if our copy is current.
+    if( etag.size() )
+        kcurl.SetHeader( "If-None-Match", etag );
+
     try
     {
         kcurl.Perform();
-        m_zip_image = kcurl.GetBuffer();
     }
     catch( const IO_ERROR& ioe )
     {
+        if( cache_zip.size() )
+        {
+            // No network, the cached zip archive is the best we have.
+            wxLogDebug( wxT( "Using cached zip archive: " ) + cache_zip );
+            m_zip_file = cache_zip;
+            return;
+        }
+
         // https "GET" has failed, report this to API caller.
         // Note: kcurl.Perform() does not return an error if the file to download is not found
         static const char errorcmd[] = "http GET command failed";  // Do not translate this message
@@ -554,16 +727,54 @@ void GITHUB_PLUGIN::remoteGetZip( const wxString& aRepoURL ) throw( IO_ERROR )
         THROW_IO_ERROR( msg );
     }
 
+    long code = kcurl.GetResponseCode();
+
+    if( cache_zip.size() && useCachedZip( code ) )
+    {
+        wxLogDebug( wxT( "Using cached zip archive: " ) + cache_zip );
+        m_zip_file = cache_zip;
+        return;
+    }
+
+    const std::string& image = kcurl.GetBuffer();
+
     // If the zip archive is not existing, the received data is "Not Found" or "404: Not Found",
     // and no error is returned by kcurl.Perform().
-    if( ( m_zip_image.compare( 0, 9, "Not Found", 9 ) == 0 ) ||
-        ( m_zip_image.compare( 0, 14, "404: Not Found", 14 ) == 0 ) )
+    if( code == 404 || code == 410 ||
+        ( image.compare( 0, 9, "Not Found", 9 ) == 0 ) ||
+        ( image.compare( 0, 14, "404: Not Found", 14 ) == 0 ) )
     {
         UTF8 fmt( _( "Cannot download library '%s'.\nThe library does not exist on the server" ) );
         std::string msg = StrPrintf( fmt.c_str(), TO_UTF8( aRepoURL ) );
 
         THROW_IO_ERROR( msg );
     }
+
+    // Any other error page is not a zip archive, and must not replace the cached one.
+    if( code < 200 || code >= 300 )
+    {
+        UTF8 fmt( _( "Cannot download library '%s'.\nThe server answered with the HTTP status %ld" ) );
+        std::string msg = StrPrintf( fmt.c_str(), TO_UTF8( aRepoURL ), code );
+
+        THROW_IO_ERROR( msg );
+    }
+
+    // Keep the new zip archive on disk, with the ETag which identifies it for the
+    // next session.  Otherwise keep it in memory, as a cache which cannot be written
+    // is not an error.
+    if( m_cache_dir.size() )
+    {
+        wxString new_zip = zipCacheName( zip_url );
+
+        if( writeCacheFile( new_zip, image ) )
+        {
+            writeCacheFile( new_zip + wxT( ".etag" ), kcurl.GetResponseHeader( "ETag" ) );
+            m_zip_file = new_zip;
+            return;
+        }
+    }
+
+    m_zip_image = image;
 }
 
 #if 0 && defined(STANDALONE)
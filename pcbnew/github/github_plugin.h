@@ -28,6 +28,7 @@
 #include <kicad_plugin.h>
 
 struct GH_CACHE;
+class wxInputStream;
 
 
 /**
@@ -129,6 +130,17 @@ struct GH_CACHE;
    substituted with any environment variable strings embedded, just like the
    "Library Path" is.
 
+   <p>The zip file of each Github library is cached on disk, in the directory given by
+   the option <b>cache_github_zip_in_this_dir</b> or by default in the github_cache
+   directory of the KiCad configuration directory.  Later sessions only ask the server
+   whether the zip file has changed, using its ETag, and use the cached zip file as is
+   when the server cannot be reached, answers with a server error (5xx), or refuses the
+   request for now: 403 (the Github rate limit), 408 or 429.  The other client errors,
+   such as 404 for a library removed from the server, are reported and the cached zip
+   file is not used.  Only a successful (2xx) answer replaces the cached zip file.  Footprints are inflated from the zip file one by
+   one, when loaded.  The same works through a caching proxy such as the one configured
+   by pcbnew/github/nginx.conf, which passes the ETag through.
+
    <p>What's the point of COW? It is to turbo-charge the sharing of footprints.
    If you periodically email your COW pretty footprint modifications to the
    Github repo maintainer, you can help update the Github copy. Simply email the
@@ -214,13 +226,39 @@ protected:
 
     /**
      * Function remoteGetZip
-     * fetches a zip file image from a github repo synchronously.  The byte image
-     * is received into the m_input_stream.
+     * fetches a zip file image from a github repo synchronously.  The zip file is
+     * kept in the local cache directory, in m_zip_file, or else in m_zip_image.
+     * A cached zip file is only downloaded again if its ETag has changed, and is
+     * used as is when the server cannot be reached or cannot answer for now, see
+     * useCachedZip() in github_plugin.cpp.
      */
     void remoteGetZip( const wxString& aRepoURL ) throw( IO_ERROR );
 
+    /**
+     * Function setCacheDir
+     * sets m_cache_dir from the option "cache_github_zip_in_this_dir" in \a aProperties,
+     * or to the default cache directory.  m_cache_dir is empty if the directory does
+     * not exist and cannot be created.
+     */
+    void setCacheDir( const PROPERTIES* aProperties );
+
+    /**
+     * Function zipCacheName
+     * returns the full path of the cached zip file downloaded from \a aZipURL.
+     */
+    wxString zipCacheName( const std::string& aZipURL ) const;
+
+    /**
+     * Function openZip
+     * returns a new input stream on the zip file, read from m_zip_file or m_zip_image.
+     * The caller owns the stream.
+     */
+    wxInputStream* openZip() const;
+
     wxString    m_lib_path;     ///< from aLibraryPath, something like https://github.com/liftoff-sr/pretty_footprints
-    std::string m_zip_image;    ///< byte image of the zip file in its entirety.
+    std::string m_zip_image;    ///< byte image of the zip file in its entirety, if not in m_zip_file.
+    wxString    m_zip_file;     ///< the zip file in the local cache, or empty.
+    wxString    m_cache_dir;    ///< directory of the local zip cache, or empty.
     GH_CACHE*   m_gh_cache;
     wxString    m_pretty_dir;
 };
@@ -28,6 +28,7 @@
 #include <io_mgr.h>
 #include <legacy_plugin.h>
 #include <kicad_plugin.h>
+#include <pcb_cache_plugin.h>
 #include <eagle_plugin.h>
 #include <pcad2kicadpcb_plugin/pcad_plugin.h>
 #include <gpcb_plugin.h>
@@ -99,6 +100,9 @@ PLUGIN* IO_MGR::PluginFind( PCB_FILE_T aFileType )
         THROW_IO_ERROR( "BUILD_GITHUB_PLUGIN not enabled in cmake build environment" );
 #endif
 
+    case KICAD_CACHED:
+        return new PCB_CACHE_PLUGIN();
+
     case FILE_TYPE_NONE:
         return NULL;
     }
@@ -145,6 +149,9 @@ const wxString IO_MGR::ShowType( PCB_FILE_T aType )
 
     case GITHUB:
         return wxString( wxT( "Github" ) );
+
+    case KICAD_CACHED:
+        return wxString( wxT( "KiCad-Cached" ) );
     }
 }
 
@@ -173,6 +180,9 @@ IO_MGR::PCB_FILE_T IO_MGR::EnumFromStr( const wxString& aType )
     if( aType == wxT( "Github" ) )
         return GITHUB;
 
+    if( aType == wxT( "KiCad-Cached" ) )
+        return KICAD_CACHED;
+
     // wxASSERT( blow up here )
 
     return PCB_FILE_T( -1 );
@@ -78,6 +78,7 @@ public:
         PCAD,
         GEDA_PCB,       ///< Geda PCB file formats.
         GITHUB,         ///< Read only http://github.com repo holding pretty footprints
+        KICAD_CACHED,   ///< S-expression Pcbnew file format, with a binary cache of loaded boards.
 
         // add your type here.
 
@@ -50,6 +50,7 @@
 #include <wx/wfstream.h>
 #include <boost/ptr_container/ptr_map.hpp>
 #include <memory.h>
+#include <set>
 
 using namespace PCB_KEYS_T;
 
@@ -88,7 +89,8 @@ class FP_CACHE_ITEM
 {
     wxFileName              m_file_name; ///< The the full file name and path of the footprint to cache.
     wxDateTime              m_mod_time;  ///< The last file modified time stamp.
-    std::auto_ptr<MODULE>   m_module;
+    std::auto_ptr<MODULE>   m_module;    ///< NULL until the footprint file is parsed.
+    bool                    m_dirty;     ///< True until a footprint saved in the cache is written.
 
 public:
     FP_CACHE_ITEM( MODULE* aModule, const wxFileName& aFileName );
@@ -101,15 +103,29 @@ public:
 
     MODULE*     GetModule() const { return m_module.get(); }
     void        UpdateModificationTime() { m_mod_time = m_file_name.GetModificationTime(); }
+
+    /// Tell if the footprint has to be written to its file by FP_CACHE::Save().
+    bool        IsDirty() const { return m_dirty; }
+    void        SetDirty( bool aDirty ) { m_dirty = aDirty; }
+
+    /// Set the footprint parsed from the file as it was at \a aModTime.
+    void        SetModule( MODULE* aModule, const wxDateTime& aModTime )
+    {
+        m_module.reset( aModule );
+        m_mod_time = aModTime;
+    }
 };
 
 
 FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const wxFileName& aFileName ) :
-    m_module( aModule )
+    m_module( aModule ),
+    m_dirty( false )
 {
     m_file_name = aFileName;
 
-    if( m_file_name.FileExists() )
+    // The time stamp of a footprint not parsed yet is taken when it is parsed, this
+    // saves a stat() per footprint when a library is enumerated.
+    if( aModule && m_file_name.FileExists() )
         m_mod_time = m_file_name.GetModificationTime();
     else
         m_mod_time.Now();
@@ -118,8 +134,9 @@ FP_CACHE_ITEM::FP_CACHE_ITEM( MODULE* aModule, const wxFileName& aFileName ) :
 
 bool FP_CACHE_ITEM::IsModified() const
 {
+    // A removed file does not hold the cached footprint anymore.
     if( !m_file_name.FileExists() )
-        return false;
+        return true;
 
     wxLogTrace( traceFootprintLibrary, wxT( "File '%s', m_mod_time %s-%s, file mod time: %s-%s." ),
                 GetChars( m_file_name.GetFullPath() ),
@@ -141,7 +158,7 @@ class FP_CACHE
     PCB_IO*         m_owner;        /// Plugin object that owns the cache.
     wxFileName      m_lib_path;     /// The path of the library.
     wxDateTime      m_mod_time;     /// Footprint library path modified time stamp.
-    MODULE_MAP      m_modules;      /// Map of footprint file name per MODULE*.
+    MODULE_MAP      m_modules;      /// Map of footprint file name per MODULE*, parsed on demand.
 
 public:
     FP_CACHE( PCB_IO* aOwner, const wxString& aLibraryPath );
@@ -155,28 +172,42 @@ public:
     // error codes nor user interface calls from here, nor in any PLUGIN.
     // Catch these exceptions higher up please.
 
-    /// save the entire legacy library to m_lib_name;
+    /**
+     * Function Save
+     * writes the footprints saved in the cache since the last Save() to their files.  The
+     * other footprints are left alone, even when their file was changed or removed by
+     * another program.
+     */
     void Save();
 
+    /**
+     * Function Load
+     * enumerates the footprint files of the library.  The footprints are only parsed
+     * when GetFootprint() asks for them.  Footprints already in the cache are kept, and
+     * the ones whose file was removed are forgotten.
+     */
     void Load();
 
-    void Remove( const wxString& aFootprintName );
-
-    wxDateTime GetLibModificationTime() const;
+    /**
+     * Function Sync
+     * enumerates the library again if its directory has changed since the last Load().
+     */
+    void Sync();
 
     /**
-     * Function IsModified
-     * check if the footprint cache has been modified relative to \a aLibPath
-     * and \a aFootprintName.
+     * Function GetFootprint
+     * returns the footprint \a aFootprintName, parsing its file if it was not parsed
+     * yet or if it has been modified since it was parsed.
      *
-     * @param aLibPath is a path to test the current cache library path against.
-     * @param aFootprintName is the footprint name in the cache to test.  If the footprint
-     *                       name is empty, the all the footprint files in the library are
-     *                       checked to see if they have been modified.
-     * @return true if the cache has been modified.
+     * @return the cached footprint, owned by the cache, or NULL if \a aFootprintName is
+     *         not in the library.
+     * @throw IO_ERROR if the footprint file cannot be parsed.
      */
-    bool IsModified( const wxString& aLibPath,
-                     const wxString& aFootprintName = wxEmptyString ) const;
+    const MODULE* GetFootprint( const wxString& aFootprintName );
+
+    void Remove( const wxString& aFootprintName );
+
+    wxDateTime GetLibModificationTime() const;
 
     /**
      * Function IsPath
@@ -223,11 +254,11 @@ void FP_CACHE::Save()
 
     for( MODULE_ITER it = m_modules.begin();  it != m_modules.end();  ++it )
     {
-        wxFileName fn = it->second->GetFileName();
-
-        if( fn.FileExists() && !it->second->IsModified() )
+        if( !it->second->IsDirty() )
             continue;
 
+        wxFileName fn = it->second->GetFileName();
+
         wxString tempFileName =
 #ifdef USE_TMP_FILE
         fn.CreateTempFileName( fn.GetPath() );
@@ -264,6 +295,7 @@ void FP_CACHE::Save()
         }
 #endif
         it->second->UpdateModificationTime();
+        it->second->SetDirty( false );
         m_mod_time = GetLibModificationTime();
     }
 }
@@ -283,49 +315,91 @@ void FP_CACHE::Load()
         THROW_IO_ERROR( msg );
     }
 
-    wxString fpFileName;
-    wxString wildcard = wxT( "*." ) + KiCadFootprintFileExtension;
+    // Remember the modification time of the library directory before reading it, so that
+    // in a networked environment a footprint added meanwhile is found by the next Sync().
+    m_mod_time = GetLibModificationTime();
+
+    std::set<std::string>   found;
+    wxString                fpFileName;
+    wxString                wildcard = wxT( "*." ) + KiCadFootprintFileExtension;
 
     if( dir.GetFirst( &fpFileName, wildcard, wxDIR_FILES ) )
     {
-        wxString cacheError;
-
         do
         {
             // prepend the libpath into fullPath
-            wxFileName fullPath( m_lib_path.GetPath(), fpFileName );
+            wxFileName  fullPath( m_lib_path.GetPath(), fpFileName );
 
-            // Queue I/O errors so only files that fail to parse don't get loaded.
-            try
-            {
-                FILE_LINE_READER    reader( fullPath.GetFullPath() );
+            // The footprint name is the file name without the extension.
+            std::string name = TO_UTF8( fullPath.GetName() );
 
-                m_owner->m_parser->SetLineReader( &reader );
+            found.insert( name );
 
-                std::string name = TO_UTF8( fullPath.GetName() );
-                MODULE*     footprint = (MODULE*) m_owner->m_parser->Parse();
+            if( m_modules.find( name ) == m_modules.end() )
+                m_modules.insert( name, new FP_CACHE_ITEM( NULL, fullPath ) );
+        } while( dir.GetNext( &fpFileName ) );
+    }
 
-                // The footprint name is the file name without the extension.
-                footprint->SetFPID( FPID( fullPath.GetName() ) );
-                m_modules.insert( name, new FP_CACHE_ITEM( footprint, fullPath ) );
-            }
-            catch( const IO_ERROR& ioe )
-            {
-                if( !cacheError.IsEmpty() )
-                    cacheError += "\n\n";
+    for( MODULE_ITER it = m_modules.begin();  it != m_modules.end();  )
+    {
+        if( found.count( it->first ) )
+            ++it;
+        else
+            m_modules.erase( it++ );
+    }
+}
 
-                cacheError += ioe.errorText;
-            }
-        } while( dir.GetNext( &fpFileName ) );
 
-        // Remember the file modification time of library file when the
-        // cache snapshot was made, so that in a networked environment we will
-        // reload the cache as needed.
-        m_mod_time = GetLibModificationTime();
+void FP_CACHE::Sync()
+{
+    // Adding, removing or renaming a footprint file changes the directory time stamp,
+    // modified footprint files are caught one by one by GetFootprint().
+    if( !m_lib_path.DirExists() || GetLibModificationTime() != m_mod_time )
+    {
+        wxLogTrace( traceFootprintLibrary, wxT( "Footprint library '%s' has changed." ),
+                    GetChars( m_lib_path.GetPath() ) );
+        Load();
+    }
+}
+
+
+const MODULE* FP_CACHE::GetFootprint( const wxString& aFootprintName )
+{
+    MODULE_ITER it = m_modules.find( TO_UTF8( aFootprintName ) );
+
+    if( it == m_modules.end() )
+        return NULL;
+
+    FP_CACHE_ITEM* item = it->second;
+
+    if( item->GetModule() && !item->IsModified() )
+        return item->GetModule();
+
+    wxFileName fn = item->GetFileName();
 
-        if( !cacheError.IsEmpty() )
-            THROW_IO_ERROR( cacheError );
+    if( !fn.FileExists() )
+    {
+        // Removed since the library was enumerated.
+        m_modules.erase( it );
+        return NULL;
     }
+
+    wxLogTrace( traceFootprintLibrary, wxT( "Parsing footprint file '%s'." ),
+                GetChars( fn.GetFullPath() ) );
+
+    // Take the time stamp first, a change made while parsing is caught next time.
+    wxDateTime          modTime = fn.GetModificationTime();
+    FILE_LINE_READER    reader( fn.GetFullPath() );
+
+    m_owner->m_parser->SetLineReader( &reader );
+
+    MODULE* footprint = (MODULE*) m_owner->m_parser->Parse();
+
+    // The footprint name is the file name without the extension.
+    footprint->SetFPID( FPID( fn.GetName() ) );
+    item->SetModule( footprint, modTime );
+
+    return footprint;
 }
 
 
@@ -362,52 +436,6 @@ bool FP_CACHE::IsPath( const wxString& aPath ) const
 }
 
 
-bool FP_CACHE::IsModified( const wxString& aLibPath, const wxString& aFootprintName ) const
-{
-    // The library is modified if the library path got deleted or changed.
-    if( !m_lib_path.DirExists() || !IsPath( aLibPath ) )
-        return true;
-
-    // If no footprint was specified, check every file modification time against the time
-    // it was loaded.
-    if( aFootprintName.IsEmpty() )
-    {
-        for( MODULE_CITER it = m_modules.begin();  it != m_modules.end();  ++it )
-        {
-            wxFileName fn = m_lib_path;
-
-            fn.SetName( it->second->GetFileName().GetName() );
-            fn.SetExt( KiCadFootprintFileExtension );
-
-            if( !fn.FileExists() )
-            {
-                wxLogTrace( traceFootprintLibrary,
-                            wxT( "Footprint cache file '%s' does not exist." ),
-                            fn.GetFullPath().GetData() );
-                return true;
-            }
-
-            if( it->second->IsModified() )
-            {
-                wxLogTrace( traceFootprintLibrary,
-                            wxT( "Footprint cache file '%s' has been modified." ),
-                            fn.GetFullPath().GetData() );
-                return true;
-            }
-        }
-    }
-    else
-    {
-        MODULE_CITER it = m_modules.find( TO_UTF8( aFootprintName ) );
-
-        if( it == m_modules.end() || it->second->IsModified() )
-            return true;
-    }
-
-    return false;
-}
-
-
 void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* aProperties )
 {
     LOCALE_IO   toggle;     // toggles on, then off, the C locale.
@@ -770,11 +798,14 @@ void PCB_IO::format( BOARD* aBoard, int aNestLevel ) const
     // Do not save MARKER_PCBs, they can be regenerated easily.
 
     // Save the tracks and vias.
-    for( TRACK* track = aBoard->m_Track;  track; track = track->Next() )
-        Format( track, aNestLevel );
+    if( !( m_ctl & CTL_OMIT_TRACKS ) )
+    {
+        for( TRACK* track = aBoard->m_Track;  track; track = track->Next() )
+            Format( track, aNestLevel );
 
-    if( aBoard->m_Track.GetCount() )
-        m_out->Print( 0, "\n" );
+        if( aBoard->m_Track.GetCount() )
+            m_out->Print( 0, "\n" );
+    }
 
     /// @todo Add warning here that the old segment filed zones are no longer supported and
     ///       will not be saved.
@@ -1645,19 +1676,20 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
     const SHAPE_POLY_SET& fv = aZone->GetFilledPolysList();
     newLine = 0;
 
-    if( !fv.IsEmpty() )
+    if( !fv.IsEmpty() && !( m_ctl & CTL_OMIT_ZONE_FILLS ) )
     {
         m_out->Print( aNestLevel+1, "(filled_polygon\n" );
         m_out->Print( aNestLevel+2, "(pts\n" );
 
+        // Fills can have a huge number of points: a line of points is formatted
+        // here, and printed at once
+        std::string line;
+
         for( SHAPE_POLY_SET::CONST_ITERATOR it = fv.CIterate(); it; ++it )
         {
-            if( newLine == 0 )
-                m_out->Print( aNestLevel+3, "(xy %s %s)",
-                              FMT_IU( it->x ).c_str(), FMT_IU( it->y ).c_str() );
-            else
-                m_out->Print( 0, " (xy %s %s)",
-                              FMT_IU( it->x ) .c_str(), FMT_IU( it->y ).c_str() );
+            line += newLine == 0 ? "(xy " : " (xy ";
+            line += FMT_IU( wxPoint( it->x, it->y ) );
+            line += ')';
 
             if( newLine < 4 )
             {
@@ -1666,13 +1698,17 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
             else
             {
                 newLine = 0;
-                m_out->Print( 0, "\n" );
+                m_out->Print( aNestLevel+3, "%s\n", line.c_str() );
+                line.clear();
             }
 
             if( it.IsEndContour() )
             {
                 if( newLine != 0 )
-                    m_out->Print( 0, "\n" );
+                {
+                    m_out->Print( aNestLevel+3, "%s\n", line.c_str() );
+                    line.clear();
+                }
 
                 m_out->Print( aNestLevel+2, ")\n" );
 
@@ -1692,7 +1728,7 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
     // Save the filling segments list
     const std::vector< SEGMENT >& segs = aZone->FillSegments();
 
-    if( segs.size() )
+    if( segs.size() && !( m_ctl & CTL_OMIT_ZONE_FILLS ) )
     {
         m_out->Print( aNestLevel+1, "(fill_segments\n" );
 
@@ -1729,20 +1765,63 @@ PCB_IO::~PCB_IO()
 }
 
 
+void PCB_IO::readFile( const wxString& aFileName, std::string& aText ) throw( IO_ERROR )
+{
+    FILE* fp = wxFopen( aFileName, wxT( "rb" ) );
+
+    if( !fp )
+    {
+        wxString msg = wxString::Format(
+            _( "Unable to open filename '%s' for reading" ), aFileName.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+    fseek( fp, 0, SEEK_END );
+    long size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+
+    if( size > 0 )
+    {
+        aText.resize( size );
+
+        if( fread( &aText[0], 1, size, fp ) != (size_t) size )
+        {
+            fclose( fp );
+
+            wxString msg = wxString::Format(
+                _( "Unable to read file '%s'" ), aFileName.GetData() );
+            THROW_IO_ERROR( msg );
+        }
+    }
+
+    fclose( fp );
+}
+
+
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
+    // The board is read at once, so that its footprints, tracks and zones can be
+    // parsed in parallel.
+    std::string text;
+
+    readFile( aFileName, text );
+
+    return parseText( text, aFileName, aAppendToMe, aProperties );
+}
+
 
+BOARD* PCB_IO::parseText( const std::string& aText, const wxString& aFileName,
+                          BOARD* aAppendToMe, const PROPERTIES* aProperties )
+{
     init( aProperties );
 
-    m_parser->SetLineReader( &reader );
     m_parser->SetBoard( aAppendToMe );
 
     BOARD* board;
 
     try
     {
-        board = dynamic_cast<BOARD*>( m_parser->Parse() );
+        board = dynamic_cast<BOARD*>( m_parser->Parse( aText, aFileName ) );
     }
     catch( const FUTURE_FORMAT_ERROR& parse_error )
     {
@@ -1776,15 +1855,19 @@ void PCB_IO::init( const PROPERTIES* aProperties )
 }
 
 
-void PCB_IO::cacheLib( const wxString& aLibraryPath, const wxString& aFootprintName )
+void PCB_IO::cacheLib( const wxString& aLibraryPath )
 {
-    if( !m_cache || m_cache->IsModified( aLibraryPath, aFootprintName ) )
+    if( !m_cache || !m_cache->IsPath( aLibraryPath ) )
     {
         // a spectacular episode in memory management:
         delete m_cache;
         m_cache = new FP_CACHE( this, aLibraryPath );
         m_cache->Load();
     }
+    else
+    {
+        m_cache->Sync();
+    }
 }
 
 
@@ -1803,29 +1886,15 @@ wxArrayString PCB_IO::FootprintEnumerate( const wxString&   aLibraryPath,
 
     init( aProperties );
 
-#if 1                         // Set to 0 to only read directory contents, not load cache.
+    // Caching the library only reads the directory, the footprints are parsed on demand.
     cacheLib( aLibraryPath );
 
     const MODULE_MAP& mods = m_cache->GetModules();
 
-
     for( MODULE_CITER it = mods.begin();  it != mods.end();  ++it )
     {
         ret.Add( FROM_UTF8( it->first.c_str() ) );
     }
-#else
-    wxString fpFileName;
-    wxString wildcard = wxT( "*." ) + KiCadFootprintFileExtension;
-
-    if( dir.GetFirst( &fpFileName, wildcard, wxDIR_FILES ) )
-    {
-        do
-        {
-            wxFileName fn( aLibraryPath, fpFileName );
-            ret.Add( fn.GetName() );
-        } while( dir.GetNext( &fpFileName ) );
-    }
-#endif
 
     return ret;
 }
@@ -1838,19 +1907,17 @@ MODULE* PCB_IO::FootprintLoad( const wxString& aLibraryPath, const wxString& aFo
 
     init( aProperties );
 
-    cacheLib( aLibraryPath, aFootprintName );
-
-    const MODULE_MAP& mods = m_cache->GetModules();
+    cacheLib( aLibraryPath );
 
-    MODULE_CITER it = mods.find( TO_UTF8( aFootprintName ) );
+    const MODULE* footprint = m_cache->GetFootprint( aFootprintName );
 
-    if( it == mods.end() )
+    if( !footprint )
     {
         return NULL;
     }
 
     // copy constructor to clone the already loaded MODULE
-    return new MODULE( *it->second->GetModule() );
+    return new MODULE( *footprint );
 }
 
 
@@ -1920,7 +1987,10 @@ void PCB_IO::FootprintSave( const wxString& aLibraryPath, const MODULE* aFootpri
 
     wxLogTrace( traceFootprintLibrary, wxT( "Creating s-expression footprint file: %s." ),
                 fn.GetFullPath().GetData() );
-    mods.insert( footprintName, new FP_CACHE_ITEM( module, fn ) );
+    FP_CACHE_ITEM* item = new FP_CACHE_ITEM( module, fn );
+
+    item->SetDirty( true );
+    mods.insert( footprintName, item );
     m_cache->Save();
 }
 
@@ -48,6 +48,8 @@ class NETINFO_MAPPING;
 #define CTL_OMIT_INITIAL_COMMENTS   (1 << 3)    ///< omit MODULE initial comments
 #define CTL_OMIT_PATH               (1 << 4)    ///< Omit component sheet time stamp (useless in library)
 #define CTL_OMIT_AT                 (1 << 5)    ///< Omit position and rotation
+#define CTL_OMIT_TRACKS             (1 << 6)    ///< Omit tracks and vias (board cache head)
+#define CTL_OMIT_ZONE_FILLS         (1 << 7)    ///< Omit zone filled polygons and fill segments
                                                 // (always saved with potion 0,0 and rotation = 0 in library)
 
 
@@ -179,10 +181,24 @@ protected:
                                     ///< are stored with consecutive integers as net codes
 
     /// we only cache one footprint library, this determines which one.
-    void cacheLib( const wxString& aLibraryPath, const wxString& aFootprintName = wxEmptyString );
+    void cacheLib( const wxString& aLibraryPath );
 
     void init( const PROPERTIES* aProperties );
 
+    /**
+     * Function readFile
+     * reads the whole content of \a aFileName into \a aText.
+     * @throw IO_ERROR if the file cannot be read.
+     */
+    static void readFile( const wxString& aFileName, std::string& aText ) throw( IO_ERROR );
+
+    /**
+     * Function parseText
+     * parses the board held in \a aText, the content of \a aFileName, as Load() does.
+     */
+    BOARD* parseText( const std::string& aText, const wxString& aFileName,
+                      BOARD* aAppendToMe, const PROPERTIES* aProperties );
+
 private:
     void format( BOARD* aBoard, int aNestLevel = 0 ) const
         throw( IO_ERROR );
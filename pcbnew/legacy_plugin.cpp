@@ -429,7 +429,7 @@ BOARD* LEGACY_PLUGIN::Load( const wxString& aFileName, BOARD* aAppendToMe,
     // delete on exception, iff I own m_board, according to aAppendToMe
     auto_ptr<BOARD> deleter( aAppendToMe ? NULL : m_board );
 
-    FILE_LINE_READER    reader( aFileName );
+    MMAP_LINE_READER    reader( aFileName );
 
     m_reader = &reader;          // member function accessibility
 
@@ -4307,7 +4307,7 @@ wxDateTime LP_CACHE::GetLibModificationTime()
 
 void LP_CACHE::Load()
 {
-    FILE_LINE_READER    reader( m_lib_path );
+    MMAP_LINE_READER    reader( m_lib_path );
 
     ReadAndVerifyHeader( &reader );
     SkipIndex( &reader );
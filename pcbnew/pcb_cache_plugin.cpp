@@ -0,0 +1,594 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcb_cache_plugin.cpp
+ * @brief KiCad board plugin keeping a binary cache of loaded boards.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+
+#include <fctsys.h>
+#include <common.h>
+#include <build_version.h>
+#include <macros.h>
+#include <class_board.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <pcb_cache_plugin.h>
+#include <wx/filename.h>
+
+
+static const wxChar traceBoardCache[] = wxT( "KicadBoardCache" );
+
+static const uint32_t CACHE_MAGIC = 0x4B504342;         // "KPCB"
+
+/// Bump this when the layout of the cache file changes.
+static const uint32_t CACHE_FORMAT_VERSION = 1;
+
+/// Written in native byte order, to reject a cache copied from another architecture.
+static const uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+static const uint32_t CACHE_END_MARK = 0x454E4421;      // "END!"
+
+enum CACHE_TRACK_T
+{
+    CACHE_TRACK,
+    CACHE_VIA
+};
+
+
+/**
+ * Class BOARD_CACHE_WRITER
+ * accumulates the binary part of a board cache in memory.
+ */
+class BOARD_CACHE_WRITER
+{
+public:
+    template <typename T>
+    void Write( T aValue )
+    {
+        m_data.append( (const char*) &aValue, sizeof( aValue ) );
+    }
+
+    void WriteString( const std::string& aString )
+    {
+        Write<uint32_t>( aString.size() );
+        m_data.append( aString );
+    }
+
+    void WritePoint( const wxPoint& aPoint )
+    {
+        Write<int32_t>( aPoint.x );
+        Write<int32_t>( aPoint.y );
+    }
+
+    const std::string& GetData() const { return m_data; }
+
+private:
+    std::string m_data;
+};
+
+
+/**
+ * Class BOARD_CACHE_READER
+ * reads back the data of a BOARD_CACHE_WRITER.
+ * @throw IO_ERROR when reading past the end of the data, so a truncated or damaged
+ *        cache is detected.
+ */
+class BOARD_CACHE_READER
+{
+public:
+    BOARD_CACHE_READER( const std::string& aData ) :
+        m_pos( aData.data() ),
+        m_end( aData.data() + aData.size() )
+    {
+    }
+
+    template <typename T>
+    T Read() throw( IO_ERROR )
+    {
+        T value;
+
+        need( sizeof( value ) );
+        memcpy( &value, m_pos, sizeof( value ) );
+        m_pos += sizeof( value );
+
+        return value;
+    }
+
+    std::string ReadString() throw( IO_ERROR )
+    {
+        uint32_t size = Read<uint32_t>();
+
+        need( size );
+        std::string ret( m_pos, size );
+        m_pos += size;
+
+        return ret;
+    }
+
+    wxPoint ReadPoint() throw( IO_ERROR )
+    {
+        int x = Read<int32_t>();
+        int y = Read<int32_t>();
+
+        return wxPoint( x, y );
+    }
+
+    /**
+     * Function ReadCount
+     * reads the count of the items which follow, each one at least \a aItemSize bytes long,
+     * and checks it against the remaining data before anything is allocated for them.
+     */
+    uint32_t ReadCount( size_t aItemSize ) throw( IO_ERROR )
+    {
+        uint32_t count = Read<uint32_t>();
+
+        if( count > size_t( m_end - m_pos ) / aItemSize )
+            THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+        return count;
+    }
+
+private:
+    void need( size_t aSize ) throw( IO_ERROR )
+    {
+        if( aSize > size_t( m_end - m_pos ) )
+            THROW_IO_ERROR( _( "Damaged board cache" ) );
+    }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+
+/**
+ * Function hashText
+ * returns a 64 bits FNV-1a like hash of \a aText, consuming eight bytes at a time.
+ */
+static uint64_t hashText( const std::string& aText )
+{
+    const uint64_t  prime = 0x100000001B3ULL;
+    uint64_t        hash  = 0xCBF29CE484222325ULL;
+    const char*     p     = aText.data();
+    size_t          left  = aText.size();
+
+    for( ; left >= sizeof( uint64_t ); left -= sizeof( uint64_t ), p += sizeof( uint64_t ) )
+    {
+        uint64_t word;
+
+        memcpy( &word, p, sizeof( word ) );
+        hash = ( hash ^ word ) * prime;
+        hash ^= hash >> 32;
+    }
+
+    for( ; left; --left, ++p )
+        hash = ( hash ^ (unsigned char) *p ) * prime;
+
+    return hash;
+}
+
+
+/**
+ * Function fileStamp
+ * gets the size and the modification time of \a aFileName.
+ * @return false if the file does not exist.
+ */
+static bool fileStamp( const wxString& aFileName, uint64_t& aSize, int64_t& aTime )
+{
+    wxFileName fn( aFileName );
+
+    // Do not call wxFileName::GetModificationTime() on a non-existent file.
+    if( !fn.FileExists() )
+        return false;
+
+    aSize = fn.GetSize().GetValue();
+    aTime = fn.GetModificationTime().GetValue().GetValue();
+
+    return true;
+}
+
+
+PCB_CACHE_PLUGIN::PCB_CACHE_PLUGIN() :
+    PCB_IO( CTL_FOR_BOARD )
+{
+}
+
+
+BOARD* PCB_CACHE_PLUGIN::Load( const wxString& aFileName, BOARD* aAppendToMe,
+                               const PROPERTIES* aProperties )
+{
+    // Appending merges the loaded items into an existing board, only the parser does that.
+    if( aAppendToMe )
+        return PCB_IO::Load( aFileName, aAppendToMe, aProperties );
+
+    uint64_t    size = 0;
+    int64_t     time = 0;
+
+    if( !fileStamp( aFileName, size, time ) )
+        return PCB_IO::Load( aFileName, NULL, aProperties );    // reports the error
+
+    // The board file is read to check the cache, and parsed only when the cache is stale.
+    std::string text;
+    bool        rekey = false;
+    wxString    cacheName = aFileName + BOARD_CACHE_FILE_SUFFIX;
+    BOARD*      board = loadCache( aFileName, size, time, cacheName, aProperties, text, rekey );
+
+    if( board )
+    {
+        // The board file was touched, but not changed: store its new time in the key.
+        if( rekey )
+            saveCache( board, text, size, time, cacheName );
+
+        return board;
+    }
+
+    if( text.empty() )
+        readFile( aFileName, text );
+
+    board = parseText( text, aFileName, NULL, aProperties );
+
+    saveCache( board, text, size, time, cacheName );
+
+    return board;
+}
+
+
+BOARD* PCB_CACHE_PLUGIN::loadCache( const wxString& aFileName, uint64_t aSize, int64_t aTime,
+                                    const wxString& aCacheName, const PROPERTIES* aProperties,
+                                    std::string& aText, bool& aRekey )
+{
+    if( !wxFileName::FileExists( aCacheName ) )
+        return NULL;
+
+    std::string data;
+    BOARD*      board = NULL;
+
+    try
+    {
+        readFile( aCacheName, data );
+
+        BOARD_CACHE_READER in( data );
+
+        if( in.Read<uint32_t>() != CACHE_MAGIC
+            || in.Read<uint32_t>() != CACHE_FORMAT_VERSION
+            || in.Read<uint32_t>() != CACHE_BYTE_ORDER
+            || in.ReadString() != std::string( TO_UTF8( GetBuildVersion() ) )
+            || in.Read<int32_t>() != SEXPR_BOARD_FILE_VERSION
+            || in.Read<uint64_t>() != aSize )
+        {
+            wxLogTrace( traceBoardCache, wxT( "Stale board cache %s" ), GetChars( aCacheName ) );
+            return NULL;
+        }
+
+        int64_t     time = in.Read<int64_t>();
+        uint64_t    hash = in.Read<uint64_t>();
+
+        // The size and the time do not prove the board file is unchanged: it can be
+        // rewritten within the resolution of the time stamp, or get its old time back
+        // (e.g. by a copy).  Its content decides, reading and hashing it is still much
+        // faster than parsing it.
+        readFile( aFileName, aText );
+
+        if( aText.size() != aSize || hashText( aText ) != hash )
+        {
+            wxLogTrace( traceBoardCache, wxT( "Stale board cache %s" ), GetChars( aCacheName ) );
+            return NULL;
+        }
+
+        // The board file was touched only, e.g. by a checkout or a copy
+        aRekey = time != aTime;
+
+        int formatVersion = in.Read<int32_t>();
+
+        // The board, except its tracks and zone fills
+        board = parseText( in.ReadString(), aFileName, NULL, aProperties );
+
+        // Net codes of the cache to the net codes of the loaded board
+        std::vector<int> netCodes( in.ReadCount( sizeof( uint32_t ) ) );
+
+        for( unsigned i = 0; i < netCodes.size(); ++i )
+        {
+            wxString netname = FROM_UTF8( in.ReadString().c_str() );
+
+            if( i == 0 )
+            {
+                netCodes[i] = NETINFO_LIST::UNCONNECTED;
+                continue;
+            }
+
+            NETINFO_ITEM* net = board->FindNet( netname );
+
+            if( !net )
+                THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+            netCodes[i] = net->GetNet();
+        }
+
+        // Tracks and vias
+        for( uint32_t count = in.ReadCount( 9 * sizeof( int32_t ) ); count; --count )
+        {
+            uint8_t                 type = in.Read<uint8_t>();
+            std::auto_ptr<TRACK>    track;
+
+            if( type == CACHE_VIA )
+            {
+                VIA* via = new VIA( board );
+
+                track.reset( via );
+                via->SetStart( in.ReadPoint() );
+                via->SetEnd( via->GetStart() );
+                via->SetWidth( in.Read<int32_t>() );
+                via->SetViaType( (VIATYPE_T) in.Read<int32_t>() );
+
+                int top    = in.Read<int32_t>();
+                int bottom = in.Read<int32_t>();
+
+                if( unsigned( top ) >= LAYER_ID_COUNT || unsigned( bottom ) >= LAYER_ID_COUNT )
+                    THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+                via->SetLayerPair( LAYER_ID( top ), LAYER_ID( bottom ) );
+                via->SetDrill( in.Read<int32_t>() );
+            }
+            else if( type == CACHE_TRACK )
+            {
+                track.reset( new TRACK( board ) );
+                track->SetStart( in.ReadPoint() );
+                track->SetEnd( in.ReadPoint() );
+                track->SetWidth( in.Read<int32_t>() );
+
+                int layer = in.Read<int32_t>();
+
+                if( unsigned( layer ) >= LAYER_ID_COUNT )
+                    THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+                track->SetLayer( LAYER_ID( layer ) );
+            }
+            else
+            {
+                THROW_IO_ERROR( _( "Damaged board cache" ) );
+            }
+
+            uint32_t net = in.Read<uint32_t>();
+
+            if( net >= netCodes.size() )
+                THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+            track->SetNetCode( netCodes[net], /* aNoAssert */ true );
+            track->SetTimeStamp( (time_t) in.Read<int64_t>() );
+            track->SetStatus( (STATUS_FLAGS) in.Read<uint32_t>() );
+
+            board->Add( track.release(), ADD_APPEND );
+        }
+
+        // Zone fills, in the order of the zones of the board
+        if( in.Read<uint32_t>() != (uint32_t) board->GetAreaCount() )
+            THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+        for( int ii = 0; ii < board->GetAreaCount(); ++ii )
+        {
+            ZONE_CONTAINER* zone = board->GetArea( ii );
+            SHAPE_POLY_SET  polys;
+
+            for( uint32_t outline = in.ReadCount( sizeof( uint32_t ) ); outline; --outline )
+            {
+                polys.NewOutline();
+
+                for( uint32_t count = in.ReadCount( 2 * sizeof( int32_t ) ); count; --count )
+                {
+                    int x = in.Read<int32_t>();
+                    int y = in.Read<int32_t>();
+
+                    polys.Append( x, y );
+                }
+            }
+
+            if( !polys.IsEmpty() )
+                zone->AddFilledPolysList( polys );
+
+            std::vector<SEGMENT> segs( in.ReadCount( 4 * sizeof( int32_t ) ) );
+
+            for( unsigned i = 0; i < segs.size(); ++i )
+            {
+                segs[i].m_Start = in.ReadPoint();
+                segs[i].m_End   = in.ReadPoint();
+            }
+
+            if( segs.size() )
+                zone->AddFillSegments( segs );
+        }
+
+        if( in.Read<uint32_t>() != CACHE_END_MARK )
+            THROW_IO_ERROR( _( "Damaged board cache" ) );
+
+        board->SetFileFormatVersionAtLoad( formatVersion );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogTrace( traceBoardCache, wxT( "Unable to load board cache %s: %s" ),
+                    GetChars( aCacheName ), GetChars( ioe.errorText ) );
+        delete board;
+        return NULL;
+    }
+
+    wxLogTrace( traceBoardCache, wxT( "Board loaded from cache %s" ), GetChars( aCacheName ) );
+
+    return board;
+}
+
+
+void PCB_CACHE_PLUGIN::saveCache( BOARD* aBoard, const std::string& aText,
+                                  uint64_t aSize, int64_t aTime, const wxString& aCacheName )
+{
+    // The board file was changed while it was read: its key is unknown.
+    if( aText.size() != aSize )
+        return;
+
+    BOARD_CACHE_WRITER out;
+
+    out.Write<uint32_t>( CACHE_MAGIC );
+    out.Write<uint32_t>( CACHE_FORMAT_VERSION );
+    out.Write<uint32_t>( CACHE_BYTE_ORDER );
+    out.WriteString( TO_UTF8( GetBuildVersion() ) );
+    out.Write<int32_t>( SEXPR_BOARD_FILE_VERSION );
+    out.Write<uint64_t>( aSize );
+    out.Write<int64_t>( aTime );
+    out.Write<uint64_t>( hashText( aText ) );
+    out.Write<int32_t>( aBoard->GetFileFormatVersionAtLoad() );
+
+    // Format the board without its tracks and zone fills, they are stored in binary below.
+    STRING_FORMATTER    head;
+    int                 ctl = m_ctl;
+
+    m_board = aBoard;
+    m_mapping->SetBoard( aBoard );
+    m_out = &head;
+    m_ctl |= CTL_OMIT_TRACKS | CTL_OMIT_ZONE_FILLS;
+
+    try
+    {
+        head.Print( 0, "(kicad_pcb (version %d) (host pcbnew %s)\n", SEXPR_BOARD_FILE_VERSION,
+                    head.Quotew( GetBuildVersion() ).c_str() );
+
+        Format( aBoard, 1 );
+
+        head.Print( 0, ")\n" );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        m_ctl = ctl;
+        wxLogTrace( traceBoardCache, wxT( "Unable to format board cache %s: %s" ),
+                    GetChars( aCacheName ), GetChars( ioe.errorText ) );
+        return;
+    }
+
+    m_ctl = ctl;
+
+    out.WriteString( head.GetString() );
+
+    // Net names, in the order of the net codes of the head
+    out.Write<uint32_t>( m_mapping->GetSize() );
+
+    for( NETINFO_MAPPING::iterator net = m_mapping->begin(), netEnd = m_mapping->end();
+            net != netEnd; ++net )
+    {
+        out.WriteString( TO_UTF8( net->GetNetname() ) );
+    }
+
+    // Tracks and vias
+    out.Write<uint32_t>( aBoard->m_Track.GetCount() );
+
+    for( TRACK* track = aBoard->m_Track;  track;  track = track->Next() )
+    {
+        if( track->Type() == PCB_VIA_T )
+        {
+            const VIA*  via = static_cast<const VIA*>( track );
+            LAYER_ID    top, bottom;
+
+            via->LayerPair( &top, &bottom );
+
+            out.Write<uint8_t>( CACHE_VIA );
+            out.WritePoint( via->GetStart() );
+            out.Write<int32_t>( via->GetWidth() );
+            out.Write<int32_t>( via->GetViaType() );
+            out.Write<int32_t>( top );
+            out.Write<int32_t>( bottom );
+            out.Write<int32_t>( via->GetDrill() );
+        }
+        else
+        {
+            out.Write<uint8_t>( CACHE_TRACK );
+            out.WritePoint( track->GetStart() );
+            out.WritePoint( track->GetEnd() );
+            out.Write<int32_t>( track->GetWidth() );
+            out.Write<int32_t>( track->GetLayer() );
+        }
+
+        out.Write<uint32_t>( m_mapping->Translate( track->GetNetCode() ) );
+        out.Write<int64_t>( track->GetTimeStamp() );
+        out.Write<uint32_t>( track->GetStatus() );
+    }
+
+    // Zone fills
+    out.Write<uint32_t>( aBoard->GetAreaCount() );
+
+    for( int ii = 0; ii < aBoard->GetAreaCount(); ++ii )
+    {
+        const ZONE_CONTAINER*   zone = aBoard->GetArea( ii );
+        const SHAPE_POLY_SET&   polys = zone->GetFilledPolysList();
+
+        out.Write<uint32_t>( polys.OutlineCount() );
+
+        for( int outline = 0; outline < polys.OutlineCount(); ++outline )
+        {
+            const SHAPE_LINE_CHAIN& chain = polys.COutline( outline );
+
+            out.Write<uint32_t>( chain.PointCount() );
+
+            for( int i = 0; i < chain.PointCount(); ++i )
+            {
+                out.Write<int32_t>( chain.CPoint( i ).x );
+                out.Write<int32_t>( chain.CPoint( i ).y );
+            }
+        }
+
+        const std::vector<SEGMENT>& segs = zone->FillSegments();
+
+        out.Write<uint32_t>( segs.size() );
+
+        for( unsigned i = 0; i < segs.size(); ++i )
+        {
+            out.WritePoint( segs[i].m_Start );
+            out.WritePoint( segs[i].m_End );
+        }
+    }
+
+    out.Write<uint32_t>( CACHE_END_MARK );
+
+    // Write a temporary file renamed at the end, so a reader never sees a partial cache.
+    wxString    tempName = aCacheName + wxT( ".tmp" );
+    bool        ok = false;
+
+    {
+        wxLogNull   noLog;      // a cache which cannot be written is not an error
+        FILE*       fp = wxFopen( tempName, wxT( "wb" ) );
+
+        if( !fp )
+            return;
+
+        const std::string& data = out.GetData();
+
+        ok = fwrite( data.data(), 1, data.size(), fp ) == data.size();
+        ok = ( fclose( fp ) == 0 ) && ok;
+        ok = ok && wxRenameFile( tempName, aCacheName, true );
+
+        if( !ok )
+            wxRemoveFile( tempName );
+    }
+
+    if( ok )
+        wxLogTrace( traceBoardCache, wxT( "Board cache %s written" ), GetChars( aCacheName ) );
+}
@@ -0,0 +1,100 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcb_cache_plugin.h
+ * @brief KiCad board plugin keeping a binary cache of loaded boards.
+ */
+
+#ifndef PCB_CACHE_PLUGIN_H_
+#define PCB_CACHE_PLUGIN_H_
+
+#include <stdint.h>
+
+#include <kicad_plugin.h>
+
+
+/// Extension appended to the board file name to build the cache file name.
+#define BOARD_CACHE_FILE_SUFFIX     wxT( "-cache" )
+
+
+/**
+ * Class PCB_CACHE_PLUGIN
+ * is a PCB_IO derivation which keeps a binary sidecar cache of every board it loads.
+ *
+ * The cache file (the board file name followed by #BOARD_CACHE_FILE_SUFFIX) holds the
+ * board without its tracks and zone fills in s-expression format, and the tracks, vias
+ * and zone fills, which are the bulk of a large board, as binary records.  The cache is
+ * keyed by the size, the modification time and the hash of the board file content, and
+ * by the version of Pcbnew which wrote it.  The board file is always read and hashed, but
+ * it is parsed only when the cache is stale; a cache matching only another time of the
+ * board file gets the new time.  A stale cache is simply rebuilt from the board file.
+ *
+ * Saving is done by PCB_IO, in the s-expression format.
+ *
+ * @note This class is not thread safe, but it is re-entrant multiple times in sequence.
+ */
+class PCB_CACHE_PLUGIN : public PCB_IO
+{
+public:
+
+    //-----<PLUGIN API>---------------------------------------------------------
+
+    const wxString PluginName() const
+    {
+        return wxT( "KiCad-Cached" );
+    }
+
+    BOARD* Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties = NULL );
+
+    //-----</PLUGIN API>--------------------------------------------------------
+
+    PCB_CACHE_PLUGIN();
+
+private:
+
+    /**
+     * Function loadCache
+     * loads the board from \a aCacheName, the cache of \a aFileName, which is \a aSize
+     * bytes long and was modified at \a aTime.
+     *
+     * @param aText receives the content of \a aFileName if the cache header is valid,
+     *  and is left empty otherwise.
+     * @param aRekey is set to true if the cache is valid for another modification time.
+     * @return BOARD* - the board, or NULL if the cache is missing, stale or damaged.
+     */
+    BOARD* loadCache( const wxString& aFileName, uint64_t aSize, int64_t aTime,
+                      const wxString& aCacheName, const PROPERTIES* aProperties,
+                      std::string& aText, bool& aRekey );
+
+    /**
+     * Function saveCache
+     * writes \a aCacheName, the cache of \a aBoard loaded from \a aText, the content of
+     * a board file of size \a aSize modified at \a aTime.  Errors are ignored: the
+     * cache is simply rebuilt at the next load.
+     */
+    void saveCache( BOARD* aBoard, const std::string& aText, uint64_t aSize, int64_t aTime,
+                    const wxString& aCacheName );
+};
+
+#endif  // PCB_CACHE_PLUGIN_H_
@@ -197,6 +197,17 @@ public:
     /// @copydoc PAINTER::Draw()
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer );
 
+    /// @copydoc PAINTER::Clone()
+    virtual PAINTER* Clone( GAL* aGal ) const
+    {
+        PCB_PAINTER* painter = new PCB_PAINTER( aGal );
+
+        painter->m_pcbSettings = m_pcbSettings;
+        painter->m_brightenedColor = m_brightenedColor;
+
+        return painter;
+    }
+
 protected:
     PCB_RENDER_SETTINGS m_pcbSettings;
 
@@ -52,7 +52,12 @@
 #include <zones.h>
 #include <pcb_parser.h>
 
+#include <job_scheduler.h>
+
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 
 using namespace PCB_KEYS_T;
 
@@ -125,13 +130,82 @@ void PCB_PARSER::pushValueIntoMap( int aIndex, int aValue )
     m_netCodes[aIndex] = aValue;
 }
 
+/**
+ * Function parseFixedPoint
+ * converts aText, a fixed point number like "-12.345", without strtod(), which
+ * is slow and locale dependent.  The result is the one of strtod(): the digits and
+ * the power of ten are both exact doubles, so their quotient is correctly rounded.
+ *
+ * @return false if aText is not a fixed point number which can be converted exactly,
+ *  e.g. it has an exponent or too many digits.  Use strtod() then.
+ */
+static bool parseFixedPoint( const char* aText, double* aValue )
+{
+    static const double powersOf10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Above this, another digit could make the mantissa bigger than 2^53
+    const unsigned long long maxMantissa = 900719925474099ULL;
+
+    const char*         cp = aText;
+    bool                negative = false;
+    bool                sawDigit = false;
+    bool                sawDot = false;
+    unsigned long long  mantissa = 0;
+    unsigned            decimals = 0;
+
+    if( *cp == '-' || *cp == '+' )
+        negative = *cp++ == '-';
+
+    for( ; *cp; ++cp )
+    {
+        if( *cp >= '0' && *cp <= '9' )
+        {
+            if( mantissa >= maxMantissa )
+                return false;
+
+            mantissa = mantissa * 10 + ( *cp - '0' );
+            sawDigit = true;
+
+            if( sawDot )
+                ++decimals;
+        }
+        else if( *cp == '.' && !sawDot )
+        {
+            sawDot = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if( !sawDigit || decimals >= DIM( powersOf10 ) )
+        return false;
+
+    double value = mantissa / powersOf10[decimals];
+
+    *aValue = negative ? -value : value;
+
+    return true;
+}
+
+
 double PCB_PARSER::parseDouble() throw( IO_ERROR )
 {
     char* tmp;
+    double fval;
+
+    // Nearly all the numbers of a board file are plain fixed point numbers
+    if( parseFixedPoint( CurText(), &fval ) )
+        return fval;
 
     errno = 0;
 
-    double fval = strtod( CurText(), &tmp );
+    fval = strtod( CurText(), &tmp );
 
     if( errno )
     {
@@ -408,6 +482,475 @@ S3D_MASTER* PCB_PARSER::parse3DModel() throw( PARSE_ERROR, IO_ERROR )
 }
 
 
+/// The approximate size, in bytes, of the text parsed by a job of parseSections()
+#define SECTION_JOB_SIZE    65536
+
+
+/**
+ * Class SECTION_LINE_READER
+ * reads the lines of a text in memory, from any position of the text, and up to
+ * any position.  Used to parse the sections of a board file separately.
+ */
+class SECTION_LINE_READER : public LINE_READER
+{
+public:
+    SECTION_LINE_READER( const std::string& aText, const wxString& aSource ) :
+        m_text( aText ),
+        m_offset( 0 ),
+        m_end( aText.size() ),
+        m_lineOffset( 0 )
+    {
+        source = aSource;
+    }
+
+    char* ReadLine() throw( IO_ERROR )
+    {
+        const char* begin = m_text.data() + m_offset;
+        const char* eol   = (const char*) memchr( begin, '\n', m_end - m_offset );
+        unsigned    len   = eol ? eol + 1 - begin : m_end - m_offset;
+
+        if( len >= maxLineLength )
+            THROW_IO_ERROR( _( "Line length exceeded" ) );
+
+        length = 0;
+
+        if( len + 1 > capacity )    // +1 for terminating nul
+            expandCapacity( len + 1 );
+
+        memcpy( line, begin, len );
+        line[len] = 0;
+        length = len;
+
+        m_lineOffset = m_offset;
+        m_offset += len;
+
+        ++lineNum;      // this gets incremented even if no bytes were read
+
+        return length ? line : NULL;
+    }
+
+    /// @return the text read by this reader.
+    const std::string& Text() const         { return m_text; }
+
+    /// @return the offset in the text of the line returned by the last ReadLine().
+    size_t LineOffset() const               { return m_lineOffset; }
+
+    /**
+     * Function Seek
+     * makes the next ReadLine() read from \a aOffset, up to \a aEnd.
+     * @param aLineNumber is the line number of \a aOffset.
+     */
+    void Seek( size_t aOffset, unsigned aLineNumber, size_t aEnd )
+    {
+        m_offset = aOffset;
+        m_end    = aEnd;
+        lineNum  = aLineNumber - 1;
+    }
+
+private:
+    const std::string&  m_text;
+    size_t              m_offset;       ///< where the next line begins
+    size_t              m_end;          ///< where reading stops
+    size_t              m_lineOffset;   ///< where the current line begins
+};
+
+
+/**
+ * Struct BOARD_SECTION
+ * is a footprint, track, via or zone of a board, found by findSections() and
+ * parsed by PCB_PARSER::parseSections().
+ */
+struct BOARD_SECTION
+{
+    size_t          m_begin;        ///< offset of the opening bracket
+    size_t          m_keyword;      ///< offset of the keyword
+    size_t          m_end;          ///< offset after the closing bracket
+    unsigned        m_line;         ///< line number of m_begin
+    unsigned        m_endLine;      ///< line number of m_end
+    BOARD_ITEM*     m_item;         ///< the parsed item, until it is added to the board
+    IO_ERROR*       m_error;        ///< the parse error, may be a PARSE_ERROR
+    bool            m_fixZoneNet;   ///< the net of the zone must be fixed, see fixZoneNet()
+    wxString        m_zoneNet;      ///< the zone net name in file, if m_fixZoneNet
+
+    BOARD_SECTION() :
+        m_begin( 0 ), m_keyword( 0 ), m_end( 0 ), m_line( 0 ), m_endLine( 0 ),
+        m_item( NULL ), m_error( NULL ), m_fixZoneNet( false )
+    {
+    }
+};
+
+
+/// Consecutive sections parsed by a single job of PCB_PARSER::parseSections()
+struct SECTION_JOB
+{
+    unsigned    m_first;
+    unsigned    m_count;
+    size_t      m_size;             ///< the size of the text of the sections
+
+    /// The biggest jobs come first in the queue
+    bool operator<( const SECTION_JOB& aOther ) const
+    {
+        return m_size > aOther.m_size;
+    }
+};
+
+
+/**
+ * Function findSections
+ * finds the footprints, tracks, vias and zones of the board in \a aText, by
+ * matching the brackets, with the same token rules as DSNLEXER.
+ *
+ * @return bool - false if \a aText is not a board which can be parsed in parallel:
+ *  if it is not a board, if a layer, setup, net or net class is defined after the
+ *  first of these sections, if the text is oddly formatted, or has errors.  It is
+ *  then parsed serially, which reports the errors.
+ */
+static bool findSections( const std::string& aText, std::vector<BOARD_SECTION>& aSections )
+{
+    const char*     text = aText.data();
+    size_t          size = aText.size();
+    unsigned        lineNum = 1;
+    int             depth = 0;
+    bool            lineStart = true;       // only blanks since the start of the line
+    bool            tokenStart = true;      // a token can start at the next char
+    bool            sawBoard = false;
+    BOARD_SECTION   section;
+    std::string     keyword;
+
+    aSections.clear();
+
+    for( size_t ii = 0;  ii < size;  ++ii )
+    {
+        char c = text[ii];
+
+        if( c == '\n' )
+        {
+            ++lineNum;
+            lineStart  = true;
+            tokenStart = true;
+            continue;
+        }
+
+        if( c == ' ' || c == '\t' || c == '\r' || c == '\0' )
+        {
+            tokenStart = true;
+            continue;
+        }
+
+        if( lineStart && c == '#' )     // a comment line
+        {
+            const char* eol = (const char*) memchr( text + ii, '\n', size - ii );
+
+            ii = eol ? eol - text - 1 : size;
+            continue;
+        }
+
+        lineStart = false;
+
+        if( c == '"' && tokenStart )    // a quoted string, which cannot span lines
+        {
+            for( ++ii;  ii < size && text[ii] != '"';  ++ii )
+            {
+                if( text[ii] == '\n' )
+                    return false;
+
+                if( text[ii] == '\\' && ++ii < size && text[ii] == '\n' )
+                    return false;
+            }
+
+            if( ii >= size )
+                return false;
+
+            continue;
+        }
+
+        if( c == '(' )
+        {
+            if( depth <= 1 )
+            {
+                // The keyword must follow, on the same line
+                size_t kw = ii + 1;
+
+                while( kw < size && ( text[kw] == ' ' || text[kw] == '\t' ) )
+                    ++kw;
+
+                size_t kwEnd = kw;
+
+                while( kwEnd < size && !strchr( " \t\r\n()\"", text[kwEnd] ) )
+                    ++kwEnd;
+
+                keyword.assign( text + kw, kwEnd - kw );
+
+                if( depth == 0 )
+                {
+                    if( sawBoard || keyword != "kicad_pcb" )
+                        return false;
+
+                    sawBoard = true;
+                }
+                else if( keyword == "module" || keyword == "segment" || keyword == "via"
+                        || keyword == "zone" )
+                {
+                    section.m_begin   = ii;
+                    section.m_keyword = kw;
+                    section.m_line    = lineNum;
+                }
+                else if( !aSections.empty() && ( keyword == "layers" || keyword == "setup"
+                            || keyword == "net" || keyword == "net_class" ) )
+                {
+                    return false;
+                }
+                else
+                {
+                    section.m_begin = 0;
+                }
+            }
+
+            ++depth;
+            tokenStart = true;
+            continue;
+        }
+
+        if( c == ')' )
+        {
+            if( --depth < 0 )
+                return false;
+
+            if( depth == 1 && section.m_begin )
+            {
+                section.m_end     = ii + 1;
+                section.m_endLine = lineNum;
+                aSections.push_back( section );
+                section.m_begin = 0;
+            }
+
+            tokenStart = true;
+            continue;
+        }
+
+        tokenStart = false;     // within a symbol
+    }
+
+    return sawBoard && depth == 0 && !aSections.empty();
+}
+
+
+BOARD_ITEM* PCB_PARSER::Parse( const std::string& aText, const wxString& aSource )
+    throw( IO_ERROR, PARSE_ERROR )
+{
+    SECTION_LINE_READER         reader( aText, aSource );
+    std::vector<BOARD_SECTION>  sections;
+    BOARD_ITEM*                 item;
+
+    SetLineReader( &reader );
+
+    if( findSections( aText, sections ) )
+    {
+        m_sectionReader = &reader;
+        m_sections      = &sections;
+        m_nextSection   = 0;
+    }
+
+    try
+    {
+        item = Parse();
+    }
+    catch( ... )
+    {
+        // The sections not yet added to the board
+        for( unsigned ii = 0;  ii < sections.size();  ++ii )
+        {
+            delete sections[ii].m_item;
+            delete sections[ii].m_error;
+        }
+
+        m_sectionReader = NULL;
+        m_sections = NULL;
+        PopReader();
+        throw;
+    }
+
+    m_sectionReader = NULL;
+    m_sections = NULL;
+    PopReader();
+
+    return item;
+}
+
+
+void PCB_PARSER::skipSection() throw( IO_ERROR, PARSE_ERROR )
+{
+    // Check that the current token is the section found by findSections()
+    size_t offset = m_sectionReader->LineOffset() + curOffset;
+
+    if( m_nextSection >= m_sections->size() || (*m_sections)[m_nextSection].m_keyword != offset )
+    {
+        wxString err;
+        err.Printf( _( "unexpected token \"%s\"" ), GetChars( FromUTF8() ) );
+        THROW_PARSE_ERROR( err, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+    }
+
+    const BOARD_SECTION& section = (*m_sections)[m_nextSection++];
+
+    // Resume after the closing bracket of the section
+    m_sectionReader->Seek( section.m_end, section.m_endLine, m_sectionReader->Text().size() );
+    next = limit;
+}
+
+
+void PCB_PARSER::parseSections() throw( IO_ERROR, PARSE_ERROR )
+{
+    std::vector<BOARD_SECTION>& sections = *m_sections;
+
+    if( m_nextSection != sections.size() )
+        THROW_PARSE_ERROR( _( "unexpected end of board" ), CurSource(), CurLine(),
+                           CurLineNumber(), CurOffset() );
+
+    // Group the small sections in jobs of about SECTION_JOB_SIZE bytes
+    std::vector<SECTION_JOB> jobs;
+
+    for( unsigned ii = 0;  ii < sections.size();  ++ii )
+    {
+        size_t size = sections[ii].m_end - sections[ii].m_begin;
+
+        if( jobs.empty() || jobs.back().m_size >= SECTION_JOB_SIZE )
+        {
+            SECTION_JOB job = { ii, 0, 0 };
+            jobs.push_back( job );
+        }
+
+        jobs.back().m_count++;
+        jobs.back().m_size += size;
+    }
+
+    std::sort( jobs.begin(), jobs.end() );
+
+    // A parser per thread, which knows the layers and nets of the board
+    int threadCount = JOB_SCHEDULER::GetThreadCount( jobs.size() );
+    std::vector<PCB_PARSER*> workers;
+    boost::ptr_vector<SECTION_LINE_READER> readers;
+
+    for( int ii = 0;  ii < threadCount;  ++ii )
+    {
+        readers.push_back( new SECTION_LINE_READER( m_sectionReader->Text(), CurSource() ) );
+
+        PCB_PARSER* worker = new PCB_PARSER( &readers.back() );
+
+        worker->m_board           = m_board;
+        worker->m_layerIndices    = m_layerIndices;
+        worker->m_layerMasks      = m_layerMasks;
+        worker->m_netCodes        = m_netCodes;
+        worker->m_tooRecent       = m_tooRecent;
+        worker->m_requiredVersion = m_requiredVersion;
+        worker->m_sectionReader   = &readers.back();
+        workers.push_back( worker );
+    }
+
+    JOB_SCHEDULER::Run( jobs.size(), boost::bind( &PCB_PARSER::parseSectionJob, this,
+                                                  &workers, &jobs, _1, _2 ) );
+
+    // Footprints may require a more recent version than the board
+    for( int ii = 0;  ii < threadCount;  ++ii )
+    {
+        m_requiredVersion = std::max( m_requiredVersion, workers[ii]->m_requiredVersion );
+        m_tooRecent = m_tooRecent || workers[ii]->m_tooRecent;
+        delete workers[ii];
+    }
+
+    // Add the items in file order, until the first error
+    IO_ERROR* error = NULL;
+
+    for( unsigned ii = 0;  ii < sections.size();  ++ii )
+    {
+        BOARD_SECTION& section = sections[ii];
+
+        if( !error && section.m_error )
+        {
+            std::swap( error, section.m_error );
+        }
+        else if( !error )
+        {
+            if( section.m_fixZoneNet )
+                fixZoneNet( (ZONE_CONTAINER*) section.m_item, section.m_zoneNet );
+
+            m_board->Add( section.m_item, ADD_APPEND );
+            section.m_item = NULL;
+        }
+    }
+
+    if( error )
+    {
+        // Throw a copy of the error, with its type
+        std::auto_ptr<IO_ERROR> saved( error );
+
+        if( PARSE_ERROR* parseError = dynamic_cast<PARSE_ERROR*>( error ) )
+            throw PARSE_ERROR( *parseError );
+
+        throw IO_ERROR( *error );
+    }
+}
+
+
+void PCB_PARSER::parseSectionJob( std::vector<PCB_PARSER*>* aWorkers,
+                                  const std::vector<SECTION_JOB>* aJobs, int aJob, int aThread )
+{
+    PCB_PARSER*         worker = (*aWorkers)[aThread];
+    const SECTION_JOB&  job = (*aJobs)[aJob];
+
+    for( unsigned ii = job.m_first;  ii < job.m_first + job.m_count;  ++ii )
+        worker->parseSection( (*m_sections)[ii] );
+}
+
+
+void PCB_PARSER::parseSection( BOARD_SECTION& aSection )
+{
+    m_sectionReader->Seek( aSection.m_begin, aSection.m_line, aSection.m_end );
+    SetLineReader( m_sectionReader );   // restart the lexer on the new position
+    m_section = &aSection;
+
+    try
+    {
+        NeedLEFT();
+
+        switch( NextTok() )
+        {
+        case T_module:
+            aSection.m_item = parseMODULE_unchecked();
+            break;
+
+        case T_segment:
+            aSection.m_item = parseTRACK();
+            break;
+
+        case T_via:
+            aSection.m_item = parseVIA();
+            break;
+
+        case T_zone:
+            aSection.m_item = parseZONE_CONTAINER();
+            break;
+
+        default:
+            Expecting( "module, segment, via or zone" );
+        }
+    }
+    catch( const PARSE_ERROR& pe )
+    {
+        aSection.m_error = new PARSE_ERROR( pe );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        aSection.m_error = new IO_ERROR( ioe );
+    }
+    catch( const std::exception& se )
+    {
+        aSection.m_error = new IO_ERROR( __FILE__, __LOC__, se.what() );
+    }
+
+    m_section = NULL;
+}
+
+
 BOARD_ITEM* PCB_PARSER::Parse() throw( IO_ERROR, PARSE_ERROR )
 {
     T               token;
@@ -476,6 +1019,14 @@ BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
 
         token = NextTok();
 
+        // With Parse( aText ), these sections are parsed by parseSections() below
+        if( m_sections && ( token == T_module || token == T_segment || token == T_via
+                            || token == T_zone ) )
+        {
+            skipSection();
+            continue;
+        }
+
         switch( token )
         {
         case T_general:
@@ -549,6 +1100,9 @@ BOARD* PCB_PARSER::parseBOARD_unchecked() throw( IO_ERROR, PARSE_ERROR )
         }
     }
 
+    if( m_sections )
+        parseSections();
+
     return m_board;
 }
 
@@ -2980,31 +3534,16 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER() throw( IO_ERROR, PARSE_ERROR )
     // Ensure the zone net name is valid, and matches the net code, for copper zones
     if( zone_has_net && ( zone->GetNet()->GetNetname() != netnameFromfile ) )
     {
-        // Can happens which old boards, with nonexistent nets ...
-        // or after being edited by hand
-        // We try to fix the mismatch.
-        NETINFO_ITEM* net = m_board->FindNet( netnameFromfile );
-
-        if( net )   // An existing net has the same net name. use it for the zone
-            zone->SetNetCode( net->GetNet() );
-        else    // Not existing net: add a new net to keep trace of the zone netname
+        // A worker parser cannot change the board, the net is fixed when the zone
+        // is added to the board by parseSections().
+        if( m_section )
+        {
+            m_section->m_fixZoneNet = true;
+            m_section->m_zoneNet = netnameFromfile;
+        }
+        else
         {
-            int newnetcode = m_board->GetNetCount();
-            net = new NETINFO_ITEM( m_board, netnameFromfile, newnetcode );
-            m_board->AppendNet( net );
-
-            // Store the new code mapping
-            pushValueIntoMap( newnetcode, net->GetNet() );
-            // and update the zone netcode
-            zone->SetNetCode( net->GetNet() );
-
-            // Prompt the user
-            wxString msg;
-            msg.Printf( _( "There is a zone that belongs to a not existing net\n"
-                           "\"%s\"\n"
-                           "you should verify and edit it (run DRC test)." ),
-                           GetChars( netnameFromfile ) );
-            DisplayError( NULL, msg );
+            fixZoneNet( zone.get(), netnameFromfile );
         }
     }
 
@@ -3012,6 +3551,37 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER() throw( IO_ERROR, PARSE_ERROR )
 }
 
 
+void PCB_PARSER::fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname )
+{
+    // Can happens which old boards, with nonexistent nets ...
+    // or after being edited by hand
+    // We try to fix the mismatch.
+    NETINFO_ITEM* net = m_board->FindNet( aNetname );
+
+    if( net )   // An existing net has the same net name. use it for the zone
+        aZone->SetNetCode( net->GetNet() );
+    else    // Not existing net: add a new net to keep trace of the zone netname
+    {
+        int newnetcode = m_board->GetNetCount();
+        net = new NETINFO_ITEM( m_board, aNetname, newnetcode );
+        m_board->AppendNet( net );
+
+        // Store the new code mapping
+        pushValueIntoMap( newnetcode, net->GetNet() );
+        // and update the zone netcode
+        aZone->SetNetCode( net->GetNet() );
+
+        // Prompt the user
+        wxString msg;
+        msg.Printf( _( "There is a zone that belongs to a not existing net\n"
+                       "\"%s\"\n"
+                       "you should verify and edit it (run DRC test)." ),
+                       GetChars( aNetname ) );
+        DisplayError( NULL, msg );
+    }
+}
+
+
 PCB_TARGET* PCB_PARSER::parsePCB_TARGET() throw( IO_ERROR, PARSE_ERROR )
 {
     wxCHECK_MSG( CurTok() == T_target, NULL,
@@ -52,7 +52,10 @@ class PCB_TARGET;
 class VIA;
 class S3D_MASTER;
 class ZONE_CONTAINER;
+class SECTION_LINE_READER;
 struct LAYER;
+struct BOARD_SECTION;
+struct SECTION_JOB;
 
 
 /**
@@ -72,6 +75,11 @@ class PCB_PARSER : public PCB_LEXER
     bool                m_tooRecent;        ///< true if version parses as later than supported
     int                 m_requiredVersion;  ///< set to the KiCad format version this board requires
 
+    SECTION_LINE_READER*        m_sectionReader;    ///< reads the text given to Parse( aText ), or NULL
+    std::vector<BOARD_SECTION>* m_sections;         ///< the sections parsed in parallel, or NULL
+    unsigned                    m_nextSection;      ///< the next one of m_sections to be skipped
+    BOARD_SECTION*              m_section;          ///< the section a worker parser is parsing, or NULL
+
     ///> Converts net code using the mapping table if available,
     ///> otherwise returns unchanged net code if < 0 or if is is out of range
     inline int getNetCode( int aNetCode )
@@ -99,6 +107,42 @@ class PCB_PARSER : public PCB_LEXER
      */
     void init();
 
+    /**
+     * Function skipSection
+     * skips the section of m_sections whose keyword is the current token, when the
+     * board is parsed by Parse( aText ).  It is parsed later by parseSections().
+     */
+    void skipSection() throw( IO_ERROR, PARSE_ERROR );
+
+    /**
+     * Function parseSections
+     * parses m_sections on several threads, once the rest of the board was parsed,
+     * and adds the items to the board in file order.
+     */
+    void parseSections() throw( IO_ERROR, PARSE_ERROR );
+
+    /**
+     * Function parseSectionJob
+     * parses the sections of job aJob with the worker parser of thread aThread.
+     * Called by a JOB_SCHEDULER.
+     */
+    void parseSectionJob( std::vector<PCB_PARSER*>* aWorkers,
+                          const std::vector<SECTION_JOB>* aJobs, int aJob, int aThread );
+
+    /**
+     * Function parseSection
+     * parses aSection into aSection.m_item, or stores the error into aSection.m_error.
+     * Used by the worker parsers.
+     */
+    void parseSection( BOARD_SECTION& aSection );
+
+    /**
+     * Function fixZoneNet
+     * fixes the net of a copper zone whose net name in file, \a aNetname, does not
+     * match its net code, by finding the net from its name, or adding it to the board.
+     */
+    void fixZoneNet( ZONE_CONTAINER* aZone, const wxString& aNetname );
+
     void parseHeader() throw( IO_ERROR, PARSE_ERROR );
     void parseGeneralSection() throw( IO_ERROR, PARSE_ERROR );
     void parsePAGE_INFO() throw( IO_ERROR, PARSE_ERROR );
@@ -279,7 +323,11 @@ public:
 
     PCB_PARSER( LINE_READER* aReader = NULL ) :
         PCB_LEXER( aReader ),
-        m_board( 0 )
+        m_board( 0 ),
+        m_sectionReader( 0 ),
+        m_sections( 0 ),
+        m_nextSection( 0 ),
+        m_section( 0 )
     {
         init();
     }
@@ -307,6 +355,22 @@ public:
 
     BOARD_ITEM* Parse() throw( IO_ERROR, PARSE_ERROR );
 
+    /**
+     * Function Parse
+     * parses \a aText, the whole content of a board or footprint file.  The
+     * footprints, tracks, vias and zones of a board are found by a quick scan of the
+     * brackets, and are parsed on several threads once the rest of the board, which
+     * they depend on, was parsed.  They are added to the board in file order, so the
+     * result is the same as with Parse().
+     *
+     * The line reader set by SetLineReader(), if any, is dropped.
+     *
+     * @param aText is the text to parse.  It is not copied.
+     * @param aSource is the name of the file, for the error messages.
+     */
+    BOARD_ITEM* Parse( const std::string& aText, const wxString& aSource )
+        throw( IO_ERROR, PARSE_ERROR );
+
     /**
      * Return whether a version number, if any was parsed, was too recent
      */
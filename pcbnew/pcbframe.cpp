@@ -65,6 +65,7 @@
 #include <worksheet_viewitem.h>
 #include <ratsnest_data.h>
 #include <ratsnest_viewitem.h>
+#include <background_save.h>
 
 #include <tool/tool_manager.h>
 #include <tool/tool_dispatcher.h>
@@ -350,6 +351,7 @@ PCB_EDIT_FRAME::PCB_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ) :
     m_Layers = new PCB_LAYER_WIDGET( this, GetCanvas(), pointSize );
 
     m_drc = new DRC( this );        // these 2 objects point to each other
+    m_autoSaver = new BACKGROUND_BOARD_SAVER();
 
     wxIcon  icon;
     icon.CopyFromBitmap( KiBitmap( icon_pcbnew_xpm ) );
@@ -470,6 +472,9 @@ PCB_EDIT_FRAME::PCB_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ) :
 
 PCB_EDIT_FRAME::~PCB_EDIT_FRAME()
 {
+    // Waits for a running auto save
+    delete m_autoSaver;
+
     m_RecordingMacros = -1;
 
     for( int i = 0; i < 10; i++ )
@@ -606,6 +611,9 @@ void PCB_EDIT_FRAME::OnCloseWindow( wxCloseEvent& Event )
 
     GetGalCanvas()->StopDrawing();
 
+    // A running auto save would write the file again after it is deleted
+    m_autoSaver->Wait();
+
     // Delete the auto save file if it exists.
     wxFileName fn = GetBoard()->GetFileName();
 
@@ -752,6 +760,8 @@ void PCB_EDIT_FRAME::LoadSettings( wxConfigBase* aCfg )
     aCfg->Read( SHOW_MICROWAVE_TOOLS, &m_show_microwave_tools );
     aCfg->Read( SHOW_LAYER_MANAGER_TOOLS, &m_show_layer_manager_tools );
     aCfg->Read( SHOW_PAGE_LIMITS_KEY, &m_showPageLimits );
+
+    RN_DATA::SetThreadCount( g_RatsnestThreadCount );
 }
 
 
@@ -71,6 +71,8 @@ bool        g_Alternate_Track_Posture = false;
 bool        g_Track_45_Only_Allowed = true;  // True to allow horiz, vert. and 45deg only tracks
 bool        g_Segments_45_Only;              // True to allow horiz, vert. and 45deg only graphic segments
 bool        g_TwoSegmentTrackBuild = true;
+int         g_RatsnestThreadCount = 0;      // Threads computing the ratsnest, 0 for all processors
+bool        g_AutoRefillZones = false;      // True to refill the zones around moved or deleted items
 
 LAYER_ID    g_Route_Layer_TOP;
 LAYER_ID    g_Route_Layer_BOTTOM;
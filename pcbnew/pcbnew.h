@@ -90,6 +90,13 @@ extern LAYER_ID g_Route_Layer_BOTTOM;
 
 extern bool     g_TwoSegmentTrackBuild;
 
+/// Number of threads used to compute the ratsnest (0 for the number of available processors).
+extern int      g_RatsnestThreadCount;
+
+/// True to refill the filled zones around the items moved, rotated, flipped or deleted by the
+/// edit tool of the GAL canvas.
+extern bool     g_AutoRefillZones;
+
 extern int      g_MagneticPadOption;
 extern int      g_MagneticTrackOption;
 
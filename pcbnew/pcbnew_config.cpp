@@ -428,6 +428,10 @@ PARAM_CFG_ARRAY& PCB_EDIT_FRAME::GetConfigurationSettings()
                                                         &g_TwoSegmentTrackBuild, true ) );
         m_configSettings.push_back( new PARAM_CFG_BOOL( true, wxT( "SegmPcb45Only" )
                                                         , &g_Segments_45_Only, true ) );
+        m_configSettings.push_back( new PARAM_CFG_INT( true, wxT( "RatsnestThreadCount" ),
+                                                       &g_RatsnestThreadCount, 0, 0, 256 ) );
+        m_configSettings.push_back( new PARAM_CFG_BOOL( true, wxT( "AutoRefillZones" ),
+                                                        &g_AutoRefillZones, false ) );
     }
 
     return m_configSettings;
@@ -0,0 +1,259 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2016 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcbnew_drc.cpp
+ * @brief Command line design rules checker.
+ *
+ * Usage: pcbnew_drc [--json] [--threads N] board.kicad_pcb
+ *
+ * Loads the board, runs all the DRC tests without any window (see DRC::RunTestsHeadless())
+ * and prints the time spent in each test and the violations found, as text or as JSON.
+ * The exit code is 0 if the board passes, 1 if violations were found, 2 on errors.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <wx/init.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+#include <fctsys.h>
+#include <macros.h>
+#include <convert_to_biu.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <ratsnest_data.h>
+#include <drc_stuff.h>
+
+
+/**
+ * Function jsonString
+ * @return aText as a quoted JSON string, UTF8 encoded.
+ */
+static std::string jsonString( const wxString& aText )
+{
+    std::string utf8 = TO_UTF8( aText );
+    std::string result = "\"";
+
+    for( unsigned ii = 0; ii < utf8.size(); ++ii )
+    {
+        char c = utf8[ii];
+
+        switch( c )
+        {
+        case '"':   result += "\\\"";   break;
+        case '\\':  result += "\\\\";   break;
+        case '\n':  result += "\\n";    break;
+        case '\r':  result += "\\r";    break;
+        case '\t':  result += "\\t";    break;
+
+        default:
+            if( (unsigned char) c < 0x20 )
+            {
+                char escaped[8];
+                sprintf( escaped, "\\u%04x", c );
+                result += escaped;
+            }
+            else
+            {
+                result += c;
+            }
+        }
+    }
+
+    return result + "\"";
+}
+
+
+static void printJsonItem( const wxString& aText, const wxPoint& aPos )
+{
+    printf( "{ \"text\": %s, \"x_mm\": %.6f, \"y_mm\": %.6f }",
+            jsonString( aText ).c_str(), aPos.x / IU_PER_MM, aPos.y / IU_PER_MM );
+}
+
+
+static void printJsonReport( const wxString& aBoardName,
+                             const std::vector<DRC_TEST_RESULT>& aResults )
+{
+    int violationCount = 0;
+
+    printf( "{\n  \"board\": %s,\n  \"tests\": [", jsonString( aBoardName ).c_str() );
+
+    for( unsigned ii = 0; ii < aResults.size(); ++ii )
+    {
+        const DRC_TEST_RESULT& result = aResults[ii];
+
+        printf( "%s\n    {\n      \"name\": %s,\n      \"time_ms\": %.3f,\n      \"violations\": [",
+                ii ? "," : "", jsonString( result.m_name ).c_str(), result.m_msecs );
+
+        for( unsigned jj = 0; jj < result.m_items.size(); ++jj )
+        {
+            const DRC_ITEM& item = result.m_items[jj];
+
+            printf( "%s\n        { \"code\": %d, \"description\": %s, \"items\": [ ",
+                    jj ? "," : "", item.GetErrorCode(), jsonString( item.GetErrorText() ).c_str() );
+
+            printJsonItem( item.GetTextA(), item.GetPointA() );
+
+            if( item.HasSecondItem() )
+            {
+                printf( ", " );
+                printJsonItem( item.GetTextB(), item.GetPointB() );
+            }
+
+            printf( " ] }" );
+        }
+
+        printf( "%s]\n    }", result.m_items.empty() ? "" : "\n      " );
+
+        violationCount += result.m_items.size();
+    }
+
+    printf( "\n  ],\n  \"violation_count\": %d\n}\n", violationCount );
+}
+
+
+static void printTextReport( const wxString& aBoardName,
+                             const std::vector<DRC_TEST_RESULT>& aResults )
+{
+    printf( "** DRC report for %s **\n", TO_UTF8( aBoardName ) );
+
+    for( unsigned ii = 0; ii < aResults.size(); ++ii )
+    {
+        const DRC_TEST_RESULT& result = aResults[ii];
+
+        printf( "\n%s: %.3f ms, %d violation(s)\n", TO_UTF8( result.m_name ), result.m_msecs,
+                (int) result.m_items.size() );
+
+        for( unsigned jj = 0; jj < result.m_items.size(); ++jj )
+            printf( "%s", TO_UTF8( result.m_items[jj].ShowReport() ) );
+    }
+}
+
+
+static void usage()
+{
+    fprintf( stderr, "Usage: pcbnew_drc [--json] [--threads N] board.kicad_pcb\n" );
+}
+
+
+int main( int argc, char** argv )
+{
+    bool        json = false;
+    int         threadCount = 0;
+    const char* boardFile = NULL;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        if( !strcmp( argv[ii], "--json" ) )
+        {
+            json = true;
+        }
+        else if( !strcmp( argv[ii], "--threads" ) && ii + 1 < argc )
+        {
+            threadCount = atoi( argv[++ii] );
+        }
+        else if( argv[ii][0] != '-' && !boardFile )
+        {
+            boardFile = argv[ii];
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if( !boardFile )
+    {
+        usage();
+        return 2;
+    }
+
+    wxInitializer initializer( argc, argv );
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Can't initialize wxWidgets\n" );
+        return 2;
+    }
+
+    if( threadCount > 0 )
+    {
+#ifdef USE_OPENMP
+        omp_set_num_threads( threadCount );
+#endif /* USE_OPENMP */
+        RN_DATA::SetThreadCount( threadCount );
+    }
+
+    wxString fileName = FROM_UTF8( boardFile );
+    IO_MGR::PCB_FILE_T pluginType = fileName.EndsWith( wxT( ".brd" ) ) ?
+                                    IO_MGR::LEGACY : IO_MGR::KICAD;
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, fileName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "Can't load %s: %s\n", boardFile, TO_UTF8( ioe.errorText ) );
+        return 2;
+    }
+
+    if( !board )
+    {
+        fprintf( stderr, "Can't load %s\n", boardFile );
+        return 2;
+    }
+
+    // Same preparation as PCB_EDIT_FRAME::OpenProjectFiles()
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+
+    std::vector<DRC_TEST_RESULT> results;
+    int violationCount = 0;
+
+    {
+        DRC drc( board );
+        drc.RunTestsHeadless( results );
+    }
+
+    for( unsigned ii = 0; ii < results.size(); ++ii )
+        violationCount += results[ii].m_items.size();
+
+    if( json )
+        printJsonReport( fileName, results );
+    else
+        printTextReport( fileName, results );
+
+    delete board;
+
+    return violationCount ? 1 : 0;
+}
@@ -39,11 +39,14 @@
 #include <pcbnew.h>
 #include <plotcontroller.h>
 #include <pcb_plot_params.h>
+#include <gendrill_Excellon_writer.h>
 #include <wx/ffile.h>
 #include <dialog_plot.h>
 #include <macros.h>
 #include <build_version.h>
 
+#include <boost/bind.hpp>
+
 
 const wxString GetGerberProtelExtension( LAYER_NUM aLayer )
 {
@@ -323,12 +326,14 @@ PLOT_CONTROLLER::PLOT_CONTROLLER( BOARD *aBoard )
     m_plotter = NULL;
     m_board = aBoard;
     m_plotLayer = UNDEFINED_LAYER;
+    m_queue = NULL;
 }
 
 
 PLOT_CONTROLLER::~PLOT_CONTROLLER()
 {
     ClosePlot();
+    RunQueue();
 }
 
 
@@ -349,6 +354,35 @@ void PLOT_CONTROLLER::ClosePlot()
 }
 
 
+bool PLOT_CONTROLLER::buildPlotFileName( const wxString &aSuffix, PlotFormat aFormat )
+{
+    // Now compute the full filename for the output
+    // (after ensuring the output directory is OK)
+    wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
+    wxFileName outputDir = wxFileName::DirName( outputDirName );
+    wxString boardFilename = m_board->GetFileName();
+
+    if( !EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+        return false;
+
+    // outputDir contains now the full path of plot files
+    m_plotFile = boardFilename;
+    m_plotFile.SetPath( outputDir.GetPath() );
+    wxString fileExt = GetDefaultPlotExtension( aFormat );
+
+    // Gerber format can use specific file ext, depending on layers
+    // (now not a good practice, because the official file ext is .gbr)
+    if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
+        GetPlotOptions().GetUseGerberProtelExtensions() )
+        fileExt = GetGerberProtelExtension( GetLayer() );
+
+    // Build plot filenames from the board name and layer names:
+    BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
+
+    return true;
+}
+
+
 bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
                                     PlotFormat     aFormat,
                                     const wxString &aSheetDesc )
@@ -363,28 +397,9 @@ bool PLOT_CONTROLLER::OpenPlotfile( const wxString &aSuffix,
     // Ensure that the previous plot is closed
     ClosePlot();
 
-    // Now compute the full filename for the output and start the plot
-    // (after ensuring the output directory is OK)
-    wxString outputDirName = GetPlotOptions().GetOutputDirectory() ;
-    wxFileName outputDir = wxFileName::DirName( outputDirName );
-    wxString boardFilename = m_board->GetFileName();
-
-    if( EnsureFileDirectoryExists( &outputDir, boardFilename ) )
+    // Now start the plot
+    if( buildPlotFileName( aSuffix, aFormat ) )
     {
-        // outputDir contains now the full path of plot files
-        m_plotFile = boardFilename;
-        m_plotFile.SetPath( outputDir.GetPath() );
-        wxString fileExt = GetDefaultPlotExtension( aFormat );
-
-        // Gerber format can use specific file ext, depending on layers
-        // (now not a good practice, because the official file ext is .gbr)
-        if( GetPlotOptions().GetFormat() == PLOT_FORMAT_GERBER &&
-            GetPlotOptions().GetUseGerberProtelExtensions() )
-            fileExt = GetGerberProtelExtension( GetLayer() );
-
-        // Build plot filenames from the board name and layer names:
-        BuildPlotFileName( &m_plotFile, outputDir.GetPath(), aSuffix, fileExt );
-
         m_plotter = StartPlotBoard( m_board, &GetPlotOptions(), ToLAYER_ID( GetLayer() ),
                                     m_plotFile.GetFullPath(), aSheetDesc );
     }
@@ -424,3 +439,48 @@ bool PLOT_CONTROLLER::GetColorMode()
 
     return m_plotter->GetColorMode();
 }
+
+
+bool PLOT_CONTROLLER::QueuePlotfile( const wxString &aSuffix,
+                                     PlotFormat     aFormat,
+                                     const wxString &aSheetDesc )
+{
+    GetPlotOptions().SetFormat( aFormat );
+
+    if( !buildPlotFileName( aSuffix, aFormat ) )
+        return false;
+
+    if( !m_queue )
+        m_queue = new BOARD_PLOT_BATCH( m_board );
+
+    // The plot options are copied by the batch
+    return m_queue->AddLayer( ToLAYER_ID( GetLayer() ), GetPlotOptions(),
+                              m_plotFile.GetFullPath(), aSheetDesc ) >= 0;
+}
+
+
+void PLOT_CONTROLLER::QueueDrillFiles( const EXCELLON_WRITER& aWriter,
+                                       const wxString& aPlotDirectory,
+                                       bool aGenDrill, bool aGenMap )
+{
+    if( !m_queue )
+        m_queue = new BOARD_PLOT_BATCH( m_board );
+
+    // The job owns its copy of the writer, whose hole lists are built by the job
+    m_queue->AddJob( boost::bind( &EXCELLON_WRITER::CreateDrillandMapFilesSet, aWriter,
+                                  aPlotDirectory, aGenDrill, aGenMap, (REPORTER*) NULL ) );
+}
+
+
+bool PLOT_CONTROLLER::RunQueue()
+{
+    if( !m_queue )
+        return true;
+
+    bool ok = m_queue->Run();
+
+    delete m_queue;
+    m_queue = NULL;
+
+    return ok;
+}
@@ -29,6 +29,8 @@
 #ifndef PCBPLOT_H_
 #define PCBPLOT_H_
 
+#include <vector>
+#include <boost/function.hpp>
 #include <wx/filename.h>
 #include <pad_shapes.h>
 #include <pcb_plot_params.h>
@@ -125,6 +127,14 @@ public:
      */
     void PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T aPlotMode );
 
+    /**
+     * Plot a pad with the size \a aSize instead of its actual size
+     * (for instance to add the solder mask or solder paste margin)
+     * without changing the pad.
+     */
+    void PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T aPlotMode,
+                  const wxSize& aSize );
+
     /**
      * plot items like text and graphics,
      *  but not tracks and modules
@@ -179,6 +189,84 @@ PLOTTER* StartPlotBoard( BOARD* aBoard,
 void PlotOneBoardLayer( BOARD *aBoard, PLOTTER* aPlotter, LAYER_ID aLayer,
                         const PCB_PLOT_PARAMS& aPlotOpt );
 
+/**
+ * Class BOARD_PLOT_BATCH
+ * plots a set of layers of a board, each one in its own file, at the same time:
+ * each layer has its own PLOTTER, and the layers are plotted on a pool of threads
+ * by a JOB_SCHEDULER.  Other jobs writing fabrication files from the board, like the
+ * EXCELLON_WRITER drill files, can be run in the same batch.
+ *
+ * AddLayer() opens the plot file and plots the page header and the worksheet, which
+ * need the calling thread.  Run() plots the layers and runs the jobs, and returns when
+ * all of them are done.  The board must not be modified while the batch runs.
+ */
+class BOARD_PLOT_BATCH
+{
+public:
+    /**
+     * A job run in the batch.  It is called with the C locale on one of the threads of the
+     * JOB_SCHEDULER: the calling thread (thread 0) or a worker thread, so it must not use
+     * the GUI (for instance a REPORTER writing in a window).  It must not modify the board,
+     * and returns false if it fails.  An IO_ERROR or std::exception thrown by the job is
+     * caught and reported as a failure.
+     */
+    typedef boost::function<bool ()> JOB;
+
+    BOARD_PLOT_BATCH( BOARD* aBoard );
+    ~BOARD_PLOT_BATCH();
+
+    /**
+     * Function AddLayer
+     * creates the plot file \a aFullFileName of \a aLayer (see StartPlotBoard()).
+     * @return int - the index of the layer in the batch, or -1 if the file cannot be created.
+     */
+    int AddLayer( LAYER_ID aLayer, const PCB_PLOT_PARAMS& aPlotOpts,
+                  const wxString& aFullFileName, const wxString& aSheetDesc );
+
+    /**
+     * Function AddJob
+     * adds \a aJob to the batch.
+     * @return int - the index of the job in the batch.
+     */
+    int AddJob( const JOB& aJob );
+
+    /**
+     * Function Run
+     * plots the layers and runs the jobs added since the last call.
+     * @return bool - true if all the layers and jobs succeeded.
+     */
+    bool Run();
+
+    /**
+     * Function Succeeded
+     * @return bool - true if the layer or the job \a aIndex has been run successfully.
+     */
+    bool Succeeded( int aIndex ) const
+    {
+        return aIndex >= 0 && aIndex < (int) m_items.size() && m_items[aIndex].m_ok;
+    }
+
+    /// @return the number of layers and jobs in the batch.
+    int GetCount() const { return m_items.size(); }
+
+private:
+    struct ITEM
+    {
+        PLOTTER*        m_plotter;      ///< the layer plotter, NULL for a job
+        LAYER_ID        m_layer;
+        PCB_PLOT_PARAMS m_plotOpts;
+        JOB             m_job;
+        bool            m_done;
+        bool            m_ok;
+    };
+
+    /// Plots the layer or runs the job (*aPending)[aJob], called by a JOB_SCHEDULER.
+    void runItem( const std::vector<int>* aPending, int aJob, int aThread );
+
+    BOARD*              m_board;
+    std::vector<ITEM>   m_items;
+};
+
 /**
  * Function PlotStandardLayer
  * plot copper or technical layers.
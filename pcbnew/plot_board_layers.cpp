@@ -50,6 +50,9 @@
 
 #include <pcbnew.h>
 #include <pcbplot.h>
+#include <job_scheduler.h>
+
+#include <boost/bind.hpp>
 
 // Local
 /* Plot a solder mask layer.
@@ -371,15 +374,14 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             if( pad->GetLayerSet()[F_Cu] )
                 color = ColorFromInt( color | aBoard->GetVisibleElementColor( PAD_FR_VISIBLE ) );
 
-            // Temporary set the pad size to the required plot size:
-            wxSize tmppadsize = pad->GetSize();
-            pad->SetSize( padPlotsSize );
+            // Plot the pad at the required plot size. The pad itself is not
+            // modified, because other layers can be plotted at the same time.
             switch( pad->GetShape() )
             {
             case PAD_SHAPE_CIRCLE:
             case PAD_SHAPE_OVAL:
                 if( aPlotOpt.GetSkipPlotNPTH_Pads() &&
-                    (pad->GetSize() == pad->GetDrillSize()) &&
+                    (padPlotsSize == pad->GetDrillSize()) &&
                     (pad->GetAttribute() == PAD_ATTRIB_HOLE_NOT_PLATED) )
                     break;
 
@@ -387,11 +389,9 @@ void PlotStandardLayer( BOARD *aBoard, PLOTTER* aPlotter,
             case PAD_SHAPE_TRAPEZOID:
             case PAD_SHAPE_RECT:
             default:
-                itemplotter.PlotPad( pad, color, plotMode );
+                itemplotter.PlotPad( pad, color, plotMode, padPlotsSize );
                 break;
             }
-
-            pad->SetSize( tmppadsize );     // Restore the pad size
         }
     }
 
@@ -1038,3 +1038,119 @@ PLOTTER* StartPlotBoard( BOARD *aBoard, PCB_PLOT_PARAMS *aPlotOpts,
     delete plotter;
     return NULL;
 }
+
+
+BOARD_PLOT_BATCH::BOARD_PLOT_BATCH( BOARD* aBoard ) :
+    m_board( aBoard )
+{
+}
+
+
+BOARD_PLOT_BATCH::~BOARD_PLOT_BATCH()
+{
+    // Plotters of a batch which was never run
+    for( unsigned ii = 0;  ii < m_items.size();  ++ii )
+        delete m_items[ii].m_plotter;
+}
+
+
+int BOARD_PLOT_BATCH::AddLayer( LAYER_ID aLayer, const PCB_PLOT_PARAMS& aPlotOpts,
+                                const wxString& aFullFileName, const wxString& aSheetDesc )
+{
+    ITEM item;
+
+    item.m_layer    = aLayer;
+    item.m_plotOpts = aPlotOpts;
+    item.m_done     = false;
+    item.m_ok       = false;
+
+    {
+        LOCALE_IO toggle;
+
+        item.m_plotter = StartPlotBoard( m_board, &item.m_plotOpts, aLayer,
+                                         aFullFileName, aSheetDesc );
+    }
+
+    if( !item.m_plotter )
+        return -1;
+
+    m_items.push_back( item );
+    return m_items.size() - 1;
+}
+
+
+int BOARD_PLOT_BATCH::AddJob( const JOB& aJob )
+{
+    ITEM item;
+
+    item.m_plotter  = NULL;
+    item.m_layer    = UNDEFINED_LAYER;
+    item.m_job      = aJob;
+    item.m_done     = false;
+    item.m_ok       = false;
+
+    m_items.push_back( item );
+    return m_items.size() - 1;
+}
+
+
+void BOARD_PLOT_BATCH::runItem( const std::vector<int>* aPending, int aJob, int aThread )
+{
+    ITEM& item = m_items[ (*aPending)[aJob] ];
+
+    // The plotters and the jobs write their numbers with LOCALE_IO, which is a no-op
+    // on a thread using the C locale: the locale of the other threads is left alone
+    THREAD_C_LOCALE cLocale;
+
+    if( item.m_plotter )
+    {
+        PlotOneBoardLayer( m_board, item.m_plotter, item.m_layer, item.m_plotOpts );
+        item.m_ok = item.m_plotter->EndPlot();
+
+        delete item.m_plotter;
+        item.m_plotter = NULL;
+    }
+    else
+    {
+        try
+        {
+            item.m_ok = item.m_job();
+        }
+        catch( const IO_ERROR& )
+        {
+            item.m_ok = false;
+        }
+        catch( const std::exception& )
+        {
+            item.m_ok = false;
+        }
+    }
+
+    item.m_done = true;
+}
+
+
+bool BOARD_PLOT_BATCH::Run()
+{
+    std::vector<int> pending;
+
+    // The layers are queued first: they are usually longer than the other jobs
+    for( int pass = 0;  pass < 2;  ++pass )
+    {
+        for( unsigned ii = 0;  ii < m_items.size();  ++ii )
+        {
+            if( !m_items[ii].m_done && ( m_items[ii].m_plotter != NULL ) == ( pass == 0 ) )
+                pending.push_back( ii );
+        }
+    }
+
+    JOB_SCHEDULER::Run( pending.size(), boost::bind( &BOARD_PLOT_BATCH::runItem, this,
+                                                     &pending, _1, _2 ) );
+
+    bool ok = true;
+
+    for( unsigned ii = 0;  ii < m_items.size();  ++ii )
+        ok = ok && m_items[ii].m_ok;
+
+    return ok;
+}
@@ -64,6 +64,13 @@ EDA_COLOR_T BRDITEMS_PLOTTER::getColor( LAYER_NUM aLayer )
 
 
 void BRDITEMS_PLOTTER::PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T aPlotMode )
+{
+    PlotPad( aPad, aColor, aPlotMode, aPad->GetSize() );
+}
+
+
+void BRDITEMS_PLOTTER::PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T aPlotMode,
+                                const wxSize& aSize )
 {
     wxPoint shape_pos = aPad->ShapePos();
 
@@ -74,18 +81,18 @@ void BRDITEMS_PLOTTER::PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T
     switch( aPad->GetShape() )
     {
     case PAD_SHAPE_CIRCLE:
-        m_plotter->FlashPadCircle( shape_pos, aPad->GetSize().x, aPlotMode );
+        m_plotter->FlashPadCircle( shape_pos, aSize.x, aPlotMode );
         break;
 
     case PAD_SHAPE_OVAL:
-        m_plotter->FlashPadOval( shape_pos, aPad->GetSize(),
+        m_plotter->FlashPadOval( shape_pos, aSize,
                                  aPad->GetOrientation(), aPlotMode );
         break;
 
     case PAD_SHAPE_TRAPEZOID:
         {
             wxPoint coord[4];
-            aPad->BuildPadPolygon( coord, wxSize(0,0), 0 );
+            aPad->BuildPadPolygon( coord, wxSize(0,0), 0, aSize );
             m_plotter->FlashPadTrapez( shape_pos, coord,
                                        aPad->GetOrientation(), aPlotMode );
         }
@@ -93,7 +100,7 @@ void BRDITEMS_PLOTTER::PlotPad( D_PAD* aPad, EDA_COLOR_T aColor, EDA_DRAW_MODE_T
 
     case PAD_SHAPE_RECT:
     default:
-        m_plotter->FlashPadRect( shape_pos, aPad->GetSize(),
+        m_plotter->FlashPadRect( shape_pos, aSize,
                                  aPad->GetOrientation(), aPlotMode );
         break;
     }
@@ -493,9 +500,9 @@ void BRDITEMS_PLOTTER::PlotFilledAreas( ZONE_CONTAINER* aZone )
     if( polysList.IsEmpty() )
         return;
 
-    // We need a buffer to store corners coordinates:
-    static std::vector< wxPoint > cornerList;
-    cornerList.clear();
+    // We need a buffer to store corners coordinates
+    // (not static: several layers can be plotted at the same time)
+    std::vector< wxPoint > cornerList;
 
     m_plotter->SetColor( getColor( aZone->GetLayer() ) );
 
@@ -35,6 +35,8 @@
 
 class PLOTTER;
 class BOARD;
+class BOARD_PLOT_BATCH;
+class EXCELLON_WRITER;
 
 
 /**
@@ -49,6 +51,7 @@ public:
     PLOT_CONTROLLER( BOARD *aBoard );
 
     /** Batch plotter destructor, ensures that the last plot is closed
+     * and that the queued files are created
      */
     ~PLOT_CONTROLLER();
 
@@ -84,6 +87,36 @@ public:
      */
     bool PlotLayer();
 
+    /**
+     * Function QueuePlotfile
+     * opens a new plotfile of the current layer, like OpenPlotfile(), but the layer is
+     * plotted by RunQueue(), at the same time as the other queued plotfiles.
+     * The plot options used are the current ones.
+     * @param aSuffix is a string added to the base filename (see OpenPlotfile())
+     * @param aFormat is the plot file format identifier
+     * @param aSheetDesc
+     * @return true if the plotfile has been created
+     */
+    bool QueuePlotfile( const wxString &aSuffix, PlotFormat aFormat,
+                        const wxString &aSheetDesc );
+
+    /**
+     * Function QueueDrillFiles
+     * queues the drill and drill map files of \a aWriter, which are created in
+     * \a aPlotDirectory by RunQueue() (see EXCELLON_WRITER::CreateDrillandMapFilesSet()).
+     * A copy of aWriter is queued: aWriter can be changed or deleted after this call.
+     */
+    void QueueDrillFiles( const EXCELLON_WRITER& aWriter, const wxString& aPlotDirectory,
+                          bool aGenDrill, bool aGenMap );
+
+    /**
+     * Function RunQueue
+     * plots the queued plotfiles and creates the queued drill files, on several threads,
+     * and empties the queue.  The board must not be modified until it returns.
+     * @return true if all the files have been created
+     */
+    bool RunQueue();
+
     /**
      * @return the current plot full filename, set by OpenPlotfile
      */
@@ -123,6 +156,17 @@ private:
 
     /// The current plot filename, set by OpenPlotfile
     wxFileName m_plotFile;
+
+    /// The queued plotfiles and drill files, NULL if the queue is empty
+    BOARD_PLOT_BATCH* m_queue;
+
+    /**
+     * Function buildPlotFileName
+     * sets m_plotFile to the name of the plotfile of the current layer
+     * (see OpenPlotfile()), and ensures its directory exists.
+     * @return false if the output directory cannot be created
+     */
+    bool buildPlotFileName( const wxString &aSuffix, PlotFormat aFormat );
 };
 
 #endif
@@ -49,6 +49,8 @@
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <set>
+#include <cmath>
 
 #ifdef PROFILE
 #include <profile.h>
@@ -72,6 +74,27 @@ static bool sortDistance( const RN_NODE_PTR& aOrigin, const RN_NODE_PTR& aNode1,
 }
 
 
+static bool sortNodeX( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
+{
+    return aNode1->GetX() < aNode2->GetX();
+}
+
+
+static bool nodeXLess( const RN_NODE_PTR& aNode, int aX )
+{
+    return aNode->GetX() < aX;
+}
+
+
+static bool sortNodePosition( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
+{
+    if( aNode1->GetX() != aNode2->GetX() )
+        return aNode1->GetX() < aNode2->GetX();
+
+    return aNode1->GetY() < aNode2->GetY();
+}
+
+
 static bool sortWeight( const RN_EDGE_PTR& aEdge1, const RN_EDGE_PTR& aEdge2 )
 {
     return aEdge1->GetWeight() < aEdge2->GetWeight();
@@ -137,6 +160,7 @@ static std::vector<RN_EDGE_MST_PTR>* kruskalMST( RN_LINKS::RN_EDGE_LIST& aEdges,
 
     // Lists of nodes connected together (subtrees) to detect cycles in the graph
     std::vector<std::list<int> > cycles( nodeNumber );
+    std::vector<unsigned int> cycleSizes( nodeNumber, 1 );
     for( unsigned int i = 0; i < nodeNumber; ++i )
         cycles[i].push_back( i );
 
@@ -159,6 +183,15 @@ static std::vector<RN_EDGE_MST_PTR>* kruskalMST( RN_LINKS::RN_EDGE_LIST& aEdges,
             if( !ratsnestLines && dt->GetWeight() != 0 )
                 ratsnestLines = true;
 
+            // Always retag the smaller subtree, otherwise joining a growing subtree to
+            // single nodes retags it over and over (quadratic for large nets). Tags are
+            // only compared for equality, so the tree itself does not change.
+            if( cycleSizes[srcTag] < cycleSizes[trgTag] )
+                std::swap( srcTag, trgTag );
+
+            cycleSizes[srcTag] += cycleSizes[trgTag];
+            cycleSizes[trgTag] = 0;
+
             // Update tags
             std::list<int>::iterator it, itEnd;
 
@@ -295,6 +328,9 @@ const RN_NODE_PTR& RN_LINKS::AddNode( int aX, int aY )
 
     boost::tie( node, wasNewElement ) = m_nodes.emplace( boost::make_shared<RN_NODE>( aX, aY ) );
 
+    if( wasNewElement )
+        m_addedNodes.push_back( *node );
+
     return *node;
 }
 
@@ -303,6 +339,7 @@ bool RN_LINKS::RemoveNode( const RN_NODE_PTR& aNode )
 {
     if( aNode->GetRefCount() == 0 )
     {
+        m_removedNodes.push_back( aNode );
         m_nodes.erase( aNode );
 
         return true;
@@ -323,6 +360,319 @@ RN_EDGE_MST_PTR RN_LINKS::AddConnection( const RN_NODE_PTR& aNode1, const RN_NOD
 }
 
 
+///> Number of local triangulation updates before the net is triangulated from scratch
+///> (local updates accumulate redundant candidate edges).
+static const int MAX_INCREMENTAL_UPDATES = 32;
+
+
+static void triangulateNodes( std::vector<RN_NODE_PTR>& aNodes,
+                              std::vector<RN_EDGE_MST_PTR>& aEdges )
+{
+    if( aNodes.size() < 3 )
+    {
+        if( aNodes.size() == 2 )
+            aEdges.push_back( boost::make_shared<RN_EDGE_MST>( aNodes[0], aNodes[1],
+                                                  getDistance( aNodes[0], aNodes[1] ) ) );
+
+        return;
+    }
+
+    TRIANGULATOR triangulator;
+    triangulator.CreateDelaunay( aNodes.begin(), aNodes.end() );
+    boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( triangulator.GetEdges() );
+
+    // Triangulation edges are only valid as long as the triangulator exists,
+    // so store them as independent edges with their weight/distance
+    RN_LINKS::RN_EDGE_LIST::iterator eit, eitEnd;
+    for( eit = (*triangEdges).begin(), eitEnd = (*triangEdges).end(); eit != eitEnd; ++eit )
+    {
+        const RN_NODE_PTR& source = (*eit)->GetSourceNode();
+        const RN_NODE_PTR& target = (*eit)->GetTargetNode();
+
+        aEdges.push_back( boost::make_shared<RN_EDGE_MST>( source, target,
+                                                           getDistance( source, target ) ) );
+    }
+}
+
+
+void RN_NET::triangulate()
+{
+    const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
+
+    // Move and sort (sorting speeds up) all nodes to a vector for the Delaunay triangulation.
+    // Nodes are sorted by their position, so the result does not depend on memory addresses.
+    std::vector<RN_NODE_PTR> nodes( boardNodes.size() );
+    std::partial_sort_copy( boardNodes.begin(), boardNodes.end(), nodes.begin(), nodes.end(),
+                            sortNodePosition );
+
+    m_triangEdges.clear();
+    triangulateNodes( nodes, m_triangEdges );
+
+    m_triangValid = true;
+    m_incrementalUpdates = 0;
+}
+
+
+/**
+ * Function circumcircleInside
+ * @return true if the part of the circumcircle of the triangle aA, aB, aC that is inside of
+ * aNetArea (i.e. where there might be nodes) is also inside of aArea (false for degenerate
+ * triangles).
+ */
+static bool circumcircleInside( const RN_NODE_PTR& aA, const RN_NODE_PTR& aB,
+                                const RN_NODE_PTR& aC, const BOX2I& aArea,
+                                const BOX2I& aNetArea )
+{
+    // Relative to aA, to keep the precision
+    double bx = (double) aB->GetX() - aA->GetX();
+    double by = (double) aB->GetY() - aA->GetY();
+    double cx = (double) aC->GetX() - aA->GetX();
+    double cy = (double) aC->GetY() - aA->GetY();
+    double d = 2.0 * ( bx * cy - by * cx );
+
+    if( d == 0.0 )
+        return false;
+
+    double b2 = bx * bx + by * by;
+    double c2 = cx * cx + cy * cy;
+    double ux = ( cy * b2 - by * c2 ) / d;
+    double uy = ( bx * c2 - cx * b2 ) / d;
+
+    // Round the radius up, nodes exactly on the circle do not matter
+    double r = hypot( ux, uy ) * ( 1.0 + 1e-9 ) + 1.0;
+
+    ux += aA->GetX();
+    uy += aA->GetY();
+
+    // Triangles along the outline of the net have huge circumcircles, but there are no
+    // nodes outside of aNetArea
+    return std::max( ux - r, (double) aNetArea.GetX() ) >= aArea.GetX()
+        && std::min( ux + r, (double) aNetArea.GetRight() ) <= aArea.GetRight()
+        && std::max( uy - r, (double) aNetArea.GetY() ) >= aArea.GetY()
+        && std::min( uy + r, (double) aNetArea.GetBottom() ) <= aArea.GetBottom();
+}
+
+
+/**
+ * Function isHullEdge
+ * @return true if no node of aNodes is strictly on the other side of the edge aA-aB than
+ * aInside.
+ */
+static bool isHullEdge( const RN_NODE_PTR& aA, const RN_NODE_PTR& aB, const RN_NODE_PTR& aInside,
+                        const RN_LINKS::RN_NODE_SET& aNodes )
+{
+    // Nodes of a board are less than 2^31 apart, so the cross products fit in 64 bits
+    int64_t dx = (int64_t) aB->GetX() - aA->GetX();
+    int64_t dy = (int64_t) aB->GetY() - aA->GetY();
+    int64_t inside = dx * ( (int64_t) aInside->GetY() - aA->GetY() )
+                     - dy * ( (int64_t) aInside->GetX() - aA->GetX() );
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, aNodes )
+    {
+        int64_t side = dx * ( (int64_t) node->GetY() - aA->GetY() )
+                       - dy * ( (int64_t) node->GetX() - aA->GetX() );
+
+        if( ( inside > 0 && side < 0 ) || ( inside < 0 && side > 0 ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+bool RN_NET::triangulateArea( const std::vector<RN_NODE_PTR>& aSeeds )
+{
+    const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
+
+    if( aSeeds.empty() )
+        return true;
+
+    std::set<const RN_NODE*> seeds;
+    BOX2I area( VECTOR2I( aSeeds[0]->GetX(), aSeeds[0]->GetY() ), VECTOR2I( 0, 0 ) );
+    BOX2I netArea = area;
+
+    BOOST_FOREACH( const RN_NODE_PTR& seed, aSeeds )
+    {
+        seeds.insert( seed.get() );
+        area.Merge( VECTOR2I( seed->GetX(), seed->GetY() ) );
+    }
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, boardNodes )
+        netArea.Merge( VECTOR2I( node->GetX(), node->GetY() ) );
+
+    // Start with about twice the average distance between the nodes
+    double margin = 2.0 * sqrt( (double) netArea.GetWidth() * netArea.GetHeight()
+                                / boardNodes.size() ) + 1.0;
+
+    while( margin < std::numeric_limits<int>::max() / 4 )
+    {
+        BOX2I inflated = area;
+        inflated.Inflate( (int) margin );
+        margin *= 2.0;
+
+        std::vector<RN_NODE_PTR> nodes;
+
+        BOOST_FOREACH( const RN_NODE_PTR& node, boardNodes )
+        {
+            if( inflated.Contains( VECTOR2I( node->GetX(), node->GetY() ) ) )
+                nodes.push_back( node );
+        }
+
+        if( nodes.size() * 2 > boardNodes.size() )
+            return false;
+
+        if( nodes.size() < 3 )
+            continue;
+
+        std::sort( nodes.begin(), nodes.end(), sortNodePosition );
+
+        TRIANGULATOR triangulator;
+        triangulator.CreateDelaunay( nodes.begin(), nodes.end() );
+
+        // The triangles of a seed are the ones of the whole net if their circumcircles are
+        // inside of the area (so no node outside of it can change them), and if they surround
+        // the seed, apart from the edges on the outline of the net
+        std::set<const RN_NODE*> covered;
+        bool valid = true;
+
+        BOOST_FOREACH( const RN_EDGE_PTR& leadingEdge, triangulator.GetLeadingEdges() )
+        {
+            const RN_EDGE_PTR& e2 = leadingEdge->GetNextEdgeInFace();
+            const RN_EDGE_PTR& e3 = e2->GetNextEdgeInFace();
+            const RN_EDGE_PTR* edges[3] = { &leadingEdge, &e2, &e3 };
+            bool hasSeed = false;
+
+            for( int i = 0; i < 3 && valid; ++i )
+            {
+                const RN_EDGE_PTR& edge = *edges[i];
+                const RN_NODE_PTR& source = edge->GetSourceNode();
+                const RN_NODE_PTR& target = edge->GetTargetNode();
+
+                if( seeds.count( source.get() ) )
+                {
+                    hasSeed = true;
+                    covered.insert( source.get() );
+                }
+
+                if( !edge->GetTwinEdge()
+                        && ( seeds.count( source.get() ) || seeds.count( target.get() ) ) )
+                {
+                    const RN_NODE_PTR& opposite = ( *edges[( i + 2 ) % 3] )->GetSourceNode();
+
+                    valid = isHullEdge( source, target, opposite, boardNodes );
+                }
+            }
+
+            if( valid && hasSeed && !circumcircleInside( leadingEdge->GetSourceNode(),
+                                                         e2->GetSourceNode(),
+                                                         e3->GetSourceNode(), inflated,
+                                                         netArea ) )
+                valid = false;
+
+            if( !valid )
+                break;
+        }
+
+        // A seed without triangles (e.g. with collinear nodes around it) has unknown edges
+        if( !valid || covered.size() < seeds.size() )
+            continue;
+
+        boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( triangulator.GetEdges() );
+
+        BOOST_FOREACH( const RN_EDGE_PTR& edge, *triangEdges )
+        {
+            const RN_NODE_PTR& source = edge->GetSourceNode();
+            const RN_NODE_PTR& target = edge->GetTargetNode();
+
+            if( seeds.count( source.get() ) || seeds.count( target.get() ) )
+                m_triangEdges.push_back( boost::make_shared<RN_EDGE_MST>( source, target,
+                                                             getDistance( source, target ) ) );
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+bool RN_NET::updateTriangulation()
+{
+    const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
+    const std::vector<RN_NODE_PTR>& added = m_links.GetAddedNodes();
+    const std::vector<RN_NODE_PTR>& removed = m_links.GetRemovedNodes();
+
+    if( added.empty() && removed.empty() )
+        return true;
+
+    std::set<const RN_NODE*> addedSet, removedSet;
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, added )
+        addedSet.insert( node.get() );
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, removed )
+        removedSet.insert( node.get() );
+
+    // Nodes added and removed again (e.g. while an item was dragged) are not a part of the
+    // triangulation, nor of the net anymore
+    std::vector<RN_NODE_PTR> newNodes;
+    std::set<const RN_NODE*> seedSet;
+    unsigned int removedCount = 0;
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, added )
+    {
+        if( !removedSet.count( node.get() ) && seedSet.insert( node.get() ).second )
+            newNodes.push_back( node );
+    }
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, removed )
+    {
+        if( !addedSet.count( node.get() ) )
+            ++removedCount;
+    }
+
+    if( ( newNodes.size() + removedCount ) * 4 > boardNodes.size() )
+        return false;
+
+    // Drop edges of the removed nodes; their neighbours have to be connected again
+    std::vector<RN_NODE_PTR> neighbours;
+    unsigned int kept = 0;
+
+    for( unsigned int i = 0; i < m_triangEdges.size(); ++i )
+    {
+        const RN_NODE_PTR& source = m_triangEdges[i]->GetSourceNode();
+        const RN_NODE_PTR& target = m_triangEdges[i]->GetTargetNode();
+        bool sourceRemoved = removedSet.count( source.get() );
+        bool targetRemoved = removedSet.count( target.get() );
+
+        if( !sourceRemoved && !targetRemoved )
+        {
+            m_triangEdges[kept++] = m_triangEdges[i];
+            continue;
+        }
+
+        if( !sourceRemoved && seedSet.insert( source.get() ).second )
+            neighbours.push_back( source );
+
+        if( !targetRemoved && seedSet.insert( target.get() ).second )
+            neighbours.push_back( target );
+    }
+
+    m_triangEdges.resize( kept );
+
+    // The kept edges are the Delaunay edges of the net, apart from the edges replacing the
+    // ones of the removed nodes (which link their neighbours) and the edges of the added
+    // nodes.  Both sets are handled separately, as e.g. a moved footprint leaves a hole in
+    // one place and adds nodes in another one.
+    if( !triangulateArea( neighbours ) || !triangulateArea( newNodes ) )
+        return false;
+
+    ++m_incrementalUpdates;
+
+    return true;
+}
+
+
 void RN_NET::compute()
 {
     const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
@@ -346,27 +696,29 @@ void RN_NET::compute()
         BOOST_FOREACH( RN_NODE_PTR node, boardNodes )
             node->SetTag( 0 );
 
+        m_triangEdges.clear();
+        m_triangValid = false;
+        m_links.ClearChanges();
+
         return;
     }
 
-    // Move and sort (sorting speeds up) all nodes to a vector for the Delaunay triangulation
-    std::vector<RN_NODE_PTR> nodes( boardNodes.size() );
-    std::partial_sort_copy( boardNodes.begin(), boardNodes.end(), nodes.begin(), nodes.end() );
+    if( !m_triangValid || m_incrementalUpdates >= MAX_INCREMENTAL_UPDATES
+            || !updateTriangulation() )
+    {
+        triangulate();
+    }
 
-    TRIANGULATOR triangulator;
-    triangulator.CreateDelaunay( nodes.begin(), nodes.end() );
-    boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( triangulator.GetEdges() );
+    m_links.ClearChanges();
 
-    // Compute weight/distance for edges resulting from triangulation
-    RN_LINKS::RN_EDGE_LIST::iterator eit, eitEnd;
-    for( eit = (*triangEdges).begin(), eitEnd = (*triangEdges).end(); eit != eitEnd; ++eit )
-        (*eit)->SetWeight( getDistance( (*eit)->GetSourceNode(), (*eit)->GetTargetNode() ) );
+    std::vector<RN_NODE_PTR> nodes( boardNodes.begin(), boardNodes.end() );
 
-    // Add the currently existing connections list to the results of triangulation
-    std::copy( boardEdges.begin(), boardEdges.end(), std::front_inserter( *triangEdges ) );
+    // Add the currently existing connections list to the triangulation edges
+    RN_LINKS::RN_EDGE_LIST edges( m_triangEdges.begin(), m_triangEdges.end() );
+    std::copy( boardEdges.begin(), boardEdges.end(), std::front_inserter( edges ) );
 
     // Get the minimal spanning tree
-    m_rnEdges.reset( kruskalMST( *triangEdges, nodes ) );
+    m_rnEdges.reset( kruskalMST( edges, nodes ) );
 }
 
 
@@ -466,6 +818,9 @@ void RN_NET::AddItem( const ZONE_CONTAINER* aZone )
     // Prepare a list of polygons (every zone can contain one or more polygons)
     const SHAPE_POLY_SET& polySet = aZone->GetFilledPolysList();
 
+    // RN_POLY::HitTest() queries may run in parallel (see RN_DATA::Recalculate())
+    polySet.BuildEdgeIndex();
+
     for( int i = 0; i < polySet.OutlineCount(); ++i )
     {
         const SHAPE_LINE_CHAIN& path = polySet.COutline( i );
@@ -992,6 +1347,11 @@ void RN_NET::processZones()
 
 void RN_NET::processPads()
 {
+    // Nodes sorted by their x coordinate, so every pad tests only the nodes in its vicinity
+    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
+    std::vector<RN_NODE_PTR> candidates( nodes.begin(), nodes.end() );
+    std::sort( candidates.begin(), candidates.end(), sortNodeX );
+
     for( PAD_NODE_MAP::iterator it = m_pads.begin(); it != m_pads.end(); ++it )
     {
         const D_PAD* pad = it->first;
@@ -1002,15 +1362,23 @@ void RN_NET::processPads()
         BOOST_FOREACH( RN_EDGE_MST_PTR edge, edges )
             m_links.RemoveConnection( edge );
 
+        edges.clear();
+
         LSET layers = pad->GetLayerSet();
-        RN_LINKS::RN_NODE_SET candidates = m_links.GetNodes();
-        RN_LINKS::RN_NODE_SET::iterator point, pointEnd;
 
-        point = candidates.begin();
+        // D_PAD::HitTest() rejects points outside the bounding radius square
+        wxPoint center = pad->ShapePos();
+        int radius = pad->GetBoundingRadius();
+
+        std::vector<RN_NODE_PTR>::iterator point, pointEnd;
+        point = std::lower_bound( candidates.begin(), candidates.end(), center.x - radius, nodeXLess );
         pointEnd = candidates.end();
 
-        while( point != pointEnd )
+        for( ; point != pointEnd && (*point)->GetX() <= center.x + radius; ++point )
         {
+            if( std::abs( (*point)->GetY() - center.y ) > radius )
+                continue;
+
             if( *point != node && ( (*point)->GetLayers() & layers ).any() &&
                     pad->HitTest( wxPoint( (*point)->GetX(), (*point)->GetY() ) ) )
             {
@@ -1019,8 +1387,6 @@ void RN_NET::processPads()
                 RN_EDGE_MST_PTR connection = m_links.AddConnection( node, *point );
                 edges.push_back( connection );
             }
-
-            ++point;
         }
     }
 }
@@ -1216,6 +1582,29 @@ void RN_DATA::ProcessBoard()
 }
 
 
+int RN_DATA::m_threadCount = 0;
+
+
+///> Orders net codes by decreasing net size (and by net code, for nets of equal size).
+struct BIGGER_NET_FIRST
+{
+    BIGGER_NET_FIRST( const std::vector<RN_NET>& aNets ) : m_nets( aNets ) {}
+
+    bool operator()( int aNet1, int aNet2 ) const
+    {
+        unsigned int size1 = m_nets[aNet1].GetNodeCount();
+        unsigned int size2 = m_nets[aNet2].GetNodeCount();
+
+        if( size1 != size2 )
+            return size1 > size2;
+
+        return aNet1 < aNet2;
+    }
+
+    const std::vector<RN_NET>& m_nets;
+};
+
+
 void RN_DATA::Recalculate( int aNet )
 {
     unsigned int netCount = m_board->GetNetCount();
@@ -1230,22 +1619,31 @@ void RN_DATA::Recalculate( int aNet )
     prof_start( &totalRealTime );
 #endif
 
-        unsigned int i;
+        std::vector<int> dirtyNets;
 
-#ifdef USE_OPENMP
-        #pragma omp parallel shared(netCount) private(i)
+        // Start with net number 1, as 0 stands for not connected
+        for( unsigned int i = 1; i < netCount; ++i )
         {
-            #pragma omp for schedule(guided, 1)
-#else /* USE_OPENMP */
-        {
-#endif
-            // Start with net number 1, as 0 stands for not connected
-            for( i = 1; i < netCount; ++i )
-            {
-                if( m_nets[i].IsDirty() )
-                    updateNet( i );
-            }
-        }  /* end of parallel section */
+            if( m_nets[i].IsDirty() )
+                dirtyNets.push_back( i );
+        }
+
+        // The biggest nets go first, so none of them is left to be computed at the end
+        // while other threads are idle
+        std::sort( dirtyNets.begin(), dirtyNets.end(), BIGGER_NET_FIRST( m_nets ) );
+
+        int count = dirtyNets.size();
+        int i;
+
+        // Every net is computed by a single thread and writes only its own data
+#ifdef USE_OPENMP
+        int threadCount = m_threadCount > 0 ? m_threadCount : omp_get_num_procs();
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(threadCount) private(i)
+#endif /* USE_OPENMP */
+        for( i = 0; i < count; ++i )
+            updateNet( dirtyNets[i] );
+
 #ifdef PROFILE
     prof_end( &totalRealTime );
 
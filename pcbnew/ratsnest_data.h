@@ -39,6 +39,9 @@
 #include <boost/unordered_map.hpp>
 #include <boost/foreach.hpp>
 
+#include <vector>
+#include <algorithm>
+
 class BOARD;
 class BOARD_ITEM;
 class BOARD_CONNECTED_ITEM;
@@ -215,6 +218,34 @@ public:
         return m_nodes;
     }
 
+    /**
+     * Function GetAddedNodes()
+     * Returns the nodes added since the last call to ClearChanges().
+     */
+    const std::vector<RN_NODE_PTR>& GetAddedNodes() const
+    {
+        return m_addedNodes;
+    }
+
+    /**
+     * Function GetRemovedNodes()
+     * Returns the nodes removed since the last call to ClearChanges().
+     */
+    const std::vector<RN_NODE_PTR>& GetRemovedNodes() const
+    {
+        return m_removedNodes;
+    }
+
+    /**
+     * Function ClearChanges()
+     * Clears the lists of added and removed nodes.
+     */
+    void ClearChanges()
+    {
+        m_addedNodes.clear();
+        m_removedNodes.clear();
+    }
+
     /**
      * Function AddConnection()
      * Adds a connection between two nodes and of given distance. Edges with distance equal 0 are
@@ -254,6 +285,12 @@ protected:
 
     ///> List of edges that currently connect nodes.
     RN_EDGE_LIST m_edges;
+
+    ///> Nodes added since the last call to ClearChanges().
+    std::vector<RN_NODE_PTR> m_addedNodes;
+
+    ///> Nodes removed since the last call to ClearChanges().
+    std::vector<RN_NODE_PTR> m_removedNodes;
 };
 
 
@@ -319,7 +356,8 @@ class RN_NET
 {
 public:
     ///> Default constructor.
-    RN_NET() : m_dirty( true ), m_visible( true )
+    RN_NET() : m_dirty( true ), m_triangValid( false ), m_incrementalUpdates( 0 ),
+        m_visible( true )
     {}
 
     /**
@@ -363,6 +401,16 @@ public:
         return m_dirty;
     }
 
+    /**
+     * Function GetNodeCount()
+     * Returns the number of nodes in the net, which is a measure of its ratsnest computation cost.
+     * @return Number of nodes.
+     */
+    unsigned int GetNodeCount() const
+    {
+        return m_links.GetNodes().size();
+    }
+
     /**
      * Function GetUnconnected()
      * Returns pointer to a vector of edges that makes ratsnest for a given net.
@@ -567,9 +615,33 @@ protected:
     ///> Adds additional edges to account for connections made by items located in pads areas.
     void processPads();
 
-    ///> Recomputes ratsnset from scratch.
+    ///> Recomputes ratsnset, triangulating again only the nodes around the changed ones
+    ///> if possible. The minimal spanning tree is always computed again from all the edges.
     void compute();
 
+    ///> Triangulates all the nodes and stores the resulting edges in m_triangEdges.
+    void triangulate();
+
+    /**
+     * Function updateTriangulation()
+     * Updates m_triangEdges after the node set has changed, so it still contains all the
+     * Delaunay edges of the nodes (and so a minimal spanning tree): edges of the removed
+     * nodes are dropped, and the Delaunay edges of their neighbours and of the added nodes
+     * are added.
+     * @return False if the change is too large, and the whole net should be triangulated.
+     */
+    bool updateTriangulation();
+
+    /**
+     * Function triangulateArea()
+     * Adds to m_triangEdges the Delaunay edges of a set of nodes.  The nodes around them
+     * are triangulated in a growing area, until the circumcircles of all the triangles of
+     * the seeds are inside of the area (so no node outside of it can change them).
+     * @param aSeeds are the nodes whose edges are needed.
+     * @return False if the area has to contain too many nodes to be worth a local update.
+     */
+    bool triangulateArea( const std::vector<RN_NODE_PTR>& aSeeds );
+
     ////> Stores information about connections for a given net.
     RN_LINKS m_links;
 
@@ -585,6 +657,17 @@ protected:
     ///> Flag indicating necessity of recalculation of ratsnest for a net.
     bool m_dirty;
 
+    ///> Edges of the Delaunay triangulation of nodes (candidates for ratsnest edges), kept
+    ///> between updates so small changes do not require triangulating the whole net.
+    std::vector<RN_EDGE_MST_PTR> m_triangEdges;
+
+    ///> Flag indicating that m_triangEdges matches the nodes, apart from the changes
+    ///> recorded by m_links.
+    bool m_triangValid;
+
+    ///> Number of local updates of m_triangEdges since the last full triangulation.
+    int m_incrementalUpdates;
+
     ///> Structure to hold ratsnest data for ZONE_CONTAINER objects.
     typedef struct
     {
@@ -699,10 +782,32 @@ public:
     /**
      * Function Recalculate()
      * Recomputes ratsnest for selected net number or all nets that need updating.
+     * Nets are independent, so they are recomputed in parallel (the biggest nets first).
+     * The result does not depend on the number of threads.
      * @param aNet is a net number. If it is negative, all nets that need updating are recomputed.
      */
     void Recalculate( int aNet = -1 );
 
+    /**
+     * Function SetThreadCount()
+     * Sets the number of threads used to recompute nets.
+     * @param aCount is the number of threads, 0 stands for the number of available processors.
+     */
+    static void SetThreadCount( int aCount )
+    {
+        m_threadCount = std::max( aCount, 0 );
+    }
+
+    /**
+     * Function GetThreadCount()
+     * Returns the number of threads used to recompute nets (0 stands for the number of
+     * available processors).
+     */
+    static int GetThreadCount()
+    {
+        return m_threadCount;
+    }
+
     /**
      * Function GetNetCount()
      * Returns the number of nets handled by the ratsnest.
@@ -776,6 +881,9 @@ protected:
 
     ///> Stores information about ratsnest grouped by net numbers.
     std::vector<RN_NET> m_nets;
+
+    ///> Number of threads used to recompute nets (0 for the number of available processors).
+    static int m_threadCount;
 };
 
 #endif /* RATSNEST_DATA_H */
@@ -138,7 +138,7 @@ bool PNS_LINE_PLACER::handleSelfIntersections()
     // from the beginning
     if( n < 2 )
     {
-        m_p_start = tail.Point( 0 );
+        m_p_start = tail.CPoint( 0 );
         m_direction = m_initial_direction;
         tail.Clear();
         head.Clear();
@@ -1062,7 +1062,7 @@ bool PNS_LINE_PLACER::buildInitialLine( const VECTOR2I& aP, PNS_LINE& aHead )
             VECTOR2I newLast = l.CSegment( 0 ).LineProject( l.CPoint( -1 ) );
 
             l.Remove( -1, -1 );
-            l.Point( 1 ) = newLast;
+            l.SetPoint( 1, newLast );
         }
     }
 
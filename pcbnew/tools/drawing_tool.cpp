@@ -1498,9 +1498,9 @@ void DRAWING_TOOL::make45DegLine( DRAWSEGMENT* aSegment, DRAWSEGMENT* aHelper )
 
     if( newChain.PointCount() > 2 )
     {
-        aSegment->SetEnd( wxPoint( newChain.Point( -2 ).x, newChain.Point( -2 ).y ) );
-        aHelper->SetStart( wxPoint( newChain.Point( -2 ).x, newChain.Point( -2 ).y ) );
-        aHelper->SetEnd( wxPoint( newChain.Point( -1 ).x, newChain.Point( -1 ).y ) );
+        aSegment->SetEnd( wxPoint( newChain.CPoint( -2 ).x, newChain.CPoint( -2 ).y ) );
+        aHelper->SetStart( wxPoint( newChain.CPoint( -2 ).x, newChain.CPoint( -2 ).y ) );
+        aHelper->SetEnd( wxPoint( newChain.CPoint( -1 ).x, newChain.CPoint( -1 ).y ) );
     }
     else
     {
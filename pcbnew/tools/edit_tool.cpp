@@ -30,6 +30,7 @@
 #include <class_edge_mod.h>
 #include <class_zone.h>
 #include <wxPcbStruct.h>
+#include <pcbnew.h>
 #include <kiway.h>
 #include <class_draw_panel_gal.h>
 #include <module_editor_frame.h>
@@ -225,6 +226,9 @@ int EDIT_TOOL::Main( const TOOL_EVENT& aEvent )
                         editFrame->SaveCopyInUndoList( selection.items, UR_CHANGED );
                     }
 
+                    // The zones filled around the items will be refilled at their new position
+                    invalidateZoneFills( selection.items );
+
                     m_cursor = controls->GetCursorPosition();
 
                     if( selection.Size() == 1 )
@@ -317,6 +321,9 @@ int EDIT_TOOL::Main( const TOOL_EVENT& aEvent )
         }
     } while( evt = Wait() );
 
+    // The items were saved in the undo list only if they were dragged
+    bool dragged = m_dragging;
+
     if( m_dragging )
         decUndoInhibit();
 
@@ -334,6 +341,12 @@ int EDIT_TOOL::Main( const TOOL_EVENT& aEvent )
     {
         // Changes are applied, so update the items
         selection.group->ItemsViewUpdate( m_updateFlag );
+
+        if( dragged )
+        {
+            invalidateZoneFills( selection.items );
+            refillDirtyZones();
+        }
     }
 
     if( unselect )
@@ -443,6 +456,10 @@ int EDIT_TOOL::Rotate( const TOOL_EVENT& aEvent )
         editFrame->SaveCopyInUndoList( selection.items, UR_ROTATED, rotatePoint );
     }
 
+    // When dragging, the zones are refilled at the end of the move
+    if( !m_dragging )
+        invalidateZoneFills( selection.items );
+
     for( unsigned int i = 0; i < selection.items.GetCount(); ++i )
     {
         BOARD_ITEM* item = selection.Item<BOARD_ITEM>( i );
@@ -453,6 +470,12 @@ int EDIT_TOOL::Rotate( const TOOL_EVENT& aEvent )
             item->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );
     }
 
+    if( !m_dragging )
+    {
+        invalidateZoneFills( selection.items );
+        refillDirtyZones();
+    }
+
     updateRatsnest( m_dragging );
 
     // Update dragging offset (distance between cursor and the first dragged item)
@@ -492,6 +515,10 @@ int EDIT_TOOL::Flip( const TOOL_EVENT& aEvent )
         editFrame->SaveCopyInUndoList( selection.items, UR_FLIPPED, flipPoint );
     }
 
+    // When dragging, the zones are refilled at the end of the move
+    if( !m_dragging )
+        invalidateZoneFills( selection.items );
+
     for( unsigned int i = 0; i < selection.items.GetCount(); ++i )
     {
         BOARD_ITEM* item = selection.Item<BOARD_ITEM>( i );
@@ -502,6 +529,12 @@ int EDIT_TOOL::Flip( const TOOL_EVENT& aEvent )
             item->ViewUpdate( KIGFX::VIEW_ITEM::LAYERS );
     }
 
+    if( !m_dragging )
+    {
+        invalidateZoneFills( selection.items );
+        refillDirtyZones();
+    }
+
     updateRatsnest( m_dragging );
 
     // Update dragging offset (distance between cursor and the first dragged item)
@@ -543,10 +576,14 @@ int EDIT_TOOL::Remove( const TOOL_EVENT& aEvent )
     editFrame->OnModify();
     editFrame->SaveCopyInUndoList( selectedItems, UR_DELETED );
 
+    invalidateZoneFills( selectedItems );
+
     // And now remove
     for( unsigned int i = 0; i < selectedItems.GetCount(); ++i )
         remove( static_cast<BOARD_ITEM*>( selectedItems.GetPickedItem( i ) ) );
 
+    refillDirtyZones();
+
     getModel<BOARD>()->GetRatsnest()->Recalculate();
 
     return 0;
@@ -991,6 +1028,58 @@ bool EDIT_TOOL::hoverSelection( const SELECTION& aSelection, bool aSanitize )
     return !aSelection.Empty();
 }
 
+void EDIT_TOOL::invalidateZoneFills( const PICKED_ITEMS_LIST& aItems )
+{
+    if( !g_AutoRefillZones )
+        return;
+
+    BOARD* board = getModel<BOARD>();
+
+    for( unsigned int i = 0; i < aItems.GetCount(); ++i )
+        board->InvalidateZoneFills( static_cast<BOARD_ITEM*>( aItems.GetPickedItem( i ) ) );
+}
+
+
+void EDIT_TOOL::refillDirtyZones()
+{
+    if( !g_AutoRefillZones )
+        return;
+
+    BOARD* board = getModel<BOARD>();
+    PCB_BASE_EDIT_FRAME* editFrame = getEditFrame<PCB_BASE_EDIT_FRAME>();
+    std::vector<PICKED_ITEMS_LIST*>& undoList = editFrame->GetScreen()->m_UndoList.m_CommandsList;
+
+    // The zones are saved in the undo command of the modification as they are before the
+    // refill, so undo and redo give back the copper matching the items
+    if( !undoList.empty() )
+    {
+        PICKED_ITEMS_LIST* command = undoList.back();
+
+        for( int ii = 0; ii < board->GetAreaCount(); ii++ )
+        {
+            ZONE_CONTAINER* zone = board->GetArea( ii );
+
+            if( !zone->IsFillDirty() || command->ContainsItem( zone ) )
+                continue;
+
+            ITEM_PICKER picker( zone, UR_CHANGED );
+            picker.SetLink( zone->Clone() );
+            command->PushItem( picker );
+        }
+    }
+
+    std::vector<ZONE_CONTAINER*> refilledZones;
+
+    board->RefillDirtyZones( &refilledZones );
+
+    for( unsigned int i = 0; i < refilledZones.size(); ++i )
+    {
+        refilledZones[i]->ViewUpdate( KIGFX::VIEW_ITEM::ALL );
+        board->GetRatsnest()->Update( refilledZones[i] );
+    }
+}
+
+
 void EDIT_TOOL::processUndoBuffer( const PICKED_ITEMS_LIST* aLastChange )
 {
     PCB_BASE_EDIT_FRAME* editFrame = getEditFrame<PCB_BASE_EDIT_FRAME>();
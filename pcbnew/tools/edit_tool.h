@@ -178,6 +178,15 @@ private:
     ///> the cursor or displays a disambiguation menu if there are multpile items.
     bool hoverSelection( const SELECTION& aSelection, bool aSanitize = true );
 
+    ///> Tells the filled zones that the items were modified at their current position, so
+    ///> refillDirtyZones() rebuilds the copper around them (see BOARD::InvalidateZoneFills()).
+    ///> Does nothing unless g_AutoRefillZones is set.
+    void invalidateZoneFills( const PICKED_ITEMS_LIST& aItems );
+
+    ///> Adds the zones to refill to the last undo command, refills them, and updates their
+    ///> view and ratsnest.  Must be called after the modification is saved in the undo list.
+    void refillDirtyZones();
+
     ///> Processes the current undo buffer since the last change. If the last change does not occur
     ///> in the current buffer, then the whole list is processed.
     void processUndoBuffer( const PICKED_ITEMS_LIST* aLastChange );
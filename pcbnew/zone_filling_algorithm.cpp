@@ -29,10 +29,19 @@
 
 #include <algorithm> // sort
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+
 #include <fctsys.h>
 #include <trigo.h>
 #include <wxPcbStruct.h>
 
+#include <class_board.h>
+#include <class_module.h>
 #include <class_zone.h>
 
 #include <pcbnew.h>
@@ -54,32 +63,19 @@
  * to add holes for pads and tracks and other items not in net.
  */
 
-bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer )
+CPolyLine* ZONE_CONTAINER::createSmoothedPoly() const
 {
-    /* convert outlines + holes to outlines without holes (adding extra segments if necessary)
-     * m_Poly data is expected normalized, i.e. NormalizeAreaOutlines was used after building
-     * this zone
-     */
-
-    if( GetNumCorners() <= 2 )  // malformed zone. polygon calculations do not like it ...
-        return 0;
-
-    // Make a smoothed polygon out of the user-drawn polygon if required
-    if( m_smoothedPoly )
-    {
-        delete m_smoothedPoly;
-        m_smoothedPoly = NULL;
-    }
+    // Chamfer() and Fillet() remove the null segments of the outline they smooth:
+    // smooth a copy, m_Poly can be read by other threads
+    CPolyLine outline( *m_Poly );
 
     switch( m_cornerSmoothingType )
     {
     case ZONE_SETTINGS::SMOOTHING_CHAMFER:
-        m_smoothedPoly = m_Poly->Chamfer( m_cornerRadius );
-        break;
+        return outline.Chamfer( m_cornerRadius );
 
     case ZONE_SETTINGS::SMOOTHING_FILLET:
-        m_smoothedPoly = m_Poly->Fillet( m_cornerRadius, m_ArcToSegmentsCount );
-        break;
+        return outline.Fillet( m_cornerRadius, m_ArcToSegmentsCount );
 
     default:
         // Acute angles between adjacent edges can create issues in calculations,
@@ -87,39 +83,64 @@ bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET*
         // We can avoid issues by creating a very small chamfer which remove acute angles,
         // or left it without chamfer and use only CPOLYGONS_LIST::InflateOutline to create
         // clearance areas
-        m_smoothedPoly = m_Poly->Chamfer( Millimeter2iu( 0.0 ) );
-        break;
+        return outline.Chamfer( Millimeter2iu( 0.0 ) );
     }
+}
 
+
+void ZONE_CONTAINER::BuildSmoothedPoly()
+{
+    delete m_smoothedPoly;
+    m_smoothedPoly = createSmoothedPoly();
+}
+
+
+bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, SHAPE_POLY_SET* aOutlineBuffer )
+{
+    /* convert outlines + holes to outlines without holes (adding extra segments if necessary)
+     * m_Poly data is expected normalized, i.e. NormalizeAreaOutlines was used after building
+     * this zone
+     */
+
+    if( GetNumCorners() <= 2 )  // malformed zone. polygon calculations do not like it ...
+        return 0;
+
+    // Only the outline is needed: use a smoothed copy of the outline, and leave
+    // m_smoothedPoly untouched, because this zone can be filled at the same time
     if( aOutlineBuffer )
-        aOutlineBuffer->Append( ConvertPolyListToPolySet( m_smoothedPoly->m_CornersList ) );
+    {
+        boost::scoped_ptr<CPolyLine> smoothedPoly( createSmoothedPoly() );
+        aOutlineBuffer->Append( ConvertPolyListToPolySet( smoothedPoly->m_CornersList ) );
+
+        return true;
+    }
+
+    // Make a smoothed polygon out of the user-drawn polygon if required
+    BuildSmoothedPoly();
 
     /* For copper layers, we now must add holes in the Polygon list.
      * holes are pads and tracks with their clearance area
      * for non copper layers just recalculate the m_FilledPolysList
      * with m_ZoneMinThickness taken in account
      */
+    m_FilledPolysList.RemoveAllContours();
+
+    if( IsOnCopperLayer() )
+    {
+        AddClearanceAreasPolygonsToPolysList_NG( aPcb );
+    }
     else
     {
-        m_FilledPolysList.RemoveAllContours();
+        int margin = m_ZoneMinThickness / 2;
+        m_FilledPolysList = ConvertPolyListToPolySet( m_smoothedPoly->m_CornersList );
+        m_FilledPolysList.Inflate( -margin, 16 );
+        m_FilledPolysList.Fracture();
+    }
 
-        if( IsOnCopperLayer() )
-        {
-            AddClearanceAreasPolygonsToPolysList_NG( aPcb );
-        }
-        else
-        {
-            int margin = m_ZoneMinThickness / 2;
-            m_FilledPolysList = ConvertPolyListToPolySet( m_smoothedPoly->m_CornersList );
-            m_FilledPolysList.Inflate( -margin, 16 );
-            m_FilledPolysList.Fracture();
-        }
+    if( m_FillMode )   // if fill mode uses segments, create them:
+        FillZoneAreasWithSegments();
 
-        if( m_FillMode )   // if fill mode uses segments, create them:
-            FillZoneAreasWithSegments();
-
-        m_IsFilled = true;
-    }
+    m_IsFilled = true;
 
     return true;
 }
@@ -247,3 +268,132 @@ int ZONE_CONTAINER::FillZoneAreasWithSegments()
 }
 
 
+void BOARD::PrepareZonesFill( std::vector<ZONE_CONTAINER*>& aZonesToFill )
+{
+    aZonesToFill.clear();
+
+    // Remove segment zones
+    m_Zone.DeleteAll();
+
+    // Zones are filled in parallel, each one only reading the board and the outlines of
+    // the other zones, and writing its own filled areas.
+    // Everything lazily calculated and cached by the board items read during the filling
+    // is calculated here, in order to have only read accesses from the worker threads.
+    for( MODULE* module = m_Modules; module; module = module->Next() )
+    {
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+            pad->GetBoundingRadius();
+    }
+
+    for( int ii = 0; ii < GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = GetArea( ii );
+
+        // The fill reads the outlines of the other zones from a smoothed copy: the
+        // smoothed outlines, used by the DRC outline tests, are rebuilt here, and
+        // keepout zones, which are not filled, only need this one
+        zone->BuildSmoothedPoly();
+
+        if( !zone->GetIsKeepout() )
+            aZonesToFill.push_back( zone );
+    }
+}
+
+
+/// Orders zones by decreasing bounding box area, i.e. roughly by decreasing fill time
+struct BIGGER_ZONE_FIRST
+{
+    bool operator()( const std::pair<double, ZONE_CONTAINER*>& aZone1,
+                     const std::pair<double, ZONE_CONTAINER*>& aZone2 ) const
+    {
+        return aZone1.first > aZone2.first;
+    }
+};
+
+
+bool BOARD::FillZones( const std::vector<ZONE_CONTAINER*>& aZones, int aThreadCount,
+                       const ZONE_FILL_PROGRESS& aProgress,
+                       std::vector<ZONE_CONTAINER*>* aRefilledZones, bool aStopOnError )
+{
+    // The biggest zones go first, so none of them is left to be filled at the end
+    // while other threads are idle.  A zone fill only reads the outlines of the other
+    // zones, from the smoothed copies built by PrepareZonesFill(), and never their
+    // filled areas, so the zones can be filled in any order.
+    std::vector< std::pair<double, ZONE_CONTAINER*> > zones;
+
+    for( unsigned jj = 0; jj < aZones.size(); jj++ )
+        zones.push_back( std::make_pair( aZones[jj]->GetBoundingBox().GetArea(), aZones[jj] ) );
+
+    std::stable_sort( zones.begin(), zones.end(), BIGGER_ZONE_FIRST() );
+
+    int                 zoneCount = zones.size();
+    boost::atomic<int>  filledCount( 0 );
+    boost::atomic<bool> aborted( false );
+    boost::atomic<bool> failed( false );
+    std::vector<char>   refilled( zoneCount, 0 );   // written by one thread per zone
+    int                 ii;
+
+#ifdef USE_OPENMP
+    if( aThreadCount <= 0 )
+        aThreadCount = omp_get_max_threads();
+
+    // Dumping zones writes in a single file: it needs a serial fill
+    if( g_DumpZonesWhenFilling )
+        aThreadCount = 1;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(aThreadCount) private(ii)
+#endif /* USE_OPENMP */
+    for( ii = 0; ii < zoneCount; ii++ )
+    {
+        // The zones not filled after an abort keep their previous filled areas
+        if( aborted )
+            continue;
+
+        ZONE_CONTAINER* zone = zones[ii].second;
+
+        zone->ClearFilledPolysList();
+        zone->UnFill();
+        refilled[ii] = 1;
+
+        if( !zone->BuildFilledSolidAreasPolygons( this ) )
+        {
+            failed = true;
+
+            if( aStopOnError )
+                aborted = true;
+        }
+
+        int filled = ++filledCount;
+
+        // The progress is reported by the calling thread only, which may use the GUI
+#ifdef USE_OPENMP
+        if( omp_get_thread_num() != 0 )
+            continue;
+#endif /* USE_OPENMP */
+
+        if( aProgress && !aProgress( filled, zoneCount, zone ) )
+            aborted = true;
+    }
+
+    if( aRefilledZones )
+    {
+        aRefilledZones->clear();
+
+        for( ii = 0; ii < zoneCount; ii++ )
+        {
+            if( refilled[ii] )
+                aRefilledZones->push_back( zones[ii].second );
+        }
+    }
+
+    return !aborted && !failed;
+}
+
+
+void BOARD::FillAllZones( int aThreadCount )
+{
+    std::vector<ZONE_CONTAINER*> zonesToFill;
+
+    PrepareZonesFill( zonesToFill );
+    FillZones( zonesToFill, aThreadCount );
+}
@@ -28,6 +28,8 @@
 
 #include <wx/progdlg.h>
 
+#include <boost/bind.hpp>
+
 #include <fctsys.h>
 #include <pgm_base.h>
 #include <class_drawpanel.h>
@@ -37,6 +39,7 @@
 #include <macros.h>
 
 #include <class_board.h>
+#include <class_module.h>
 #include <class_track.h>
 #include <class_zone.h>
 
@@ -92,9 +95,13 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
     aZone->ClearFilledPolysList();
     aZone->UnFill();
 
-    // Cannot fill keepout zones:
+    // Cannot fill keepout zones.  The DRC outline tests use their smoothed outline,
+    // which BuildFilledSolidAreasPolygons() rebuilds for the other zones
     if( aZone->GetIsKeepout() )
+    {
+        aZone->BuildSmoothedPoly();
         return 1;
+    }
 
     wxString msg;
 
@@ -124,6 +131,18 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 }
 
 
+/// Shows the fill progress of BOARD::FillZones(), returns false if the user aborts.
+static bool updateFillProgress( wxProgressDialog* aProgressDialog, int aFilledCount,
+                                int aZoneCount, ZONE_CONTAINER* aZone )
+{
+    wxString msg;
+
+    msg.Printf( FORMAT_STRING, aFilledCount, aZoneCount, GetChars( aZone->GetNetname() ) );
+
+    return aProgressDialog->Update( aFilledCount, msg );
+}
+
+
 int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
 {
     int errorLevel = 0;
@@ -145,34 +164,35 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
     if( progressDialog )
         progressDialog->Update( 0, _( "Starting zone fill..." ) );
 
-    // Remove segment zones
-    GetBoard()->m_Zone.DeleteAll();
+    std::vector<ZONE_CONTAINER*> zonesToFill;
+    std::vector<ZONE_CONTAINER*> filledZones;
+    BOARD::ZONE_FILL_PROGRESS    progress;
 
-    int ii;
+    GetBoard()->PrepareZonesFill( zonesToFill );
 
-    for( ii = 0; ii < areaCount; ii++ )
-    {
-        ZONE_CONTAINER* zoneContainer = GetBoard()->GetArea( ii );
-        if( zoneContainer->GetIsKeepout() )
-            continue;
-
-        msg.Printf( FORMAT_STRING, ii + 1, areaCount, GetChars( zoneContainer->GetNetname() ) );
-
-        if( progressDialog )
-        {
-            if( !progressDialog->Update( ii+1, msg ) )
-                break;  // Aborted by user
-        }
+    // The progress dialog is updated (and the user abort request tested) by the
+    // calling thread, each time it has filled a zone
+    if( progressDialog )
+        progress = boost::bind( &updateFillProgress, progressDialog, _1, _2, _3 );
 
-        errorLevel = Fill_Zone( zoneContainer );
+    // When not verbose, stop at the first zone which cannot be filled
+    if( !GetBoard()->FillZones( zonesToFill, 0, progress, &filledZones, !aVerbose ) )
+        errorLevel = 1;     // Aborted by user, or a zone could not be filled
 
-        if( errorLevel && !aVerbose )
-            break;
+    // Commit the results in the view and ratsnest from the main thread.  The zones not
+    // filled after an abort are unchanged.
+    for( unsigned ii = 0; ii < filledZones.size(); ii++ )
+    {
+        filledZones[ii]->ViewUpdate( KIGFX::VIEW_ITEM::ALL );
+        GetBoard()->GetRatsnest()->Update( filledZones[ii] );
     }
 
+    if( !filledZones.empty() )
+        OnModify();
+
     if( progressDialog )
     {
-        progressDialog->Update( ii+2, _( "Updating ratsnest..." ) );
+        progressDialog->Update( areaCount+1, _( "Updating ratsnest..." ) );
 #ifdef __WXMAC__
         // Work around a dialog z-order issue on OS X
         aActiveWindow->Raise();
@@ -89,7 +89,51 @@ extern void CreateThermalReliefPadPolygon( SHAPE_POLY_SET&       aCornerBuffer,
 // Local Variables:
 static double s_thermalRot = 450;  // angle of stubs in thermal reliefs for round pads
 
-void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeatures )
+bool ZONE_CONTAINER::reuseFeatureHoles( const BOARD_ITEM* aItem, int aKind,
+                                        const EDA_RECT& aItemBox, const EDA_RECT* aDirtyArea,
+                                        SHAPE_POLY_SET& aFeatures, FEATURE_HOLES_MAP& aMap ) const
+{
+    if( !aDirtyArea || aItemBox.Intersects( *aDirtyArea ) )
+        return false;
+
+    FEATURE_HOLES_MAP::const_iterator it = m_featureHolesMap.find( std::make_pair( aItem, aKind ) );
+
+    if( it == m_featureHolesMap.end() )
+        return false;
+
+    // A moved item should be in the dirty area: check its bounding box anyway
+    const FEATURE_HOLES& holes = it->second;
+
+    if( holes.m_itemBox.GetOrigin() != aItemBox.GetOrigin()
+        || holes.m_itemBox.GetSize() != aItemBox.GetSize() )
+        return false;
+
+    int first = aFeatures.OutlineCount();
+
+    for( int ii = holes.m_first; ii < holes.m_first + holes.m_count; ii++ )
+        aFeatures.Polygon( aFeatures.NewOutline() ) = m_featureHoles.CPolygon( ii );
+
+    recordFeatureHoles( aItem, aKind, aItemBox, first, aFeatures, aMap );
+
+    return true;
+}
+
+
+void ZONE_CONTAINER::recordFeatureHoles( const BOARD_ITEM* aItem, int aKind,
+                                         const EDA_RECT& aItemBox, int aFirst,
+                                         const SHAPE_POLY_SET& aFeatures,
+                                         FEATURE_HOLES_MAP& aMap )
+{
+    FEATURE_HOLES& holes = aMap[ std::make_pair( aItem, aKind ) ];
+
+    holes.m_itemBox = aItemBox;
+    holes.m_first = aFirst;
+    holes.m_count = aFeatures.OutlineCount() - aFirst;
+}
+
+
+void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeatures,
+                                           const EDA_RECT* aDirtyArea )
 {
     int segsPerCircle;
     double correctionFactor;
@@ -127,6 +171,10 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
     biggest_clearance = std::max( biggest_clearance, zone_clearance );
     zone_boundingbox.Inflate( biggest_clearance );
 
+    // The holes of each item, for the next refill
+    FEATURE_HOLES_MAP holesMap;
+    int first;
+
     /*
      * First : Add pads. Note: pads having the same net as zone are left in zone.
      * Thermal shapes will be created later if necessary
@@ -151,6 +199,7 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
         {
             nextpad = pad->Next();  // pad pointer can be modified by next code, so
                                     // calculate the next pad here
+            const D_PAD* boardPad = pad;    // the holes are kept by board pad
 
             if( !pad->IsOnLayer( GetLayer() ) )
             {
@@ -182,11 +231,19 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
 
                 if( item_boundingbox.Intersects( zone_boundingbox ) )
                 {
-                    int clearance = std::max( zone_clearance, item_clearance );
-                    pad->TransformShapeWithClearanceToPolygon( aFeatures,
-                                                               clearance,
-                                                               segsPerCircle,
-                                                               correctionFactor );
+                    first = aFeatures.OutlineCount();
+
+                    if( !reuseFeatureHoles( boardPad, HOLE_CLEARANCE, item_boundingbox,
+                                            aDirtyArea, aFeatures, holesMap ) )
+                    {
+                        int clearance = std::max( zone_clearance, item_clearance );
+                        pad->TransformShapeWithClearanceToPolygon( aFeatures,
+                                                                   clearance,
+                                                                   segsPerCircle,
+                                                                   correctionFactor );
+                        recordFeatureHoles( boardPad, HOLE_CLEARANCE, item_boundingbox,
+                                            first, aFeatures, holesMap );
+                    }
                 }
 
                 continue;
@@ -201,10 +258,18 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
 
                 if( item_boundingbox.Intersects( zone_boundingbox ) )
                 {
-                    pad->TransformShapeWithClearanceToPolygon( aFeatures,
-                                                               gap,
-                                                               segsPerCircle,
-                                                               correctionFactor );
+                    first = aFeatures.OutlineCount();
+
+                    if( !reuseFeatureHoles( boardPad, HOLE_CLEARANCE, item_boundingbox,
+                                            aDirtyArea, aFeatures, holesMap ) )
+                    {
+                        pad->TransformShapeWithClearanceToPolygon( aFeatures,
+                                                                   gap,
+                                                                   segsPerCircle,
+                                                                   correctionFactor );
+                        recordFeatureHoles( boardPad, HOLE_CLEARANCE, item_boundingbox,
+                                            first, aFeatures, holesMap );
+                    }
                 }
             }
         }
@@ -226,11 +291,19 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
 
         if( item_boundingbox.Intersects( zone_boundingbox ) )
         {
-            int clearance = std::max( zone_clearance, item_clearance );
-            track->TransformShapeWithClearanceToPolygon( aFeatures,
-                                                         clearance,
-                                                         segsPerCircle,
-                                                         correctionFactor );
+            first = aFeatures.OutlineCount();
+
+            if( !reuseFeatureHoles( track, HOLE_CLEARANCE, item_boundingbox, aDirtyArea,
+                                    aFeatures, holesMap ) )
+            {
+                int clearance = std::max( zone_clearance, item_clearance );
+                track->TransformShapeWithClearanceToPolygon( aFeatures,
+                                                             clearance,
+                                                             segsPerCircle,
+                                                             correctionFactor );
+                recordFeatureHoles( track, HOLE_CLEARANCE, item_boundingbox, first,
+                                    aFeatures, holesMap );
+            }
         }
     }
 
@@ -252,9 +325,17 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
 
             if( item_boundingbox.Intersects( zone_boundingbox ) )
             {
-                ( (EDGE_MODULE*) item )->TransformShapeWithClearanceToPolygon(
-                    aFeatures, zone_clearance,
-                    segsPerCircle, correctionFactor );
+                first = aFeatures.OutlineCount();
+
+                if( !reuseFeatureHoles( item, HOLE_CLEARANCE, item_boundingbox, aDirtyArea,
+                                        aFeatures, holesMap ) )
+                {
+                    ( (EDGE_MODULE*) item )->TransformShapeWithClearanceToPolygon(
+                        aFeatures, zone_clearance,
+                        segsPerCircle, correctionFactor );
+                    recordFeatureHoles( item, HOLE_CLEARANCE, item_boundingbox, first,
+                                        aFeatures, holesMap );
+                }
             }
         }
     }
@@ -265,6 +346,16 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
         if( item->GetLayer() != GetLayer() && item->GetLayer() != Edge_Cuts )
             continue;
 
+        if( item->Type() != PCB_LINE_T && item->Type() != PCB_TEXT_T )
+            continue;
+
+        first = aFeatures.OutlineCount();
+        item_boundingbox = item->GetBoundingBox();
+
+        if( reuseFeatureHoles( item, HOLE_CLEARANCE, item_boundingbox, aDirtyArea,
+                               aFeatures, holesMap ) )
+            continue;
+
         switch( item->Type() )
         {
         case PCB_LINE_T:
@@ -281,9 +372,13 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
         default:
             break;
         }
+
+        recordFeatureHoles( item, HOLE_CLEARANCE, item_boundingbox, first, aFeatures,
+                            holesMap );
     }
 
-    // Add zones outlines having an higher priority and keepout
+    // Add zones outlines having an higher priority and keepout.  They are always rebuilt:
+    // an outline can be edited without changing its bounding box
     for( int ii = 0; ii < GetBoard()->GetAreaCount(); ii++ )
     {
         ZONE_CONTAINER* zone = GetBoard()->GetArea( ii );
@@ -355,16 +450,27 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, SHAPE_POLY_SET& aFeature
 
             if( item_boundingbox.Intersects( zone_boundingbox ) )
             {
-                CreateThermalReliefPadPolygon( aFeatures,
-                                               *pad, thermalGap,
-                                               GetThermalReliefCopperBridge( pad ),
-                                               m_ZoneMinThickness,
-                                               segsPerCircle,
-                                               correctionFactor, s_thermalRot );
+                first = aFeatures.OutlineCount();
+
+                if( !reuseFeatureHoles( pad, HOLE_THERMAL, item_boundingbox, aDirtyArea,
+                                        aFeatures, holesMap ) )
+                {
+                    CreateThermalReliefPadPolygon( aFeatures,
+                                                   *pad, thermalGap,
+                                                   GetThermalReliefCopperBridge( pad ),
+                                                   m_ZoneMinThickness,
+                                                   segsPerCircle,
+                                                   correctionFactor, s_thermalRot );
+                    recordFeatureHoles( pad, HOLE_THERMAL, item_boundingbox, first,
+                                        aFeatures, holesMap );
+                }
             }
         }
     }
 
+    // Keep the holes for the next refill
+    m_featureHoles = aFeatures;
+    m_featureHolesMap.swap( holesMap );
 }
 
 
@@ -447,6 +553,9 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
     if (g_DumpZonesWhenFilling)
         dumper->Write( &holes, "feature-holes-postsimplify" );
 
+    // Keep the solid area, for RefillDirtyArea()
+    m_solidAreaOutline = solidAreas;
+
     // Generate the filled areas (currently, without thermal shapes, which will
     // be created later).
     // Generate strictly simple polygons needed by Gerber files and Fracture()
@@ -455,11 +564,24 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
     if (g_DumpZonesWhenFilling)
         dumper->Write( &solidAreas, "solid-areas-minus-holes" );
 
-    SHAPE_POLY_SET fractured = solidAreas;
+    buildFillCacheKey( m_fillCacheKey );
+    m_isFillDirty = false;
+
+    buildFilledAreas( aPcb, solidAreas, correctionFactor, *dumper );
+
+    if(g_DumpZonesWhenFilling)
+        dumper->EndGroup();
+}
+
+
+void ZONE_CONTAINER::buildFilledAreas( BOARD* aPcb, SHAPE_POLY_SET& aSolidAreas,
+                                       double aCorrectionFactor, SHAPE_FILE_IO& aDumper )
+{
+    SHAPE_POLY_SET fractured = aSolidAreas;
     fractured.Fracture();
 
     if (g_DumpZonesWhenFilling)
-        dumper->Write( &fractured, "fractured" );
+        aDumper.Write( &fractured, "fractured" );
 
     m_FilledPolysList = fractured;
 
@@ -473,7 +595,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
     // (this is a refinement for thermal relief shapes)
     if( GetNetCode() > 0 )
         BuildUnconnectedThermalStubsPolygonList( thermalHoles, aPcb, this,
-                                                 correctionFactor, s_thermalRot );
+                                                 aCorrectionFactor, s_thermalRot );
 
     // remove copper areas corresponding to not connected stubs
     if( !thermalHoles.IsEmpty() )
@@ -481,25 +603,80 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
         thermalHoles.Simplify();
         // Remove unconnected stubs.
         // Generate strictly simple polygons needed by Gerber files and Fracture()
-        solidAreas.BooleanSubtract( thermalHoles, false );
+        aSolidAreas.BooleanSubtract( thermalHoles, false );
 
         if( g_DumpZonesWhenFilling )
-            dumper->Write( &thermalHoles, "thermal-holes" );
+            aDumper.Write( &thermalHoles, "thermal-holes" );
 
         // put these areas in m_FilledPolysList
-        SHAPE_POLY_SET fractured = solidAreas;
+        SHAPE_POLY_SET fractured = aSolidAreas;
         fractured.Fracture();
 
         if( g_DumpZonesWhenFilling )
-            dumper->Write ( &fractured, "fractured" );
+            aDumper.Write ( &fractured, "fractured" );
 
         m_FilledPolysList = fractured;
 
         if( GetNetCode() > 0 )
             TestForCopperIslandAndRemoveInsulatedIslands( aPcb );
     }
+}
 
-    if(g_DumpZonesWhenFilling)
+
+void ZONE_CONTAINER::RefillDirtyArea( BOARD* aPcb )
+{
+    std::vector<int> key;
+    buildFillCacheKey( key );
+
+    // The data kept from the last fill can be used only if the zone itself was not modified
+    if( !m_IsFilled || !IsOnCopperLayer() || key != m_fillCacheKey )
+    {
+        BuildFilledSolidAreasPolygons( aPcb );
+        return;
+    }
+
+    if( !m_isFillDirty )
+        return;
+
+    int segsPerCircle;
+    double correctionFactor;
+
+    // Set the number of segments in arc approximations
+    if( m_ArcToSegmentsCount == ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF  )
+        segsPerCircle = ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF;
+    else
+        segsPerCircle = ARC_APPROX_SEGMENTS_COUNT_LOW_DEF;
+
+    correctionFactor = 1.0 / cos( M_PI / (double) segsPerCircle );
+
+    std::auto_ptr<SHAPE_FILE_IO> dumper( new SHAPE_FILE_IO(
+            g_DumpZonesWhenFilling ? "zones_dump.txt" : "", SHAPE_FILE_IO::IOM_APPEND ) );
+
+    if( g_DumpZonesWhenFilling )
+        dumper->BeginGroup( "clipper-zone-refill" );
+
+    // Rebuild the holes of the items in the invalidated area, and reuse the other ones
+    SHAPE_POLY_SET holes;
+    buildFeatureHoleList( aPcb, holes, &m_dirtyArea );
+    holes.Simplify( true );
+
+    // The holes are removed from the whole zone, exactly as in a full fill: clipping the
+    // subtraction to the invalidated area would give other polygons than a full fill
+    SHAPE_POLY_SET solidAreas = m_solidAreaOutline;
+    solidAreas.BooleanSubtract( holes, false );
+
+    if( g_DumpZonesWhenFilling )
+        dumper->Write( &solidAreas, "solid-areas-minus-holes" );
+
+    m_isFillDirty = false;
+
+    // Islands and thermal stubs depend on the connections of the whole zone
+    buildFilledAreas( aPcb, solidAreas, correctionFactor, *dumper );
+
+    if( m_FillMode )   // if fill mode uses segments, create them:
+        FillZoneAreasWithSegments();
+
+    if( g_DumpZonesWhenFilling )
         dumper->EndGroup();
 }
 
@@ -321,7 +321,8 @@ bool BOARD::CombineAreas( PICKED_ITEMS_LIST* aDeletedList, ZONE_CONTAINER* area_
 
 
 int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_Examine,
-                                                      bool            aCreate_Markers )
+                                                      bool            aCreate_Markers,
+                                                      std::vector<MARKER_PCB*>* aMarkers )
 {
     int         nerrors = 0;
 
@@ -391,7 +392,10 @@ int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_E
                                                               wxPoint( x, y ),
                                                               msg1, wxPoint( x, y ),
                                                               msg2, wxPoint( x, y ) );
-                        Add( marker );
+                        if( aMarkers )
+                            aMarkers->push_back( marker );
+                        else
+                            Add( marker );
                     }
 
                     nerrors++;
@@ -415,7 +419,10 @@ int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_E
                                                               wxPoint( x, y ),
                                                               msg1, wxPoint( x, y ),
                                                               msg2, wxPoint( x, y ) );
-                        Add( marker );
+                        if( aMarkers )
+                            aMarkers->push_back( marker );
+                        else
+                            Add( marker );
                     }
 
                     nerrors++;
@@ -487,7 +494,10 @@ int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_E
                                                                           wxPoint( x, y ),
                                                                           msg1, wxPoint( x, y ),
                                                                           msg2, wxPoint( x, y ) );
-                                    Add( marker );
+                                    if( aMarkers )
+                                        aMarkers->push_back( marker );
+                                    else
+                                        Add( marker );
                                 }
 
                                 nerrors++;
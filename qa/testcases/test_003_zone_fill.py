@@ -0,0 +1,120 @@
+import code
+import unittest
+import os
+import re
+import pcbnew
+import pdb
+import tempfile
+
+
+from pcbnew import *
+
+
+def extract_zone(text):
+    """Return the first (zone ...) block of a board file."""
+    start = text.index('  (zone ')
+    depth = 0
+
+    for i in range(start, len(text)):
+        if text[i] == '(':
+            depth += 1
+        elif text[i] == ')':
+            depth -= 1
+            if depth == 0:
+                return text[start:i + 1] + '\n'
+
+
+def make_zone(zone, net, net_name, layer, priority, corners):
+    """Return a copy of the zone block with another net, layer, priority and outline."""
+    zone = re.sub(r'\(net \d+\) \(net_name [^)]*\) \(layer [^)]*\)',
+                  '(net %d) (net_name %s) (layer %s)' % (net, net_name, layer), zone, 1)
+    zone = zone.replace('(hatch edge 0.508)\n',
+                        '(hatch edge 0.508)\n    (priority %d)\n' % priority, 1)
+    pts = ' '.join(['(xy %g %g)' % corner for corner in corners])
+    return re.sub(r'\(polygon\s*\(pts[^()]*(\([^()]*\)[^()]*)*\)\s*\)',
+                  '(polygon\n      (pts\n        %s\n      )\n    )' % pts, zone, 1)
+
+
+class TestZoneFill(unittest.TestCase):
+
+    def setUp(self):
+        # The test board has a single zone: add zones so several zones are filled
+        # at the same time, including zones reading the outline of other zones
+        with open("data/complex_hierarchy.kicad_pcb") as f:
+            text = f.read()
+
+        zone = extract_zone(text)
+        zones = [
+            make_zone(zone, 12, 'GND', 'Composant', 0,
+                      [(187.325, 131.572), (187.325, 53.086), (88.392, 53.086), (88.392, 131.572)]),
+            make_zone(zone, 1, '+12V', 'Cuivre', 1,
+                      [(150, 110), (150, 70), (110, 70), (110, 110)]),
+            make_zone(zone, 13, 'HT', 'Composant', 1,
+                      [(170, 125), (170, 95), (130, 95), (130, 125)]),
+            make_zone(zone, 2, '-VAA', 'Composant', 2,
+                      [(120, 100), (120, 60), (95, 60), (95, 100)])
+            ]
+
+        self.BOARDNAME = tempfile.mktemp() + ".kicad_pcb"
+        self.FILENAME = tempfile.mktemp() + ".kicad_pcb"
+
+        with open(self.BOARDNAME, 'w') as f:
+            f.write(text.replace(zone, zone + ''.join(zones), 1))
+
+        self.pcb = LoadBoard(self.BOARDNAME)
+
+    def tearDown(self):
+        for name in (self.BOARDNAME, self.FILENAME):
+            if os.path.exists(name):
+                os.remove(name)
+
+    def fill_and_save(self, threads):
+        self.pcb.FillAllZones(threads)
+        SaveBoard(self.FILENAME, self.pcb)
+
+        with open(self.FILENAME) as f:
+            return f.read()
+
+    def test_zone_count(self):
+        self.assertEqual(self.pcb.GetAreaCount(), 5)
+
+    def test_parallel_fill_equals_serial_fill(self):
+        serial = self.fill_and_save(1)
+        parallel = self.fill_and_save(4)
+
+        self.assertEqual(serial.count('(filled_polygon'),
+                         parallel.count('(filled_polygon'))
+        self.assertTrue(serial.count('(filled_polygon') >= 5)
+        self.assertEqual(serial, parallel)
+
+    def test_refill_is_stable(self):
+        first = self.fill_and_save(0)
+        second = self.fill_and_save(0)
+
+        self.assertEqual(first, second)
+
+    def test_local_refill_equals_full_refill(self):
+        self.pcb.FillAllZones(0)
+
+        # Move a track, and refill only the area around its old and new position
+        track = list(self.pcb.GetTracks())[0]
+        self.pcb.InvalidateZoneFills(track)
+        track.Move(wxPoint(FromMM(0.6), FromMM(0.6)))
+        self.pcb.InvalidateZoneFills(track)
+
+        self.assertTrue(self.pcb.RefillDirtyZones() > 0)
+        self.assertEqual(self.pcb.RefillDirtyZones(), 0)
+
+        SaveBoard(self.FILENAME, self.pcb)
+
+        with open(self.FILENAME) as f:
+            local = f.read()
+
+        # The local refill must give exactly the polygons of a full refill
+        full = self.fill_and_save(0)
+
+        self.assertTrue(local.count('(filled_polygon') >= 5)
+        self.assertEqual(local, full)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,86 @@
+import code
+import unittest
+import os
+import pcbnew
+import pdb
+import tempfile
+
+
+from pcbnew import *
+
+
+BOARDNAME = "data/complex_hierarchy.kicad_pcb"
+
+
+def xy(point):
+    return (point.x, point.y)
+
+
+class TestPCBParse(unittest.TestCase):
+
+    def setUp(self):
+        # LoadBoard() parses the footprints, tracks and zones on several threads,
+        # PCB_IO.Parse() parses the same text with the serial parser
+        self.parallel = LoadBoard(BOARDNAME)
+
+        with open(BOARDNAME) as f:
+            self.serial = PCB_IO().Parse(f.read().decode('utf-8')).Cast()
+
+        self.FILENAME = tempfile.mktemp() + ".kicad_pcb"
+
+    def tearDown(self):
+        if os.path.exists(self.FILENAME):
+            os.remove(self.FILENAME)
+
+    def save(self, pcb):
+        SaveBoard(self.FILENAME, pcb)
+
+        with open(self.FILENAME) as f:
+            return f.read()
+
+    def test_item_counts(self):
+        self.assertEqual(self.serial.GetClass(), "BOARD")
+        self.assertEqual(len(list(self.serial.GetModules())),
+                         len(list(self.parallel.GetModules())))
+        self.assertEqual(len(list(self.serial.GetTracks())),
+                         len(list(self.parallel.GetTracks())))
+        self.assertEqual(len(list(self.serial.GetDrawings())),
+                         len(list(self.parallel.GetDrawings())))
+        self.assertEqual(self.serial.GetAreaCount(), self.parallel.GetAreaCount())
+        self.assertEqual(self.serial.GetNetCount(), self.parallel.GetNetCount())
+
+    def test_module_order_and_pad_nets(self):
+        serial = [(m.GetReference(), xy(m.GetPosition()),
+                   [(p.GetPadName(), p.GetNetCode()) for p in m.Pads()])
+                  for m in self.serial.GetModules()]
+        parallel = [(m.GetReference(), xy(m.GetPosition()),
+                     [(p.GetPadName(), p.GetNetCode()) for p in m.Pads()])
+                    for m in self.parallel.GetModules()]
+
+        self.assertEqual(serial, parallel)
+
+    def test_track_order_and_nets(self):
+        serial = [(t.GetClass(), xy(t.GetStart()), xy(t.GetEnd()), t.GetNetCode())
+                  for t in self.serial.GetTracks()]
+        parallel = [(t.GetClass(), xy(t.GetStart()), xy(t.GetEnd()), t.GetNetCode())
+                    for t in self.parallel.GetTracks()]
+
+        self.assertEqual(serial, parallel)
+
+    def test_zone_nets(self):
+        serial = [(self.serial.GetArea(i).GetNetCode(), self.serial.GetArea(i).GetNetname(),
+                   self.serial.GetArea(i).GetLayer())
+                  for i in range(self.serial.GetAreaCount())]
+        parallel = [(self.parallel.GetArea(i).GetNetCode(),
+                     self.parallel.GetArea(i).GetNetname(),
+                     self.parallel.GetArea(i).GetLayer())
+                    for i in range(self.parallel.GetAreaCount())]
+
+        self.assertEqual(serial, parallel)
+        self.assertTrue(all(net > 0 for net, name, layer in parallel))
+
+    def test_saved_boards_are_identical(self):
+        self.assertEqual(self.save(self.serial), self.save(self.parallel))
+
+if __name__ == '__main__':
+    unittest.main()
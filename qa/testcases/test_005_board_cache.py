@@ -0,0 +1,98 @@
+import code
+import unittest
+import os
+import re
+import pcbnew
+import pdb
+import tempfile
+
+
+from pcbnew import *
+
+
+class TestBoardCache(unittest.TestCase):
+
+    def setUp(self):
+        with open("data/complex_hierarchy.kicad_pcb") as f:
+            self.text = f.read()
+
+        self.BOARDNAME = tempfile.mktemp() + ".kicad_pcb"
+        self.CACHENAME = self.BOARDNAME + "-cache"
+        self.FILENAME = tempfile.mktemp() + ".kicad_pcb"
+
+        self.write_board(self.text)
+
+    def tearDown(self):
+        for name in (self.BOARDNAME, self.CACHENAME, self.FILENAME):
+            if os.path.exists(name):
+                os.remove(name)
+
+    def write_board(self, text):
+        with open(self.BOARDNAME, 'w') as f:
+            f.write(text)
+
+    def saved(self, pcb):
+        SaveBoard(self.FILENAME, pcb)
+
+        with open(self.FILENAME) as f:
+            return f.read()
+
+    def fresh_load(self):
+        return self.saved(LoadBoard(self.BOARDNAME))
+
+    def cached_load(self):
+        return self.saved(LoadBoard(self.BOARDNAME, IO_MGR.KICAD_CACHED))
+
+    def cache(self):
+        with open(self.CACHENAME, 'rb') as f:
+            return f.read()
+
+    def test_cached_load_equals_fresh_load(self):
+        fresh = self.fresh_load()
+
+        # The first load parses the board and writes the cache, the second one reads it
+        self.assertFalse(os.path.exists(self.CACHENAME))
+        self.assertEqual(self.cached_load(), fresh)
+        self.assertTrue(os.path.exists(self.CACHENAME))
+        self.assertEqual(self.cached_load(), fresh)
+
+    def test_changed_board_with_same_time(self):
+        self.cached_load()
+
+        # Same size and time, other content: the content decides, the edit is loaded
+        stat = os.stat(self.BOARDNAME)
+        self.write_board(self.text.replace('(width 0.6096)', '(width 0.6095)', 1))
+        os.utime(self.BOARDNAME, (stat.st_atime, stat.st_mtime))
+
+        self.assertTrue('(width 0.6095)' in self.cached_load())
+        self.assertEqual(self.cached_load(), self.fresh_load())
+
+    def test_touched_board(self):
+        fresh = self.fresh_load()
+        self.cached_load()
+        cache = self.cache()
+
+        # Another time, same content: the cache is used, and its key gets the new time
+        stat = os.stat(self.BOARDNAME)
+        os.utime(self.BOARDNAME, (stat.st_atime, stat.st_mtime + 10))
+
+        self.assertEqual(self.cached_load(), fresh)
+        self.assertNotEqual(self.cache(), cache)
+        self.assertEqual(len(self.cache()), len(cache))
+
+    def test_changed_board(self):
+        self.cached_load()
+
+        # Another time, same size, other content: the cache is rebuilt
+        stat = os.stat(self.BOARDNAME)
+        self.write_board(self.text.replace('(width 0.6096)', '(width 0.6095)', 1))
+        os.utime(self.BOARDNAME, (stat.st_atime, stat.st_mtime + 10))
+
+        fresh = self.fresh_load()
+
+        self.assertTrue('(width 0.6095)' in fresh)
+        self.assertEqual(self.cached_load(), fresh)
+        self.assertEqual(self.cached_load(), fresh)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,116 @@
+import code
+import unittest
+import os
+import shutil
+import pcbnew
+import pdb
+import tempfile
+
+
+from pcbnew import *
+
+
+def footprint_text(name, pads):
+    """Return a footprint file with the given number of pads."""
+    text = '(module %s (layer F.Cu) (tedit 0)\n' % name
+    text += '  (fp_text reference REF** (at 0 0) (layer F.SilkS)\n'
+    text += '    (effects (font (size 1 1) (thickness 0.15))))\n'
+    text += '  (fp_text value %s (at 0 2) (layer F.Fab)\n' % name
+    text += '    (effects (font (size 1 1) (thickness 0.15))))\n'
+
+    for pad in range(pads):
+        text += '  (pad %d smd rect (at %d 0) (size 1 1) (layers F.Cu F.Paste F.Mask))\n' % (
+            pad + 1, pad * 2)
+
+    return text + ')\n'
+
+
+class TestFootprintLib(unittest.TestCase):
+
+    def setUp(self):
+        self.LIBNAME = tempfile.mkdtemp(suffix='.pretty')
+        self.io = PCB_IO()
+
+        self.write_footprint('FP_A', 2)
+        self.write_footprint('FP_B', 3)
+
+    def tearDown(self):
+        shutil.rmtree(self.LIBNAME)
+
+    def footprint_name(self, name):
+        return os.path.join(self.LIBNAME, name + '.kicad_mod')
+
+    def write_footprint(self, name, pads):
+        with open(self.footprint_name(name), 'w') as f:
+            f.write(footprint_text(name, pads))
+
+    def keep_times(self, path, action):
+        """Run action, then give path its previous time stamps back."""
+        stat = os.stat(path)
+        action()
+        os.utime(path, (stat.st_atime, stat.st_mtime))
+
+    def load(self, name):
+        return self.io.FootprintLoad(self.LIBNAME, name)
+
+    def test_enumerate(self):
+        self.assertEqual(sorted(self.io.FootprintEnumerate(self.LIBNAME)), ['FP_A', 'FP_B'])
+
+        # The time stamps may have a one second resolution
+        stat = os.stat(self.LIBNAME)
+        self.write_footprint('FP_C', 1)
+        os.utime(self.LIBNAME, (stat.st_atime, stat.st_mtime + 10))
+
+        self.assertEqual(sorted(self.io.FootprintEnumerate(self.LIBNAME)),
+                         ['FP_A', 'FP_B', 'FP_C'])
+
+    def test_load(self):
+        self.assertEqual(self.load('FP_A').GetPadCount(), 2)
+        self.assertEqual(self.load('FP_B').GetPadCount(), 3)
+        self.assertEqual(self.load('FP_A').GetValue(), 'FP_A')
+        self.assertEqual(self.load('FP_D'), None)
+
+    def test_modified_file_is_parsed_again(self):
+        self.assertEqual(self.load('FP_A').GetPadCount(), 2)
+
+        # Only the file changes, not the library directory
+        stat = os.stat(self.footprint_name('FP_A'))
+        self.keep_times(self.LIBNAME, lambda: self.write_footprint('FP_A', 4))
+        os.utime(self.footprint_name('FP_A'), (stat.st_atime, stat.st_mtime + 10))
+
+        self.assertEqual(self.load('FP_A').GetPadCount(), 4)
+        self.assertEqual(self.load('FP_B').GetPadCount(), 3)
+
+    def test_removed_file_is_not_loaded(self):
+        self.assertEqual(self.load('FP_A').GetPadCount(), 2)
+
+        # The library directory keeps its time, so only the footprint file tells
+        self.keep_times(self.LIBNAME, lambda: os.remove(self.footprint_name('FP_A')))
+
+        self.assertEqual(self.load('FP_A'), None)
+        self.assertEqual(self.load('FP_B').GetPadCount(), 3)
+
+    def test_save_keeps_other_modified_files(self):
+        self.assertEqual(self.load('FP_A').GetPadCount(), 2)
+        self.assertEqual(self.load('FP_B').GetPadCount(), 3)
+        self.assertEqual(self.load('FP_C'), None)
+
+        # Another program edits FP_B and removes FP_C, the library directory keeps its time
+        self.write_footprint('FP_C', 1)
+        self.keep_times(self.LIBNAME, lambda: self.write_footprint('FP_B', 5))
+        stat = os.stat(self.footprint_name('FP_B'))
+        os.utime(self.footprint_name('FP_B'), (stat.st_atime, stat.st_mtime + 10))
+        self.assertEqual(self.load('FP_C').GetPadCount(), 1)
+        self.keep_times(self.LIBNAME, lambda: os.remove(self.footprint_name('FP_C')))
+
+        self.io.FootprintSave(self.LIBNAME, self.load('FP_A'))
+
+        with open(self.footprint_name('FP_B')) as f:
+            self.assertEqual(f.read(), footprint_text('FP_B', 5))
+
+        self.assertFalse(os.path.exists(self.footprint_name('FP_C')))
+        self.assertEqual(self.load('FP_A').GetPadCount(), 2)
+        self.assertEqual(self.load('FP_B').GetPadCount(), 5)
+
+if __name__ == '__main__':
+    unittest.main()
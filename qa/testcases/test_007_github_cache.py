@@ -0,0 +1,183 @@
+import code
+import unittest
+import os
+import shutil
+import pcbnew
+import pdb
+import tempfile
+import threading
+import zipfile
+import BaseHTTPServer
+import StringIO
+
+
+from pcbnew import *
+
+
+FOOTPRINT = '''(module %s (layer F.Cu) (tedit 0)
+  (fp_text reference REF** (at 0 0) (layer F.SilkS) (effects (font (size 1 1) (thickness 0.15))))
+  (fp_text value %s (at 0 2) (layer F.Fab) (effects (font (size 1 1) (thickness 0.15))))
+  (pad 1 smd rect (at 0 0) (size 1 1) (layers F.Cu F.Paste F.Mask))
+)
+'''
+
+
+def zip_image(names):
+    """Return a zip file holding a .pretty library as Github serves it."""
+    image = StringIO.StringIO()
+    archive = zipfile.ZipFile(image, 'w')
+
+    for name in names:
+        archive.writestr('Test.pretty-master/%s.kicad_mod' % name, FOOTPRINT % (name, name))
+
+    archive.close()
+
+    return image.getvalue()
+
+
+class StandInHandler(BaseHTTPServer.BaseHTTPRequestHandler):
+    """Serves server.zip with server.etag, or answers with server.status."""
+
+    def do_GET(self):
+        server = self.server
+        server.requests.append(self.headers.get('If-None-Match'))
+
+        if server.status != 200:
+            self.send_response(server.status)
+            self.end_headers()
+            self.wfile.write('Error %d' % server.status)
+        elif self.headers.get('If-None-Match') == server.etag:
+            self.send_response(304)
+            self.send_header('ETag', server.etag)
+            self.end_headers()
+        else:
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/zip')
+            self.send_header('Content-Length', str(len(server.zip)))
+            self.send_header('ETag', server.etag)
+            self.end_headers()
+            self.wfile.write(server.zip)
+
+    def log_message(self, format, *args):
+        pass
+
+
+class TestGithubCache(unittest.TestCase):
+    """The Github plugin zip cache, against a local HTTP server standing in for
+    Github or for the nginx proxy of pcbnew/github/nginx.conf."""
+
+    def setUp(self):
+        try:
+            IO_MGR.PluginRelease(IO_MGR.PluginFind(IO_MGR.GITHUB))
+        except IOError:
+            self.skipTest('BUILD_GITHUB_PLUGIN is not enabled')
+
+        # The default cache directory is in the KiCad configuration directory
+        self.CONFIG = tempfile.mkdtemp()
+        self.xdg = os.environ.get('XDG_CONFIG_HOME')
+        os.environ['XDG_CONFIG_HOME'] = self.CONFIG
+
+        self.server = BaseHTTPServer.HTTPServer(('127.0.0.1', 0), StandInHandler)
+        self.server.zip = zip_image(['FP_A', 'FP_B'])
+        self.server.etag = '"v1"'
+        self.server.status = 200
+        self.server.requests = []
+
+        self.thread = threading.Thread(target=self.server.serve_forever)
+        self.thread.start()
+
+        self.URL = 'http://127.0.0.1:%d/KiCad/Test.pretty' % self.server.server_address[1]
+
+    def tearDown(self):
+        self.stop_server()
+
+        if self.xdg is None:
+            del os.environ['XDG_CONFIG_HOME']
+        else:
+            os.environ['XDG_CONFIG_HOME'] = self.xdg
+
+        shutil.rmtree(self.CONFIG)
+
+    def stop_server(self):
+        if self.server:
+            self.server.shutdown()
+            self.server.server_close()
+            self.thread.join()
+            self.server = None
+
+    def enumerate(self):
+        # A new plugin has no zip in memory, as in a new session
+        plugin = IO_MGR.PluginFind(IO_MGR.GITHUB)
+
+        try:
+            return sorted(plugin.FootprintEnumerate(self.URL))
+        finally:
+            IO_MGR.PluginRelease(plugin)
+
+    def cached_zip(self):
+        cache_dir = os.path.join(self.CONFIG, 'kicad', 'github_cache')
+        names = [name for name in os.listdir(cache_dir) if name.endswith('.zip')]
+
+        self.assertEqual(len(names), 1)
+
+        with open(os.path.join(cache_dir, names[0]), 'rb') as f:
+            return f.read()
+
+    def test_download_is_cached(self):
+        self.assertEqual(self.enumerate(), ['FP_A', 'FP_B'])
+        self.assertEqual(self.server.requests, [None])
+        self.assertEqual(self.cached_zip(), self.server.zip)
+
+        plugin = IO_MGR.PluginFind(IO_MGR.GITHUB)
+        self.assertEqual(plugin.FootprintLoad(self.URL, 'FP_B').GetValue(), 'FP_B')
+        IO_MGR.PluginRelease(plugin)
+
+    def test_not_modified(self):
+        self.enumerate()
+
+        # The next session sends the ETag, and reads the cached zip on 304
+        self.assertEqual(self.enumerate(), ['FP_A', 'FP_B'])
+        self.assertEqual(self.server.requests, [None, '"v1"'])
+
+    def test_modified(self):
+        self.enumerate()
+
+        self.server.zip = zip_image(['FP_A', 'FP_B', 'FP_C'])
+        self.server.etag = '"v2"'
+
+        self.assertEqual(self.enumerate(), ['FP_A', 'FP_B', 'FP_C'])
+        self.assertEqual(self.cached_zip(), self.server.zip)
+
+    def test_offline(self):
+        self.enumerate()
+        self.stop_server()
+
+        self.assertEqual(self.enumerate(), ['FP_A', 'FP_B'])
+
+    def test_statuses_using_the_cache(self):
+        self.enumerate()
+        cached = self.cached_zip()
+
+        for status in (403, 408, 429, 500, 502, 503):
+            self.server.status = status
+
+            self.assertEqual(self.enumerate(), ['FP_A', 'FP_B'])
+            self.assertEqual(self.cached_zip(), cached)
+
+    def test_statuses_reported(self):
+        self.enumerate()
+        cached = self.cached_zip()
+
+        for status in (400, 401, 404, 410):
+            self.server.status = status
+
+            self.assertRaises(IOError, self.enumerate)
+            self.assertEqual(self.cached_zip(), cached)
+
+    def test_error_without_cache(self):
+        self.server.status = 503
+
+        self.assertRaises(IOError, self.enumerate)
+
+if __name__ == '__main__':
+    unittest.main()
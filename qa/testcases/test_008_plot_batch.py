@@ -0,0 +1,107 @@
+import code
+import unittest
+import os
+import shutil
+import pcbnew
+import pdb
+import tempfile
+
+
+from pcbnew import *
+
+
+BOARDNAME = "data/complex_hierarchy.kicad_pcb"
+
+LAYERS = [
+    ( "CuTop", F_Cu ),
+    ( "CuBottom", B_Cu ),
+    ( "MaskTop", F_Mask ),
+    ( "PasteTop", F_Paste ),
+    ( "SilkTop", F_SilkS ),
+    ( "EdgeCuts", Edge_Cuts ),
+]
+
+
+def read_files(directory):
+    """Return the files of directory, without the lines holding the creation date."""
+    files = {}
+
+    for name in os.listdir(directory):
+        with open(os.path.join(directory, name)) as f:
+            files[name] = [line for line in f if ' date ' not in line]
+
+    return files
+
+
+class TestPlotBatch(unittest.TestCase):
+
+    def setUp(self):
+        self.pcb = LoadBoard(BOARDNAME)
+        self.SERIAL = tempfile.mkdtemp()
+        self.QUEUED = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.SERIAL)
+        shutil.rmtree(self.QUEUED)
+
+    def controller(self, directory):
+        pctl = PLOT_CONTROLLER(self.pcb)
+        popt = pctl.GetPlotOptions()
+
+        popt.SetOutputDirectory(directory)
+        popt.SetPlotFrameRef(False)
+        popt.SetAutoScale(False)
+        popt.SetScale(1)
+        popt.SetMirror(False)
+        popt.SetUseGerberAttributes(True)
+
+        return pctl
+
+    def drill_writer(self):
+        drlwriter = EXCELLON_WRITER(self.pcb)
+        drlwriter.SetMapFileFormat(PLOT_FORMAT_GERBER)
+        drlwriter.SetOptions(False, False, wxPoint(0, 0), False)
+        drlwriter.SetFormat(True)
+
+        return drlwriter
+
+    def test_queued_files_equal_serial_files(self):
+        pctl = self.controller(self.SERIAL)
+
+        for suffix, layer in LAYERS:
+            pctl.SetLayer(layer)
+            self.assertTrue(pctl.OpenPlotfile(suffix, PLOT_FORMAT_GERBER, suffix))
+            self.assertTrue(pctl.PlotLayer())
+
+        pctl.ClosePlot()
+        self.assertTrue(self.drill_writer().CreateDrillandMapFilesSet(
+            pctl.GetPlotDirName(), True, True))
+
+        pctl = self.controller(self.QUEUED)
+
+        for suffix, layer in LAYERS:
+            pctl.SetLayer(layer)
+            self.assertTrue(pctl.QueuePlotfile(suffix, PLOT_FORMAT_GERBER, suffix))
+
+        # The writer is copied: the queued job is not changed by SetFormat()
+        drlwriter = self.drill_writer()
+        pctl.QueueDrillFiles(drlwriter, pctl.GetPlotDirName(), True, True)
+        drlwriter.SetFormat(False)
+
+        self.assertTrue(pctl.RunQueue())
+
+        serial = read_files(self.SERIAL)
+        queued = read_files(self.QUEUED)
+
+        self.assertTrue(len(serial) > len(LAYERS))
+        self.assertEqual(sorted(serial.keys()), sorted(queued.keys()))
+
+        for name in serial:
+            self.assertEqual(serial[name], queued[name], name)
+
+    def test_empty_queue(self):
+        self.assertTrue(self.controller(self.QUEUED).RunQueue())
+        self.assertEqual(os.listdir(self.QUEUED), [])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,132 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file bench_driver.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <wx/init.h>
+
+#include <fctsys.h>
+#include <macros.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <bench_driver.h>
+
+
+BOARD* LoadBenchBoard( const wxString& aFileName )
+{
+    IO_MGR::PCB_FILE_T pluginType = aFileName.EndsWith( wxT( ".brd" ) ) ?
+                                    IO_MGR::LEGACY : IO_MGR::KICAD;
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, aFileName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "Can't load %s: %s\n", TO_UTF8( aFileName ), TO_UTF8( ioe.errorText ) );
+        return NULL;
+    }
+
+    if( !board )
+    {
+        fprintf( stderr, "Can't load %s\n", TO_UTF8( aFileName ) );
+        return NULL;
+    }
+
+    // Same preparation as PCB_EDIT_FRAME::OpenProjectFiles()
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+
+    return board;
+}
+
+
+static void usage( const char* aName )
+{
+    fprintf( stderr, "Usage: %s [--repeat N] board.kicad_pcb [board.kicad_pcb ...]\n", aName );
+}
+
+
+int RunBench( int argc, char** argv, const char* aName, BENCH_FUNC aBench )
+{
+    int                         repeats = 1;
+    std::vector<const char*>    boardFiles;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        if( !strcmp( argv[ii], "--repeat" ) && ii + 1 < argc )
+        {
+            repeats = atoi( argv[++ii] );
+        }
+        else if( argv[ii][0] != '-' )
+        {
+            boardFiles.push_back( argv[ii] );
+        }
+        else
+        {
+            usage( aName );
+            return 2;
+        }
+    }
+
+    if( boardFiles.empty() || repeats <= 0 )
+    {
+        usage( aName );
+        return 2;
+    }
+
+    wxInitializer initializer( argc, argv );
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Can't initialize wxWidgets\n" );
+        return 2;
+    }
+
+    bool identical = true;
+
+    for( unsigned ii = 0; ii < boardFiles.size(); ++ii )
+    {
+        printf( "%s\n", boardFiles[ii] );
+
+        int result = aBench( FROM_UTF8( boardFiles[ii] ), repeats );
+
+        if( result == 2 )
+            return 2;
+
+        if( result )
+            identical = false;
+    }
+
+    printf( "%s\n", identical ? "All the results match" : "The results differ" );
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file bench_driver.h
+ * @brief Command line driver shared by the pcbnew benchmarks (drc_bench, connect_bench...).
+ */
+
+#ifndef BENCH_DRIVER_H_
+#define BENCH_DRIVER_H_
+
+#include <wx/string.h>
+
+class BOARD;
+
+/**
+ * A benchmark run on one board file.
+ * @return 0 if the results match, 1 if they differ and 2 on errors.
+ */
+typedef int (*BENCH_FUNC)( const wxString& aFileName, int aRepeats );
+
+/**
+ * Function LoadBenchBoard
+ * loads aFileName, in the legacy or the s-expression format, and prepares it as
+ * PCB_EDIT_FRAME::OpenProjectFiles() does.
+ * @return the board, owned by the caller, or NULL (after printing why) if it cannot
+ * be loaded.
+ */
+BOARD* LoadBenchBoard( const wxString& aFileName );
+
+/**
+ * Function RunBench
+ * is the main() of a benchmark: parses "[--repeat N] board [board ...]", initializes
+ * wxWidgets, prints the name of each board and runs aBench on it.
+ * @param aName is the program name, for the usage message.
+ * @return the exit code: 0 if all the results match, 1 if they differ and 2 on errors.
+ */
+int RunBench( int argc, char** argv, const char* aName, BENCH_FUNC aBench );
+
+#endif  // BENCH_DRIVER_H_
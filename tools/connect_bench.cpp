@@ -0,0 +1,133 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file connect_bench.cpp
+ * @brief Benchmark and consistency check of the connectivity computation.
+ *
+ * Usage: connect_bench [--repeat N] board.kicad_pcb [board.kicad_pcb ...]
+ *
+ * Runs RecalculateAllTracksNetcode() and TestConnections() on each board, as done when
+ * a board is opened, and prints the time of each one.  The net codes of the track
+ * segments are compared with the ones saved in the board file, which were computed by
+ * the same function, and the track order must stay sorted by net codes.  The exit code
+ * is 0 if all the results match, 1 if they differ and 2 on errors.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <fctsys.h>
+#include <macros.h>
+#include <class_board.h>
+#include <class_track.h>
+#include <class_pad.h>
+#include <connect.h>
+#include <profile.h>
+#include <bench_driver.h>
+
+
+/**
+ * Function runConnections
+ * loads aFileName and computes its connectivity aRepeats times.
+ * @return 0 if the net codes match the file, 1 if they differ and 2 if the board
+ * cannot be loaded.
+ */
+static int runConnections( const wxString& aFileName, int aRepeats )
+{
+    BOARD* board = LoadBenchBoard( aFileName );
+
+    if( !board )
+        return 2;
+
+    // The net code of each track, as saved in the file
+    std::vector<const TRACK*>   tracks;
+    std::vector<int>            netcodes;
+
+    for( TRACK* track = board->m_Track; track; track = track->Next() )
+    {
+        tracks.push_back( track );
+        netcodes.push_back( track->GetNetCode() );
+    }
+
+    double netcodeTime = 0.0;
+    double connectionTime = 0.0;
+
+    for( int run = 0; run < aRepeats; ++run )
+    {
+        prof_counter cnt;
+
+        prof_start( &cnt );
+        RecalculateAllTracksNetcode( board );
+        prof_end( &cnt );
+        netcodeTime += cnt.msecs();
+
+        prof_start( &cnt );
+        TestConnections( board );
+        prof_end( &cnt );
+        connectionTime += cnt.msecs();
+    }
+
+    printf( "  %d tracks, %d pads: net codes %.1f ms, connections %.1f ms\n",
+            (int) tracks.size(), (int) board->GetPadCount(), netcodeTime / aRepeats,
+            connectionTime / aRepeats );
+
+    int result = 0;
+    int previous = 0;
+
+    for( TRACK* track = board->m_Track; track; track = track->Next() )
+    {
+        if( track->GetNetCode() < previous )
+        {
+            printf( "    the tracks are not sorted by net codes\n" );
+            result = 1;
+            break;
+        }
+
+        previous = track->GetNetCode();
+    }
+
+    int differences = 0;
+
+    for( unsigned ii = 0; ii < tracks.size(); ++ii )
+    {
+        if( tracks[ii]->GetNetCode() != netcodes[ii] )
+            differences++;
+    }
+
+    if( differences )
+    {
+        printf( "    %d track(s) have another net code than in the file\n", differences );
+        result = 1;
+    }
+
+    delete board;
+
+    return result;
+}
+
+
+int main( int argc, char** argv )
+{
+    return RunBench( argc, argv, "connect_bench", runConnections );
+}
@@ -0,0 +1,211 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file drc_bench.cpp
+ * @brief Benchmark and consistency check of the DRC implementations.
+ *
+ * Usage: drc_bench [--repeat N] board.kicad_pcb [board.kicad_pcb ...]
+ *
+ * Runs the DRC of each board (see DRC::RunTestsHeadless()) on one thread with the
+ * reference implementation, which scans the whole pad and track lists for the track
+ * clearances, and with the default one, which only tests the candidates found in a
+ * spatial index, then with the default one on all the processors, where the test
+ * families run concurrently and the marker texts are built after them.
+ * Prints the time of each test family, and checks all the modes find the same
+ * violations, with the same texts and in the same order.  The exit code is 0 if all
+ * the results match, 1 if they differ and 2 on errors.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <fctsys.h>
+#include <macros.h>
+#include <class_board.h>
+#include <drc_stuff.h>
+#include <ratsnest_data.h>
+#include <bench_driver.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+
+/// A way of running the DRC
+struct DRC_MODE
+{
+    const char* m_name;
+    bool        m_scanTracks;
+    bool        m_parallel;     ///< run on all the processors, otherwise on one thread
+};
+
+/// The first mode is the reference the others are compared to
+static const DRC_MODE modes[] =
+{
+    { "scan",       true,   false },
+    { "index",      false,  false },
+    { "parallel",   false,  true  }
+};
+
+static const int MODE_COUNT = sizeof( modes ) / sizeof( modes[0] );
+
+
+/**
+ * Function runDrc
+ * loads aFileName and runs the DRC in aMode.
+ * @return false if the board cannot be loaded.
+ */
+static bool runDrc( const wxString& aFileName, const DRC_MODE& aMode,
+                    std::vector<DRC_TEST_RESULT>& aResults )
+{
+    BOARD* board = LoadBenchBoard( aFileName );
+
+    if( !board )
+        return false;
+
+    int threadCount = 1;
+
+#ifdef USE_OPENMP
+    if( aMode.m_parallel )
+        threadCount = omp_get_num_procs();
+
+    omp_set_num_threads( threadCount );
+#endif /* USE_OPENMP */
+    RN_DATA::SetThreadCount( threadCount );
+
+    {
+        DRC drc( board );
+        drc.SetScanTracks( aMode.m_scanTracks );
+        drc.RunTestsHeadless( aResults );
+    }
+
+    delete board;
+
+    return true;
+}
+
+
+static bool sameItems( const DRC_ITEM& aItem, const DRC_ITEM& aOther )
+{
+    return aItem.GetErrorCode() == aOther.GetErrorCode()
+        && aItem.GetTextA() == aOther.GetTextA()
+        && aItem.GetPointA() == aOther.GetPointA()
+        && aItem.HasSecondItem() == aOther.HasSecondItem()
+        && aItem.GetTextB() == aOther.GetTextB()
+        && aItem.GetPointB() == aOther.GetPointB();
+}
+
+
+/**
+ * Function compareResults
+ * prints the first difference between the violations of aResults and aReference.
+ * @return true if they are identical.
+ */
+static bool compareResults( const std::vector<DRC_TEST_RESULT>& aReference,
+                            const std::vector<DRC_TEST_RESULT>& aResults )
+{
+    if( aReference.size() != aResults.size() )
+    {
+        printf( "    different test families: %d instead of %d\n", (int) aResults.size(),
+                (int) aReference.size() );
+        return false;
+    }
+
+    for( unsigned ii = 0; ii < aReference.size(); ++ii )
+    {
+        const std::vector<DRC_ITEM>& ref = aReference[ii].m_items;
+        const std::vector<DRC_ITEM>& items = aResults[ii].m_items;
+
+        if( ref.size() != items.size() )
+        {
+            printf( "    %s: %d violation(s) instead of %d\n", TO_UTF8( aResults[ii].m_name ),
+                    (int) items.size(), (int) ref.size() );
+            return false;
+        }
+
+        for( unsigned jj = 0; jj < ref.size(); ++jj )
+        {
+            if( !sameItems( ref[jj], items[jj] ) )
+            {
+                printf( "    %s: violation %d differs:\n%s    instead of:\n%s",
+                        TO_UTF8( aResults[ii].m_name ), jj,
+                        TO_UTF8( items[jj].ShowReport() ), TO_UTF8( ref[jj].ShowReport() ) );
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * Function runModes
+ * runs the DRC of aFileName in all the modes, aRepeats times each, and prints the time
+ * of each test family.
+ * @return 0 if all the modes find the same violations, 1 if they differ and 2 if the
+ * board cannot be loaded.
+ */
+static int runModes( const wxString& aFileName, int aRepeats )
+{
+    std::vector<DRC_TEST_RESULT> reference;
+    bool identical = true;
+
+    for( int mode = 0; mode < MODE_COUNT; ++mode )
+    {
+        std::vector<DRC_TEST_RESULT> results;
+        std::vector<double> msecs;
+
+        for( int run = 0; run < aRepeats; ++run )
+        {
+            if( !runDrc( aFileName, modes[mode], results ) )
+                return 2;
+
+            msecs.resize( results.size() );
+
+            for( unsigned jj = 0; jj < results.size(); ++jj )
+                msecs[jj] += results[jj].m_msecs / aRepeats;
+        }
+
+        printf( "  %-8s", modes[mode].m_name );
+
+        for( unsigned jj = 0; jj < results.size(); ++jj )
+            printf( " %s %.1f ms", TO_UTF8( results[jj].m_name ), msecs[jj] );
+
+        printf( "\n" );
+
+        if( mode == 0 )
+            reference = results;
+        else if( !compareResults( reference, results ) )
+            identical = false;
+    }
+
+    return identical ? 0 : 1;
+}
+
+
+int main( int argc, char** argv )
+{
+    return RunBench( argc, argv, "drc_bench", runModes );
+}
@@ -0,0 +1,275 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file line_reader_bench.cpp
+ * @brief Read benchmark of FILE_LINE_READER against MMAP_LINE_READER.
+ *
+ * Usage: line_reader_bench [file...]
+ *
+ * Reads each file line by line with both readers, a few times each, and prints
+ * the best time and throughput of each.  Both readers must give the same lines, which
+ * is checked with a checksum.  The "\r\n" line ends count as "\n", as MMAP_LINE_READER
+ * returns them.
+ *
+ * It first checks that MMAP_LINE_READER gives the same lines from a mapped file as from
+ * the files it cannot map, an open file which was already read from and a pipe, with a
+ * line longer than the initial line buffer and a line ending with "\r\n".
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <richio.h>
+#include <profile.h>
+
+#include <wx/filename.h>
+
+
+#define RUNS    5
+
+
+struct READ_RESULT
+{
+    unsigned long long  m_bytes;
+    unsigned long long  m_checksum;
+    unsigned            m_lines;
+};
+
+
+/**
+ * Reads all the lines of aReader, and touches each byte like a parser would.  A line
+ * ending with "\r\n" counts as ending with "\n".
+ */
+static READ_RESULT readAll( LINE_READER& aReader )
+{
+    READ_RESULT result = { 0, 0, 0 };
+
+    while( char* line = aReader.ReadLine() )
+    {
+        unsigned len = aReader.Length();
+
+        if( len >= 2 && line[len - 2] == '\r' && line[len - 1] == '\n' )
+        {
+            line[len - 2] = '\n';
+            --len;
+        }
+
+        for( unsigned ii = 0; ii < len; ++ii )
+            result.m_checksum = result.m_checksum * 31 + (unsigned char) line[ii];
+
+        result.m_bytes += len;
+        ++result.m_lines;
+    }
+
+    return result;
+}
+
+
+/// @return the best time of RUNS reads of aFileName, in milliseconds.
+static double bench( const wxString& aFileName, bool aMmap, READ_RESULT& aResult )
+{
+    double best = 0.0;
+
+    for( int run = 0; run < RUNS; ++run )
+    {
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        if( aMmap )
+        {
+            MMAP_LINE_READER reader( aFileName );
+            aResult = readAll( reader );
+        }
+        else
+        {
+            FILE_LINE_READER reader( aFileName );
+            aResult = readAll( reader );
+        }
+
+        prof_end( &cnt );
+
+        if( run == 0 || cnt.msecs() < best )
+            best = cnt.msecs();
+    }
+
+    return best;
+}
+
+
+/**
+ * Reads all the lines of aReader and checks they are the lines of aExpected, where
+ * "\r\n" is read as "\n".
+ */
+static bool checkLines( LINE_READER& aReader, const char* aName, const std::string& aExpected )
+{
+    std::string read;
+
+    try
+    {
+        while( char* line = aReader.ReadLine() )
+        {
+            if( strlen( line ) != aReader.Length() )
+                break;
+
+            read.append( line, aReader.Length() );
+        }
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "%s: %s\n", aName, (const char*) ioe.errorText.utf8_str() );
+        return false;
+    }
+
+    std::string expected = aExpected;
+    size_t      crlf;
+
+    while( ( crlf = expected.find( "\r\n" ) ) != std::string::npos )
+        expected.erase( crlf, 1 );
+
+    bool same = read == expected;
+
+    printf( "%s: %s\n", aName, same ? "ok" : "LINES DIFFER" );
+
+    return same;
+}
+
+
+/// Checks the files MMAP_LINE_READER maps and the ones it does not map give the same lines.
+static bool checkMappedAndUnmappedFiles()
+{
+    // longer than LINE_READER_LINE_INITIAL_SIZE, the line buffer is reallocated.
+    std::string longLine( 4 * LINE_READER_LINE_INITIAL_SIZE, 'a' );
+    std::string lines = longLine + "\ndos\r\nend\n";
+    bool        ok = true;
+
+    // A file which was not read from is mapped.
+    wxString tempName = wxFileName::CreateTempFileName( wxT( "line_reader_bench" ) );
+    FILE*    file = wxFopen( tempName, wxT( "wb" ) );
+
+    if( file )
+    {
+        fputs( lines.c_str(), file );
+        fclose( file );
+
+        try
+        {
+            MMAP_LINE_READER reader( tempName );
+            ok = checkLines( reader, "mapped file", lines );
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            fprintf( stderr, "%s\n", (const char*) ioe.errorText.utf8_str() );
+            ok = false;
+        }
+
+        wxRemoveFile( tempName );
+    }
+
+    // A file which was already read from is not mapped.
+    file = tmpfile();
+
+    if( file )
+    {
+        fputs( "first\n", file );
+        fputs( lines.c_str(), file );
+        rewind( file );
+
+        char first[16];
+
+        if( fgets( first, sizeof( first ), file ) )
+        {
+            MMAP_LINE_READER reader( file, wxT( "offset file" ), false );
+            ok = checkLines( reader, "offset file, not mapped", lines ) && ok;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        fclose( file );
+    }
+
+#ifndef __WINDOWS__
+    // A pipe is not mapped.
+    std::string command = "printf '%s'";
+    command.replace( command.find( "%s" ), 2, lines.substr( 0, lines.size() - 1 ) );
+    command += "; echo";
+
+    FILE* pipe = popen( command.c_str(), "r" );
+
+    if( pipe )
+    {
+        {
+            MMAP_LINE_READER reader( pipe, wxT( "pipe" ), false );
+            ok = checkLines( reader, "pipe, not mapped", lines ) && ok;
+        }
+
+        pclose( pipe );
+    }
+#endif
+
+    return ok;
+}
+
+
+int main( int argc, char** argv )
+{
+    bool ok = checkMappedAndUnmappedFiles();
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        wxString fileName = wxString::FromUTF8( argv[ii] );
+
+        try
+        {
+            READ_RESULT fileResult, mmapResult;
+
+            double fileTime = bench( fileName, false, fileResult );
+            double mmapTime = bench( fileName, true, mmapResult );
+            double megs = fileResult.m_bytes / ( 1024.0 * 1024.0 );
+
+            bool same = fileResult.m_bytes == mmapResult.m_bytes
+                        && fileResult.m_lines == mmapResult.m_lines
+                        && fileResult.m_checksum == mmapResult.m_checksum;
+
+            printf( "%s: %.1f MB, %u lines\n", argv[ii], megs, fileResult.m_lines );
+            printf( "  FILE_LINE_READER %10.2f ms %8.1f MB/s\n", fileTime,
+                    fileTime > 0.0 ? megs * 1000.0 / fileTime : 0.0 );
+            printf( "  MMAP_LINE_READER %10.2f ms %8.1f MB/s %s\n", mmapTime,
+                    mmapTime > 0.0 ? megs * 1000.0 / mmapTime : 0.0,
+                    same ? "" : "LINES DIFFER" );
+
+            ok = ok && same;
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            fprintf( stderr, "%s\n", (const char*) ioe.errorText.utf8_str() );
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file plotter_bench.cpp
+ * @brief Plotting benchmark of the PLOTTER backends.
+ *
+ * Usage: plotter_bench [primitive count [size count]]
+ *
+ * Plots the same set of pads, segments and polygons with each backend (Gerber, PDF,
+ * SVG, Postscript, DXF and HPGL), and prints the time and the number of primitives
+ * per second of each.  The pads and segments use "size count" different sizes and
+ * widths, which is the number of apertures of the Gerber file.  The plot files are
+ * written in the current directory and removed.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <common.h>
+#include <plot_common.h>
+#include <class_page_info.h>
+#include <profile.h>
+
+
+#define PRIMITIVES_DEFAULT  200000
+#define SIZES_DEFAULT       500
+
+/// Internal units per decimil, the ones of Pcbnew
+#define IUS_PER_DECIMIL     254.0
+
+
+/// Plots aCount primitives using aSizeCount sizes, on a 100 x 100 mm area.
+static void plotPrimitives( PLOTTER* aPlotter, int aCount, int aSizeCount )
+{
+    const int   step = 100000;      // 0.1 mm
+    const int   cols = 1000;
+    std::vector<wxPoint> poly( 5 );
+
+    for( int ii = 0; ii < aCount; ++ii )
+    {
+        wxPoint pos( ( ii % cols ) * step, ( ( ii / cols ) % cols ) * step );
+        int     size = 100000 + ( ii % aSizeCount ) * 1000;
+
+        switch( ii % 6 )
+        {
+        case 0:
+            aPlotter->FlashPadCircle( pos, size, FILLED );
+            break;
+
+        case 1:
+            aPlotter->FlashPadRect( pos, wxSize( size, size / 2 ), 0.0, FILLED );
+            break;
+
+        case 2:
+            aPlotter->FlashPadOval( pos, wxSize( size, size * 2 ), 900.0, FILLED );
+            break;
+
+        case 3:
+        case 4:
+            aPlotter->ThickSegment( pos, pos + wxPoint( step * 5, step ), size / 4, FILLED );
+            break;
+
+        case 5:
+            poly[0] = pos;
+            poly[1] = pos + wxPoint( size, 0 );
+            poly[2] = pos + wxPoint( size, size );
+            poly[3] = pos + wxPoint( 0, size );
+            poly[4] = pos;
+            aPlotter->PlotPoly( poly, FILLED_SHAPE, size / 8 );
+            break;
+        }
+    }
+}
+
+
+/// @return the time to plot aCount primitives with aPlotter, in milliseconds,
+/// or a negative value if the plot file cannot be written.
+static double bench( PLOTTER* aPlotter, int aCount, int aSizeCount )
+{
+    wxString    fileName = wxT( "plotter_bench." )
+                           + GetDefaultPlotExtension( aPlotter->GetPlotterType() );
+    PAGE_INFO   page( wxT( "A4" ) );
+    double      time = -1.0;
+
+    aPlotter->SetPageSettings( page );
+    aPlotter->SetViewport( wxPoint( 0, 0 ), IUS_PER_DECIMIL, 1.0, false );
+    aPlotter->SetCreator( wxT( "plotter_bench" ) );
+
+    if( aPlotter->OpenFile( fileName ) )
+    {
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        aPlotter->StartPlot();
+        plotPrimitives( aPlotter, aCount, aSizeCount );
+        bool ok = aPlotter->EndPlot();
+
+        prof_end( &cnt );
+
+        if( ok )
+            time = cnt.msecs();
+    }
+
+    wxRemoveFile( fileName );
+
+    return time;
+}
+
+
+int main( int argc, char** argv )
+{
+    int count = argc > 1 ? atoi( argv[1] ) : PRIMITIVES_DEFAULT;
+    int sizeCount = argc > 2 ? atoi( argv[2] ) : SIZES_DEFAULT;
+
+    if( count <= 0 || sizeCount <= 0 )
+    {
+        fprintf( stderr, "Usage: plotter_bench [primitive count [size count]]\n" );
+        return 1;
+    }
+
+    LOCALE_IO toggle;   // use standard C notation for float numbers
+
+    printf( "%d primitives, %d sizes\n", count, sizeCount );
+
+    bool ok = true;
+
+    for( int format = PLOT_FIRST_FORMAT; format <= PLOT_LAST_FORMAT; ++format )
+    {
+        PLOTTER* plotter;
+
+        switch( format )
+        {
+        case PLOT_FORMAT_HPGL:      plotter = new HPGL_PLOTTER();   break;
+        case PLOT_FORMAT_GERBER:    plotter = new GERBER_PLOTTER(); break;
+        case PLOT_FORMAT_POST:      plotter = new PS_PLOTTER();     break;
+        case PLOT_FORMAT_DXF:       plotter = new DXF_PLOTTER();    break;
+        case PLOT_FORMAT_PDF:       plotter = new PDF_PLOTTER();    break;
+        case PLOT_FORMAT_SVG:       plotter = new SVG_PLOTTER();    break;
+        default:                    continue;
+        }
+
+        wxString name = GetDefaultPlotExtension( plotter->GetPlotterType() );
+        double   time = bench( plotter, count, sizeCount );
+
+        if( time < 0.0 )
+        {
+            printf( "  %-4s failed\n", TO_UTF8( name ) );
+            ok = false;
+        }
+        else
+        {
+            printf( "  %-4s %10.2f ms %12.0f primitives/s\n", TO_UTF8( name ), time,
+                    time > 0.0 ? count * 1000.0 / time : 0.0 );
+        }
+
+        delete plotter;
+    }
+
+    return ok ? 0 : 1;
+}
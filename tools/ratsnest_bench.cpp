@@ -0,0 +1,290 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file ratsnest_bench.cpp
+ * @brief Consistency check and benchmark of the incremental ratsnest update.
+ *
+ * Usage: ratsnest_bench [board count [moves per board]]
+ *
+ * Builds random boards of footprints whose pads belong to a few nets, then moves random
+ * footprints, updating the ratsnest incrementally (see RN_NET::updateTriangulation()).
+ * After each move, the ratsnest of every net is compared with the one of a ratsnest
+ * computed from scratch.  The positions are multiples of 2^16 nm, so the edge weights
+ * are exact squared distances, and both minimal spanning trees must have the same edge
+ * weights.  The first board is the case of a node added between two distant groups of
+ * nodes.  The exit code is 0 if all the results match, 1 otherwise.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+#include <wx/init.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_netinfo.h>
+#include <ratsnest_data.h>
+#include <profile.h>
+
+
+#define BOARDS_DEFAULT      20
+#define MOVES_DEFAULT       50
+
+/// Position unit, so the ratsnest weights (see getDistance()) are exact
+#define GRID                ( 1 << 16 )
+
+#define NET_COUNT           6
+#define FOOTPRINT_COUNT     150
+#define MAX_PADS            12
+#define BOARD_SIZE          1500        // in GRID units
+
+
+/// @return a random number in [0, aRange).
+static int randomInt( int aRange )
+{
+    return (int) ( ( (double) rand() / ( (double) RAND_MAX + 1.0 ) ) * aRange );
+}
+
+
+/// Adds a footprint at aOrigin, with aCount pads in a row on the nets given by aNets.
+static MODULE* addFootprint( BOARD* aBoard, const wxPoint& aOrigin, int aCount, const int* aNets )
+{
+    MODULE* module = new MODULE( aBoard );
+
+    module->SetPosition( aOrigin );
+    module->SetReference( wxString::Format( wxT( "U%d" ), aBoard->m_Modules.GetCount() + 1 ) );
+    aBoard->Add( module );
+
+    for( int ii = 0; ii < aCount; ++ii )
+    {
+        D_PAD*  pad = new D_PAD( module );
+        wxPoint offset( ii * 2 * GRID, 0 );
+
+        pad->SetShape( PAD_RECT );
+        pad->SetSize( wxSize( GRID, GRID ) );
+        pad->SetAttribute( PAD_SMD );
+        pad->SetLayerSet( D_PAD::SMDMask() );
+        pad->SetPadName( wxString::Format( wxT( "%d" ), ii + 1 ) );
+        pad->SetPos0( offset );
+        pad->SetPosition( aOrigin + offset );
+        pad->SetNetCode( aNets[ii] );
+        module->Pads().PushBack( pad );
+    }
+
+    return module;
+}
+
+
+static void addNets( BOARD* aBoard )
+{
+    for( int net = 1; net <= NET_COUNT; ++net )
+        aBoard->AppendNet( new NETINFO_ITEM( aBoard, wxString::Format( wxT( "N%d" ), net ), net ) );
+}
+
+
+/// @return the sorted edge weights of the ratsnest of aNet.
+static std::vector<unsigned int> ratsnestWeights( RN_DATA& aRatsnest, int aNet )
+{
+    std::vector<unsigned int> weights;
+    const std::vector<RN_EDGE_MST_PTR>* edges = aRatsnest.GetNet( aNet ).GetUnconnected();
+
+    if( edges )
+    {
+        for( unsigned int ii = 0; ii < edges->size(); ++ii )
+            weights.push_back( (*edges)[ii]->GetWeight() );
+    }
+
+    std::sort( weights.begin(), weights.end() );
+
+    return weights;
+}
+
+
+/**
+ * Function compareRatsnest
+ * computes the ratsnest of aBoard from scratch, and compares it with aRatsnest.
+ * @return true if the edge weights of all the nets match.
+ */
+static bool compareRatsnest( BOARD* aBoard, RN_DATA& aRatsnest, double& aFullTime )
+{
+    RN_DATA full( aBoard );
+    prof_counter cnt;
+
+    prof_start( &cnt );
+    full.ProcessBoard();
+    prof_end( &cnt );
+    aFullTime += cnt.msecs();
+
+    for( int net = 1; net < aBoard->GetNetCount(); ++net )
+    {
+        std::vector<unsigned int> incremental = ratsnestWeights( aRatsnest, net );
+        std::vector<unsigned int> reference = ratsnestWeights( full, net );
+
+        if( incremental != reference )
+        {
+            unsigned int sum = 0, refSum = 0;
+
+            for( unsigned int ii = 0; ii < incremental.size(); ++ii )
+                sum += incremental[ii];
+
+            for( unsigned int ii = 0; ii < reference.size(); ++ii )
+                refSum += reference[ii];
+
+            printf( "  net %d: %d edges of total weight %u instead of %d edges of weight %u\n",
+                    net, (int) incremental.size(), sum, (int) reference.size(), refSum );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/// Two groups of pads far away from each other, then a pad added between them.
+static bool checkDistantGroups()
+{
+    BOARD board;
+    int nets[MAX_PADS];
+
+    addNets( &board );
+    std::fill( nets, nets + MAX_PADS, 1 );
+
+    addFootprint( &board, wxPoint( 0, 0 ), 8, nets );
+    addFootprint( &board, wxPoint( 0, 4 * GRID ), 8, nets );
+    addFootprint( &board, wxPoint( 100 * GRID, 0 ), 8, nets );
+    addFootprint( &board, wxPoint( 100 * GRID, 4 * GRID ), 8, nets );
+
+    RN_DATA ratsnest( &board );
+    ratsnest.ProcessBoard();
+
+    MODULE* module = addFootprint( &board, wxPoint( 55 * GRID, 2 * GRID ), 1, nets );
+    ratsnest.Add( module );
+    ratsnest.Recalculate();
+
+    double fullTime = 0.0;
+    bool ok = compareRatsnest( &board, ratsnest, fullTime );
+
+    printf( "distant groups: %s\n", ok ? "match" : "DIFFERENT" );
+
+    return ok;
+}
+
+
+static bool checkRandomBoard( int aSeed, int aMoves, double& aIncrementalTime,
+                              double& aFullTime )
+{
+    BOARD board;
+    std::vector<MODULE*> modules;
+
+    srand( aSeed );
+    addNets( &board );
+
+    for( int ii = 0; ii < FOOTPRINT_COUNT; ++ii )
+    {
+        int nets[MAX_PADS];
+        int count = 1 + randomInt( MAX_PADS );
+
+        for( int jj = 0; jj < count; ++jj )
+            nets[jj] = 1 + randomInt( NET_COUNT );
+
+        // Footprints are on separate rows, so no two pads are at the same place
+        wxPoint origin( randomInt( BOARD_SIZE ) * GRID, ii * 3 * GRID );
+        modules.push_back( addFootprint( &board, origin, count, nets ) );
+    }
+
+    RN_DATA ratsnest( &board );
+    ratsnest.ProcessBoard();
+
+    for( int move = 0; move < aMoves; ++move )
+    {
+        prof_counter cnt;
+
+        // Move a few footprints along their row, as they would be dragged
+        int count = 1 + randomInt( 3 );
+
+        prof_start( &cnt );
+
+        for( int ii = 0; ii < count; ++ii )
+        {
+            MODULE* module = modules[randomInt( modules.size() )];
+            int dx = randomInt( BOARD_SIZE ) * GRID - module->GetPosition().x;
+
+            module->Move( wxPoint( dx, 0 ) );
+            ratsnest.Update( module );
+        }
+
+        ratsnest.Recalculate();
+        prof_end( &cnt );
+        aIncrementalTime += cnt.msecs();
+
+        if( !compareRatsnest( &board, ratsnest, aFullTime ) )
+        {
+            printf( "board %d: move %d differs\n", aSeed, move );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+int main( int argc, char** argv )
+{
+    int boards = argc > 1 ? atoi( argv[1] ) : BOARDS_DEFAULT;
+    int moves = argc > 2 ? atoi( argv[2] ) : MOVES_DEFAULT;
+
+    if( argc > 3 || boards <= 0 || moves <= 0 )
+    {
+        fprintf( stderr, "Usage: ratsnest_bench [board count [moves per board]]\n" );
+        return 1;
+    }
+
+    wxInitializer initializer( argc, argv );
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Can't initialize wxWidgets\n" );
+        return 1;
+    }
+
+    bool ok = checkDistantGroups();
+    double incrementalTime = 0.0;
+    double fullTime = 0.0;
+    int failures = 0;
+
+    for( int seed = 1; seed <= boards; ++seed )
+    {
+        if( !checkRandomBoard( seed, moves, incrementalTime, fullTime ) )
+            failures++;
+    }
+
+    printf( "%d random boards, %d moves each: %d failure(s)\n", boards, moves, failures );
+    printf( "  incremental update %10.2f ms per move, full recompute %10.2f ms\n",
+            incrementalTime / ( boards * moves ), fullTime / ( boards * moves ) );
+
+    return ok && !failures ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file save_bench.cpp
+ * @brief Benchmark and consistency check of the background board save.
+ *
+ * Usage: save_bench [--repeat N] board.kicad_pcb [board.kicad_pcb ...]
+ *
+ * Saves each board in the foreground with PCB_IO::Save(), as SavePcbFile() does, then
+ * with a BACKGROUND_BOARD_SAVER, as the auto save does: a snapshot of the board is
+ * taken on the calling thread and saved on a worker thread.  The second file must
+ * be byte-identical to the first one.  Prints the time of the foreground save and
+ * the time the calling thread is blocked by the background save.  The exit code is 0
+ * if all the files match, 1 if they differ and 2 on errors.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <boost/bind.hpp>
+
+#include <wx/filename.h>
+
+#include <fctsys.h>
+#include <macros.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <background_save.h>
+#include <profile.h>
+#include <bench_driver.h>
+
+
+/// The result of a background save, written by the worker thread
+struct SAVE_RESULT
+{
+    wxString    m_error;
+
+    void Done( const wxString& aFileName, const wxString& aError )
+    {
+        m_error = aError;
+    }
+};
+
+
+/**
+ * Function readFile
+ * reads the whole content of aFileName in aText.
+ * @return false if the file cannot be read.
+ */
+static bool readFile( const wxString& aFileName, std::string& aText )
+{
+    FILE* fp = wxFopen( aFileName, wxT( "rb" ) );
+
+    if( !fp )
+        return false;
+
+    char    buffer[8192];
+    size_t  count;
+
+    aText.clear();
+
+    while( ( count = fread( buffer, 1, sizeof( buffer ), fp ) ) > 0 )
+        aText.append( buffer, count );
+
+    bool ok = !ferror( fp );
+
+    fclose( fp );
+
+    return ok;
+}
+
+
+/**
+ * Function runSaves
+ * loads aFileName and saves it aRepeats times in the foreground and in the background.
+ * @return 0 if the saved files are identical, 1 if they differ and 2 on errors.
+ */
+static int runSaves( const wxString& aFileName, int aRepeats )
+{
+    BOARD* board = LoadBenchBoard( aFileName );
+
+    if( !board )
+        return 2;
+
+    wxString foregroundName = wxFileName::CreateTempFileName( wxT( "save_bench" ) );
+    wxString backgroundName = wxFileName::CreateTempFileName( wxT( "save_bench" ) );
+
+    double  foregroundTime = 0.0;
+    double  backgroundTime = 0.0;
+    int     result = 0;
+
+    BACKGROUND_BOARD_SAVER  saver;
+
+    for( int run = 0; run < aRepeats && !result; ++run )
+    {
+        prof_counter cnt;
+
+        try
+        {
+            PLUGIN::RELEASER pi( IO_MGR::PluginFind( IO_MGR::KICAD ) );
+
+            prof_start( &cnt );
+            pi->Save( foregroundName, board, NULL );
+            prof_end( &cnt );
+            foregroundTime += cnt.msecs();
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            fprintf( stderr, "Can't save %s: %s\n", TO_UTF8( foregroundName ),
+                     TO_UTF8( ioe.errorText ) );
+            result = 2;
+            break;
+        }
+
+        SAVE_RESULT saved;
+
+        prof_start( &cnt );
+        saver.Start( board, backgroundName, boost::bind( &SAVE_RESULT::Done, &saved, _1, _2 ) );
+        prof_end( &cnt );
+        backgroundTime += cnt.msecs();
+
+        saver.Wait();
+
+        if( !saved.m_error.IsEmpty() )
+        {
+            fprintf( stderr, "Can't save %s: %s\n", TO_UTF8( backgroundName ),
+                     TO_UTF8( saved.m_error ) );
+            result = 2;
+            break;
+        }
+
+        std::string foreground, background;
+
+        if( !readFile( foregroundName, foreground ) || !readFile( backgroundName, background ) )
+        {
+            fprintf( stderr, "Can't read the saved files\n" );
+            result = 2;
+        }
+        else if( foreground != background )
+        {
+            size_t pos = 0;
+
+            while( pos < foreground.size() && pos < background.size()
+                   && foreground[pos] == background[pos] )
+                ++pos;
+
+            printf( "    the background save differs at byte %u\n", (unsigned) pos );
+            result = 1;
+        }
+    }
+
+    if( result != 2 )
+    {
+        printf( "  foreground save %.1f ms, background save blocks %.1f ms\n",
+                foregroundTime / aRepeats, backgroundTime / aRepeats );
+    }
+
+    wxRemoveFile( foregroundName );
+    wxRemoveFile( backgroundName );
+
+    delete board;
+
+    return result;
+}
+
+
+int main( int argc, char** argv )
+{
+    return RunBench( argc, argv, "save_bench", runSaves );
+}
@@ -0,0 +1,540 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file shape_poly_set_bench.cpp
+ * @brief Microbenchmark for the SHAPE_POLY_SET boolean operations, inflation and fracturing.
+ *
+ * Without arguments, runs on synthetic polygons (a grid of pads with holes, cut by
+ * clearance circles). Otherwise, runs on polygon sets dumped by the zone filler
+ * (see g_DumpZonesWhenFilling): each zone solid area is tested against its feature holes.
+ *
+ * Each operation is run as by default, with a single Clipper pass over the whole set,
+ * then split in independent groups (see SHAPE_POLY_SET::SetSplitOperations()) with one
+ * thread and with all the available threads.  The split results must have the same area
+ * and number of vertices as the default ones (within a small tolerance, Clipper may merge
+ * the edges of the groups in another order), and the results of the threaded runs must
+ * be identical to the single thread ones.
+ *
+ * Then Contains() and Collide() are checked against a brute force point in polygon test
+ * on the fractured difference, first from one thread, then from several threads on a
+ * set which is not indexed yet, and on a set whose outlines are moved in place after it
+ * was indexed.  The exit code is 0 if all the results match, 1 otherwise.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+#include <profile.h>
+#include <geometry/shape_poly_set.h>
+#include <clipper.hpp>
+
+using namespace ClipperLib;
+
+
+///> Relative area difference allowed between the split and reference results
+static const double AREA_TOLERANCE = 1e-6;
+
+///> Relative vertex count difference allowed between the split and reference results
+static const double VERTEX_TOLERANCE = 1e-3;
+
+///> Number of random points given to the point queries
+static const int QUERY_COUNT = 100000;
+
+///> Clearance of the Collide() queries
+static const int QUERY_CLEARANCE = 50000;
+
+///> Threads running the point queries at once
+static const int QUERY_THREADS = 4;
+
+
+static void addCircle( SHAPE_POLY_SET& aSet, int aX, int aY, int aRadius, int aSegs )
+{
+    aSet.NewOutline();
+
+    for( int i = 0; i < aSegs; i++ )
+    {
+        double a = 2.0 * M_PI * i / aSegs;
+        aSet.Append( aX + (int) ( aRadius * cos( a ) ), aY + (int) ( aRadius * sin( a ) ) );
+    }
+}
+
+
+/**
+ * Function makeSynthetic
+ * builds aSize x aSize square islands with a hole each, and a set of clearance
+ * circles cutting them.
+ */
+static void makeSynthetic( int aSize, SHAPE_POLY_SET& aIslands, SHAPE_POLY_SET& aHoles )
+{
+    const int pitch = 2000000;
+    const int half = 800000;
+
+    for( int i = 0; i < aSize; i++ )
+    {
+        for( int j = 0; j < aSize; j++ )
+        {
+            int x = i * pitch;
+            int y = j * pitch;
+            int outline = aIslands.NewOutline();
+
+            aIslands.Append( x - half, y - half, outline );
+            aIslands.Append( x + half, y - half, outline );
+            aIslands.Append( x + half, y + half, outline );
+            aIslands.Append( x - half, y + half, outline );
+
+            aIslands.NewHole( outline );
+            aIslands.Append( x - half / 4, y - half / 4, outline, 0 );
+            aIslands.Append( x + half / 4, y - half / 4, outline, 0 );
+            aIslands.Append( x + half / 4, y + half / 4, outline, 0 );
+            aIslands.Append( x - half / 4, y + half / 4, outline, 0 );
+
+            addCircle( aHoles, x + half, y + half / 2, half / 3, 32 );
+            addCircle( aHoles, x - half / 2, y - half, half / 4, 32 );
+        }
+    }
+}
+
+
+static bool loadDump( const char* aFilename, std::vector<SHAPE_POLY_SET>& aSets,
+                      std::vector<std::string>& aNames )
+{
+    std::ifstream file( aFilename );
+
+    if( !file )
+        return false;
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+
+    std::string tmp;
+
+    while( ss >> tmp )
+    {
+        if( tmp != "shape" )
+            continue;
+
+        int type;
+        std::string name;
+
+        ss >> type >> name;
+
+        if( type != SH_POLY_SET )
+            continue;
+
+        SHAPE_POLY_SET set;
+
+        if( set.Parse( ss ) )
+        {
+            aSets.push_back( set );
+            aNames.push_back( name );
+        }
+    }
+
+    return true;
+}
+
+
+static void setThreads( int aCount )
+{
+#ifdef USE_OPENMP
+    omp_set_num_threads( aCount );
+#endif /* USE_OPENMP */
+}
+
+
+static int maxThreads()
+{
+#ifdef USE_OPENMP
+    return omp_get_num_procs();
+#else
+    return 1;
+#endif /* USE_OPENMP */
+}
+
+
+enum BENCH_OP
+{
+    OP_UNION,
+    OP_SUBTRACT,
+    OP_INFLATE,
+    OP_FRACTURE
+};
+
+
+static const char* opName( BENCH_OP aOp )
+{
+    switch( aOp )
+    {
+    case OP_UNION:      return "union";
+    case OP_SUBTRACT:   return "subtract";
+    case OP_INFLATE:    return "inflate";
+    default:            return "fracture";
+    }
+}
+
+
+static Path toClipper( const SHAPE_LINE_CHAIN& aPath, bool aOutline )
+{
+    Path path;
+
+    for( int i = 0; i < aPath.PointCount(); i++ )
+        path.push_back( IntPoint( aPath.CPoint( i ).x, aPath.CPoint( i ).y ) );
+
+    if( Orientation( path ) != aOutline )
+        ReversePath( path );
+
+    return path;
+}
+
+
+static Paths toClipper( const SHAPE_POLY_SET& aSet )
+{
+    Paths paths;
+
+    for( int i = 0; i < aSet.OutlineCount(); i++ )
+    {
+        const SHAPE_POLY_SET::POLYGON& poly = aSet.CPolygon( i );
+
+        for( unsigned int j = 0; j < poly.size(); j++ )
+            paths.push_back( toClipper( poly[j], j == 0 ) );
+    }
+
+    return paths;
+}
+
+
+/// @return the area of aPaths, holes being oriented the other way round than outlines
+static double area( const Paths& aPaths )
+{
+    double total = 0.0;
+
+    for( unsigned int i = 0; i < aPaths.size(); i++ )
+        total += Area( aPaths[i] );
+
+    return total;
+}
+
+
+static int vertexCount( const Paths& aPaths )
+{
+    int count = 0;
+
+    for( unsigned int i = 0; i < aPaths.size(); i++ )
+        count += aPaths[i].size();
+
+    return count;
+}
+
+
+static bool near( double aValue, double aReference, double aTolerance )
+{
+    return fabs( aValue - aReference ) <= fabs( aReference ) * aTolerance + 1.0;
+}
+
+
+static SHAPE_POLY_SET runOp( BENCH_OP aOp, const SHAPE_POLY_SET& aA, const SHAPE_POLY_SET& aB,
+                             bool aSplit, int aThreads, float& aMsecs )
+{
+    SHAPE_POLY_SET result( aA );
+    prof_counter cnt;
+
+    result.SetSplitOperations( aSplit );
+    setThreads( aThreads );
+    prof_start( &cnt );
+
+    switch( aOp )
+    {
+    case OP_UNION:      result.BooleanAdd( aB );        break;
+    case OP_SUBTRACT:   result.BooleanSubtract( aB );   break;
+    case OP_INFLATE:    result.Inflate( 100000, 16 );   break;
+    case OP_FRACTURE:   result.Fracture();              break;
+    }
+
+    prof_end( &cnt );
+    aMsecs = cnt.msecs();
+
+    return result;
+}
+
+
+/// @return true if aP is inside aPath, by the even-odd rule, testing every edge.
+static bool pointInOutline( const VECTOR2I& aP, const SHAPE_LINE_CHAIN& aPath )
+{
+    bool inside = false;
+    int cnt = aPath.PointCount();
+
+    for( int i = 0, j = cnt - 1; i < cnt; j = i++ )
+    {
+        const VECTOR2I& a = aPath.CPoint( i );
+        const VECTOR2I& b = aPath.CPoint( j );
+
+        if( ( a.y > aP.y ) != ( b.y > aP.y )
+            && aP.x < (double) ( b.x - a.x ) * ( aP.y - a.y ) / ( b.y - a.y ) + a.x )
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+
+/**
+ * Function checkQueries
+ * compares SHAPE_POLY_SET::Contains() and Collide() with a brute force test on random
+ * points, then runs them from several threads on a copy which is not indexed yet, and
+ * on a copy whose outlines are moved through Outline() after it was indexed.
+ * @return true if all the results match.
+ */
+static bool checkQueries( const SHAPE_POLY_SET& aSet )
+{
+    BOX2I bbox = aSet.BBox( QUERY_CLEARANCE );
+    std::vector<VECTOR2I> points( QUERY_COUNT );
+    std::vector<char> onEdge( QUERY_COUNT );
+    std::vector<char> refContains( QUERY_COUNT ), refCollide( QUERY_COUNT );
+    std::vector<char> contains( QUERY_COUNT ), collide( QUERY_COUNT );
+    std::vector<char> threadContains( QUERY_COUNT ), threadCollide( QUERY_COUNT );
+    prof_counter cnt;
+    float bruteForce, indexed, threaded;
+
+    srand( 1 );
+
+    for( int i = 0; i < QUERY_COUNT; i++ )
+    {
+        int64_t x = ( (int64_t) rand() * RAND_MAX + rand() ) % ( (int64_t) bbox.GetWidth() + 1 );
+        int64_t y = ( (int64_t) rand() * RAND_MAX + rand() ) % ( (int64_t) bbox.GetHeight() + 1 );
+
+        points[i] = VECTOR2I( bbox.GetX() + (int) x, bbox.GetY() + (int) y );
+    }
+
+    std::vector<BOX2I> boxes;
+
+    for( int j = 0; j < aSet.OutlineCount(); j++ )
+        boxes.push_back( aSet.CPolygon( j )[0].BBox( QUERY_CLEARANCE ) );
+
+    prof_start( &cnt );
+
+    for( int i = 0; i < QUERY_COUNT; i++ )
+    {
+        int distance = INT_MAX;
+
+        refContains[i] = false;
+
+        // Holes are not supported by Contains() and Collide(): only test the outlines
+        for( int j = 0; j < aSet.OutlineCount(); j++ )
+        {
+            const SHAPE_LINE_CHAIN& path = aSet.CPolygon( j )[0];
+
+            if( !boxes[j].Contains( points[i] ) )
+                continue;
+
+            if( pointInOutline( points[i], path ) )
+                refContains[i] = true;
+
+            distance = std::min( distance, path.Distance( points[i] ) );
+        }
+
+        // The points on the edges are inside, which the brute force test does not tell
+        onEdge[i] = distance <= 1;
+        refCollide[i] = refContains[i] || distance <= QUERY_CLEARANCE;
+    }
+
+    prof_end( &cnt );
+    bruteForce = cnt.msecs();
+
+    prof_start( &cnt );
+
+    for( int i = 0; i < QUERY_COUNT; i++ )
+    {
+        contains[i] = aSet.Contains( points[i] );
+        collide[i] = aSet.Collide( points[i], QUERY_CLEARANCE );
+    }
+
+    prof_end( &cnt );
+    indexed = cnt.msecs();
+
+    // Moving the copy drops its index: the threads will race to build it
+    SHAPE_POLY_SET shared( aSet );
+    shared.Move( VECTOR2I( 0, 0 ) );
+
+    prof_start( &cnt );
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for num_threads( QUERY_THREADS )
+#endif /* USE_OPENMP */
+    for( int i = 0; i < QUERY_COUNT; i++ )
+    {
+        threadContains[i] = shared.Contains( points[i] );
+        threadCollide[i] = shared.Collide( points[i], QUERY_CLEARANCE );
+    }
+
+    prof_end( &cnt );
+    threaded = cnt.msecs();
+
+    int errors = 0;
+    int threadErrors = 0;
+    int movedErrors = 0;
+
+    for( int i = 0; i < QUERY_COUNT; i++ )
+    {
+        if( ( !onEdge[i] && contains[i] != refContains[i] ) || collide[i] != refCollide[i] )
+            errors++;
+
+        if( threadContains[i] != contains[i] || threadCollide[i] != collide[i] )
+            threadErrors++;
+    }
+
+    // The outlines modified through a reference after the index was built are indexed again
+    SHAPE_POLY_SET moved( aSet );
+    VECTOR2I offset( bbox.GetWidth() / 3, bbox.GetHeight() / 5 );
+
+    moved.Contains( points[0] );
+
+    for( int j = 0; j < moved.OutlineCount(); j++ )
+        moved.Outline( j ).Move( offset );
+
+    for( int i = 0; i < QUERY_COUNT; i += 10 )
+    {
+        if( moved.Contains( points[i] + offset ) != (bool) contains[i]
+            || moved.Collide( points[i] + offset, QUERY_CLEARANCE ) != (bool) collide[i] )
+            movedErrors++;
+    }
+
+    printf( "  %-10s %10.2f ms (reference) %10.2f ms (indexed) %10.2f ms (%d threads) ",
+            "queries", bruteForce, indexed, threaded, QUERY_THREADS );
+
+    if( errors )
+        printf( "%d WRONG RESULTS ", errors );
+
+    if( threadErrors )
+        printf( "%d THREADED RESULTS DIFFER ", threadErrors );
+
+    if( movedErrors )
+        printf( "%d MOVED RESULTS DIFFER", movedErrors );
+
+    printf( "\n" );
+
+    return !errors && !threadErrors && !movedErrors;
+}
+
+
+static bool benchmark( const char* aName, const SHAPE_POLY_SET& aA, const SHAPE_POLY_SET& aB )
+{
+    bool ok = true;
+
+    printf( "%s: %d polygons, %d vertices (clip: %d polygons, %d vertices)\n", aName,
+            aA.OutlineCount(), aA.TotalVertices(), aB.OutlineCount(), aB.TotalVertices() );
+
+    for( int op = OP_UNION; op <= OP_FRACTURE; op++ )
+    {
+        float single, multi, reference;
+
+        SHAPE_POLY_SET unsplit = runOp( (BENCH_OP) op, aA, aB, false, 1, reference );
+        SHAPE_POLY_SET ref = runOp( (BENCH_OP) op, aA, aB, true, 1, single );
+        SHAPE_POLY_SET res = runOp( (BENCH_OP) op, aA, aB, true, maxThreads(), multi );
+
+        Paths paths = toClipper( ref );
+        Paths refPaths = toClipper( unsplit );
+        bool same = ref.Format() == res.Format();
+        bool match = near( area( paths ), area( refPaths ), AREA_TOLERANCE )
+                     && near( vertexCount( paths ), vertexCount( refPaths ), VERTEX_TOLERANCE );
+
+        printf( "  %-10s %10.2f ms (unsplit) %10.2f ms (1 thread) %10.2f ms (%d threads) %s%s\n",
+                opName( (BENCH_OP) op ), reference, single, multi, maxThreads(),
+                match ? "" : "AREA OR VERTICES DIFFER ", same ? "" : "THREADED RESULTS DIFFER" );
+
+        if( !match )
+        {
+            printf( "    area %.0f instead of %.0f, %d vertices instead of %d\n",
+                    area( paths ), area( refPaths ), vertexCount( paths ),
+                    vertexCount( refPaths ) );
+        }
+
+        ok = ok && same && match;
+    }
+
+    // Point queries on fractured copper, as in the ratsnest, DRC and zone filling
+    SHAPE_POLY_SET copper( aA );
+    copper.BooleanSubtract( aB );
+    copper.Fracture();
+
+    ok = checkQueries( copper ) && ok;
+
+    return ok;
+}
+
+
+int main( int argc, char** argv )
+{
+    bool ok = true;
+
+    if( argc < 2 )
+    {
+        int sizes[] = { 10, 50, 100 };
+
+        for( unsigned int i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ )
+        {
+            SHAPE_POLY_SET islands, holes;
+            char name[64];
+
+            makeSynthetic( sizes[i], islands, holes );
+            sprintf( name, "synthetic %dx%d", sizes[i], sizes[i] );
+
+            ok = benchmark( name, islands, holes ) && ok;
+        }
+    }
+
+    for( int i = 1; i < argc; i++ )
+    {
+        std::vector<SHAPE_POLY_SET> sets;
+        std::vector<std::string> names;
+
+        if( !loadDump( argv[i], sets, names ) )
+        {
+            fprintf( stderr, "Can't read %s\n", argv[i] );
+            return 1;
+        }
+
+        // Each zone dump holds its solid areas, followed by the holes subtracted from them
+        for( unsigned int j = 0; j + 1 < sets.size(); j++ )
+        {
+            if( names[j] != "solid-areas" || names[j + 1] != "feature-holes" )
+                continue;
+
+            char name[1024];
+            snprintf( name, sizeof( name ), "%s, zone #%u", argv[i], j );
+
+            ok = benchmark( name, sets[j], sets[j + 1] ) && ok;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
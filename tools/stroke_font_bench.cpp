@@ -0,0 +1,203 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file stroke_font_bench.cpp
+ * @brief Benchmark of the layout cache of the GAL stroke font.
+ *
+ * Usage: stroke_font_bench [frame count]
+ *
+ * Draws sets of texts (references, pad names and net names) with the stroke font of a GAL
+ * which only counts the points, frame after frame in the same order, as a view redraw does.
+ * The sets are smaller and larger than the layout cache.  Prints the time per frame with
+ * the layout cache and without it, and checks that both draw the same points.  Also draws
+ * a frame of the large set followed by frames of another set, as after a zoom change.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <wx/init.h>
+#include <wx/string.h>
+
+#include <macros.h>
+#include <gal/graphics_abstraction_layer.h>
+#include <profile.h>
+
+
+#define FRAMES_DEFAULT  20
+
+/// Number of texts of each set, around the default size of the layout cache (8192)
+static const unsigned TEXT_COUNTS[] = { 2000, 8000, 9000, 12000, 20000, 60000 };
+
+
+/**
+ * A GAL which does not draw: it sums the coordinates of the points, to check that
+ * two runs draw the same texts.
+ */
+class COUNTING_GAL : public KIGFX::GAL
+{
+public:
+    COUNTING_GAL() :
+        m_points( 0 ),
+        m_sum( 0.0 )
+    {
+    }
+
+    virtual void DrawLine( const VECTOR2D& aStartPoint, const VECTOR2D& aEndPoint )
+    {
+        m_points += 2;
+        m_sum += aStartPoint.x + aStartPoint.y + aEndPoint.x + aEndPoint.y;
+    }
+
+    virtual void DrawPolyline( const VECTOR2D aPointList[], int aListSize )
+    {
+        m_points += aListSize;
+
+        for( int ii = 0; ii < aListSize; ++ii )
+            m_sum += aPointList[ii].x + aPointList[ii].y;
+    }
+
+    void SetLayoutCacheSize( unsigned aSize )
+    {
+        strokeFont.SetLayoutCacheSize( aSize );
+    }
+
+    long    m_points;
+    double  m_sum;
+};
+
+
+/// Builds aCount different texts as found on a board: references, pad names, net names.
+static void buildTexts( std::vector<wxString>& aTexts, unsigned aCount, const wxString& aPrefix )
+{
+    aTexts.clear();
+
+    for( unsigned ii = 0; ii < aCount; ++ii )
+    {
+        switch( ii % 3 )
+        {
+        case 0:
+            aTexts.push_back( wxString::Format( wxT( "%sU%u" ), GetChars( aPrefix ), ii ) );
+            break;
+
+        case 1:
+            aTexts.push_back( wxString::Format( wxT( "%sR%u.%u" ), GetChars( aPrefix ), ii,
+                                                ii % 64 + 1 ) );
+            break;
+
+        default:
+            aTexts.push_back( wxString::Format( wxT( "%s/SHEET%u/~NET~%u" ), GetChars( aPrefix ),
+                                                ii % 16, ii ) );
+            break;
+        }
+    }
+}
+
+
+/// @return the time to draw aFrames frames of aTexts on aGal, in milliseconds per frame.
+static double drawFrames( COUNTING_GAL* aGal, const std::vector<wxString>& aTexts, int aFrames )
+{
+    prof_counter cnt;
+
+    aGal->SetGlyphSize( VECTOR2D( 1000000.0, 1000000.0 ) );
+
+    prof_start( &cnt );
+
+    for( int frame = 0; frame < aFrames; ++frame )
+    {
+        for( unsigned ii = 0; ii < aTexts.size(); ++ii )
+            aGal->StrokeText( aTexts[ii], VECTOR2D( 0.0, ii * 1000.0 ), 0.0 );
+    }
+
+    prof_end( &cnt );
+
+    return cnt.msecs() / aFrames;
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer( argc, argv );
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "Can't initialize wxWidgets\n" );
+        return 2;
+    }
+
+    long frames = FRAMES_DEFAULT;
+
+    if( ( argc > 1 && !wxString::FromUTF8( argv[1] ).ToLong( &frames ) ) || frames <= 0 )
+    {
+        fprintf( stderr, "Usage: stroke_font_bench [frame count]\n" );
+        return 2;
+    }
+
+    std::vector<wxString>   texts;
+    bool                    identical = true;
+
+    printf( "%ld frames\n", frames );
+
+    for( unsigned ii = 0; ii < DIM( TEXT_COUNTS ); ++ii )
+    {
+        buildTexts( texts, TEXT_COUNTS[ii], wxEmptyString );
+
+        COUNTING_GAL cached;
+        COUNTING_GAL uncached;
+
+        uncached.SetLayoutCacheSize( 0 );
+
+        double cachedTime = drawFrames( &cached, texts, frames );
+        double uncachedTime = drawFrames( &uncached, texts, frames );
+
+        if( cached.m_points != uncached.m_points || cached.m_sum != uncached.m_sum )
+            identical = false;
+
+        printf( "  %6u texts  cache %8.2f ms  no cache %8.2f ms per frame\n",
+                TEXT_COUNTS[ii], cachedTime, uncachedTime );
+    }
+
+    // A zoom change: the texts of the view are other ones, which fit in the cache
+    std::vector<wxString> zoomed;
+
+    buildTexts( texts, TEXT_COUNTS[DIM( TEXT_COUNTS ) - 1], wxEmptyString );
+    buildTexts( zoomed, TEXT_COUNTS[0], wxT( "Z" ) );
+
+    COUNTING_GAL cached;
+    COUNTING_GAL uncached;
+
+    uncached.SetLayoutCacheSize( 0 );
+    drawFrames( &cached, texts, 2 );
+
+    double cachedTime = drawFrames( &cached, zoomed, frames );
+    double uncachedTime = drawFrames( &uncached, zoomed, frames );
+
+    printf( "  zoom %6u texts after %u: cache %8.2f ms  no cache %8.2f ms per frame\n",
+            TEXT_COUNTS[0], TEXT_COUNTS[DIM( TEXT_COUNTS ) - 1], cachedTime, uncachedTime );
+
+    printf( "%s\n", identical ? "The cached and uncached texts are identical"
+                              : "The cached and uncached texts differ" );
+
+    return identical ? 0 : 1;
+}
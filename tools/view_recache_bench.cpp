@@ -0,0 +1,342 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2017 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file view_recache_bench.cpp
+ * @brief Benchmark of the VIEW recaching, with the Cairo or the OpenGL GAL.
+ *
+ * Usage: view_recache_bench [--opengl] [footprint count [repeat count]]
+ *
+ * Builds a synthetic board of footprints with pads, tracks and vias, displays it in a
+ * frame with the Cairo GAL (hidden) or the OpenGL GAL (shown), and prints the time to
+ * recache all the items, to update the geometry of the tracks and to draw a frame, with the
+ * items drawn on one thread and on several threads.  With threads, the items are recorded on
+ * the worker threads and replayed on the GAL, which does the OpenGL tessellation and fills
+ * the vertex buffers: the time to replay all the items, the part which is not run on several
+ * threads, is printed too.  The vertices are uploaded by the first frame after a recache.
+ *
+ * Before that, the items are recached on one thread and on several threads on two
+ * RECORDING_GALs standing for the real GAL, which must receive the same commands.  The exit
+ * code is 0 if they do, 1 if they differ and 2 on errors.  It needs a display (and OpenGL
+ * 2.1 with --opengl): use e.g. xvfb-run on a headless machine.
+ */
+
+#include <cstdio>
+
+#include <wx/app.h>
+#include <wx/frame.h>
+
+#include <boost/bind.hpp>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_colors_design_settings.h>
+#include <layers_id_colors_and_visibility.h>
+#include <view/view.h>
+#include <gal/cairo/cairo_gal.h>
+#include <gal/opengl/opengl_gal.h>
+#include <gal/recording_gal.h>
+#include <pcb_painter.h>
+#include <profile.h>
+
+
+#define FOOTPRINTS_DEFAULT  2000
+#define REPEATS_DEFAULT     5
+
+/// Pads of each footprint, and tracks and vias per footprint
+#define PADS_PER_FOOTPRINT  16
+
+
+/// Adds aCount footprints to aBoard, each one with pads, a track per pad and a via.
+static void buildBoard( BOARD* aBoard, int aCount )
+{
+    const int pitch = 1270000;      // 1.27 mm
+    const int cols = 40;
+
+    for( int ii = 0; ii < aCount; ++ii )
+    {
+        wxPoint origin( ( ii % cols ) * pitch * 12, ( ii / cols ) * pitch * 12 );
+        MODULE* module = new MODULE( aBoard );
+
+        module->SetPosition( origin );
+        module->SetReference( wxString::Format( wxT( "U%d" ), ii + 1 ) );
+        aBoard->Add( module );
+
+        for( int jj = 0; jj < PADS_PER_FOOTPRINT; ++jj )
+        {
+            D_PAD*  pad = new D_PAD( module );
+            wxPoint offset( ( jj % 8 ) * pitch, ( jj / 8 ) * pitch * 6 );
+
+            pad->SetShape( jj % 2 ? PAD_OVAL : PAD_RECT );
+            pad->SetSize( wxSize( 600000, 1500000 ) );
+            pad->SetDrillSize( wxSize( 0, 0 ) );
+            pad->SetAttribute( PAD_SMD );
+            pad->SetLayerSet( D_PAD::SMDMask() );
+            pad->SetPadName( wxString::Format( wxT( "%d" ), jj + 1 ) );
+            pad->SetPos0( offset );
+            pad->SetPosition( origin + offset );
+            module->Pads().PushBack( pad );
+
+            TRACK* track = new TRACK( aBoard );
+
+            track->SetStart( origin + offset );
+            track->SetEnd( origin + offset + wxPoint( pitch * 2, pitch * 3 ) );
+            track->SetWidth( 250000 );
+            track->SetLayer( jj % 2 ? B_Cu : F_Cu );
+            aBoard->Add( track );
+        }
+
+        VIA* via = new VIA( aBoard );
+
+        via->SetPosition( origin + wxPoint( pitch * 4, pitch * 3 ) );
+        via->SetWidth( 600000 );
+        via->SetDrill( 300000 );
+        via->SetViaType( VIA_THROUGH );
+        via->SetLayerPair( F_Cu, B_Cu );
+        aBoard->Add( via );
+    }
+}
+
+
+/// Adds the items of aBoard to aView, like PCB_DRAW_PANEL_GAL::DisplayBoard().
+static void displayBoard( KIGFX::VIEW* aView, BOARD* aBoard )
+{
+    for( TRACK* track = aBoard->m_Track; track; track = track->Next() )
+        aView->Add( track );
+
+    for( MODULE* module = aBoard->m_Modules; module; module = module->Next() )
+    {
+        module->RunOnChildren( boost::bind( &KIGFX::VIEW::Add, aView, _1 ) );
+        aView->Add( module );
+    }
+}
+
+
+/// @return the time to draw a frame of aView on aGal, in milliseconds.
+static double drawFrame( KIGFX::VIEW* aView, KIGFX::GAL* aGal, const KIGFX::COLOR4D& aBackground )
+{
+    prof_counter cnt;
+
+    prof_start( &cnt );
+
+    aView->MarkDirty();
+    aView->UpdateItems();
+    aGal->BeginDrawing();
+    aGal->ClearScreen( aBackground );
+    aView->ClearTargets();
+    aView->Redraw();
+    aGal->EndDrawing();
+
+    prof_end( &cnt );
+
+    return cnt.msecs();
+}
+
+
+/**
+ * Recaches the items of aView on one thread, then on several threads, each time on a
+ * RECORDING_GAL given the attributes of aGal, and restores aGal.
+ * @param aReplay receives the commands of the recache on several threads.
+ * @return true if both recaches gave the same commands.
+ */
+static bool checkRecache( KIGFX::VIEW* aView, KIGFX::PAINTER* aPainter, KIGFX::GAL* aGal,
+                          KIGFX::RECORDING_GAL* aReplay )
+{
+    KIGFX::RECORDING_GAL serial;
+
+    serial.CopyAttributes( *aGal );
+    aReplay->CopyAttributes( *aGal );
+
+    aPainter->SetGAL( &serial );
+    aView->SetGAL( &serial );
+    aView->SetUseThreads( false );
+    aView->RecacheAllItems( true );
+
+    aPainter->SetGAL( aReplay );
+    aView->SetGAL( aReplay );
+    aView->SetUseThreads( true );
+    aView->RecacheAllItems( true );
+
+    aPainter->SetGAL( aGal );
+    aView->SetGAL( aGal );
+
+    return serial.GetCommandCount() > 0 && serial.IsSameRecording( *aReplay );
+}
+
+
+class VIEW_RECACHE_BENCH : public wxApp
+{
+public:
+    // Do not parse the command line, it is not made of wxWidgets options
+    bool OnInit()
+    {
+        return true;
+    }
+
+    int OnRun();
+};
+
+
+int VIEW_RECACHE_BENCH::OnRun()
+{
+    long count = FOOTPRINTS_DEFAULT;
+    long repeats = REPEATS_DEFAULT;
+    bool useOpenGL = false;
+    int  arg = 1;
+
+    if( argc > arg && wxString( argv[arg] ) == wxT( "--opengl" ) )
+    {
+        useOpenGL = true;
+        ++arg;
+    }
+
+    if( ( argc > arg && !wxString( argv[arg] ).ToLong( &count ) )
+        || ( argc > arg + 1 && !wxString( argv[arg + 1] ).ToLong( &repeats ) )
+        || argc > arg + 2 || count <= 0 || repeats <= 0 )
+    {
+        fprintf( stderr, "Usage: view_recache_bench [--opengl] [footprint count [repeat count]]\n" );
+        return 2;
+    }
+
+    wxFrame* frame = new wxFrame( NULL, wxID_ANY, wxT( "view_recache_bench" ),
+                                  wxDefaultPosition, wxSize( 1280, 1024 ) );
+    KIGFX::GAL* gal;
+
+    if( useOpenGL )
+    {
+        // The OpenGL GAL draws only when it is shown on screen
+        frame->Show();
+        gal = new KIGFX::OPENGL_GAL( frame );
+
+        for( int ii = 0; ii < 100 && !gal->IsInitialized(); ++ii )
+        {
+            wxYield();
+            wxMilliSleep( 10 );
+        }
+
+        if( !gal->IsInitialized() )
+        {
+            fprintf( stderr, "The OpenGL canvas cannot be shown\n" );
+            frame->Destroy();
+            return 2;
+        }
+    }
+    else
+    {
+        gal = new KIGFX::CAIRO_GAL( frame );
+    }
+
+    KIGFX::PCB_PAINTER      painter( gal );
+    KIGFX::VIEW             view;
+    COLORS_DESIGN_SETTINGS  colors;
+    BOARD                   board;
+
+    gal->ResizeScreen( 1280, 1024 );
+    painter.GetSettings()->ImportLegacyColors( &colors );
+    view.SetPainter( &painter );
+    view.SetGAL( gal );
+
+    for( int layer = 0; layer < TOTAL_LAYER_COUNT; ++layer )
+        view.AddLayer( layer );
+
+    buildBoard( &board, count );
+    displayBoard( &view, &board );
+
+    BOX2I extents = view.CalculateExtents();
+    view.SetViewport( BOX2D( VECTOR2D( extents.GetOrigin() ), VECTOR2D( extents.GetSize() ) ) );
+
+    printf( "%s GAL, %ld footprints, %d items per footprint, %ld repeats\n",
+            useOpenGL ? "OpenGL" : "Cairo", count, PADS_PER_FOOTPRINT * 2 + 4, repeats );
+
+    KIGFX::RECORDING_GAL replay;
+    bool identical = checkRecache( &view, &painter, gal, &replay );
+
+    printf( "  serial and threaded recaches %s\n", identical ? "match" : "differ" );
+
+    const KIGFX::COLOR4D& background = painter.GetSettings()->GetBackgroundColor();
+
+    for( int threads = 0; threads < 2; ++threads )
+    {
+        double recacheTime = 0.0;
+        double updateTime = 0.0;
+        double frameTime = 0.0;
+
+        view.SetUseThreads( threads );
+
+        for( int ii = 0; ii < repeats; ++ii )
+        {
+            prof_counter cnt;
+
+            prof_start( &cnt );
+            view.RecacheAllItems( true );
+            prof_end( &cnt );
+            recacheTime += cnt.msecs();
+
+            for( TRACK* track = board.m_Track; track; track = track->Next() )
+                track->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );
+
+            prof_start( &cnt );
+            view.UpdateItems();
+            prof_end( &cnt );
+            updateTime += cnt.msecs();
+
+            frameTime += drawFrame( &view, gal, background );
+        }
+
+        printf( "  %-8s recache %10.2f ms  update tracks %10.2f ms  frame %10.2f ms\n",
+                threads ? "threads" : "serial", recacheTime / repeats, updateTime / repeats,
+                frameTime / repeats );
+    }
+
+    // The replay of all the recorded items in a group, i.e. the GAL side of a recache
+    double replayTime = 0.0;
+
+    for( int ii = 0; ii < repeats; ++ii )
+    {
+        prof_counter cnt;
+
+        prof_start( &cnt );
+
+        int group = gal->BeginGroup();
+        replay.Replay( gal, 0, replay.GetCommandCount() );
+        gal->EndGroup();
+
+        prof_end( &cnt );
+        replayTime += cnt.msecs();
+
+        gal->DeleteGroup( group );
+    }
+
+    printf( "  replay   %10.2f ms (%d commands)\n", replayTime / repeats,
+            replay.GetCommandCount() );
+
+    view.Clear();
+    frame->Destroy();
+
+    return identical ? 0 : 1;
+}
+
+
+IMPLEMENT_APP( VIEW_RECACHE_BENCH )